@@ -0,0 +1,103 @@
+/**
+ * Typed array over length elements of the wasm heap starting at byteOffset.
+ *
+ * Growing wasm memory replaces the heap buffer and detaches all arrays
+ * created on the previous one, so array() rebuilds its array when this
+ * happens. Do not keep the returned array across calls into wasm.
+ */
+function HeapArray(arrayType, byteOffset, length) {
+  this.arrayType = arrayType;
+  this.byteOffset = byteOffset;
+  this.length = length;
+  this.buffer = null;
+  this.typedArray = null;
+}
+
+/**
+ * Typed array over the data, empty if byteOffset is null.
+ */
+HeapArray.prototype.array = function() {
+  if (this.byteOffset == 0) {
+    if (this.typedArray === null) this.typedArray = new this.arrayType(0);
+  } else if (this.buffer !== Module.HEAPU8.buffer) {
+    this.buffer = Module.HEAPU8.buffer;
+    this.typedArray = new this.arrayType(this.buffer, this.byteOffset, this.length);
+  }
+  return this.typedArray;
+}
+
+/**
+ * Typed view of the data of a mesh attribute living in the wasm heap.
+ *
+ * array() returns a Float32Array, Int32Array or Uint8Array starting at the
+ * first component of the attribute. Element i, component k is at index
+ * offset(i) + k, where offset(i) = i * stride and stride is counted in
+ * components: it equals componentCount for contiguous attributes, is larger
+ * for attributes interleaved with others (e.g. views into a loaded file) and
+ * is 0 when a single value is shared by all elements. Like for HeapArray,
+ * the array is rebuilt when the heap buffer changes.
+ *
+ * Attributes whose data is not aligned on their component size cannot be
+ * viewed as a typed array; array() then returns null and get() falls back
+ * to a DataView.
+ */
+function AttributeView(attrib) {
+  this.type = attrib.type();
+  this.componentCount = attrib.componentCount();
+  this.elementCount = attrib.elementCount();
+  this.contiguous = attrib.isContiguous();
+  this.componentSize = attrib.componentSize();
+  this.byteOffset = attrib.data().ptr;
+  this.byteStride = attrib.byteStride();
+
+  let arrayType = null;
+  this.dataViewGetter = null;
+  if (this.type == "OfxMeshAttribTypeFloat") {
+    arrayType = Float32Array;
+    this.dataViewGetter = DataView.prototype.getFloat32;
+  } else if (this.type == "OfxMeshAttribTypeInt") {
+    arrayType = Int32Array;
+    this.dataViewGetter = DataView.prototype.getInt32;
+  } else if (this.type == "OfxMeshAttribTypeUByte") {
+    arrayType = Uint8Array;
+    this.dataViewGetter = DataView.prototype.getUint8;
+  } else {
+    console.error("Unknown attribute type: " + this.type);
+  }
+
+  this.isNull = this.byteOffset == 0 || arrayType === null;
+  this.isAligned = !this.isNull
+    && this.byteOffset % this.componentSize == 0
+    && this.byteStride % this.componentSize == 0;
+  this.stride = this.isAligned ? this.byteStride / this.componentSize : 0;
+
+  // Number of components spanned by the data, including the gaps of
+  // interleaved attributes after the last element
+  const rowCount = this.byteStride == 0 ? 1 : this.elementCount;
+  this.length = rowCount == 0 ? 0 : (rowCount - 1) * this.stride + this.componentCount;
+
+  this.heapArray = this.isAligned ? new HeapArray(arrayType, this.byteOffset, this.length) : null;
+  this.buffer = null;
+  this.dataView = null;
+}
+
+/**
+ * Typed array over the attribute data (see above), or null if the attribute
+ * has no data or is not aligned.
+ */
+AttributeView.prototype.array = function() {
+  return this.heapArray === null ? null : this.heapArray.array();
+}
+
+AttributeView.prototype.get = function(index, component) {
+  if (this.heapArray !== null) {
+    return this.heapArray.array()[index * this.stride + component];
+  }
+  if (this.isNull) return undefined;
+  if (this.buffer !== Module.HEAPU8.buffer) {
+    this.buffer = Module.HEAPU8.buffer;
+    this.dataView = new DataView(this.buffer, this.byteOffset);
+  }
+  const byteOffset = index * this.byteStride + component * this.componentSize;
+  return this.dataViewGetter.call(this.dataView, byteOffset, true);
+}
@@ -4,6 +4,15 @@ function capitalize(string) {
   return string.charAt(0).toUpperCase() + string.slice(1);
 }
 
+function isIntegerParameterType(type) {
+  return (
+    type == "OfxParamTypeInteger" ||
+    type == "OfxParamTypeChoice" ||
+    type == "OfxParamTypeInteger2D" ||
+    type == "OfxParamTypeInteger3D"
+  );
+}
+
 function App() {
   this.needRender = true;
 
@@ -11,6 +20,8 @@ function App() {
   this.effectIndices = {};
   this.effectDescriptor = null;
   this.effectInstance = null;
+  this.outputMesh = null; // pinned output of the last cook, displayed
+  this.objLoadOptions = null;
 
   this.parameterValues = { 'foo': 42 };
   this.gui = new dat.GUI({name: 'Parameters'});
@@ -22,11 +33,13 @@ function App() {
     effectIndex: document.getElementById('effect-index'),
     inputsBlock: document.getElementById('inputs'),
     parametersBlock: document.getElementById('parameters'),
-    outputPointSpreadsheet: document.querySelector('#output-spreadsheets .point'),
-    outputCornerSpreadsheet: document.querySelector('#output-spreadsheets .corner'),
-    outputFaceSpreadsheet: document.querySelector('#output-spreadsheets .face'),
-    outputMeshSpreadsheet: document.querySelector('#output-spreadsheets .mesh'),
+    outputPointSpreadsheet: document.querySelector('#output-spreadsheets .point table'),
+    outputCornerSpreadsheet: document.querySelector('#output-spreadsheets .corner table'),
+    outputFaceSpreadsheet: document.querySelector('#output-spreadsheets .face table'),
+    outputMeshSpreadsheet: document.querySelector('#output-spreadsheets .mesh table'),
     cookBtn: document.getElementById('cook-btn'),
+    exportFormat: document.getElementById('export-format'),
+    exportBtn: document.getElementById('export-btn'),
     inputs: [],
     parameters: [],
   };
@@ -40,6 +53,7 @@ function App() {
   this.onParameterChanged = this.onParameterChanged.bind(this);
   this.onInputChanged = this.onInputChanged.bind(this);
   this.cook = this.cook.bind(this);
+  this.exportMesh = this.exportMesh.bind(this);
 }
 
 App.prototype.onDomLoaded = function() {
@@ -180,59 +194,213 @@ App.prototype.onSelectEffect = function(event) {
   const paramControllers = [];
   this.dom.parameters = [];
   this.parameterValues = {};
+  this.parameterTypes = {};
   for (let i = 0 ; i < parameterCount ; ++i) {
-    const identifier = this.effectDescriptor.getParameter(i).identifier();
+    const parameter = this.effectDescriptor.getParameter(i);
+    const identifier = parameter.identifier();
+    const type = parameter.type();
+    const componentCount = parameter.componentCount();
+    if (componentCount == 0) continue; // string, group, page, etc. have no editable value here
     const divElement = document.createElement('div');
     const labelElement = document.createElement('label');
     labelElement.for = identifier;
     labelElement.innerText = identifier + " ";
     divElement.appendChild(labelElement);
-    const ui = document.createElement('input');
-    ui.type = "range";
-    ui.name = identifier;
-    ui.min = 0;
-    ui.max = 5;
-    ui.step = 'any';
-    ui.value = i;
-    ui.addEventListener('change', this.onParameterChanged)
-    divElement.appendChild(ui);
+    const value = [];
+    for (let k = 0 ; k < componentCount ; ++k) {
+      const ui = document.createElement('input');
+      ui.name = identifier;
+      ui.dataset.component = k;
+      if (type == "OfxParamTypeBoolean") {
+        ui.type = "checkbox";
+        value.push(0);
+      } else if (type == "OfxParamTypeRGB" || type == "OfxParamTypeRGBA") {
+        ui.type = "number";
+        ui.min = 0;
+        ui.max = 1;
+        ui.step = 'any';
+        ui.value = 1;
+        value.push(1);
+      } else if (componentCount > 1) {
+        ui.type = "number";
+        ui.step = isIntegerParameterType(type) ? 1 : 'any';
+        ui.value = 0;
+        value.push(0);
+      } else {
+        ui.type = "range";
+        ui.min = 0;
+        ui.max = 5;
+        ui.step = isIntegerParameterType(type) ? 1 : 'any';
+        ui.value = i;
+        value.push(i);
+      }
+      ui.addEventListener('change', this.onParameterChanged)
+      divElement.appendChild(ui);
+      this.dom.parameters.push(ui);
+    }
     paramControllers.push(divElement);
-    this.dom.parameters.push(ui);
-    this.parameterValues[identifier] = i;
+    this.parameterValues[identifier] = value;
+    this.parameterTypes[identifier] = type;
   }
   this.dom.parametersBlock.replaceChildren(...paramControllers);
 
   this.dom.cookBtn.addEventListener('click', this.cook);
+  this.dom.exportBtn.addEventListener('click', this.exportMesh);
 
   if (this.effectInstance !== null) {
     Module.destroy(this.effectInstance);
+    this.outputMesh = null;
   }
   this.effectInstance = this.effectDescriptor.instantiate();
+  if (this.effectInstance.status() != 0) {
+    console.error(`could not instantiate effect (status = ${this.effectInstance.status()})`);
+  }
+  // The displayed output remains valid (e.g. for the spreadsheet) while the
+  // next one is cooked in the other slot
+  this.effectInstance.setOutputSlotCount(2);
+}
+
+App.prototype.setParameter = function(identifier, type, value) {
+  const instance = this.effectInstance;
+  switch (type) {
+  case "OfxParamTypeInteger":
+  case "OfxParamTypeChoice":
+    return instance.setParameterInt(identifier, value[0]);
+  case "OfxParamTypeBoolean":
+    return instance.setParameterBoolean(identifier, value[0] != 0);
+  case "OfxParamTypeDouble2D":
+  case "OfxParamTypeInteger2D":
+    return instance.setParameter2d(identifier, value[0], value[1]);
+  case "OfxParamTypeDouble3D":
+  case "OfxParamTypeInteger3D":
+    return instance.setParameter3d(identifier, value[0], value[1], value[2]);
+  case "OfxParamTypeRGB":
+    return instance.setParameterRGB(identifier, value[0], value[1], value[2]);
+  case "OfxParamTypeRGBA":
+    return instance.setParameterRGBA(identifier, value[0], value[1], value[2], value[3]);
+  default:
+    return instance.setParameter(identifier, value[0]);
+  }
 }
 
 App.prototype.onParameterChanged = function(event) {
   console.log(`parameter changed: ${event.target.name}`)
-  this.parameterValues[event.target.name] = event.target.value;
+  const ui = event.target;
+  const value = ui.type == "checkbox" ? (ui.checked ? 1 : 0) : parseFloat(ui.value);
+  this.parameterValues[ui.name][ui.dataset.component] = value;
   this.cook();
 }
 
 App.prototype.onInputChanged = async function(event) {
   console.log(`input changed: ${event.target.name}`)
 
-  // Load plugin file into WebAssembly's memory
-  const filename = 'input__' + event.target.name + '.obj';
-  const filedata = new Uint8Array(await event.target.files[0].arrayBuffer());
-  const f = Module.FS.open(filename, 'w');
-  Module.FS.write(f, filedata, 0, filedata.length);
-  Module.FS.close(f);
-
-  this.inputMeshes[event.target.name].loadObj(filename);
   const mesh = this.inputMeshes[event.target.name];
+  const file = event.target.files[0];
+  const extension = file.name.toLowerCase().split('.').pop();
+  let status;
+  if (extension == 'glb') {
+    status = await this.loadFileFromMemory(mesh, file, mesh.loadGlbFromMemory);
+  } else if (extension == 'ply') {
+    status = await this.loadFileFromMemory(mesh, file, mesh.loadPlyFromMemory);
+  } else {
+    status = await this.loadObjFile(mesh, file);
+  }
+  console.log(`status = ${status}`);
   //this.updateMesh(mesh);
   //this.updateSpreadsheet(mesh);
   this.cook();
 }
 
+/**
+ * Load an OBJ file into a mesh without going through the virtual file system.
+ * The file is streamed into a staging buffer allocated once in the wasm heap,
+ * and each time the buffer is full it is parsed while the next bytes are read.
+ */
+App.prototype.loadObjFile = async function(mesh, file) {
+  const stagingSize = Math.min(file.size, 16 << 20);
+
+  if (!file.stream) {
+    // Fallback for browsers that cannot stream files: copy it once into the heap
+    const size = file.size;
+    const ptr = Module._malloc(Math.max(size, 1));
+    Module.HEAPU8.set(new Uint8Array(await file.arrayBuffer()), ptr);
+    const status = mesh.loadObjFromMemory(ptr, size, this.objLoadOptions);
+    Module._free(ptr);
+    return status;
+  }
+
+  const ptr = Module._malloc(Math.max(stagingSize, 1));
+  let filled = 0;
+  mesh.beginObj(this.objLoadOptions);
+  const reader = file.stream().getReader();
+  for (;;) {
+    const { done, value } = await reader.read();
+    if (done) break;
+    let offset = 0;
+    while (offset < value.length) {
+      const count = Math.min(value.length - offset, stagingSize - filled);
+      // Get HEAPU8 every time because the heap buffer changes when memory grows
+      Module.HEAPU8.set(value.subarray(offset, offset + count), ptr + filled);
+      filled += count;
+      offset += count;
+      if (filled == stagingSize) {
+        mesh.feedObj(ptr, filled);
+        filled = 0;
+      }
+    }
+  }
+  if (filled > 0) {
+    mesh.feedObj(ptr, filled);
+  }
+  Module._free(ptr);
+  return mesh.endObj();
+}
+
+/**
+ * Copy a whole file once into the wasm heap and load it with one of the
+ * loadXxxFromMemory() methods of the mesh, for formats that keep mesh
+ * attributes pointing into the file content (GLB, PLY).
+ */
+App.prototype.loadFileFromMemory = async function(mesh, file, loadFromMemory) {
+  const size = file.size;
+  const ptr = Module._malloc(Math.max(size, 1));
+  Module.HEAPU8.set(new Uint8Array(await file.arrayBuffer()), ptr);
+  const status = loadFromMemory.call(mesh, ptr, size);
+  Module._free(ptr);
+  return status;
+}
+
+const exportFormats = {
+  glb: { save: 'saveGlb', type: 'model/gltf-binary' },
+  obj: { save: 'saveObj', type: 'model/obj' },
+  ply: { save: 'savePly', type: 'application/octet-stream' },
+  wmfx: { save: 'saveBinary', type: 'application/octet-stream' },
+};
+
+/**
+ * Save the last output mesh in the format selected next to the export
+ * button and download it.
+ */
+App.prototype.exportMesh = function(event) {
+  if (this.outputMesh === null) return;
+  const extension = this.dom.exportFormat.value;
+  const format = exportFormats[extension];
+  const mesh = this.outputMesh;
+  const filename = 'output.' + extension;
+  const status = mesh[format.save](filename);
+  if (status != 0) {
+    console.log(`could not export mesh (status = ${status})`);
+    return;
+  }
+  const data = Module.FS.readFile(filename);
+  Module.FS.unlink(filename);
+  const link = document.createElement('a');
+  link.href = URL.createObjectURL(new Blob([data], { type: format.type }));
+  link.download = filename;
+  link.click();
+  URL.revokeObjectURL(link.href);
+}
+
 App.prototype.cook = function(event) {
   console.log(`Cooking...`);
   for (let key in this.inputMeshes) {
@@ -242,187 +410,227 @@ App.prototype.cook = function(event) {
     console.log("input pointPositionAttrib: " + pointPositionAttrib.data().ptr);
   }
   for (let key in this.parameterValues) {
-    const value = this.parameterValues[key];
-    this.effectInstance.setParameter(key, value);
+    this.setParameter(key, this.parameterTypes[key], this.parameterValues[key]);
   }
   let status;
   status = this.effectInstance.cook();
   console.log(`status = ${status}`);
+  if (status != 0) {
+    // Keep displaying the previous output
+    console.error(`cook failed (status = ${status})`);
+    return;
+  }
 
+  // Pin the new output, and only release the previous one once nothing
+  // displays it anymore
   const mesh = this.effectInstance.getOutputMesh();
+  const previousMesh = this.outputMesh;
+  this.outputMesh = mesh;
 
   const pointPositionAttrib = mesh.getAttribute("OfxMeshAttribPoint", "OfxMeshAttribPointPosition");
   console.log("output pointPositionAttrib: " + pointPositionAttrib.data().ptr);
   
   this.updateMesh(mesh);
   this.updateSpreadsheet(mesh);
+
+  if (previousMesh !== null) {
+    this.effectInstance.releaseOutputMesh(previousMesh);
+  }
+}
+
+/**
+ * Rows of one attachment of a mesh, for a spreadsheet. They are read from
+ * wasm on demand, one window of visible rows at a time, and sorted there.
+ * Buffers live in the wasm heap and must be freed with release().
+ */
+function MeshRowSource(mesh, attachment, identifiers) {
+  this.mesh = mesh;
+  this.attachment = attachment;
+  this.identifiers = identifiers; // attribute of each column but the first
+  this.rowSize = mesh.rowSize(attachment);
+  this.rowCount = mesh.rowCount(attachment);
+  this.windowPtr = 0;
+  this.windowCapacity = 0; // in rows
+  this.window = new HeapArray(Float64Array, 0, 0);
+  this.orderPtr = 0; // element index of each row once sorted
+}
+
+MeshRowSource.prototype.readRows = function(first, count) {
+  if (count > this.windowCapacity) {
+    Module._free(this.windowPtr);
+    this.windowPtr = Module._malloc(8 * this.rowSize * count);
+    this.windowCapacity = count;
+    this.window = new HeapArray(Float64Array, this.windowPtr, this.rowSize * count);
+  }
+  const status = this.mesh.readRows(this.attachment, first, count, this.windowPtr, this.orderPtr);
+  if (status != 0) {
+    console.error(`could not read spreadsheet rows (status = ${status})`);
+  }
+  // Get the array after the call since the heap changes when memory grows
+  return this.window.array().subarray(0, this.rowSize * count);
+}
+
+MeshRowSource.prototype.sort = function(columnIndex, component, ascending) {
+  if (columnIndex == 0) {
+    // Sorting by element index
+    Module._free(this.orderPtr);
+    this.orderPtr = 0;
+    if (ascending) return;
+  }
+  if (this.orderPtr == 0) {
+    this.orderPtr = Module._malloc(4 * this.rowCount);
+  }
+  if (columnIndex == 0) {
+    // Descending element index
+    const order = new HeapArray(Int32Array, this.orderPtr, this.rowCount).array();
+    order.forEach((_, i) => order[i] = this.rowCount - 1 - i);
+    return;
+  }
+  const status = this.mesh.sortRows(this.attachment, this.identifiers[columnIndex - 1], component, !ascending, this.orderPtr);
+  if (status != 0) {
+    console.error(`could not sort spreadsheet rows (status = ${status})`);
+  }
+}
+
+MeshRowSource.prototype.release = function() {
+  Module._free(this.windowPtr);
+  Module._free(this.orderPtr);
+  this.windowPtr = this.orderPtr = 0;
+  this.windowCapacity = 0;
+  this.window = new HeapArray(Float64Array, 0, 0);
+}
+
+/**
+ * Range, mean and count of non finite values of each component of an
+ * attribute, computed on the wasm side, for the summary row of spreadsheets.
+ */
+App.prototype.attributeSummaries = function(attrib) {
+  const stats = this.attributeStats;
+  if (stats.compute(attrib) != 0) return null;
+  const summaries = [];
+  for (let k = 0 ; k < stats.componentCount() ; ++k) {
+    const min = formatCellValue(stats.min(k));
+    const max = formatCellValue(stats.max(k));
+    const mean = formatCellValue(stats.mean(k));
+    const nanCount = stats.nanCount(k);
+    const infCount = stats.infCount(k);
+    let text = stats.finiteCount(k) > 0 ? `${min} … ${max}` : "-";
+    if (nanCount + infCount > 0) {
+      text = `${nanCount} NaN, ${infCount} Inf, ` + text;
+    }
+    summaries.push({
+      text: text,
+      title: `min: ${min}\nmax: ${max}\nmean: ${mean}\nNaN: ${nanCount}\nInf: ${infCount}`,
+      isWarning: nanCount + infCount > 0,
+    });
+  }
+  return summaries;
 }
 
 App.prototype.updateSpreadsheet = function(mesh) {
-  let pointColumns = [{ name: "#", componentCount: 1, getData: (i) => i }];
-  let cornerColumns = [{ name: "#", componentCount: 1, getData: (i) => i }];
-  let faceColumns = [{ name: "#", componentCount: 1, getData: (i) => i }];
-  let meshColumns = [{ name: "#", componentCount: 1, getData: (i) => i }];
+  const spreadsheets = {
+    OfxMeshAttribPoint: this.dom.outputPointSpreadsheet,
+    OfxMeshAttribCorner: this.dom.outputCornerSpreadsheet,
+    OfxMeshAttribFace: this.dom.outputFaceSpreadsheet,
+    OfxMeshAttribMesh: this.dom.outputMeshSpreadsheet,
+  };
+  const columns = {};
+  const identifiers = {};
+  for (let attachment in spreadsheets) {
+    const rowCount = mesh.rowCount(attachment);
+    const summary = { text: `${rowCount} rows`, title: `${rowCount} rows` };
+    columns[attachment] = [{ name: "#", componentCount: 1, summaries: [summary] }];
+    identifiers[attachment] = [];
+  }
+
   const attributeCount = mesh.attributeCount();
   for (let i = 0 ; i < attributeCount ; ++i) {
     const attrib = mesh.getAttributeByIndex(i);
     const identifier = attrib.identifier();
     const attachment = attrib.attachment();
-    const componentCount = attrib.componentCount();
-    const byteStride = attrib.byteStride();
-    const type = attrib.type();
-
-    let columns, elementCount;
-    if (attachment == "OfxMeshAttribPoint") {
-      columns = pointColumns;
-      elementCount = mesh.pointCount();
-    } else if (attachment == "OfxMeshAttribCorner") {
-      columns = cornerColumns;
-      elementCount = mesh.cornerCount();
-    } else if (attachment == "OfxMeshAttribFace") {
-      columns = faceColumns;
-      elementCount = mesh.faceCount();
-    } else {
-      columns = meshColumns;
-      elementCount = 1;
-    }
-
-    const dataView = new DataView(Module.HEAP8.buffer, attrib.data().ptr);
-
-    let getValue, componentByteSize;
-    if (type == "OfxMeshAttribTypeUByte") {
-      getValue = dataView.getUint8.bind(dataView);
-      componentByteSize = 1;
-    } else if (type == "OfxMeshAttribTypeInt") {
-      getValue = dataView.getInt32.bind(dataView);
-      componentByteSize = 4;
-    } else if (type == "OfxMeshAttribTypeFloat") {
-      getValue = dataView.getFloat32.bind(dataView);
-      componentByteSize = 4;
-    } else {
-      console.error("Unknown attribute type: " + type);
-    }
-
-    const getData = (index, component) => getValue(byteStride * index + componentByteSize * component, true);
-    
-    if (mesh.constantFaceSize() > -1 && attachment == "OfxMeshAttribFace" && identifier == "OfxMeshAttribFaceSize") {
-      data = new Int32Array(mesh.faceCount());
-      data.fill(mesh.constantFaceSize());
-    }
+    if (!(attachment in spreadsheets)) continue;
 
     let displayedIdentifier = identifier;
     if (identifier.startsWith(attachment)) {
       displayedIdentifier = identifier.substring(attachment.length);
     }
 
-    columns.push({
+    columns[attachment].push({
       name: displayedIdentifier,
-      componentCount: componentCount,
-      getData: getData,
+      componentCount: attrib.componentCount(),
+      summaries: this.attributeSummaries(attrib),
     });
+    identifiers[attachment].push(identifier);
   }
-  
-  updateSpreadsheet(this.dom.outputPointSpreadsheet, pointColumns, mesh.pointCount());
-  updateSpreadsheet(this.dom.outputCornerSpreadsheet, cornerColumns, mesh.cornerCount());
-  updateSpreadsheet(this.dom.outputFaceSpreadsheet, faceColumns, mesh.faceCount());
-  updateSpreadsheet(this.dom.outputMeshSpreadsheet, meshColumns, 1);
-}
-
-App.prototype.updateMesh = function(mesh) {
-  const pointCount = mesh.pointCount();
-  const cornerCount = mesh.cornerCount();
-  const faceCount = mesh.faceCount();
-  const constantFaceSize = mesh.constantFaceSize();
 
-  console.log(mesh.isValid());
-  console.log(` - ${pointCount} points`);
-  console.log(` - ${cornerCount} corners`);
-  console.log(` - ${faceCount} faces`);
-  console.log(` - constantFaceSize = ${constantFaceSize}`);
+  for (let attachment in spreadsheets) {
+    const spreadsheet = spreadsheets[attachment];
+    if (spreadsheet.rowSource) spreadsheet.rowSource.release();
+    const source = new MeshRowSource(mesh, attachment, identifiers[attachment]);
+    updateSpreadsheet(spreadsheet, columns[attachment], source);
+  }
+}
 
-  const pointPositionAttrib = mesh.getAttribute("OfxMeshAttribPoint", "OfxMeshAttribPointPosition");
-  const pointPositionStride = pointPositionAttrib.byteStride();
-  const pointPositionDataView = new DataView(Module.HEAP8.buffer, pointPositionAttrib.data().ptr);
-  const getPointPosition = (index, component) => pointPositionDataView.getFloat32(pointPositionStride * index + 4 * component, true);
-
-  const cornerPointAttrib = mesh.getAttribute("OfxMeshAttribCorner", "OfxMeshAttribCornerPoint");
-  const cornerPointStride = cornerPointAttrib.byteStride();
-  const cornerPointDataView = new DataView(Module.HEAP8.buffer, cornerPointAttrib.data().ptr);
-  const getCornerPoint = index => cornerPointDataView.getInt32(cornerPointStride * index, true);
-
-  let getFaceSize;
-  if (mesh.constantFaceSize() == -1) {
-    const faceSizeAttrib = mesh.getAttribute("OfxMeshAttribFace", "OfxMeshAttribFaceSize");
-    const faceSizeStride = faceSizeAttrib.byteStride();
-    const faceSizeDataView = new DataView(Module.HEAP8.buffer, faceSizeAttrib.data().ptr);
-    getFaceSize = index => faceSizeDataView.getInt32(faceSizeStride * index, true);
+/**
+ * Set the content of a geometry attribute (or index if name is null),
+ * reusing its array when the size did not change. Data is copied because
+ * views on the wasm heap get detached when memory grows.
+ */
+function setGeometryBuffer(geometry, name, data, itemSize) {
+  const attribute = name === null ? geometry.index : geometry.getAttribute(name);
+  if (attribute && attribute.array.length == data.length && attribute.array.constructor === data.constructor) {
+    attribute.array.set(data);
+    attribute.needsUpdate = true;
+  } else if (name === null) {
+    geometry.setIndex(new THREE.BufferAttribute(data.slice(), itemSize));
   } else {
-    getFaceSize = index => mesh.constantFaceSize();
-  }
-
-  // Convert to ThreeJs-ready triangles
-  let triangleCount = 0;
-  for (let f = 0 ; f < faceCount ; ++f) {
-    const size = getFaceSize(f);
-    if (size == 3) {
-      triangleCount += 1;
-    } else if (size == 4) {
-      triangleCount += 2;
-    } else {
-      console.error(`Unsupported face size in face #${f}: ${size}`);
-    }
+    geometry.setAttribute(name, new THREE.BufferAttribute(data.slice(), itemSize));
   }
-  const tesselatedCornerPointData = new Uint32Array(3 * triangleCount);
-  let triangleIndex = 0;
-  let cornerIndex = 0;
-  for (let f = 0 ; f < faceCount ; ++f) {
-    const size = getFaceSize(f);
-
-    for (let k = 0 ; k < 3 ; ++k) {
-      tesselatedCornerPointData[3 * triangleIndex + k] = getCornerPoint(cornerIndex + k);
-    }
-    ++triangleIndex;
+}
 
-    if (size == 4) {
-      for (let k = 0 ; k < 3 ; ++k) {
-        tesselatedCornerPointData[3 * triangleIndex + k] = getCornerPoint(cornerIndex + (k + 2) % 4);
-      }
-      ++triangleIndex;
-    }
+// Flags of RenderBuffers.changes()
+const RenderBuffersChange = {
+  positions: 1 << 0,
+  normals: 1 << 1,
+  indices: 1 << 2,
+};
 
-    cornerIndex += size;
-  }
-
-  // Expand the index buffer and compute normals
-  const tesselatedPointPositionData = new Float32Array(3 * 3 * triangleCount);
-  const tesselatedPointNormalData = new Float32Array(3 * 3 * triangleCount);
-  const pos = [new THREE.Vector3(), new THREE.Vector3(), new THREE.Vector3()];
-  const ab = new THREE.Vector3();
-  const ac = new THREE.Vector3();
-  const normal = new THREE.Vector3();
-  for (let t = 0 ; t < triangleCount ; ++t) {
-    for (let c = 0 ; c < 3 ; ++c) {
-      const p = tesselatedCornerPointData[3 * t + c];
-      for (let k = 0 ; k < 3 ; ++k) {
-        const value = getPointPosition(p, k);
-        pos[c].setComponent(k, value);
-        tesselatedPointPositionData[3 * (3 * t + c) + k] = value;
-      }
-    }
-    ab.subVectors(pos[1], pos[0]);
-    ac.subVectors(pos[2], pos[0]);
-    normal.crossVectors(ab, ac);
-    normal.normalize();
-    for (let c = 0 ; c < 3 ; ++c) {
-      for (let k = 0 ; k < 3 ; ++k) {
-        tesselatedPointNormalData[3 * (3 * t + c) + k] = normal.getComponent(k);
-      }
-    }
+/**
+ * Display a mesh. It is converted into an indexed triangle list on the wasm
+ * side (see RenderBuffers) and only the buffers that changed since the
+ * previous cook are copied and uploaded again.
+ */
+App.prototype.updateMesh = function(mesh) {
+  console.log(mesh.isValid());
+  console.log(` - ${mesh.pointCount()} points`);
+  console.log(` - ${mesh.cornerCount()} corners`);
+  console.log(` - ${mesh.faceCount()} faces`);
+  console.log(` - constantFaceSize = ${mesh.constantFaceSize()}`);
+
+  const buffers = this.renderBuffers;
+  const status = buffers.update(mesh);
+  if (status != 0) {
+    console.error(`could not display mesh (status = ${status})`);
+  }
+  const changes = buffers.changes();
+  if (changes == 0) return;
+
+  const vertexCount = buffers.vertexCount();
+  const triangleCount = buffers.triangleCount();
+  const geometry = this.pointGeometry;
+  if (changes & RenderBuffersChange.positions) {
+    const positions = new HeapArray(Float32Array, buffers.positions().ptr, 3 * vertexCount);
+    setGeometryBuffer(geometry, 'position', positions.array(), 3);
+    geometry.computeBoundingSphere();
+  }
+  if (changes & RenderBuffersChange.normals) {
+    const normals = new HeapArray(Float32Array, buffers.normals().ptr, 3 * vertexCount);
+    setGeometryBuffer(geometry, 'normal', normals.array(), 3);
+  }
+  if (changes & RenderBuffersChange.indices) {
+    const indices = new HeapArray(Uint32Array, buffers.indices().ptr, 3 * triangleCount);
+    setGeometryBuffer(geometry, null, indices.array(), 1);
   }
-
-  // Update geometry
-  this.pointGeometry.setAttribute('position', new THREE.BufferAttribute(tesselatedPointPositionData, 3));
-  this.pointGeometry.setAttribute('normal', new THREE.BufferAttribute(tesselatedPointNormalData, 3));
   this.needRender = true;
 }
 
@@ -433,6 +641,13 @@ App.prototype.onRuntimeInitialized = async function(event) {
   }
 
   app.effectLibrary = new Module.EffectLibrary();
+  app.renderBuffers = new Module.RenderBuffers();
+  app.attributeStats = new Module.AttributeStats();
+
+  // Import all optional OBJ layers so that effects and the viewer can use them
+  app.objLoadOptions = new Module.ObjLoadOptions();
+  app.objLoadOptions.texCoords = true;
+  app.objLoadOptions.normals = true;
 
   this.dom.pluginInput.addEventListener('change', app.onUploadEffectLibrary);
   this.dom.effectIndex.addEventListener('change', app.onSelectEffect);
@@ -1,22 +1,18 @@
-// https://stackoverflow.com/questions/14267781/sorting-html-table-with-javascript/49041392#49041392
-
-const getCellValue = (tr, idx) => tr.children[idx].innerText || tr.children[idx].textContent;
-
-const comparer = (idx, asc) => (a, b) => ((v1, v2) => 
-    v1 !== '' && v2 !== '' && !isNaN(v1) && !isNaN(v2) ? v1 - v2 : v1.toString().localeCompare(v2)
-    )(getCellValue(asc ? a : b, idx), getCellValue(asc ? b : a, idx));
-
 function setupSpreadsheet(spreadsheet) {
-    spreadsheet.querySelectorAll('th').forEach(th => th.addEventListener('click', function() {
+    // Headers sort by the first component of their column and summaries by
+    // their own component
+    spreadsheet.querySelectorAll('th, td.spreadsheet-summary').forEach(th => th.addEventListener('click', function() {
         const table = th.closest('table');
-        const tbody = table.querySelector('tbody');
-        const columnIndex = Array.from(th.parentNode.children).indexOf(th);
-        // Sort data
-        Array.from(tbody.querySelectorAll('tr'))
-            .sort(comparer(columnIndex, this.asc = !this.asc))
-            .forEach(tr => tbody.appendChild(tr));
-        // Highlight clicked th
-        table.querySelectorAll('th').forEach(otherTh => otherTh.classList.remove("spreadsheet-active"));
+        const columnIndex = th.dataset.column !== undefined ? Number(th.dataset.column) : Array.from(th.parentNode.children).indexOf(th);
+        const component = th.dataset.component !== undefined ? Number(th.dataset.component) : 0;
+        // Sort data, on the side of the row source since only the visible
+        // rows are in the DOM
+        if (table.rowSource && table.rowSource.sort) {
+            table.rowSource.sort(columnIndex, component, this.asc = !this.asc);
+            fillSpreadsheetRows(table);
+        }
+        // Highlight the clicked cell
+        table.querySelectorAll('th, td.spreadsheet-summary').forEach(otherTh => otherTh.classList.remove("spreadsheet-active"));
         th.classList.add("spreadsheet-active");
     }));
 
@@ -98,7 +94,52 @@ function setupSpreadsheet(spreadsheet) {
     spreadsheet.classList.add('sized');
 }
 
-updateSpreadsheet = function(spreadsheet, columnDescriptions, rowCount) {
+const defaultRowHeight = 20; // in pixels, until a row is measured
+const maxRenderedRowCount = 200;
+
+function formatCellValue(value) {
+    return Number.isInteger(value) ? value : parseFloat(value.toPrecision(7));
+}
+
+/**
+ * Fill the rows present in the DOM with the rows of the source that are
+ * visible given the scroll position of the spreadsheet's viewport.
+ */
+function fillSpreadsheetRows(spreadsheet) {
+    const source = spreadsheet.rowSource;
+    const viewport = spreadsheet.closest('.spreadsheet-viewport');
+    const rows = spreadsheet.tBodies[0].rows;
+    const renderedRowCount = rows.length;
+    if (renderedRowCount == 0) return;
+    const first = Math.max(0, Math.min(
+        Math.floor(viewport.scrollTop / spreadsheet.rowHeight),
+        source.rowCount - renderedRowCount
+    ));
+    const values = source.readRows(first, renderedRowCount);
+    const rowSize = source.rowSize;
+    for (let i = 0 ; i < renderedRowCount ; ++i) {
+        const cells = rows[i].cells;
+        for (let j = 0 ; j < rowSize ; ++j) {
+            cells[j].firstChild.firstChild.textContent = formatCellValue(values[i * rowSize + j]);
+        }
+    }
+}
+
+/**
+ * Display rows of a row source in a spreadsheet, which must be a table in a
+ * div.spreadsheet-sizer in a div.spreadsheet-viewport. Only the rows that
+ * fit in the viewport are in the DOM, and they are refilled on scroll.
+ *
+ * columnDescriptions: list of { name, componentCount, summaries }, where
+ *   the optional summaries are { text, title, isWarning } for each component
+ *   and are displayed in a second header row
+ * source: {
+ *   rowCount, rowSize, // rowSize is the sum of all componentCount
+ *   readRows(first, count), // array of count * rowSize values
+ *   sort(columnIndex, component, ascending), // optional, reorders subsequent reads
+ * }
+ */
+updateSpreadsheet = function(spreadsheet, columnDescriptions, source) {
     var header = document.createElement('thead');
     const row = document.createElement('tr');
     let cell = document.createElement('th');
@@ -107,36 +148,67 @@ updateSpreadsheet = function(spreadsheet, columnDescriptions, rowCount) {
         if (i == 0) cell.className = "spreadsheet-active";
         cell.colSpan = desc.componentCount;
         cell.innerText = desc.name;
+        cell.dataset.column = i;
         row.appendChild(cell);
     });
     header.appendChild(row);
+    // Optional summary of each component, e.g. its range
+    if (columnDescriptions.some(desc => desc.summaries)) {
+        const summaryRow = document.createElement('tr');
+        columnDescriptions.forEach((desc, i) => {
+            for (let k = 0 ; k < desc.componentCount ; ++k) {
+                const summary = desc.summaries ? desc.summaries[k] : null;
+                const cell = document.createElement('td');
+                cell.className = "spreadsheet-summary";
+                cell.dataset.column = i;
+                cell.dataset.component = k;
+                if (summary) {
+                    cell.innerText = summary.text;
+                    cell.title = summary.title || summary.text;
+                    if (summary.isWarning) cell.classList.add("spreadsheet-warning");
+                }
+                summaryRow.appendChild(cell);
+            }
+        });
+        header.appendChild(summaryRow);
+    }
     var body = document.createElement('tbody');
+    spreadsheet.replaceChildren(header, body);
+    spreadsheet.rowSource = source;
 
-    let cellContent;
-    for (let i = 0 ; i < rowCount ; ++i) {
-        const row = document.createElement('tr');
-
-        columnDescriptions.forEach(desc => {
-            for (let k = 0 ; k < desc.componentCount ; ++k) {
-                cell = document.createElement('td');
-                cellContent = document.createElement('div');
+    const viewport = spreadsheet.closest('.spreadsheet-viewport');
+    const sizer = spreadsheet.parentNode;
+    const maxViewportHeight = parseFloat(getComputedStyle(viewport).maxHeight) || 400;
+    const addRows = count => {
+        for (let i = 0 ; i < count ; ++i) {
+            const row = document.createElement('tr');
+            for (let j = 0 ; j < source.rowSize ; ++j) {
+                const cell = document.createElement('td');
+                const cellContent = document.createElement('div');
                 cellContent.className = "content";
-                cellContent.innerText =
-                    desc.getData
-                    ? desc.getData(i, k)
-                    : desc.data[desc.componentCount * i + k];
-                cellContentWrapper = document.createElement('div');
+                const cellContentWrapper = document.createElement('div');
                 cellContentWrapper.className = "content-wrapper";
                 cellContentWrapper.appendChild(cellContent);
                 cell.appendChild(cellContentWrapper);
                 row.appendChild(cell);
             }
-        });
-
-        body.appendChild(row);
+            body.appendChild(row);
+        }
     }
 
-    spreadsheet.replaceChildren(header, body);
+    // Measure a row, then add as many as fit in the viewport
+    let renderedRowCount = Math.min(source.rowCount, 1);
+    addRows(renderedRowCount);
+    spreadsheet.rowHeight = renderedRowCount > 0 ? body.rows[0].getBoundingClientRect().height || defaultRowHeight : defaultRowHeight;
+    const headerHeight = header.getBoundingClientRect().height;
+    const fittingRowCount = Math.ceil((maxViewportHeight - headerHeight) / spreadsheet.rowHeight) + 1;
+    const targetRowCount = Math.min(source.rowCount, fittingRowCount, maxRenderedRowCount);
+    addRows(targetRowCount - renderedRowCount);
+
+    sizer.style.height = `${headerHeight + source.rowCount * spreadsheet.rowHeight}px`;
+    viewport.scrollTop = 0;
+    viewport.onscroll = () => fillSpreadsheetRows(spreadsheet);
+    fillSpreadsheetRows(spreadsheet);
     setupSpreadsheet(spreadsheet);
 }
 
@@ -0,0 +1,192 @@
+#include "AttributeStats.h"
+#include "Parallel.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/common/AttributeView.h>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+static const int statsBlockSize = 1 << 16; // in elements
+static const int chunkSize = 1024; // values gathered at once, multiple of laneCount
+static const int laneCount = 8;
+
+/**
+ * Statistics of part of the values of a component, before computing the
+ * mean.
+ */
+struct PartialStats {
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double sum = 0;
+  int finiteCount = 0;
+  int nanCount = 0;
+  int infCount = 0;
+
+  void merge(const PartialStats& other) {
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sum += other.sum;
+    finiteCount += other.finiteCount;
+    nanCount += other.nanCount;
+    infCount += other.infCount;
+  }
+};
+
+/**
+ * Reduce at most chunkSize contiguous values. Lane l accumulates values
+ * l, l + laneCount, etc. with selects rather than branches so that the main
+ * loop vectorizes: non finite values are replaced by neutral values before
+ * taking the min, max and sum. Sums are accumulated in double precision,
+ * and counts in T, which is exact since a lane sees at most
+ * chunkSize / laneCount values.
+ */
+template <typename T>
+static void reduceChunk(const T *values, int count, PartialStats& stats) {
+  const T infinity = std::numeric_limits<T>::infinity();
+  T lo[laneCount], hi[laneCount], nan[laneCount], nonFinite[laneCount];
+  double sum[laneCount];
+  for (int l = 0 ; l < laneCount ; ++l) {
+    lo[l] = infinity;
+    hi[l] = -infinity;
+    nan[l] = nonFinite[l] = 0;
+    sum[l] = 0;
+  }
+
+  int laneEnd = count - count % laneCount;
+  for (int i = 0 ; i < laneEnd ; i += laneCount) {
+    for (int l = 0 ; l < laneCount ; ++l) {
+      T v = values[i + l];
+      // v - v is 0 for finite values and NaN for infinite and NaN values
+      bool isFinite = v - v == 0;
+      T low = isFinite ? v : infinity;
+      T high = isFinite ? v : -infinity;
+      lo[l] = lo[l] < low ? lo[l] : low;
+      hi[l] = hi[l] > high ? hi[l] : high;
+      sum[l] += isFinite ? static_cast<double>(v) : 0.0;
+      nan[l] += v != v ? 1 : 0;
+      nonFinite[l] += isFinite ? 0 : 1;
+    }
+  }
+
+  PartialStats chunk;
+  for (int i = laneEnd ; i < count ; ++i) {
+    T v = values[i];
+    if (v != v) {
+      ++chunk.nanCount;
+    } else if (v - v != 0) {
+      ++chunk.infCount;
+    } else {
+      chunk.min = std::min(chunk.min, static_cast<double>(v));
+      chunk.max = std::max(chunk.max, static_cast<double>(v));
+      chunk.sum += v;
+    }
+  }
+  for (int l = 0 ; l < laneCount ; ++l) {
+    chunk.min = std::min(chunk.min, static_cast<double>(lo[l]));
+    chunk.max = std::max(chunk.max, static_cast<double>(hi[l]));
+    chunk.sum += sum[l];
+    chunk.nanCount += static_cast<int>(nan[l]);
+    chunk.infCount += static_cast<int>(nonFinite[l] - nan[l]);
+  }
+  chunk.finiteCount = count - chunk.nanCount - chunk.infCount;
+  stats.merge(chunk);
+}
+
+/**
+ * Reduce elements [begin, end) of a single component view of type Src,
+ * converted to T, into stats.
+ */
+template <typename Src, typename T>
+static void reduceElements(const mfx::StridedAttributeView<const Src, 1>& view, int begin, int end, PartialStats& stats) {
+  const T *direct = nullptr;
+  if (view.byteStride() == sizeof(T) && sizeof(Src) == sizeof(T)
+    && reinterpret_cast<uintptr_t>(view.bytes(0)) % alignof(T) == 0)
+  {
+    direct = reinterpret_cast<const T*>(view.bytes(0));
+  }
+
+  T buffer[chunkSize];
+  for (int chunkBegin = begin ; chunkBegin < end ; chunkBegin += chunkSize) {
+    int count = std::min(chunkSize, end - chunkBegin);
+    if (nullptr != direct) {
+      reduceChunk<T>(direct + chunkBegin, count, stats);
+      continue;
+    }
+    for (int i = 0 ; i < count ; ++i) {
+      buffer[i] = static_cast<T>(view.get(chunkBegin + i));
+    }
+    reduceChunk<T>(buffer, count, stats);
+  }
+}
+
+/**
+ * Reduce elements [begin, end) of each of the componentCount components of
+ * type Src found in data, converted to T, into stats[componentCount].
+ */
+template <typename Src, typename T>
+static void reduceComponents(const char *data, size_t byteStride, int elementCount, int componentCount, int begin, int end, PartialStats *stats) {
+  for (int k = 0 ; k < componentCount ; ++k) {
+    mfx::StridedAttributeView<const Src, 1> view(data + k * sizeof(Src), byteStride, elementCount);
+    reduceElements<Src, T>(view, begin, end, stats[k]);
+  }
+}
+
+OfxStatus AttributeStats::compute(const OfxMeshAttributePropertySet *attrib, const OfxMeshPropertySet *meshProperties) {
+  m_components.clear();
+
+  const char *data = attrib->data;
+  size_t byteStride = attrib->byte_stride;
+  if (nullptr == data
+    && 0 == strcmp(attrib->attachment, kOfxMeshAttribFace)
+    && 0 == strcmp(attrib->name, kOfxMeshAttribFaceSize)
+    && meshProperties->constant_face_size > -1)
+  {
+    data = reinterpret_cast<const char*>(&meshProperties->constant_face_size);
+    byteStride = 0;
+  }
+  if (nullptr == data) return kOfxStatErrBadHandle;
+
+  // Int32 values are not all representable as floats, unlike as doubles
+  void (*reduce)(const char*, size_t, int, int, int, int, PartialStats*) = nullptr;
+  if (0 == strcmp(attrib->type, kOfxMeshAttribTypeFloat)) {
+    reduce = reduceComponents<float, float>;
+  } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeInt)) {
+    reduce = reduceComponents<int, double>;
+  } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeUByte)) {
+    reduce = reduceComponents<unsigned char, double>;
+  } else {
+    return kOfxStatErrUnsupported;
+  }
+
+  int componentCount = attrib->component_count;
+  int elementCount = attributeElementCount(attrib, meshProperties);
+  int blockCount = (elementCount + statsBlockSize - 1) / statsBlockSize;
+  std::vector<PartialStats> blockStats(static_cast<size_t>(blockCount) * componentCount);
+  parallelFor(blockCount, [&](int block) {
+    int begin = block * statsBlockSize;
+    int end = std::min(elementCount, begin + statsBlockSize);
+    reduce(data, byteStride, elementCount, componentCount, begin, end, &blockStats[static_cast<size_t>(block) * componentCount]);
+  });
+
+  // Merge blocks in order, so that the result does not depend on threads
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  m_components.resize(componentCount);
+  for (int k = 0 ; k < componentCount ; ++k) {
+    PartialStats total;
+    for (int block = 0 ; block < blockCount ; ++block) {
+      total.merge(blockStats[static_cast<size_t>(block) * componentCount + k]);
+    }
+    ComponentStats& stats = m_components[k];
+    bool hasFinite = total.finiteCount > 0;
+    stats.min = hasFinite ? total.min : nan;
+    stats.max = hasFinite ? total.max : nan;
+    stats.mean = hasFinite ? total.sum / total.finiteCount : nan;
+    stats.finiteCount = total.finiteCount;
+    stats.nanCount = total.nanCount;
+    stats.infCount = total.infCount;
+  }
+  return kOfxStatOK;
+}
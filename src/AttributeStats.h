@@ -0,0 +1,53 @@
+#ifndef _AttributeStats_h_
+#define _AttributeStats_h_
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <vector>
+
+class Attribute;
+
+/**
+ * Per component statistics of an attribute: range, mean and number of NaN
+ * and infinite values, e.g. to spot the zero-length normals of degenerate
+ * faces without scrolling through all elements.
+ *
+ * Values are read in a single pass, by blocks on all threads. Each block
+ * gathers a component into a contiguous buffer and reduces it with
+ * branchless per lane accumulators, which compilers turn into SIMD code.
+ */
+class AttributeStats {
+public:
+  OfxStatus compute(const OfxMeshAttributePropertySet *attrib, const OfxMeshPropertySet *meshProperties);
+  // Defined along with the JavaScript bindings
+  OfxStatus compute(const Attribute *attribute);
+
+  int componentCount() const { return static_cast<int>(m_components.size()); }
+
+  // Range and mean of the finite values, NaN if there is none
+  double min(int component) const { return m_components[component].min; }
+  double max(int component) const { return m_components[component].max; }
+  double mean(int component) const { return m_components[component].mean; }
+  int finiteCount(int component) const { return m_components[component].finiteCount; }
+  int nanCount(int component) const { return m_components[component].nanCount; }
+  int infCount(int component) const { return m_components[component].infCount; }
+
+private:
+  struct ComponentStats {
+    double min;
+    double max;
+    double mean;
+    int finiteCount;
+    int nanCount;
+    int infCount;
+  };
+
+private:
+  std::vector<ComponentStats> m_components;
+};
+
+#endif // _AttributeStats_h_
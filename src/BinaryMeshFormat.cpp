@@ -0,0 +1,186 @@
+#include "BinaryMeshFormat.h"
+#include "Blob.h"
+#include "BufferedWriter.h"
+
+extern "C" {
+#include <host/meshEffectSuite.h>
+#include <common/common.h> // for MFX_ENSURE
+}
+
+#include <cpp/host/attribute.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static uint64_t alignOffset(uint64_t offset) {
+  const uint64_t alignment = WEBMFX_BINARY_MESH_ALIGNMENT;
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+static void copyString(char *dst, const char *src, size_t size) {
+  strncpy(dst, src, size);
+  dst[size - 1] = '\0';
+}
+
+OfxStatus saveBinaryMesh(const char *filename, const OfxMeshStruct *mesh) {
+  const OfxMeshPropertySet& props = mesh->properties;
+
+  int attributeCount = 0;
+  while (attributeCount < 32 && mesh->attributes[attributeCount].is_valid) ++attributeCount;
+
+  BinaryMeshHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, WEBMFX_BINARY_MESH_MAGIC, sizeof(header.magic));
+  header.version = WEBMFX_BINARY_MESH_VERSION;
+  header.attribute_count = attributeCount;
+  header.point_count = props.point_count;
+  header.corner_count = props.corner_count;
+  header.face_count = props.face_count;
+  header.constant_face_size = props.constant_face_size;
+
+  // Lay out the payloads
+  std::vector<BinaryMeshAttribute> table(attributeCount);
+  uint64_t offset = sizeof(BinaryMeshHeader) + attributeCount * sizeof(BinaryMeshAttribute);
+  for (int i = 0 ; i < attributeCount ; ++i) {
+    const OfxMeshAttributePropertySet& attrib = mesh->attributes[i];
+    BinaryMeshAttribute& entry = table[i];
+    memset(&entry, 0, sizeof(entry));
+    copyString(entry.attachment, attrib.attachment, sizeof(entry.attachment));
+    copyString(entry.name, attrib.name, sizeof(entry.name));
+    copyString(entry.type, attrib.type, sizeof(entry.type));
+    copyString(entry.semantic, attrib.semantic, sizeof(entry.semantic));
+    entry.component_count = attrib.component_count;
+
+    size_t elementSize = attrib.component_count * attributeComponentSize(attrib.type);
+    if (elementSize == 0) {
+      printf("Error: cannot save attribute %s of unknown type %s\n", attrib.name, attrib.type);
+      return kOfxStatErrUnsupported;
+    }
+    if (nullptr == attrib.data) continue; // e.g. face sizes when they are constant
+
+    size_t elementCount = attrib.byte_stride == 0 ? 1 : attributeElementCount(&attrib, &props);
+    entry.byte_stride = attrib.byte_stride == 0 ? 0 : static_cast<uint32_t>(elementSize);
+    entry.size = elementCount * elementSize;
+    if (entry.size == 0) continue;
+    entry.offset = offset = alignOffset(offset);
+    offset += entry.size;
+  }
+
+  BufferedWriter writer;
+  if (!writer.open(filename)) {
+    printf("Error: could not open file for writing: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+
+  writer.write(&header, sizeof(header));
+  writer.write(table.data(), attributeCount * sizeof(BinaryMeshAttribute));
+  uint64_t position = sizeof(BinaryMeshHeader) + attributeCount * sizeof(BinaryMeshAttribute);
+  for (int i = 0 ; i < attributeCount ; ++i) {
+    const BinaryMeshAttribute& entry = table[i];
+    if (entry.offset == 0) continue;
+    writer.pad(entry.offset - position);
+    auto view = mfx::makeByteView(mesh, &mesh->attributes[i]);
+    size_t elementSize = mesh->attributes[i].component_count * attributeComponentSize(entry.type);
+    if (view.byteStride() == elementSize) {
+      writer.write(view.bytes(0), entry.size);
+    } else {
+      for (size_t k = 0 ; k < entry.size / elementSize ; ++k) {
+        writer.write(view.bytes(k), elementSize);
+      }
+    }
+    position = entry.offset + entry.size;
+  }
+
+  if (!writer.close()) {
+    printf("Error: could not write binary mesh file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus loadBinaryMesh(Blob& blob, OfxMeshStruct *mesh) {
+  if (blob.size() < sizeof(BinaryMeshHeader)) {
+    printf("Error: binary mesh file is too small\n");
+    return kOfxStatErrFormat;
+  }
+
+  BinaryMeshHeader header;
+  memcpy(&header, blob.data(), sizeof(header));
+  if (0 != memcmp(header.magic, WEBMFX_BINARY_MESH_MAGIC, sizeof(header.magic))) {
+    printf("Error: not a WebMfx binary mesh file\n");
+    return kOfxStatErrFormat;
+  }
+  if (header.version != WEBMFX_BINARY_MESH_VERSION) {
+    printf("Error: unsupported binary mesh version %u\n", header.version);
+    return kOfxStatErrUnsupported;
+  }
+  uint64_t tableEnd = sizeof(BinaryMeshHeader) + static_cast<uint64_t>(header.attribute_count) * sizeof(BinaryMeshAttribute);
+  if (header.attribute_count > 32 || tableEnd > blob.size()) {
+    printf("Error: invalid binary mesh attribute table\n");
+    return kOfxStatErrFormat;
+  }
+  if (header.point_count < 0 || header.corner_count < 0 || header.face_count < 0) {
+    printf("Error: invalid binary mesh element counts\n");
+    return kOfxStatErrFormat;
+  }
+
+  OfxMeshPropertySet& props = mesh->properties;
+  props.point_count = header.point_count;
+  props.corner_count = header.corner_count;
+  props.face_count = header.face_count;
+  props.constant_face_size = header.constant_face_size;
+
+  for (uint32_t i = 0 ; i < header.attribute_count ; ++i) {
+    BinaryMeshAttribute entry;
+    memcpy(&entry, blob.data() + sizeof(BinaryMeshHeader) + i * sizeof(BinaryMeshAttribute), sizeof(entry));
+    entry.attachment[63] = entry.name[63] = entry.type[63] = entry.semantic[63] = '\0';
+
+    OfxMeshAttributePropertySet *attrib;
+    MFX_ENSURE(attributeDefine(mesh,
+                               entry.attachment,
+                               entry.name,
+                               entry.component_count,
+                               entry.type,
+                               entry.semantic,
+                               (OfxPropertySetHandle*)&attrib));
+    attrib->is_owner = 0;
+    attrib->byte_stride = entry.byte_stride;
+    attrib->data = nullptr;
+    if (entry.offset == 0) continue;
+
+    // Checks are written so that no sum nor product can wrap around
+    size_t componentSize = attributeComponentSize(entry.type);
+    uint64_t elementSize = entry.component_count > 0 ? entry.component_count * componentSize : 0;
+    uint64_t elementCount = entry.byte_stride == 0 ? 1 : attributeElementCount(attrib, &props);
+    if (elementSize == 0
+      || (entry.byte_stride != 0 && entry.byte_stride != elementSize)
+      || elementCount > blob.size() / elementSize
+      || entry.size < elementSize * elementCount
+      || entry.offset < tableEnd
+      || entry.offset > blob.size()
+      || entry.size > blob.size() - entry.offset)
+    {
+      printf("Error: invalid payload for binary mesh attribute %s\n", entry.name);
+      return kOfxStatErrFormat;
+    }
+    uint64_t expectedSize = elementSize * elementCount;
+
+    char *payload = blob.data() + entry.offset;
+    if (reinterpret_cast<uintptr_t>(payload) % componentSize == 0) {
+      attrib->data = payload;
+    } else {
+      // Files written by saveBinaryMesh() are always aligned, others may not
+      // be viewed in place.
+      attrib->data = static_cast<char*>(malloc(expectedSize > 0 ? expectedSize : 1));
+      if (nullptr == attrib->data) {
+        return kOfxStatErrMemory;
+      }
+      memcpy(attrib->data, payload, expectedSize);
+      attrib->is_owner = 1;
+    }
+  }
+
+  return kOfxStatOK;
+}
@@ -0,0 +1,69 @@
+#ifndef _BinaryMeshFormat_h_
+#define _BinaryMeshFormat_h_
+
+/**
+ * WebMfx binary mesh format, a direct image of OfxMeshStruct that loads
+ * without any parsing nor copy:
+ *
+ *   BinaryMeshHeader
+ *   BinaryMeshAttribute[attribute_count]
+ *   attribute payloads, each one starting at a multiple of 64 bytes
+ *
+ * Integers are stored little endian, like in memory on all the platforms
+ * we target. Payloads are tightly packed, except for attributes that had a
+ * byte_stride of 0 (one value shared by all elements), which store a single
+ * element and keep their stride of 0.
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <cstdint>
+
+class Blob;
+
+#define WEBMFX_BINARY_MESH_MAGIC "WEBMFXMB"
+#define WEBMFX_BINARY_MESH_VERSION 1
+#define WEBMFX_BINARY_MESH_ALIGNMENT 64
+
+struct BinaryMeshHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t attribute_count;
+  int32_t point_count;
+  int32_t corner_count;
+  int32_t face_count;
+  int32_t constant_face_size;
+};
+
+struct BinaryMeshAttribute {
+  char attachment[64];
+  char name[64];
+  char type[64];
+  char semantic[64];
+  int32_t component_count;
+  uint32_t byte_stride; // stride of the payload, either 0 or the element size
+  uint64_t offset; // from the beginning of the file, 0 when there is no data
+  uint64_t size; // size of the payload in bytes
+};
+
+static_assert(sizeof(BinaryMeshHeader) == 32, "BinaryMeshHeader must not be padded");
+static_assert(sizeof(BinaryMeshAttribute) == 280, "BinaryMeshAttribute must not be padded");
+
+/**
+ * Write all the attributes of the mesh to a file, whatever their stride.
+ */
+OfxStatus saveBinaryMesh(const char *filename, const OfxMeshStruct *mesh);
+
+/**
+ * Define the attributes of a mesh initialized with meshInit() from the
+ * content of a binary mesh file. Attributes are not owned by the mesh, they
+ * point directly into the blob, unless their payload is not aligned on their
+ * component size, in which case it is copied.
+ */
+OfxStatus loadBinaryMesh(Blob& blob, OfxMeshStruct *mesh);
+
+#endif // _BinaryMeshFormat_h_
@@ -0,0 +1,96 @@
+#include "Blob.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(__EMSCRIPTEN__) && (defined(__unix__) || defined(__APPLE__))
+#define WEBMFX_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static char* allocateAligned(size_t size) {
+  if (size > SIZE_MAX - 63) return nullptr;
+  // aligned_alloc requires the size to be a multiple of the alignment
+  size_t alignedSize = (size + 63) & ~static_cast<size_t>(63);
+  return static_cast<char*>(aligned_alloc(64, alignedSize > 0 ? alignedSize : 64));
+}
+
+Blob::~Blob() {
+  for (char *allocation : m_allocations) {
+    free(allocation);
+  }
+#ifdef WEBMFX_USE_MMAP
+  if (m_isMapped) {
+    munmap(m_data, m_size);
+    return;
+  }
+#endif
+  free(m_data);
+}
+
+std::unique_ptr<Blob> Blob::fromFile(const char *filename) {
+  std::unique_ptr<Blob> blob(new Blob());
+
+#ifdef WEBMFX_USE_MMAP
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  blob->m_size = static_cast<size_t>(st.st_size);
+  if (blob->m_size > 0) {
+    void *address = mmap(nullptr, blob->m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      blob->m_data = static_cast<char*>(address);
+      blob->m_isMapped = true;
+    }
+  }
+  close(fd);
+  if (blob->m_isMapped || blob->m_size == 0) return blob;
+  // otherwise fall back to reading the file
+#endif
+
+  FILE *file = fopen(filename, "rb");
+  if (nullptr == file) return nullptr;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(file);
+    return nullptr;
+  }
+  blob->m_size = static_cast<size_t>(size);
+  blob->m_data = allocateAligned(blob->m_size);
+  if (nullptr == blob->m_data) {
+    fclose(file);
+    return nullptr;
+  }
+  size_t readSize = fread(blob->m_data, 1, blob->m_size, file);
+  fclose(file);
+  if (readSize != blob->m_size) return nullptr;
+  return blob;
+}
+
+std::unique_ptr<Blob> Blob::fromMemory(const void *data, size_t size) {
+  std::unique_ptr<Blob> blob(new Blob());
+  blob->m_size = size;
+  blob->m_data = allocateAligned(size);
+  if (nullptr == blob->m_data) return nullptr;
+  memcpy(blob->m_data, data, size);
+  return blob;
+}
+
+char* Blob::allocate(size_t size) {
+  char *allocation = allocateAligned(size);
+  if (nullptr != allocation) {
+    m_allocations.push_back(allocation);
+  }
+  return allocation;
+}
@@ -0,0 +1,46 @@
+#ifndef _Blob_h_
+#define _Blob_h_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * Raw bytes backing the attributes of a mesh loaded from a binary file.
+ * Attributes point directly into it (with is_owner = 0), so it must outlive
+ * the mesh. Native builds memory map files (privately, so that writes to the
+ * attributes never reach the file), WebAssembly builds read them at once
+ * into a single 64-byte aligned allocation.
+ */
+class Blob {
+public:
+  ~Blob();
+  Blob(const Blob&) = delete;
+  Blob& operator=(const Blob&) = delete;
+
+  // Return nullptr if the file cannot be read
+  static std::unique_ptr<Blob> fromFile(const char *filename);
+  // Copy data into a new allocation, or return nullptr if it fails
+  static std::unique_ptr<Blob> fromMemory(const void *data, size_t size);
+
+  /**
+   * Extra 64-byte aligned storage that lives as long as the blob, e.g. for
+   * an aligned copy of a part of the file. Return nullptr if it fails.
+   */
+  char* allocate(size_t size);
+
+  char* data() { return m_data; }
+  const char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  Blob() {}
+
+private:
+  char *m_data = nullptr;
+  size_t m_size = 0;
+  bool m_isMapped = false;
+  std::vector<char*> m_allocations; // see allocate()
+};
+
+#endif // _Blob_h_
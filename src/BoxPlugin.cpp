@@ -1,13 +1,16 @@
 #include "openmfx-sdk/c/common/common.h" // for MFX_ENSURE
-#include "openmfx-sdk/c/plugin/attribute.h" // for MfxAttributeProperties and mfxPullAttributeProperties
+#include "openmfx-sdk/cpp/plugin/attribute.h" // for MfxAttributeProperties and mfx::visitAttributeView
+extern "C" {
+#include "openmfx-sdk/c/plugin/mesh.h" // for MfxMeshProperties and mfxPushMeshProperties
+}
 
 #include <ofxCore.h>
 #include <ofxMeshEffect.h>
 #include <ofxProperty.h>
 #include <ofxParam.h>
 
-#include <string.h>
-#include <stdio.h>
+#include <cstring>
+#include <cstdio>
 
 /*****************************************/
 
@@ -16,13 +19,13 @@ const OfxPropertySuiteV1 *propertySuite;
 const OfxParameterSuiteV1 *parameterSuite;
 
 static void setHost(OfxHost *host) {
-	meshEffectSuite = host->fetchSuite(
+	meshEffectSuite = static_cast<const OfxMeshEffectSuiteV1*>(host->fetchSuite(
 	    host->host, // host properties, might be useful to the host's internals
 	    kOfxMeshEffectSuite, // name of the suite we want to fetch
 	    1 // version of the suite
-	);
-	propertySuite = host->fetchSuite(host->host, kOfxPropertySuite, 1);
-	parameterSuite = host->fetchSuite(host->host, kOfxParameterSuite, 1);
+	));
+	propertySuite = static_cast<const OfxPropertySuiteV1*>(host->fetchSuite(host->host, kOfxPropertySuite, 1));
+	parameterSuite = static_cast<const OfxParameterSuiteV1*>(host->fetchSuite(host->host, kOfxParameterSuite, 1));
 }
 
 static OfxStatus load() {
@@ -67,13 +70,16 @@ static OfxStatus getDoubleParameterValue(OfxParamSetHandle parameters, const cha
     return kOfxStatOK;
 }
 
-static OfxStatus cook(OfxMeshEffectHandle instance) {
+static OfxStatus cook(OfxMeshEffectHandle instance, OfxPropertySetHandle inArgs) {
     OfxMeshInputHandle output;
     MFX_ENSURE(meshEffectSuite->inputGetHandle(instance, kOfxMeshMainOutput, &output, NULL));
 
     OfxMeshHandle output_mesh;
     OfxPropertySetHandle output_mesh_props;
     OfxTime time = 0.0;
+    if (NULL != inArgs) {
+        MFX_ENSURE(propertySuite->propGetDouble(inArgs, kOfxPropTime, 0, &time));
+    }
     MFX_ENSURE(meshEffectSuite->inputGetMesh(output, time, &output_mesh, &output_mesh_props));
 
     OfxParamSetHandle parameters;
@@ -87,10 +93,12 @@ static OfxStatus cook(OfxMeshEffectHandle instance) {
     int output_point_count = 8;
     int output_face_count = 6;
     int output_corner_count = 4 * output_face_count;
-    MFX_ENSURE(propertySuite->propSetInt(output_mesh_props, kOfxMeshPropPointCount, 0, output_point_count));
-    MFX_ENSURE(propertySuite->propSetInt(output_mesh_props, kOfxMeshPropCornerCount, 0, output_corner_count));
-    MFX_ENSURE(propertySuite->propSetInt(output_mesh_props, kOfxMeshPropFaceCount, 0, output_face_count));
-    MFX_ENSURE(propertySuite->propSetInt(output_mesh_props, kOfxMeshPropConstantFaceSize, 0, 4));
+    MfxMeshProperties output_props;
+    output_props.point_count = output_point_count;
+    output_props.corner_count = output_corner_count;
+    output_props.face_count = output_face_count;
+    output_props.constant_face_size = 4;
+    MFX_ENSURE(mfxPushMeshProperties(propertySuite, meshEffectSuite, output_mesh, &output_props));
 
     OfxPropertySetHandle
         output_point_position_attrib,
@@ -121,13 +129,15 @@ static OfxStatus cook(OfxMeshEffectHandle instance) {
 
     MfxAttributeProperties output_point_position_props;
     MFX_ENSURE(mfxPullAttributeProperties(propertySuite, output_point_position_attrib, &output_point_position_props));
-    for (int i = 0 ; i < output_point_count ; ++i) {
-        float *P = (float*)(output_point_position_props.data + output_point_position_props.byte_stride * i);
-        for (int k = 0 ; k < 3 ; ++k) {
-            int sign = (i >> k) % 2;
-            P[k] = (sign - 0.5f) * dimensions[k];
+    mfx::visitAttributeView<float, 3>(output_point_position_props, output_point_count, [&](auto positions) {
+        for (int i = 0 ; i < output_point_count ; ++i) {
+            float *P = positions[i];
+            for (int k = 0 ; k < 3 ; ++k) {
+                int sign = (i >> k) % 2;
+                P[k] = (sign - 0.5f) * dimensions[k];
+            }
         }
-    }
+    });
 
     MFX_ENSURE(meshEffectSuite->inputReleaseMesh(output_mesh));
     return kOfxStatReplyDefault;
@@ -153,7 +163,7 @@ static OfxStatus mainEntry(const char *action,
         return destroyInstance((OfxMeshEffectHandle)handle);
     }
     if (0 == strcmp(action, kOfxMeshEffectActionCook)) {
-        return cook((OfxMeshEffectHandle)handle);
+        return cook((OfxMeshEffectHandle)handle, inArgs);
     }
     return kOfxStatReplyDefault; // this means "unhandled action"
 }
@@ -0,0 +1,76 @@
+#include "BufferedWriter.h"
+
+#include <cstdlib>
+#include <charconv>
+
+BufferedWriter::BufferedWriter(size_t bufferSize)
+  : m_buffer(static_cast<char*>(malloc(bufferSize)))
+  , m_capacity(bufferSize)
+{
+  if (nullptr == m_buffer) {
+    m_capacity = 0;
+    m_failed = true;
+  }
+}
+
+BufferedWriter::~BufferedWriter() {
+  close();
+  free(m_buffer);
+}
+
+bool BufferedWriter::open(const char *filename) {
+  close();
+  m_file = fopen(filename, "wb");
+  m_failed = nullptr == m_file || nullptr == m_buffer;
+  if (nullptr != m_file) {
+    setvbuf(m_file, nullptr, _IONBF, 0); // we already buffer
+  }
+  return !m_failed;
+}
+
+void BufferedWriter::pad(size_t size) {
+  static const char zeros[64] = {0};
+  for (; size > sizeof(zeros) ; size -= sizeof(zeros)) write(zeros, sizeof(zeros));
+  write(zeros, size);
+}
+
+bool BufferedWriter::close() {
+  if (nullptr == m_file) return !m_failed;
+  flush();
+  m_failed = 0 != fclose(m_file) || m_failed;
+  m_file = nullptr;
+  return !m_failed;
+}
+
+void BufferedWriter::flush() {
+  writeThrough(m_buffer, m_size);
+  m_size = 0;
+}
+
+void BufferedWriter::writeThrough(const void *data, size_t size) {
+  if (nullptr == m_file || m_failed || size == 0) return;
+  m_failed = fwrite(data, 1, size, m_file) != size;
+}
+
+//--------------------------------------------------------
+
+void TextBuffer::append(const char *str) {
+  size_t length = strlen(str);
+  size_t offset = m_text.size();
+  if (!m_text.resize(offset + length)) return;
+  memcpy(m_text.data() + offset, str, length);
+}
+
+void TextBuffer::appendFloat(float value) {
+  size_t offset = m_text.size();
+  if (!m_text.resize(offset + 32)) return;
+  std::to_chars_result result = std::to_chars(m_text.data() + offset, m_text.data() + offset + 32, value);
+  m_text.resize(result.ptr - m_text.data());
+}
+
+void TextBuffer::appendInt(int value) {
+  size_t offset = m_text.size();
+  if (!m_text.resize(offset + 16)) return;
+  std::to_chars_result result = std::to_chars(m_text.data() + offset, m_text.data() + offset + 16, value);
+  m_text.resize(result.ptr - m_text.data());
+}
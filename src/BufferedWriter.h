@@ -0,0 +1,81 @@
+#ifndef _BufferedWriter_h_
+#define _BufferedWriter_h_
+
+#include "GrowableBuffer.h"
+
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * Write a file through a single large buffer, so that exporters can emit
+ * small pieces (one vertex record, one line) without paying for a call to
+ * fwrite() each time. Errors are sticky and reported by close().
+ */
+class BufferedWriter {
+public:
+  BufferedWriter(size_t bufferSize = 1 << 22);
+  ~BufferedWriter();
+  BufferedWriter(const BufferedWriter&) = delete;
+  BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+  bool open(const char *filename);
+
+  void write(const void *data, size_t size) {
+    if (m_size + size > m_capacity) {
+      flush();
+      if (size > m_capacity) { // too large to be worth buffering
+        writeThrough(data, size);
+        return;
+      }
+    }
+    memcpy(m_buffer + m_size, data, size);
+    m_size += size;
+  }
+
+  void writeString(const char *str) { write(str, strlen(str)); }
+
+  // Write size zero bytes
+  void pad(size_t size);
+
+  /**
+   * Flush the buffer and close the file, return false if the file could
+   * not be opened or if any write failed.
+   */
+  bool close();
+
+private:
+  void flush();
+  void writeThrough(const void *data, size_t size);
+
+private:
+  FILE *m_file = nullptr;
+  char *m_buffer;
+  size_t m_size = 0;
+  size_t m_capacity;
+  bool m_failed = false;
+};
+
+/**
+ * In-memory text, used to format parts of text files concurrently before
+ * writing them in order. Text that could not be appended for lack of memory
+ * is dropped and reported by failed() until the next clear().
+ */
+class TextBuffer {
+public:
+  void clear() { m_text.clear(); }
+  const char* data() const { return m_text.data(); }
+  size_t size() const { return m_text.size(); }
+  bool failed() const { return m_text.failed(); }
+
+  void append(char c) { m_text.push_back(c); }
+  void append(const char *str);
+  // Shortest representation that reads back to the same float
+  void appendFloat(float value);
+  void appendInt(int value);
+
+private:
+  GrowableBuffer<char> m_text;
+};
+
+#endif // _BufferedWriter_h_
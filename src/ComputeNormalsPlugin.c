@@ -1,6 +1,7 @@
 #include "openmfx-sdk/c/common/common.h" // for MFX_ENSURE
 #include "openmfx-sdk/c/plugin/attribute.h" // for MfxAttributeProperties and mfxPullAttributeProperties
 #include "openmfx-sdk/c/plugin/mesh.h" // for MfxMeshProperties and mfxPullMeshProperties
+#include "openmfx-sdk/c/plugin/meshView.h" // for MfxMeshView and mfxPullMeshView
 
 #include <ofxCore.h>
 #include <ofxMeshEffect.h>
@@ -9,13 +10,30 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Loops over elements run in parallel when the plugin is built with OpenMP
+// (which is the case of the native build when available) and serially
+// otherwise, e.g. in the WebAssembly build. Small meshes are not worth waking
+// up the thread team for.
+#ifdef _OPENMP
+#define PRAGMA(x) _Pragma(#x)
+#define PARALLEL_FOR(count) PRAGMA(omp parallel for schedule(static) if((count) > 4096))
+#else
+#define PARALLEL_FOR(count)
+#endif
+
 /*****************************************/
 
 const OfxMeshEffectSuiteV1 *meshEffectSuite;
 const OfxPropertySuiteV1 *propertySuite;
 const OfxParameterSuiteV1 *parameterSuite;
+const MfxMeshViewSuiteV1 *meshViewSuite; // optional, NULL on hosts other than WebMfx
 
 static void setHost(OfxHost *host) {
 	meshEffectSuite = host->fetchSuite(
@@ -25,6 +43,7 @@ static void setHost(OfxHost *host) {
 	);
 	propertySuite = host->fetchSuite(host->host, kOfxPropertySuite, 1);
 	parameterSuite = host->fetchSuite(host->host, kOfxParameterSuite, 1);
+	meshViewSuite = host->fetchSuite(host->host, kMfxMeshViewSuite, 1);
 }
 
 static OfxStatus load() {
@@ -50,6 +69,18 @@ static OfxStatus describe(OfxMeshEffectHandle descriptor) {
 	OfxPropertySetHandle outputProperties;
 	meshEffectSuite->inputDefine(descriptor, kOfxMeshMainOutput, &output, &outputProperties);
 	propertySuite->propSetString(outputProperties, kOfxPropLabel, 0, "Output");
+
+    OfxParamSetHandle parameters;
+    meshEffectSuite->getParamSet(descriptor, &parameters);
+    // 0: face normals, 1: point normals, 2: corner normals
+    parameterSuite->paramDefine(parameters, kOfxParamTypeInteger, "mode", NULL);
+    // 0: uniform, 1: area, 2: angle (ignored in face mode)
+    parameterSuite->paramDefine(parameters, kOfxParamTypeInteger, "weighting", NULL);
+    // Maximum angle in degrees between two faces for them to share a corner normal (30 by default)
+    parameterSuite->paramDefine(parameters, kOfxParamTypeDouble, "angle", NULL);
+    OfxParamHandle angle;
+    MFX_ENSURE(parameterSuite->paramGetHandle(parameters, "angle", &angle, NULL));
+    MFX_ENSURE(parameterSuite->paramSetValue(angle, 30.0));
     return kOfxStatOK;
 }
 
@@ -61,24 +92,12 @@ static OfxStatus destroyInstance(OfxMeshEffectHandle instance) {
     return kOfxStatReplyDefault;
 }
 
-static void cross_product(const float a[3], const float b[3], float out[3]) {
-    out[0] = a[1] * b[2] - a[2] * b[1];
-    out[1] = a[2] * b[0] - a[0] * b[2];
-    out[2] = a[0] * b[1] - a[1] * b[0];
-}
-
 static void copy_v3(const float a[3], float out[3]) {
     out[0] = a[0];
     out[1] = a[1];
     out[2] = a[2];
 }
 
-static void add_v3(float inout[3], const float a[3]) {
-    inout[0] += a[0];
-    inout[1] += a[1];
-    inout[2] += a[2];
-}
-
 static void sub_v3_v3(const float a[3], const float b[3], float out[3]) {
     out[0] = a[0] - b[0];
     out[1] = a[1] - b[1];
@@ -89,168 +108,440 @@ static float dot_product(const float a[3], const float b[3]) {
     return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
 }
 
-static void normalize_v3(float inout[3]) {
-    float normalizer = 1.0f / sqrt(dot_product(inout, inout));
-    inout[0] *= normalizer;
-    inout[1] *= normalizer;
-    inout[2] *= normalizer;
+/**
+ * Leaves degenerate vectors to zero instead of producing NaNs, and returns
+ * the original length.
+ */
+static float normalize_v3(float inout[3]) {
+    float length = sqrtf(dot_product(inout, inout));
+    if (length > 0.0f) {
+        float normalizer = 1.0f / length;
+        inout[0] *= normalizer;
+        inout[1] *= normalizer;
+        inout[2] *= normalizer;
+    }
+    return length;
+}
+
+static float angle_v3_v3(const float a[3], const float b[3]) {
+    float denominator = sqrtf(dot_product(a, a) * dot_product(b, b));
+    if (denominator == 0.0f) return 0.0f;
+    float cosine = dot_product(a, b) / denominator;
+    if (cosine > 1.0f) cosine = 1.0f;
+    if (cosine < -1.0f) cosine = -1.0f;
+    return acosf(cosine);
+}
+
+typedef enum NormalMode {
+    NORMAL_MODE_FACE = 0,
+    NORMAL_MODE_POINT = 1,
+    NORMAL_MODE_CORNER = 2,
+} NormalMode;
+
+typedef enum NormalWeighting {
+    NORMAL_WEIGHTING_UNIFORM = 0,
+    NORMAL_WEIGHTING_AREA = 1,
+    NORMAL_WEIGHTING_ANGLE = 2,
+} NormalWeighting;
+
+static OfxStatus getDoubleParameterValue(OfxParamSetHandle parameters, const char* name, double *value) {
+    OfxParamHandle param;
+    MFX_ENSURE(parameterSuite->paramGetHandle(parameters, name, &param, NULL));
+    MFX_ENSURE(parameterSuite->paramGetValue(param, value));
+    return kOfxStatOK;
+}
+
+static OfxStatus getIntParameterValue(OfxParamSetHandle parameters, const char* name, int *value) {
+    OfxParamHandle param;
+    MFX_ENSURE(parameterSuite->paramGetHandle(parameters, name, &param, NULL));
+    MFX_ENSURE(parameterSuite->paramGetValue(param, value));
+    return kOfxStatOK;
+}
+
+#define ATTRIB_AT(props, type, index) ((type*)((char*)(props).data + (props).byte_stride * (size_t)(index)))
+
+/**
+ * Temporary buffers shared by the point and corner modes. Faces are first
+ * processed independently (in parallel), then each point gathers the
+ * contribution of its adjacent corners, so that there is never any concurrent
+ * write to the same normal.
+ */
+typedef struct NormalContext {
+    int point_count;
+    int corner_count;
+    int face_count;
+    float *face_normals; // unit normal of each face
+    int *face_offsets; // index of the first corner of each face, face_count + 1 entries
+    int *corner_face; // face of each corner
+    float *corner_weights; // contribution of each corner to the normal of its point
+    int *point_offsets; // point_count + 1 entries indexing point_corners
+    int *point_corners; // corners grouped by point
+} NormalContext;
+
+static void freeNormalContext(NormalContext *ctx) {
+    free(ctx->face_normals);
+    free(ctx->face_offsets);
+    free(ctx->corner_face);
+    free(ctx->corner_weights);
+    free(ctx->point_offsets);
+    free(ctx->point_corners);
+}
+
+/**
+ * Compute the normal of each face and, unless with_corners is 0, the face
+ * and weight of each corner.
+ */
+static OfxStatus computeFaceNormals(NormalContext *ctx,
+                                    const MfxAttributeDescriptor *point_position_props,
+                                    const MfxAttributeDescriptor *corner_point_props,
+                                    const MfxAttributeDescriptor *face_size_props,
+                                    int with_corners,
+                                    NormalWeighting weighting)
+{
+    int face_count = ctx->face_count;
+
+    ctx->face_normals = malloc(3 * sizeof(float) * (size_t)face_count);
+    ctx->face_offsets = malloc(sizeof(int) * ((size_t)face_count + 1));
+    if (NULL == ctx->face_normals || NULL == ctx->face_offsets) {
+        return kOfxStatErrMemory;
+    }
+    if (with_corners) {
+        ctx->corner_face = malloc(sizeof(int) * (size_t)ctx->corner_count);
+        ctx->corner_weights = malloc(sizeof(float) * (size_t)ctx->corner_count);
+        if (NULL == ctx->corner_face || NULL == ctx->corner_weights) {
+            return kOfxStatErrMemory;
+        }
+    }
+
+    // Prefix sum of face sizes, so that faces can then be processed independently
+    ctx->face_offsets[0] = 0;
+    for (int face = 0 ; face < face_count ; ++face) {
+        ctx->face_offsets[face + 1] = ctx->face_offsets[face] + *ATTRIB_AT(*face_size_props, int, face);
+    }
+
+    PARALLEL_FOR(face_count)
+    for (int face = 0 ; face < face_count ; ++face) {
+        int first = ctx->face_offsets[face];
+        int size = ctx->face_offsets[face + 1] - first;
+        float *normal = ctx->face_normals + 3 * face;
+
+        // Newell's method, robust to non planar and concave faces. The length
+        // of the resulting vector is twice the area of the face.
+        normal[0] = normal[1] = normal[2] = 0.0f;
+        for (int i = 0 ; i < size ; ++i) {
+            int point = *ATTRIB_AT(*corner_point_props, int, first + i);
+            int next_point = *ATTRIB_AT(*corner_point_props, int, first + (i + 1) % size);
+            const float *P = ATTRIB_AT(*point_position_props, float, point);
+            const float *Q = ATTRIB_AT(*point_position_props, float, next_point);
+            normal[0] += (P[1] - Q[1]) * (P[2] + Q[2]);
+            normal[1] += (P[2] - Q[2]) * (P[0] + Q[0]);
+            normal[2] += (P[0] - Q[0]) * (P[1] + Q[1]);
+        }
+        float area = 0.5f * normalize_v3(normal);
+
+        if (!with_corners) continue;
+        for (int i = 0 ; i < size ; ++i) {
+            int corner = first + i;
+            ctx->corner_face[corner] = face;
+            switch (weighting) {
+            case NORMAL_WEIGHTING_AREA:
+                ctx->corner_weights[corner] = area;
+                break;
+            case NORMAL_WEIGHTING_ANGLE:
+            {
+                int point = *ATTRIB_AT(*corner_point_props, int, corner);
+                int prev_point = *ATTRIB_AT(*corner_point_props, int, first + (i + size - 1) % size);
+                int next_point = *ATTRIB_AT(*corner_point_props, int, first + (i + 1) % size);
+                const float *P = ATTRIB_AT(*point_position_props, float, point);
+                float A[3], B[3];
+                sub_v3_v3(ATTRIB_AT(*point_position_props, float, prev_point), P, A);
+                sub_v3_v3(ATTRIB_AT(*point_position_props, float, next_point), P, B);
+                ctx->corner_weights[corner] = angle_v3_v3(A, B);
+                break;
+            }
+            case NORMAL_WEIGHTING_UNIFORM:
+            default:
+                ctx->corner_weights[corner] = 1.0f;
+                break;
+            }
+        }
+    }
+
+    return kOfxStatOK;
 }
 
-static OfxStatus cook(OfxMeshEffectHandle instance) {
-    printf("DEBUG DEBUG cook\n");
+/**
+ * Build the point to corner adjacency as a compressed sparse row table,
+ * using a counting sort over corners.
+ */
+static OfxStatus computePointCorners(NormalContext *ctx,
+                                     const MfxAttributeDescriptor *corner_point_props)
+{
+    int point_count = ctx->point_count;
+    int corner_count = ctx->corner_count;
+
+    ctx->point_offsets = calloc((size_t)point_count + 1, sizeof(int));
+    ctx->point_corners = malloc(sizeof(int) * (size_t)corner_count);
+    if (NULL == ctx->point_offsets || NULL == ctx->point_corners) {
+        return kOfxStatErrMemory;
+    }
+
+    for (int corner = 0 ; corner < corner_count ; ++corner) {
+        int point = *ATTRIB_AT(*corner_point_props, int, corner);
+        if (point < 0 || point >= point_count) {
+            printf("ComputeNormals: corner #%d points to invalid point %d\n", corner, point);
+            return kOfxStatErrValue;
+        }
+        ++ctx->point_offsets[point + 1];
+    }
+    for (int point = 0 ; point < point_count ; ++point) {
+        ctx->point_offsets[point + 1] += ctx->point_offsets[point];
+    }
+
+    // Use point_offsets[point] as a write cursor then shift it back in place
+    for (int corner = 0 ; corner < corner_count ; ++corner) {
+        int point = *ATTRIB_AT(*corner_point_props, int, corner);
+        ctx->point_corners[ctx->point_offsets[point]++] = corner;
+    }
+    for (int point = point_count ; point > 0 ; --point) {
+        ctx->point_offsets[point] = ctx->point_offsets[point - 1];
+    }
+    ctx->point_offsets[0] = 0;
+
+    return kOfxStatOK;
+}
+
+static void gatherPointNormals(const NormalContext *ctx,
+                               const MfxAttributeDescriptor *normal_props)
+{
+    PARALLEL_FOR(ctx->point_count)
+    for (int point = 0 ; point < ctx->point_count ; ++point) {
+        float *normal = ATTRIB_AT(*normal_props, float, point);
+        normal[0] = normal[1] = normal[2] = 0.0f;
+        for (int i = ctx->point_offsets[point] ; i < ctx->point_offsets[point + 1] ; ++i) {
+            int corner = ctx->point_corners[i];
+            const float *N = ctx->face_normals + 3 * ctx->corner_face[corner];
+            float w = ctx->corner_weights[corner];
+            normal[0] += w * N[0];
+            normal[1] += w * N[1];
+            normal[2] += w * N[2];
+        }
+        normalize_v3(normal);
+    }
+}
+
+static void gatherCornerNormals(const NormalContext *ctx,
+                                const MfxAttributeDescriptor *corner_point_props,
+                                const MfxAttributeDescriptor *normal_props,
+                                float cos_threshold)
+{
+    PARALLEL_FOR(ctx->corner_count)
+    for (int corner = 0 ; corner < ctx->corner_count ; ++corner) {
+        int point = *ATTRIB_AT(*corner_point_props, int, corner);
+        const float *face_normal = ctx->face_normals + 3 * ctx->corner_face[corner];
+        float *normal = ATTRIB_AT(*normal_props, float, corner);
+        normal[0] = normal[1] = normal[2] = 0.0f;
+        for (int i = ctx->point_offsets[point] ; i < ctx->point_offsets[point + 1] ; ++i) {
+            int other_corner = ctx->point_corners[i];
+            const float *N = ctx->face_normals + 3 * ctx->corner_face[other_corner];
+            if (other_corner != corner && dot_product(N, face_normal) < cos_threshold) continue;
+            float w = ctx->corner_weights[other_corner];
+            normal[0] += w * N[0];
+            normal[1] += w * N[1];
+            normal[2] += w * N[2];
+        }
+        if (0.0f == normalize_v3(normal)) {
+            copy_v3(face_normal, normal);
+        }
+    }
+}
+
+/**
+ * Similar to MFX_ENSURE but, instead of returning, stores the non-OK status
+ * in the status variable of cook() and jumps to its cleanup label so that
+ * the meshes it got are released.
+ */
+#define COOK_ENSURE(call) { \
+    status = call; \
+    if (kOfxStatOK != status) { \
+        printf("Call '" #call "' returned an invalid status: %d (%s)\n", status, ofxStatusName(status)); \
+        goto cleanup; \
+    } \
+}
+
+static OfxStatus cook(OfxMeshEffectHandle instance, OfxPropertySetHandle inArgs) {
     OfxMeshInputHandle input;
     MFX_ENSURE(meshEffectSuite->inputGetHandle(instance, kOfxMeshMainInput, &input, NULL));
 
     OfxMeshInputHandle output;
     MFX_ENSURE(meshEffectSuite->inputGetHandle(instance, kOfxMeshMainOutput, &output, NULL));
 
-    OfxMeshHandle input_mesh;
+    OfxMeshHandle input_mesh = NULL;
     OfxTime time = 0.0;
-    MFX_ENSURE(meshEffectSuite->inputGetMesh(input, time, &input_mesh, NULL));
-
-    OfxMeshHandle output_mesh;
-    MFX_ENSURE(meshEffectSuite->inputGetMesh(output, time, &output_mesh, NULL));
-
-    MfxMeshProperties input_mesh_props;
-    MFX_ENSURE(mfxPullMeshProperties(propertySuite, meshEffectSuite, input_mesh, &input_mesh_props));
+    if (NULL != inArgs) {
+        MFX_ENSURE(propertySuite->propGetDouble(inArgs, kOfxPropTime, 0, &time));
+    }
+    OfxStatus status = kOfxStatOK;
+    COOK_ENSURE(meshEffectSuite->inputGetMesh(input, time, &input_mesh, NULL));
+
+    OfxMeshHandle output_mesh = NULL;
+    COOK_ENSURE(meshEffectSuite->inputGetMesh(output, time, &output_mesh, NULL));
+
+    MfxMeshView input_view;
+    COOK_ENSURE(mfxPullMeshView(meshViewSuite, propertySuite, meshEffectSuite, input_mesh, &input_view));
+
+    const MfxAttributeDescriptor *input_point_position =
+        mfxFindAttribute(&input_view, MFX_ATTACHMENT_POINT, kOfxMeshAttribPointPosition);
+    const MfxAttributeDescriptor *input_corner_point =
+        mfxFindAttribute(&input_view, MFX_ATTACHMENT_CORNER, kOfxMeshAttribCornerPoint);
+    const MfxAttributeDescriptor *input_face_size =
+        mfxFindAttribute(&input_view, MFX_ATTACHMENT_FACE, kOfxMeshAttribFaceSize);
+    if (NULL == input_point_position || NULL == input_corner_point || NULL == input_face_size) {
+        status = kOfxStatErrBadHandle;
+        goto cleanup;
+    }
 
     MfxMeshProperties output_mesh_props;
-    output_mesh_props.point_count = input_mesh_props.point_count;
-    output_mesh_props.corner_count = input_mesh_props.corner_count;
-    output_mesh_props.face_count = input_mesh_props.face_count;
-    output_mesh_props.constant_face_size = input_mesh_props.constant_face_size;
-    MFX_ENSURE(mfxPushMeshProperties(propertySuite, meshEffectSuite, output_mesh, &output_mesh_props));
+    output_mesh_props.point_count = input_view.point_count;
+    output_mesh_props.corner_count = input_view.corner_count;
+    output_mesh_props.face_count = input_view.face_count;
+    output_mesh_props.constant_face_size = input_view.constant_face_size;
+    COOK_ENSURE(mfxPushMeshProperties(propertySuite, meshEffectSuite, output_mesh, &output_mesh_props));
 
     // 1. Forward attributes
 
     OfxPropertySetHandle
-        input_point_position_attrib,
-        input_corner_point_attrib,
-        input_face_size_attrib,
         output_point_position_attrib,
         output_corner_point_attrib,
         output_face_size_attrib;
 
-    MFX_ENSURE(meshEffectSuite->meshGetAttribute(input_mesh,
-                                                 kOfxMeshAttribPoint,
-                                                 kOfxMeshAttribPointPosition,
-                                                 &input_point_position_attrib));
-    MFX_ENSURE(meshEffectSuite->meshGetAttribute(output_mesh,
-                                                 kOfxMeshAttribPoint,
-                                                 kOfxMeshAttribPointPosition,
-                                                 &output_point_position_attrib));
-
-    MfxAttributeProperties input_point_position_props;
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, input_point_position_attrib, &input_point_position_props));
-    MfxAttributeProperties output_point_position_props;
-    memcpy(&output_point_position_props, &input_point_position_props, sizeof(MfxAttributeProperties));
-    output_point_position_props.is_owner = 0;
-    printf("DEBUG DEBUG output_point_position_props.data = %p\n", output_point_position_props.data);
-    MFX_ENSURE(mfxPushAttributeProperties(propertySuite, output_point_position_attrib, &output_point_position_props));
-
-    
-    MFX_ENSURE(meshEffectSuite->meshGetAttribute(input_mesh,
-                                                 kOfxMeshAttribCorner,
-                                                 kOfxMeshAttribCornerPoint,
-                                                 &input_corner_point_attrib));
-    MFX_ENSURE(meshEffectSuite->meshGetAttribute(output_mesh,
-                                                 kOfxMeshAttribCorner,
-                                                 kOfxMeshAttribCornerPoint,
-                                                 &output_corner_point_attrib));
-
-    MfxAttributeProperties input_corner_point_props;
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, input_corner_point_attrib, &input_corner_point_props));
-    MfxAttributeProperties output_corner_point_props;
-    memcpy(&output_corner_point_props, &input_corner_point_props, sizeof(MfxAttributeProperties));
-    output_corner_point_props.is_owner = 0;
-    MFX_ENSURE(mfxPushAttributeProperties(propertySuite, output_corner_point_attrib, &output_corner_point_props));
-
-    MFX_ENSURE(meshEffectSuite->meshGetAttribute(input_mesh,
-                                                 kOfxMeshAttribFace,
-                                                 kOfxMeshAttribFaceSize,
-                                                 &input_face_size_attrib));
-    MFX_ENSURE(meshEffectSuite->meshGetAttribute(output_mesh,
-                                                 kOfxMeshAttribFace,
-                                                 kOfxMeshAttribFaceSize,
-                                                 &output_face_size_attrib));
-
-    MfxAttributeProperties input_face_size_props;
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, input_face_size_attrib, &input_face_size_props));
-    MfxAttributeProperties output_face_size_props;
-    memcpy(&output_face_size_props, &input_face_size_props, sizeof(MfxAttributeProperties));
-    output_face_size_props.is_owner = 0;
-    MFX_ENSURE(mfxPushAttributeProperties(propertySuite, output_face_size_attrib, &output_face_size_props));
+    COOK_ENSURE(meshEffectSuite->meshGetAttribute(output_mesh,
+                                                  kOfxMeshAttribPoint,
+                                                  kOfxMeshAttribPointPosition,
+                                                  &output_point_position_attrib));
+    COOK_ENSURE(mfxForwardAttribute(propertySuite, input_point_position, output_point_position_attrib));
+
+    COOK_ENSURE(meshEffectSuite->meshGetAttribute(output_mesh,
+                                                  kOfxMeshAttribCorner,
+                                                  kOfxMeshAttribCornerPoint,
+                                                  &output_corner_point_attrib));
+    COOK_ENSURE(mfxForwardAttribute(propertySuite, input_corner_point, output_corner_point_attrib));
+
+    // When the face size is constant, there is no buffer to forward
+    if (input_view.constant_face_size == -1) {
+        COOK_ENSURE(meshEffectSuite->meshGetAttribute(output_mesh,
+                                                      kOfxMeshAttribFace,
+                                                      kOfxMeshAttribFaceSize,
+                                                      &output_face_size_attrib));
+        COOK_ENSURE(mfxForwardAttribute(propertySuite, input_face_size, output_face_size_attrib));
+    }
 
     // 2. Add extra attributes
 
-    OfxPropertySetHandle output_face_normal_attrib;
-    MFX_ENSURE(meshEffectSuite->attributeDefine(output_mesh,
-                              kOfxMeshAttribFace,
+    OfxParamSetHandle parameters;
+    COOK_ENSURE(meshEffectSuite->getParamSet(instance, &parameters));
+    int mode_value, weighting_value;
+    double angle_value;
+    COOK_ENSURE(getIntParameterValue(parameters, "mode", &mode_value));
+    COOK_ENSURE(getIntParameterValue(parameters, "weighting", &weighting_value));
+    COOK_ENSURE(getDoubleParameterValue(parameters, "angle", &angle_value));
+    NormalMode mode = (NormalMode)mode_value;
+    NormalWeighting weighting = (NormalWeighting)weighting_value;
+    if (mode < NORMAL_MODE_FACE || mode > NORMAL_MODE_CORNER) mode = NORMAL_MODE_FACE;
+
+    const char *normal_attachment =
+        mode == NORMAL_MODE_POINT ? kOfxMeshAttribPoint :
+        mode == NORMAL_MODE_CORNER ? kOfxMeshAttribCorner :
+        kOfxMeshAttribFace;
+    MfxAttachment normal_attachment_enum =
+        mode == NORMAL_MODE_POINT ? MFX_ATTACHMENT_POINT :
+        mode == NORMAL_MODE_CORNER ? MFX_ATTACHMENT_CORNER :
+        MFX_ATTACHMENT_FACE;
+
+    OfxPropertySetHandle output_normal_attrib;
+    COOK_ENSURE(meshEffectSuite->attributeDefine(output_mesh,
+                              normal_attachment,
                               "normal",
                               3,
                               kOfxMeshAttribTypeFloat,
                               kOfxMeshAttribSemanticNormal,
-                              &output_face_normal_attrib));
+                              &output_normal_attrib));
 
     // 3. Allocate attributes
 
-    MFX_ENSURE(meshEffectSuite->meshAlloc(output_mesh));
+    COOK_ENSURE(meshEffectSuite->meshAlloc(output_mesh));
 
     // 4. Fill attribute data
 
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, output_point_position_attrib, &output_point_position_props));
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, output_corner_point_attrib, &output_corner_point_props));
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, output_face_size_attrib, &output_face_size_props));
-    if (output_mesh_props.constant_face_size > -1) {
-        output_face_size_props.data = &output_mesh_props.constant_face_size;
-        output_face_size_props.byte_stride = 0;
+    // Topology is read from the input view, output attributes point to the same data
+    MfxAttributeDescriptor output_normal_props;
+    if (NULL != meshViewSuite) {
+        MfxMeshView output_view;
+        COOK_ENSURE(meshViewSuite->meshGetView(output_mesh, &output_view));
+        const MfxAttributeDescriptor *desc = mfxFindAttribute(&output_view, normal_attachment_enum, "normal");
+        if (NULL == desc) {
+            status = kOfxStatErrBadHandle;
+            goto cleanup;
+        }
+        output_normal_props = *desc;
+    } else {
+        MfxAttributeProperties props;
+        COOK_ENSURE(mfxPullAttributeProperties(propertySuite, output_normal_attrib, &props));
+        output_normal_props.data = props.data;
+        output_normal_props.byte_stride = props.byte_stride;
     }
 
-    MfxAttributeProperties output_face_normal_props;
-    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, output_face_normal_attrib, &output_face_normal_props));
-
-    float barycenter[3];
-    float normal[3];
-    float N[3];
-    float A[3];
-    float B[3];
-    int corner = 0, size = 0;
-    for (int face = 0 ; face < output_mesh_props.face_count ; ++face, corner += size) {
-        size = *(int*)(output_face_size_props.data + output_face_size_props.byte_stride * face);
-        float normalizer = 1.0f / size;
-        float *prev_P;
-
-        barycenter[0] = barycenter[1] = barycenter[2] = 0.0f;
-        for (int i = 0 ; i < size ; ++i) {
-            int point = *(int*)(output_corner_point_props.data + output_corner_point_props.byte_stride * (corner + i));
-            float *P = (float*)(output_point_position_props.data + output_point_position_props.byte_stride * point);
-            add_v3(barycenter, P);
-            prev_P = P;
-        }
-        for (int k = 0 ; k < 3 ; ++k) {
-            barycenter[k] *= normalizer;
-        }
+    NormalContext ctx;
+    memset(&ctx, 0, sizeof(NormalContext));
+    ctx.point_count = output_mesh_props.point_count;
+    ctx.corner_count = output_mesh_props.corner_count;
+    ctx.face_count = output_mesh_props.face_count;
+
+    status = computeFaceNormals(&ctx,
+                                          input_point_position,
+                                          input_corner_point,
+                                          input_face_size,
+                                          mode != NORMAL_MODE_FACE,
+                                          weighting);
+
+    if (kOfxStatOK == status && mode != NORMAL_MODE_FACE) {
+        status = computePointCorners(&ctx, input_corner_point);
+    }
 
-        normal[0] = normal[1] = normal[2] = 0.0f;
-        for (int i = 0 ; i < size ; ++i) {
-            int point = *(int*)(output_corner_point_props.data + output_corner_point_props.byte_stride * (corner + i));
-            float *P = (float*)(output_point_position_props.data + output_point_position_props.byte_stride * point);
-            sub_v3_v3(prev_P, barycenter, A);
-            sub_v3_v3(P, barycenter, B);
-            cross_product(A, B, N);
-            normalize_v3(N);
-            add_v3(normal, N);
-            prev_P = P;
+    if (kOfxStatOK == status) {
+        switch (mode) {
+        case NORMAL_MODE_POINT:
+            gatherPointNormals(&ctx, &output_normal_props);
+            break;
+        case NORMAL_MODE_CORNER:
+            gatherCornerNormals(&ctx,
+                                input_corner_point,
+                                &output_normal_props,
+                                (float)cos(angle_value * M_PI / 180.0));
+            break;
+        case NORMAL_MODE_FACE:
+        default:
+            PARALLEL_FOR(ctx.face_count)
+            for (int face = 0 ; face < ctx.face_count ; ++face) {
+                copy_v3(ctx.face_normals + 3 * face, ATTRIB_AT(output_normal_props, float, face));
+            }
+            break;
         }
-        normalize_v3(normal);
-
-        float *faceNormal = (float*)(output_face_normal_props.data + output_face_normal_props.byte_stride * face);
-        copy_v3(normal, faceNormal);
     }
 
-    MFX_ENSURE(meshEffectSuite->inputReleaseMesh(input_mesh));
-    MFX_ENSURE(meshEffectSuite->inputReleaseMesh(output_mesh));
-    return kOfxStatReplyDefault;
+    freeNormalContext(&ctx);
+
+cleanup:
+    // Meshes are released whether the cook succeeded or not
+    if (NULL != input_mesh) {
+        OfxStatus release_status = meshEffectSuite->inputReleaseMesh(input_mesh);
+        if (kOfxStatOK == status) status = release_status;
+    }
+    if (NULL != output_mesh) {
+        OfxStatus release_status = meshEffectSuite->inputReleaseMesh(output_mesh);
+        if (kOfxStatOK == status) status = release_status;
+    }
+    return kOfxStatOK == status ? kOfxStatReplyDefault : status;
 }
 
 static OfxStatus mainEntry(const char *action,
@@ -273,7 +564,7 @@ static OfxStatus mainEntry(const char *action,
         return destroyInstance((OfxMeshEffectHandle)handle);
     }
     if (0 == strcmp(action, kOfxMeshEffectActionCook)) {
-        return cook((OfxMeshEffectHandle)handle);
+        return cook((OfxMeshEffectHandle)handle, inArgs);
     }
     return kOfxStatReplyDefault; // this means "unhandled action"
 }
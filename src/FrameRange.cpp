@@ -0,0 +1,379 @@
+#include "FrameRange.h"
+#include "Hash.h"
+#include "Parallel.h"
+#include "ObjWriter.h"
+#include "PlyFormat.h"
+#include "GltfFormat.h"
+#include "BinaryMeshFormat.h"
+
+#include <ofxMeshEffect.h>
+#include <common/common.h> // for MFX_ENSURE
+
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <algorithm>
+
+/**
+ * Reference the buffers of src without taking ownership of them.
+ */
+static void borrowMesh(OfxMeshStruct *dst, const OfxMeshStruct *src) {
+  meshShallowCopy(dst, src);
+  for (int i = 0 ; i < 32 ; ++i) {
+    dst->attributes[i].is_owner = 0;
+  }
+}
+
+/**
+ * Index of the sample that an input is held to at time, following
+ * meshInputMeshAtTime().
+ */
+static int heldSampleIndex(const std::vector<OfxMeshTimeSample>& samples, double time) {
+  int index = 0;
+  while (index + 1 < static_cast<int>(samples.size()) && samples[index + 1].time <= time) ++index;
+  return index;
+}
+
+//--------------------------------------------------------
+
+OfxStatus MemoryFrameSink::beginRange(int frameCount) {
+  m_frames.clear();
+  for (int i = 0 ; i < frameCount ; ++i) {
+    m_frames.emplace_back(new Frame());
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus MemoryFrameSink::writeFrame(int frame, double time, const OfxMeshStruct *mesh) {
+  if (frame < 0 || frame >= frameCount()) return kOfxStatErrBadIndex;
+  // Frames are preallocated, so concurrent writes never touch the same one
+  Frame& f = *m_frames[frame];
+  meshDestroy(&f.mesh);
+  meshInit(&f.mesh);
+  f.time = time;
+  OfxStatus status = meshDeepCopy(&f.mesh, mesh);
+  f.written = kOfxStatOK == status;
+  return status;
+}
+
+double MemoryFrameSink::frameTime(int frame) const {
+  if (frame < 0 || frame >= frameCount()) return 0;
+  return m_frames[frame]->time;
+}
+
+const OfxMeshStruct* MemoryFrameSink::frameMesh(int frame) const {
+  if (frame < 0 || frame >= frameCount() || !m_frames[frame]->written) return nullptr;
+  return &m_frames[frame]->mesh;
+}
+
+//--------------------------------------------------------
+
+FileFrameSink::FileFrameSink(const char *pattern)
+  : m_pattern(pattern)
+{
+  std::string extension;
+  size_t dot = m_pattern.rfind('.');
+  if (dot != std::string::npos) {
+    for (char c : m_pattern.substr(dot + 1)) extension += static_cast<char>(tolower(c));
+  }
+  if (extension == "obj") m_save = &saveObjMesh;
+  else if (extension == "ply") m_save = &savePlyMesh;
+  else if (extension == "glb") m_save = &saveGlbMesh;
+  else if (extension == "wmfx") m_save = &saveBinaryMesh;
+}
+
+OfxStatus FileFrameSink::beginRange(int /*frameCount*/) {
+  if (nullptr == m_save) {
+    printf("Error: unknown file format for frame pattern '%s'\n", m_pattern.c_str());
+    return kOfxStatErrValue;
+  }
+
+  // The pattern is handed to snprintf, so make sure that it expects a
+  // single int, e.g. "%d" or "%04d", and nothing else
+  int conversionCount = 0;
+  for (size_t i = 0 ; i < m_pattern.size() ; ++i) {
+    if (m_pattern[i] != '%') continue;
+    if (i + 1 < m_pattern.size() && m_pattern[i + 1] == '%') {
+      ++i;
+      continue;
+    }
+    size_t j = i + 1;
+    while (j < m_pattern.size() && isdigit(static_cast<unsigned char>(m_pattern[j]))) ++j;
+    if (j == m_pattern.size() || m_pattern[j] != 'd') {
+      conversionCount = -1;
+      break;
+    }
+    ++conversionCount;
+    i = j;
+  }
+  if (conversionCount != 1) {
+    printf("Error: frame pattern '%s' must contain a single %%d conversion\n", m_pattern.c_str());
+    return kOfxStatErrValue;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus FileFrameSink::writeFrame(int frame, double /*time*/, const OfxMeshStruct *mesh) {
+  int size = snprintf(nullptr, 0, m_pattern.c_str(), frame);
+  if (size < 0) return kOfxStatErrValue;
+  std::vector<char> filename(size + 1);
+  snprintf(filename.data(), filename.size(), m_pattern.c_str(), frame);
+  return m_save(filename.data(), mesh);
+}
+
+//--------------------------------------------------------
+
+FrameRangeCooker::FrameRangeCooker(const OfxPlugin *plugin, const OfxMeshEffectStruct *instance)
+  : m_plugin(plugin)
+  , m_instance(instance)
+{}
+
+OfxStatus FrameRangeCooker::setInputSample(const char *inputName, double time, const OfxMeshStruct *mesh) {
+  if (nullptr == findInput(inputName)) return kOfxStatErrBadIndex;
+  if (nullptr == mesh) return kOfxStatErrBadHandle;
+
+  std::vector<OfxMeshTimeSample>& samples = m_inputSamples[inputName];
+  auto it = std::lower_bound(samples.begin(), samples.end(), time, [](const OfxMeshTimeSample& sample, double t) {
+    return sample.time < t;
+  });
+  if (it != samples.end() && it->time == time) {
+    it->mesh = mesh;
+  } else {
+    samples.insert(it, OfxMeshTimeSample{ time, mesh });
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus FrameRangeCooker::clearInputSamples(const char *inputName) {
+  if (nullptr == findInput(inputName)) return kOfxStatErrBadIndex;
+  m_inputSamples.erase(inputName);
+  return kOfxStatOK;
+}
+
+void FrameRangeCooker::setCaching(bool enabled) {
+  m_caching = enabled;
+  if (!m_caching) m_cache.clear();
+}
+
+OfxStatus FrameRangeCooker::cookRange(double first, double last, double step, FrameSink *sink) {
+  if (!(step > 0) || !(last >= first)) return kOfxStatErrValue;
+  Clock::time_point start = Clock::now();
+  m_stats = CookStats();
+
+  // Tolerate rounding errors on the last frame, e.g. for step = 0.1
+  int frameCount = static_cast<int>(std::floor((last - first) / step + 1e-6)) + 1;
+  std::vector<double> times(frameCount);
+  for (int i = 0 ; i < frameCount ; ++i) {
+    times[i] = first + i * step;
+  }
+
+  // Evaluate animation curves once for the whole range
+  const OfxParamSetStruct& instanceParameters = m_instance->parameters;
+  FrameParameters parameters(instanceParameters.count);
+  for (int j = 0 ; j < instanceParameters.count ; ++j) {
+    const OfxParamStruct *param = instanceParameters.entries[j];
+    if (param->key_count == 0) continue;
+    parameters[j].resize(4 * static_cast<size_t>(frameCount));
+    paramEvaluateRange(param, first, step, frameCount, parameters[j].data());
+  }
+
+  // Hash each input sample once rather than once per frame
+  std::map<std::string, std::vector<uint64_t>> sampleHashes;
+  if (m_caching) {
+    for (int i = 0 ; i < 16 && m_instance->inputs[i].is_valid ; ++i) {
+      const OfxMeshInputStruct *input = &m_instance->inputs[i];
+      if (0 == strcmp(input->name, kOfxMeshMainOutput)) continue;
+      std::vector<uint64_t>& hashes = sampleHashes[input->name];
+      auto it = m_inputSamples.find(input->name);
+      if (it != m_inputSamples.end() && !it->second.empty()) {
+        for (const OfxMeshTimeSample& sample : it->second) {
+          hashes.push_back(hashMesh(sample.mesh));
+        }
+      } else {
+        hashes.push_back(hashMesh(&input->mesh));
+      }
+    }
+  }
+
+  std::vector<uint64_t> stamps(frameCount, 0);
+  std::vector<std::shared_ptr<const Output>> outputs(frameCount);
+  int missCount = 0;
+  for (int i = 0 ; i < frameCount ; ++i) {
+    if (m_caching) {
+      stamps[i] = computeStamp(i, times[i], parameters, sampleHashes);
+      auto it = m_cache.find(times[i]);
+      if (it != m_cache.end() && it->second.stamp == stamps[i]) {
+        outputs[i] = it->second.output;
+        continue;
+      }
+    }
+    ++missCount;
+  }
+
+  if (nullptr != sink) MFX_ENSURE(sink->beginRange(frameCount));
+
+  // Each thread cooks with its own copy of the instance
+  std::vector<OfxMeshEffectStruct*> clones;
+  for (int c = 0 ; c < std::min(threadCount(), missCount) ; ++c) {
+    OfxMeshEffectStruct *clone = cloneInstance();
+    if (nullptr == clone) {
+      for (OfxMeshEffectStruct *other : clones) destroyClone(other);
+      return kOfxStatErrMemory;
+    }
+    clones.push_back(clone);
+  }
+  std::vector<OfxMeshEffectStruct*> freeClones = clones;
+
+  std::mutex mutex;
+  OfxStatus status = kOfxStatOK;
+  std::atomic<bool> failed(false);
+  std::atomic<int> cookedCount(0);
+
+  parallelFor(frameCount, [&](int i) {
+    if (failed) return;
+    OfxStatus frameStatus = kOfxStatOK;
+    if (!outputs[i]) {
+      OfxMeshEffectStruct *clone;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(!freeClones.empty());
+        clone = freeClones.back();
+        freeClones.pop_back();
+      }
+      frameStatus = cookFrame(m_plugin, clone, i, times[i], parameters, outputs[i]);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeClones.push_back(clone);
+      }
+      if (kOfxStatOK == frameStatus) {
+        ++cookedCount;
+      } else {
+        printf("Error: cooking frame at time %f failed with status %d (%s)\n", times[i], frameStatus, ofxStatusName(frameStatus));
+      }
+    }
+    if (kOfxStatOK == frameStatus && nullptr != sink) {
+      frameStatus = sink->writeFrame(i, times[i], &outputs[i]->mesh);
+    }
+    if (!m_caching) outputs[i].reset();
+    if (kOfxStatOK != frameStatus) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (kOfxStatOK == status) status = frameStatus;
+      failed = true;
+    }
+  });
+
+  for (OfxMeshEffectStruct *clone : clones) {
+    destroyClone(clone);
+  }
+
+  if (m_caching) {
+    for (int i = 0 ; i < frameCount ; ++i) {
+      if (outputs[i]) {
+        CachedFrame& cached = m_cache[times[i]];
+        cached.stamp = stamps[i];
+        cached.output = outputs[i];
+      } else {
+        m_cache.erase(times[i]);
+      }
+    }
+  }
+
+  m_stats.cooked = cookedCount;
+  m_stats.reused = frameCount - missCount;
+  m_stats.time = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("[host] Frame range cooked in %.3fs on %d thread(s): %d frame(s) cooked, %d reused\n",
+    m_stats.time, std::max(1, static_cast<int>(clones.size())), m_stats.cooked, m_stats.reused);
+  return status;
+}
+
+const OfxMeshInputStruct* FrameRangeCooker::findInput(const char *inputName) const {
+  for (int i = 0 ; i < 16 && m_instance->inputs[i].is_valid ; ++i) {
+    const OfxMeshInputStruct *input = &m_instance->inputs[i];
+    if (0 == strcmp(input->name, kOfxMeshMainOutput)) continue;
+    if (0 == strcmp(input->name, inputName)) return input;
+  }
+  return nullptr;
+}
+
+uint64_t FrameRangeCooker::computeStamp(int frame, double time, const FrameParameters& parameters, const std::map<std::string, std::vector<uint64_t>>& sampleHashes) const {
+  // Plugins may read the time of the cook, so it is part of the stamp
+  uint64_t h = hashBytes(&time, sizeof(double));
+
+  const OfxParamSetStruct& instanceParameters = m_instance->parameters;
+  for (int i = 0 ; i < instanceParameters.count ; ++i) {
+    const OfxParamStruct *param = instanceParameters.entries[i];
+    const OfxParamValueStruct *values = parameters[i].empty() ? param->values : &parameters[i][4 * frame];
+    h = hashParamValues(param->kind, values, h);
+  }
+
+  for (const auto& entry : sampleHashes) {
+    const std::string& name = entry.first;
+    auto it = m_inputSamples.find(name);
+    int index = it != m_inputSamples.end() && !it->second.empty() ? heldSampleIndex(it->second, time) : 0;
+    h = hashCombine(hashBytes(name.data(), name.size(), h), entry.second[index]);
+  }
+  return h;
+}
+
+OfxMeshEffectStruct* FrameRangeCooker::cloneInstance() const {
+  OfxMeshEffectStruct *clone = new OfxMeshEffectStruct;
+  meshEffectInit(clone);
+  if (kOfxStatOK != meshEffectCopy(clone, m_instance)) {
+    destroyClone(clone);
+    return nullptr;
+  }
+  for (int i = 0 ; i < 16 && clone->inputs[i].is_valid ; ++i) {
+    OfxMeshInputStruct *input = &clone->inputs[i];
+    if (0 == strcmp(input->name, kOfxMeshMainOutput)) continue;
+    auto it = m_inputSamples.find(input->name);
+    if (it != m_inputSamples.end() && !it->second.empty()) {
+      input->time_samples = it->second.data();
+      input->time_sample_count = static_cast<int>(it->second.size());
+    } else {
+      borrowMesh(&input->mesh, &m_instance->inputs[i].mesh);
+    }
+  }
+  return clone;
+}
+
+void FrameRangeCooker::destroyClone(OfxMeshEffectStruct *clone) {
+  meshEffectDestroy(clone);
+  delete clone;
+}
+
+OfxStatus FrameRangeCooker::cookFrame(const OfxPlugin *plugin, OfxMeshEffectStruct *clone, int frame, double time, const FrameParameters& parameters, std::shared_ptr<const Output>& output) {
+  OfxMeshInputStruct *outputInput = nullptr;
+  for (int i = 0 ; i < 16 && clone->inputs[i].is_valid ; ++i) {
+    if (0 == strcmp(clone->inputs[i].name, kOfxMeshMainOutput)) outputInput = &clone->inputs[i];
+  }
+  if (nullptr == outputInput) return kOfxStatErrBadHandle;
+
+  // The clone has the same parameters as the instance, in the same order
+  for (int j = 0 ; j < clone->parameters.count ; ++j) {
+    if (parameters[j].empty()) continue;
+    paramSetEvaluation(clone->parameters.entries[j], time, &parameters[j][4 * frame]);
+  }
+  meshDestroy(&outputInput->mesh);
+  meshInit(&outputInput->mesh);
+
+  OfxCookArgsPropertySet args;
+  cookArgsInit(&args, time);
+  OfxStatus status = plugin->mainEntry(kOfxMeshEffectActionCook, clone, (OfxPropertySetHandle)&args, NULL);
+  // Some plugins reply with the "default" status once done (see Graph)
+  if (kOfxStatReplyDefault == status) status = kOfxStatOK;
+
+  if (kOfxStatOK == status) {
+    std::shared_ptr<Output> taken = std::make_shared<Output>();
+    taken->mesh = outputInput->mesh;
+    meshInit(&outputInput->mesh);
+    output = taken;
+  } else {
+    meshDestroy(&outputInput->mesh);
+    meshInit(&outputInput->mesh);
+  }
+  return status;
+}
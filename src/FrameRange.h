@@ -0,0 +1,210 @@
+#ifndef _FrameRange_h_
+#define _FrameRange_h_
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Mesh;
+class EffectInstance;
+
+/**
+ * Receives the outputs of a frame range cook.
+ */
+class FrameSink {
+public:
+  virtual ~FrameSink() {}
+
+  /**
+   * Called once before writing the frames of a range.
+   */
+  virtual OfxStatus beginRange(int /*frameCount*/) { return kOfxStatOK; }
+
+  /**
+   * Called once for each frame of the range, where frame is the index of
+   * the frame in the range. Different frames are written concurrently and
+   * in any order. The mesh is only valid during the call.
+   */
+  virtual OfxStatus writeFrame(int frame, double time, const OfxMeshStruct *mesh) = 0;
+};
+
+/**
+ * Keep a copy of the output of each frame of the last range.
+ */
+class MemoryFrameSink : public FrameSink {
+public:
+  MemoryFrameSink() {}
+  MemoryFrameSink(const MemoryFrameSink&) = delete;
+  MemoryFrameSink& operator=(const MemoryFrameSink&) = delete;
+
+  OfxStatus beginRange(int frameCount) override;
+  OfxStatus writeFrame(int frame, double time, const OfxMeshStruct *mesh) override;
+
+  int frameCount() const { return static_cast<int>(m_frames.size()); }
+  double frameTime(int frame) const;
+
+  /**
+   * Output of a frame, or null if it was not written, e.g. because the
+   * cook failed. It is valid until the next range is written to the sink.
+   */
+  const OfxMeshStruct* frameMesh(int frame) const;
+  // Defined along with the JavaScript bindings
+  Mesh getFrameMesh(int frame) const;
+
+  void clear() { m_frames.clear(); }
+
+private:
+  struct Frame {
+    OfxMeshStruct mesh;
+    double time = 0;
+    bool written = false;
+
+    Frame() { meshInit(&mesh); }
+    ~Frame() { meshDestroy(&mesh); }
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+  };
+
+private:
+  std::vector<std::unique_ptr<Frame>> m_frames;
+};
+
+/**
+ * Save the output of each frame to its own file, named after a printf
+ * pattern with a single integer conversion that receives the index of the
+ * frame in the range, e.g. "bake/frame%04d.ply". The format is given by the
+ * extension: .obj, .ply, .glb or .wmfx (see BinaryMeshFormat.h).
+ */
+class FileFrameSink : public FrameSink {
+public:
+  FileFrameSink(const char *pattern);
+
+  OfxStatus beginRange(int frameCount) override;
+  OfxStatus writeFrame(int frame, double time, const OfxMeshStruct *mesh) override;
+
+private:
+  std::string m_pattern;
+  OfxStatus (*m_save)(const char*, const OfxMeshStruct*) = nullptr;
+};
+
+/**
+ * Cook an effect instance over a range of times, e.g. to bake an animated
+ * effect or a simulation offline.
+ *
+ * Inputs may be fed with a mesh per time sample, the input being held to
+ * the last sample at or before the cooked time. Inputs without samples use
+ * the mesh of the instance at all times. Animated parameters are evaluated
+ * from the keys of the instance (see paramInsertKey()) for all frames at
+ * once before cooking, and plugins that query them at the cooked time get
+ * these values without evaluating the curves again.
+ *
+ * Frames are cooked concurrently on the thread pool of Parallel.h, each
+ * thread using its own copy of the instance, and handed to a sink as soon
+ * as they are cooked. Outputs are cached per time, so cooking the range
+ * again only cooks the frames whose parameter values or input samples
+ * changed, like Graph does for its nodes.
+ */
+class FrameRangeCooker {
+public:
+  /**
+   * The instance must outlive the cooker. Its parameters and input meshes
+   * are read at each call to cookRange().
+   */
+  FrameRangeCooker(const OfxPlugin *plugin, const OfxMeshEffectStruct *instance);
+  // Defined along with the JavaScript bindings
+  FrameRangeCooker(EffectInstance *instance);
+  FrameRangeCooker(const FrameRangeCooker&) = delete;
+  FrameRangeCooker& operator=(const FrameRangeCooker&) = delete;
+
+  /**
+   * Feed a mesh to an input from a given time on, replacing the sample at
+   * the very same time if any. The mesh must remain valid as long as it is
+   * used, including by cached outputs that forward its attributes.
+   */
+  OfxStatus setInputSample(const char *inputName, double time, const OfxMeshStruct *mesh);
+  // Defined along with the JavaScript bindings
+  OfxStatus setInputSample(const char *inputName, double time, const Mesh *mesh);
+  OfxStatus clearInputSamples(const char *inputName);
+
+  /**
+   * Cook the frames at times first, first + step, ... up to last included
+   * and write them to the sink, which may be null. Stops at the first frame
+   * that fails to cook or to be written.
+   */
+  OfxStatus cookRange(double first, double last, double step, FrameSink *sink);
+
+  /**
+   * Keep the outputs of cooked frames to reuse them, which is the default.
+   */
+  void setCaching(bool enabled);
+  bool caching() const { return m_caching; }
+  void clearCache() { m_cache.clear(); }
+
+  /**
+   * Statistics of the last range: number of frames that were cooked and
+   * that were reused from the cache, and duration in seconds.
+   */
+  int cookedFrameCount() const { return m_stats.cooked; }
+  int reusedFrameCount() const { return m_stats.reused; }
+  double cookTime() const { return m_stats.time; }
+
+private:
+  /**
+   * Output of a frame, which owns its buffers.
+   */
+  struct Output {
+    OfxMeshStruct mesh;
+
+    Output() { meshInit(&mesh); }
+    ~Output() { meshDestroy(&mesh); }
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+  };
+
+  struct CachedFrame {
+    uint64_t stamp = 0; // stamp of the parameters and inputs output was cooked from
+    std::shared_ptr<const Output> output;
+  };
+
+  struct CookStats {
+    int cooked = 0;
+    int reused = 0;
+    double time = 0;
+  };
+
+  // Values of each parameter at each frame, 4 slots per frame, left empty
+  // for parameters that are not animated
+  typedef std::vector<std::vector<OfxParamValueStruct>> FrameParameters;
+
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  const OfxMeshInputStruct* findInput(const char *inputName) const;
+  // Hash of the parameter values and of the content of the inputs at a
+  // frame, given the hash of each input sample, or of the static input mesh
+  uint64_t computeStamp(int frame, double time, const FrameParameters& parameters, const std::map<std::string, std::vector<uint64_t>>& sampleHashes) const;
+  // Copy of the instance that reads the input samples of the cooker, or null
+  // if it could not be allocated
+  OfxMeshEffectStruct* cloneInstance() const;
+  static void destroyClone(OfxMeshEffectStruct *clone);
+  static OfxStatus cookFrame(const OfxPlugin *plugin, OfxMeshEffectStruct *clone, int frame, double time, const FrameParameters& parameters, std::shared_ptr<const Output>& output);
+
+private:
+  const OfxPlugin *m_plugin;
+  const OfxMeshEffectStruct *m_instance;
+  std::map<std::string, std::vector<OfxMeshTimeSample>> m_inputSamples; // sorted by time
+  bool m_caching = true;
+  std::map<double, CachedFrame> m_cache;
+  CookStats m_stats;
+};
+
+#endif // _FrameRange_h_
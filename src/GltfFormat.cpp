@@ -0,0 +1,1127 @@
+#include "GltfFormat.h"
+#include "Blob.h"
+#include "Parallel.h"
+#include "BufferedWriter.h"
+
+extern "C" {
+#include <host/meshEffectSuite.h>
+#include <common/common.h> // for MFX_ENSURE
+}
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#define GLB_MAGIC 0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A
+#define GLB_CHUNK_BIN 0x004E4942
+
+enum GltfComponentType {
+  GLTF_BYTE = 5120,
+  GLTF_UNSIGNED_BYTE = 5121,
+  GLTF_SHORT = 5122,
+  GLTF_UNSIGNED_SHORT = 5123,
+  GLTF_UNSIGNED_INT = 5125,
+  GLTF_FLOAT = 5126,
+};
+
+enum GltfPrimitiveMode {
+  GLTF_POINTS = 0,
+  GLTF_TRIANGLES = 4,
+};
+
+static const int indexBlockSize = 1 << 16;
+
+//--------------------------------------------------------
+// Minimal JSON document model, only what is needed to read glTF headers.
+
+namespace {
+
+class JsonValue {
+public:
+  enum Type {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object,
+  };
+
+  bool isNull() const { return m_type == Null; }
+  bool isNumber() const { return m_type == Number; }
+  bool isString() const { return m_type == String; }
+  bool isArray() const { return m_type == Array; }
+  bool isObject() const { return m_type == Object; }
+
+  double asNumber(double fallback = 0.0) const { return m_type == Number ? m_number : fallback; }
+  int asInt(int fallback = 0) const { return m_type == Number ? static_cast<int>(m_number) : fallback; }
+  bool asBoolean(bool fallback = false) const { return m_type == Boolean ? m_number != 0.0 : fallback; }
+  const std::string& asString() const { return m_string; }
+
+  size_t size() const { return m_type == Array ? m_items.size() : (m_type == Object ? m_members.size() : 0); }
+
+  // Missing items and members are null values
+  const JsonValue& operator[](int index) const {
+    return m_type == Array && index >= 0 && static_cast<size_t>(index) < m_items.size() ? m_items[index] : null();
+  }
+  const JsonValue& operator[](const char *key) const {
+    if (m_type == Object) {
+      for (const auto& member : m_members) {
+        if (member.first == key) return member.second;
+      }
+    }
+    return null();
+  }
+  const std::vector<std::pair<std::string, JsonValue>>& members() const { return m_members; }
+
+private:
+  static const JsonValue& null() {
+    static const JsonValue value;
+    return value;
+  }
+
+private:
+  friend class JsonParser;
+  Type m_type = Null;
+  double m_number = 0.0;
+  std::string m_string;
+  std::vector<JsonValue> m_items;
+  std::vector<std::pair<std::string, JsonValue>> m_members;
+};
+
+class JsonParser {
+public:
+  JsonParser(const char *begin, const char *end)
+    : m_cursor(begin)
+    , m_end(end)
+  {}
+
+  // Parse a complete document, return false if it is malformed
+  bool parse(JsonValue& value) {
+    if (!parseValue(value, 0)) return false;
+    skipSpaces();
+    return m_cursor == m_end;
+  }
+
+private:
+  void skipSpaces() {
+    while (m_cursor < m_end && (*m_cursor == ' ' || *m_cursor == '\t' || *m_cursor == '\n' || *m_cursor == '\r')) ++m_cursor;
+  }
+
+  bool consume(const char *literal) {
+    size_t length = strlen(literal);
+    if (static_cast<size_t>(m_end - m_cursor) < length || 0 != strncmp(m_cursor, literal, length)) return false;
+    m_cursor += length;
+    return true;
+  }
+
+  bool parseValue(JsonValue& value, int depth) {
+    if (depth > 64) return false;
+    skipSpaces();
+    if (m_cursor == m_end) return false;
+    switch (*m_cursor) {
+    case '{':
+      return parseObject(value, depth);
+    case '[':
+      return parseArray(value, depth);
+    case '"':
+      value.m_type = JsonValue::String;
+      return parseString(value.m_string);
+    case 't':
+      value.m_type = JsonValue::Boolean;
+      value.m_number = 1.0;
+      return consume("true");
+    case 'f':
+      value.m_type = JsonValue::Boolean;
+      return consume("false");
+    case 'n':
+      return consume("null");
+    default:
+      value.m_type = JsonValue::Number;
+      return parseNumber(value.m_number);
+    }
+  }
+
+  bool parseObject(JsonValue& value, int depth) {
+    value.m_type = JsonValue::Object;
+    ++m_cursor; // '{'
+    skipSpaces();
+    if (m_cursor < m_end && *m_cursor == '}') {
+      ++m_cursor;
+      return true;
+    }
+    for (;;) {
+      skipSpaces();
+      value.m_members.emplace_back();
+      if (m_cursor == m_end || *m_cursor != '"' || !parseString(value.m_members.back().first)) return false;
+      skipSpaces();
+      if (m_cursor == m_end || *m_cursor++ != ':') return false;
+      if (!parseValue(value.m_members.back().second, depth + 1)) return false;
+      skipSpaces();
+      if (m_cursor == m_end) return false;
+      char c = *m_cursor++;
+      if (c == '}') return true;
+      if (c != ',') return false;
+    }
+  }
+
+  bool parseArray(JsonValue& value, int depth) {
+    value.m_type = JsonValue::Array;
+    ++m_cursor; // '['
+    skipSpaces();
+    if (m_cursor < m_end && *m_cursor == ']') {
+      ++m_cursor;
+      return true;
+    }
+    for (;;) {
+      value.m_items.emplace_back();
+      if (!parseValue(value.m_items.back(), depth + 1)) return false;
+      skipSpaces();
+      if (m_cursor == m_end) return false;
+      char c = *m_cursor++;
+      if (c == ']') return true;
+      if (c != ',') return false;
+    }
+  }
+
+  bool parseString(std::string& str) {
+    ++m_cursor; // '"'
+    while (m_cursor < m_end && *m_cursor != '"') {
+      char c = *m_cursor++;
+      if (c != '\\') {
+        str.push_back(c);
+        continue;
+      }
+      if (m_cursor == m_end) return false;
+      c = *m_cursor++;
+      switch (c) {
+      case 'b': str.push_back('\b'); break;
+      case 'f': str.push_back('\f'); break;
+      case 'n': str.push_back('\n'); break;
+      case 'r': str.push_back('\r'); break;
+      case 't': str.push_back('\t'); break;
+      case 'u': {
+        unsigned int codePoint;
+        if (!parseHex4(codePoint)) return false;
+        if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+          unsigned int low;
+          if (!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low >= 0xE000) return false;
+          codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(str, codePoint);
+        break;
+      }
+      default:
+        str.push_back(c); // '"', '\\' and '/'
+      }
+    }
+    if (m_cursor == m_end) return false;
+    ++m_cursor; // '"'
+    return true;
+  }
+
+  bool parseHex4(unsigned int& value) {
+    if (m_end - m_cursor < 4) return false;
+    value = 0;
+    for (int i = 0 ; i < 4 ; ++i) {
+      char c = *m_cursor++;
+      value <<= 4;
+      if (c >= '0' && c <= '9') value |= c - '0';
+      else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+      else return false;
+    }
+    return true;
+  }
+
+  static void appendUtf8(std::string& str, unsigned int codePoint) {
+    if (codePoint < 0x80) {
+      str.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+      str.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+      str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+      str.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+      str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+      str.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+      str.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+      str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+  }
+
+  bool parseNumber(double& number) {
+    // The chunk is not null terminated, so copy the number before strtod
+    char buffer[64];
+    size_t length = 0;
+    while (m_cursor < m_end && length < sizeof(buffer) - 1 && strchr("+-0123456789.eE", *m_cursor)) {
+      buffer[length++] = *m_cursor++;
+    }
+    buffer[length] = '\0';
+    char *numberEnd;
+    number = strtod(buffer, &numberEnd);
+    return length > 0 && numberEnd == buffer + length;
+  }
+
+private:
+  const char *m_cursor;
+  const char *m_end;
+};
+
+/**
+ * Resolved accessor, pointing into the binary chunk.
+ */
+struct GltfAccessor {
+  char *data = nullptr; // first element
+  size_t byteStride = 0;
+  int count = 0;
+  int componentType = 0;
+  int componentCount = 0;
+  bool normalized = false;
+};
+
+struct GltfPrimitive {
+  std::vector<std::pair<std::string, GltfAccessor>> attributes;
+  GltfAccessor indices;
+  bool hasIndices = false;
+  int mode = GLTF_TRIANGLES;
+  int pointCount = 0; // vertex count of the primitive
+  int cornerCount = 0;
+
+  const GltfAccessor* attribute(const std::string& name) const {
+    for (const auto& attribute : attributes) {
+      if (attribute.first == name) return &attribute.second;
+    }
+    return nullptr;
+  }
+};
+
+} // anonymous namespace
+
+//--------------------------------------------------------
+// Import
+
+static size_t componentTypeSize(int componentType) {
+  switch (componentType) {
+  case GLTF_BYTE:
+  case GLTF_UNSIGNED_BYTE:
+    return 1;
+  case GLTF_SHORT:
+  case GLTF_UNSIGNED_SHORT:
+    return 2;
+  case GLTF_UNSIGNED_INT:
+  case GLTF_FLOAT:
+    return 4;
+  default:
+    return 0;
+  }
+}
+
+static int accessorTypeComponentCount(const std::string& type) {
+  if (type == "SCALAR") return 1;
+  if (type == "VEC2") return 2;
+  if (type == "VEC3") return 3;
+  if (type == "VEC4") return 4;
+  return 0; // matrices are not supported
+}
+
+static OfxStatus resolveAccessor(const JsonValue& document, char *bin, size_t binSize, int index, GltfAccessor& accessor) {
+  const JsonValue& json = document["accessors"][index];
+  const JsonValue& bufferView = document["bufferViews"][json["bufferView"].asInt(-1)];
+  if (!json.isObject() || !bufferView.isObject()) {
+    printf("Error: GLB accessor #%d is missing or has no buffer view\n", index);
+    return kOfxStatErrUnsupported;
+  }
+  if (!json["sparse"].isNull()) {
+    printf("Error: sparse GLB accessors are not supported (accessor #%d)\n", index);
+    return kOfxStatErrUnsupported;
+  }
+  if (bufferView["buffer"].asInt(-1) != 0 || nullptr == bin) {
+    printf("Error: GLB accessor #%d does not use the binary chunk\n", index);
+    return kOfxStatErrUnsupported;
+  }
+
+  accessor.count = json["count"].asInt(-1);
+  accessor.componentType = json["componentType"].asInt();
+  accessor.componentCount = accessorTypeComponentCount(json["type"].asString());
+  accessor.normalized = json["normalized"].asBoolean();
+  size_t elementSize = accessor.componentCount * componentTypeSize(accessor.componentType);
+  if (elementSize == 0 || accessor.count < 0) {
+    printf("Error: unsupported type for GLB accessor #%d\n", index);
+    return kOfxStatErrUnsupported;
+  }
+
+  double viewOffset = bufferView["byteOffset"].asNumber();
+  double viewLength = bufferView["byteLength"].asNumber();
+  double accessorOffset = json["byteOffset"].asNumber();
+  // Elements are tightly packed when the buffer view has no byteStride,
+  // otherwise it must be a multiple of 4 in [4, 252] (glTF 2.0, 3.6.2.4)
+  const JsonValue& byteStride = bufferView["byteStride"];
+  double stride = byteStride.asNumber(static_cast<double>(elementSize));
+  if (!byteStride.isNull() && (!byteStride.isNumber() || stride != std::floor(stride) || stride < 4 || stride > 252 || std::fmod(stride, 4.0) != 0)) {
+    printf("Error: invalid byteStride for the buffer view of GLB accessor #%d\n", index);
+    return kOfxStatErrFormat;
+  }
+  accessor.byteStride = static_cast<size_t>(stride);
+  double usedLength = accessor.count == 0 ? 0.0 : accessorOffset + (accessor.count - 1.0) * accessor.byteStride + elementSize;
+  if (viewOffset < 0 || accessorOffset < 0 || accessor.byteStride < elementSize
+    || viewOffset + viewLength > static_cast<double>(binSize)
+    || usedLength > viewLength)
+  {
+    printf("Error: GLB accessor #%d is out of the bounds of the binary chunk\n", index);
+    return kOfxStatErrFormat;
+  }
+  accessor.data = bin + static_cast<size_t>(viewOffset) + static_cast<size_t>(accessorOffset);
+  return kOfxStatOK;
+}
+
+static double readComponent(const char *p, int componentType, bool normalized) {
+  switch (componentType) {
+  case GLTF_BYTE: {
+    int8_t value;
+    memcpy(&value, p, sizeof(value));
+    return normalized ? std::max(value / 127.0, -1.0) : value;
+  }
+  case GLTF_UNSIGNED_BYTE: {
+    uint8_t value;
+    memcpy(&value, p, sizeof(value));
+    return normalized ? value / 255.0 : value;
+  }
+  case GLTF_SHORT: {
+    int16_t value;
+    memcpy(&value, p, sizeof(value));
+    return normalized ? std::max(value / 32767.0, -1.0) : value;
+  }
+  case GLTF_UNSIGNED_SHORT: {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return normalized ? value / 65535.0 : value;
+  }
+  case GLTF_UNSIGNED_INT: {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return normalized ? value / 4294967295.0 : value;
+  }
+  case GLTF_FLOAT: {
+    float value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  default:
+    return 0.0;
+  }
+}
+
+/**
+ * Attribute type able to hold the values of an accessor without loss.
+ */
+static const char* attributeTypeFor(const GltfAccessor& accessor) {
+  if (accessor.componentType == GLTF_UNSIGNED_BYTE) return kOfxMeshAttribTypeUByte;
+  if (accessor.componentType == GLTF_FLOAT || accessor.normalized) return kOfxMeshAttribTypeFloat;
+  return kOfxMeshAttribTypeInt;
+}
+
+/**
+ * Tell whether an attribute of the given type can point directly to the
+ * accessor's data, which requires the same component layout and alignment.
+ */
+static bool canReference(const GltfAccessor& accessor, const char *type) {
+  if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) {
+    return accessor.componentType == GLTF_UNSIGNED_BYTE;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) {
+    return accessor.componentType == GLTF_FLOAT
+      && reinterpret_cast<uintptr_t>(accessor.data) % sizeof(float) == 0
+      && accessor.byteStride % sizeof(float) == 0;
+  }
+  return false;
+}
+
+/**
+ * Copy the elements of all accessors one after the other into a tightly
+ * packed buffer, converting them to the given attribute type.
+ */
+static void gatherAccessors(const std::vector<const GltfAccessor*>& accessors, const char *type, char *dst) {
+  bool isFloat = 0 == strcmp(type, kOfxMeshAttribTypeFloat);
+  bool isUByte = 0 == strcmp(type, kOfxMeshAttribTypeUByte);
+  for (const GltfAccessor *accessor : accessors) {
+    size_t sourceComponentSize = componentTypeSize(accessor->componentType);
+    for (int i = 0 ; i < accessor->count ; ++i) {
+      const char *element = accessor->data + i * accessor->byteStride;
+      if (isUByte) { // only ever converted from unsigned bytes
+        memcpy(dst, element, accessor->componentCount);
+        dst += accessor->componentCount;
+        continue;
+      }
+      for (int k = 0 ; k < accessor->componentCount ; ++k) {
+        double value = readComponent(element + k * sourceComponentSize, accessor->componentType, accessor->normalized);
+        if (isFloat) {
+          float f = static_cast<float>(value);
+          memcpy(dst, &f, sizeof(f));
+        } else {
+          int n = static_cast<int>(value);
+          memcpy(dst, &n, sizeof(n));
+        }
+        dst += 4;
+      }
+    }
+  }
+}
+
+/**
+ * Define a point attribute from the accessors that hold its values in each
+ * primitive, referencing the binary chunk when possible.
+ */
+static OfxStatus definePointAttribute(OfxMeshStruct *mesh,
+                                      const char *name,
+                                      const char *semantic,
+                                      const std::vector<const GltfAccessor*>& accessors,
+                                      const char *type)
+{
+  int componentCount = accessors[0]->componentCount;
+  OfxMeshAttributePropertySet *attrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribPoint,
+                             name,
+                             componentCount,
+                             type,
+                             semantic,
+                             (OfxPropertySetHandle*)&attrib));
+
+  if (accessors.size() == 1 && canReference(*accessors[0], type)) {
+    attrib->data = accessors[0]->data;
+    attrib->byte_stride = accessors[0]->byteStride;
+    attrib->is_owner = 0;
+    return kOfxStatOK;
+  }
+
+  size_t elementSize = componentCount * attributeComponentSize(type);
+  char *data = static_cast<char*>(malloc(std::max(static_cast<size_t>(mesh->properties.point_count) * elementSize, static_cast<size_t>(1))));
+  if (nullptr == data) return kOfxStatErrMemory;
+  gatherAccessors(accessors, type, data);
+  attrib->data = data;
+  attrib->byte_stride = elementSize;
+  attrib->is_owner = 1;
+  return kOfxStatOK;
+}
+
+/**
+ * Name and semantic of the point attribute that receives a glTF attribute.
+ */
+static std::string attributeNameFor(const std::string& gltfName, const char **semantic) {
+  struct Prefix { const char *gltf; const char *name; const char *semantic; };
+  static const Prefix prefixes[] = {
+    { "TEXCOORD_", "uv", kOfxMeshAttribSemanticTextureCoordinate },
+    { "COLOR_", "color", kOfxMeshAttribSemanticColor },
+    { "WEIGHTS_", "weights", kOfxMeshAttribSemanticWeight },
+    { "JOINTS_", "joints", nullptr },
+  };
+
+  *semantic = nullptr;
+  if (gltfName == "NORMAL") {
+    *semantic = kOfxMeshAttribSemanticNormal;
+    return "normal";
+  }
+  for (const Prefix& prefix : prefixes) {
+    size_t length = strlen(prefix.gltf);
+    if (0 == gltfName.compare(0, length, prefix.gltf)) {
+      *semantic = prefix.semantic;
+      std::string set = gltfName.substr(length);
+      return set == "0" ? prefix.name : prefix.name + set;
+    }
+  }
+
+  std::string name = gltfName[0] == '_' ? gltfName.substr(1) : gltfName;
+  for (char& c : name) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  return name;
+}
+
+static OfxStatus readIndex(const GltfAccessor& indices, int i, uint32_t *index) {
+  const char *p = indices.data + i * indices.byteStride;
+  switch (indices.componentType) {
+  case GLTF_UNSIGNED_BYTE: *index = *reinterpret_cast<const uint8_t*>(p); return kOfxStatOK;
+  case GLTF_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, p, sizeof(value)); *index = value; return kOfxStatOK; }
+  case GLTF_UNSIGNED_INT: memcpy(index, p, sizeof(*index)); return kOfxStatOK;
+  default: return kOfxStatErrFormat;
+  }
+}
+
+static OfxStatus defineCornerPoints(OfxMeshStruct *mesh, const std::vector<GltfPrimitive>& primitives) {
+  OfxMeshAttributePropertySet *attrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribCorner,
+                             kOfxMeshAttribCornerPoint,
+                             1,
+                             kOfxMeshAttribTypeInt,
+                             nullptr,
+                             (OfxPropertySetHandle*)&attrib));
+
+  int cornerCount = mesh->properties.corner_count;
+  int pointCount = mesh->properties.point_count;
+
+  // Reference 32-bit indices of a single primitive, once checked
+  if (primitives.size() == 1 && primitives[0].hasIndices) {
+    const GltfAccessor& indices = primitives[0].indices;
+    if (indices.componentType == GLTF_UNSIGNED_INT
+      && indices.byteStride == sizeof(uint32_t)
+      && reinterpret_cast<uintptr_t>(indices.data) % sizeof(uint32_t) == 0)
+    {
+      const uint32_t *data = reinterpret_cast<const uint32_t*>(indices.data);
+      int blockCount = (cornerCount + indexBlockSize - 1) / indexBlockSize;
+      std::vector<char> blockIsValid(blockCount);
+      parallelFor(blockCount, [&](int block) {
+        int end = std::min(cornerCount, (block + 1) * indexBlockSize);
+        bool isValid = true;
+        for (int i = block * indexBlockSize ; i < end ; ++i) {
+          isValid = isValid && data[i] < static_cast<uint32_t>(pointCount);
+        }
+        blockIsValid[block] = isValid;
+      });
+      if (std::find(blockIsValid.begin(), blockIsValid.end(), 0) != blockIsValid.end()) {
+        printf("Error: GLB indices out of range\n");
+        return kOfxStatErrFormat;
+      }
+      attrib->data = indices.data;
+      attrib->byte_stride = sizeof(int);
+      attrib->is_owner = 0;
+      return kOfxStatOK;
+    }
+  }
+
+  int *data = static_cast<int*>(malloc(std::max(static_cast<size_t>(cornerCount) * sizeof(int), sizeof(int))));
+  if (nullptr == data) return kOfxStatErrMemory;
+  attrib->data = reinterpret_cast<char*>(data);
+  attrib->byte_stride = sizeof(int);
+  attrib->is_owner = 1;
+
+  int pointOffset = 0;
+  for (const GltfPrimitive& primitive : primitives) {
+    if (primitive.mode == GLTF_TRIANGLES) {
+      for (int i = 0 ; i < primitive.cornerCount ; ++i) {
+        uint32_t index = static_cast<uint32_t>(i);
+        if (primitive.hasIndices) MFX_ENSURE(readIndex(primitive.indices, i, &index));
+        if (index >= static_cast<uint32_t>(primitive.pointCount)) {
+          printf("Error: GLB indices out of range\n");
+          return kOfxStatErrFormat;
+        }
+        *data++ = pointOffset + static_cast<int>(index);
+      }
+    }
+    pointOffset += primitive.pointCount;
+  }
+  return kOfxStatOK;
+}
+
+// Row major local transform of a glTF node
+static void nodeMatrix(const JsonValue& node, double m[16]) {
+  const JsonValue& matrix = node["matrix"];
+  if (matrix.size() == 16) {
+    for (int i = 0 ; i < 16 ; ++i) {
+      m[(i % 4) * 4 + i / 4] = matrix[i].asNumber(); // glTF is column major
+    }
+    return;
+  }
+
+  const JsonValue& t = node["translation"];
+  const JsonValue& r = node["rotation"];
+  const JsonValue& s = node["scale"];
+  double x = r[0].asNumber(), y = r[1].asNumber(), z = r[2].asNumber(), w = r[3].asNumber(1.0);
+  double rotation[9] = {
+    1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w),
+    2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w),
+    2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y),
+  };
+  for (int row = 0 ; row < 3 ; ++row) {
+    for (int col = 0 ; col < 3 ; ++col) {
+      m[row * 4 + col] = rotation[row * 3 + col] * s[col].asNumber(1.0);
+    }
+    m[row * 4 + 3] = t[row].asNumber();
+  }
+  m[12] = m[13] = m[14] = 0.0;
+  m[15] = 1.0;
+}
+
+/**
+ * Compute the world transform of the first node that instantiates the
+ * given mesh, return false if there is none.
+ */
+static bool meshWorldMatrix(const JsonValue& document, int meshIndex, double matrix[16]) {
+  const JsonValue& nodes = document["nodes"];
+  std::vector<int> parents(nodes.size(), -1);
+  int meshNode = -1;
+  for (size_t i = 0 ; i < nodes.size() ; ++i) {
+    const JsonValue& children = nodes[i]["children"];
+    for (size_t k = 0 ; k < children.size() ; ++k) {
+      int child = children[k].asInt(-1);
+      if (child >= 0 && static_cast<size_t>(child) < parents.size()) parents[child] = static_cast<int>(i);
+    }
+    if (meshNode == -1 && nodes[i]["mesh"].asInt(-1) == meshIndex) meshNode = static_cast<int>(i);
+  }
+  if (meshNode == -1) return false;
+
+  nodeMatrix(nodes[meshNode], matrix);
+  int depth = 0;
+  for (int node = parents[meshNode] ; node != -1 && depth < 256 ; node = parents[node], ++depth) {
+    double parent[16], product[16];
+    nodeMatrix(nodes[node], parent);
+    for (int row = 0 ; row < 4 ; ++row) {
+      for (int col = 0 ; col < 4 ; ++col) {
+        product[row * 4 + col] = 0.0;
+        for (int k = 0 ; k < 4 ; ++k) product[row * 4 + col] += parent[row * 4 + k] * matrix[k * 4 + col];
+      }
+    }
+    memcpy(matrix, product, sizeof(product));
+  }
+  return true;
+}
+
+OfxStatus loadGlbMesh(Blob& blob, OfxMeshStruct *mesh) {
+  // 1. Chunks
+  uint32_t header[5];
+  if (blob.size() < sizeof(header)) {
+    printf("Error: GLB file is too small\n");
+    return kOfxStatErrFormat;
+  }
+  memcpy(header, blob.data(), sizeof(header));
+  if (header[0] != GLB_MAGIC) {
+    printf("Error: not a GLB file\n");
+    return kOfxStatErrFormat;
+  }
+  if (header[1] != 2) {
+    printf("Error: unsupported glTF version %u\n", header[1]);
+    return kOfxStatErrUnsupported;
+  }
+  size_t length = std::min(static_cast<size_t>(header[2]), blob.size());
+  size_t jsonLength = header[3];
+  if (header[4] != GLB_CHUNK_JSON || sizeof(header) + jsonLength > length) {
+    printf("Error: invalid GLB JSON chunk\n");
+    return kOfxStatErrFormat;
+  }
+  const char *json = blob.data() + sizeof(header);
+
+  char *bin = nullptr;
+  size_t binSize = 0;
+  size_t binHeaderOffset = sizeof(header) + jsonLength;
+  if (binHeaderOffset + 8 <= length) {
+    uint32_t binHeader[2];
+    memcpy(binHeader, blob.data() + binHeaderOffset, sizeof(binHeader));
+    if (binHeader[1] == GLB_CHUNK_BIN && binHeaderOffset + 8 + binHeader[0] <= length) {
+      bin = blob.data() + binHeaderOffset + 8;
+      binSize = binHeader[0];
+    }
+  }
+
+  JsonValue document;
+  JsonParser parser(json, json + jsonLength);
+  if (!parser.parse(document)) {
+    printf("Error: malformed GLB JSON chunk\n");
+    return kOfxStatErrFormat;
+  }
+
+  // 2. Primitives of the first mesh
+  const JsonValue& primitivesJson = document["meshes"][0]["primitives"];
+  std::vector<GltfPrimitive> primitives;
+  for (size_t i = 0 ; i < primitivesJson.size() ; ++i) {
+    const JsonValue& primitiveJson = primitivesJson[i];
+    GltfPrimitive primitive;
+    primitive.mode = primitiveJson["mode"].asInt(GLTF_TRIANGLES);
+    if (primitive.mode != GLTF_TRIANGLES && primitive.mode != GLTF_POINTS) {
+      printf("Warning: skipping GLB primitive #%d of unsupported mode %d\n", static_cast<int>(i), primitive.mode);
+      continue;
+    }
+    for (const auto& member : primitiveJson["attributes"].members()) {
+      GltfAccessor accessor;
+      MFX_ENSURE(resolveAccessor(document, bin, binSize, member.second.asInt(-1), accessor));
+      primitive.attributes.emplace_back(member.first, accessor);
+    }
+    const GltfAccessor *position = primitive.attribute("POSITION");
+    if (nullptr == position || position->componentCount != 3) {
+      printf("Error: GLB primitive #%d has no valid POSITION\n", static_cast<int>(i));
+      return kOfxStatErrFormat;
+    }
+    primitive.pointCount = position->count;
+    for (const auto& attribute : primitive.attributes) {
+      if (attribute.second.count != primitive.pointCount) {
+        printf("Error: GLB attribute %s does not have one value per vertex\n", attribute.first.c_str());
+        return kOfxStatErrFormat;
+      }
+    }
+    if (!primitiveJson["indices"].isNull()) {
+      MFX_ENSURE(resolveAccessor(document, bin, binSize, primitiveJson["indices"].asInt(-1), primitive.indices));
+      primitive.hasIndices = true;
+      if (primitive.indices.componentCount != 1 || GLTF_FLOAT == primitive.indices.componentType || GLTF_BYTE == primitive.indices.componentType || GLTF_SHORT == primitive.indices.componentType) {
+        printf("Error: invalid GLB indices for primitive #%d\n", static_cast<int>(i));
+        return kOfxStatErrFormat;
+      }
+    }
+    if (primitive.mode == GLTF_TRIANGLES) {
+      primitive.cornerCount = primitive.hasIndices ? primitive.indices.count : primitive.pointCount;
+      primitive.cornerCount -= primitive.cornerCount % 3;
+    }
+    primitives.push_back(std::move(primitive));
+  }
+  if (primitives.empty()) {
+    printf("Error: GLB file contains no mesh\n");
+    return kOfxStatErrFormat;
+  }
+
+  long long pointCount = 0, cornerCount = 0;
+  for (const GltfPrimitive& primitive : primitives) {
+    pointCount += primitive.pointCount;
+    cornerCount += primitive.cornerCount;
+  }
+  if (pointCount > INT_MAX || cornerCount > INT_MAX) {
+    printf("Error: GLB mesh is too large\n");
+    return kOfxStatErrUnsupported;
+  }
+
+  OfxMeshPropertySet& props = mesh->properties;
+  props.point_count = static_cast<int>(pointCount);
+  props.corner_count = static_cast<int>(cornerCount);
+  props.face_count = static_cast<int>(cornerCount / 3);
+  props.constant_face_size = 3;
+  meshWorldMatrix(document, 0, props.transform_matrix);
+
+  // 3. Attributes, only the ones that all primitives share, position first
+  std::stable_partition(primitives[0].attributes.begin(), primitives[0].attributes.end(), [](const std::pair<std::string, GltfAccessor>& attribute) {
+    return attribute.first == "POSITION";
+  });
+  for (const auto& attribute : primitives[0].attributes) {
+    const std::string& gltfName = attribute.first;
+    std::vector<const GltfAccessor*> accessors;
+    const char *type = gltfName == "POSITION" ? kOfxMeshAttribTypeFloat : attributeTypeFor(attribute.second);
+    for (const GltfPrimitive& primitive : primitives) {
+      const GltfAccessor *accessor = primitive.attribute(gltfName);
+      if (nullptr == accessor || accessor->componentCount != attribute.second.componentCount) break;
+      if (0 != strcmp(attributeTypeFor(*accessor), type)) type = kOfxMeshAttribTypeFloat;
+      accessors.push_back(accessor);
+    }
+    if (accessors.size() != primitives.size()) {
+      printf("Warning: skipping GLB attribute %s, which not all primitives have\n", gltfName.c_str());
+      continue;
+    }
+
+    if (gltfName == "POSITION") {
+      MFX_ENSURE(definePointAttribute(mesh, kOfxMeshAttribPointPosition, nullptr, accessors, type));
+      MFX_ENSURE(defineCornerPoints(mesh, primitives));
+      OfxMeshAttributePropertySet *faceSizeAttrib;
+      MFX_ENSURE(attributeDefine(mesh,
+                                 kOfxMeshAttribFace,
+                                 kOfxMeshAttribFaceSize,
+                                 1,
+                                 kOfxMeshAttribTypeInt,
+                                 nullptr,
+                                 (OfxPropertySetHandle*)&faceSizeAttrib));
+      faceSizeAttrib->is_owner = 0; // constant face size
+    } else {
+      const char *semantic;
+      std::string name = attributeNameFor(gltfName, &semantic);
+      MFX_ENSURE(definePointAttribute(mesh, name.c_str(), semantic, accessors, type));
+    }
+  }
+
+  return kOfxStatOK;
+}
+
+//--------------------------------------------------------
+// Export
+
+namespace {
+
+struct ExportedAttribute {
+  const OfxMeshAttributePropertySet *attrib;
+  std::string gltfName;
+  int componentType; // GLTF_FLOAT or GLTF_UNSIGNED_BYTE
+  size_t elementSize; // in the mesh
+  size_t vertexSize; // in the file, vertex attributes are 4-byte aligned
+  size_t offset; // in the binary chunk
+};
+
+enum SourceDomain {
+  PointDomain,
+  CornerDomain,
+  FaceDomain,
+};
+
+} // anonymous namespace
+
+static void appendf(std::string& str, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  str += buffer;
+}
+
+static void appendJsonString(std::string& str, const std::string& value) {
+  str += '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      str += '\\';
+      str += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      appendf(str, "\\u%04x", c);
+    } else {
+      str += c;
+    }
+  }
+  str += '"';
+}
+
+static SourceDomain attributeDomain(const OfxMeshAttributePropertySet *attrib) {
+  if (0 == strcmp(attrib->attachment, kOfxMeshAttribCorner)) return CornerDomain;
+  if (0 == strcmp(attrib->attachment, kOfxMeshAttribFace)) return FaceDomain;
+  return PointDomain;
+}
+
+/**
+ * List the attributes that glTF can represent and give them glTF names.
+ */
+static std::vector<ExportedAttribute> listExportedAttributes(const OfxMeshStruct *mesh) {
+  std::vector<ExportedAttribute> exported;
+  int texCoordSet = 0, colorSet = 0;
+  bool hasNormal = false;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribMesh)
+      || nullptr == attrib->data
+      || attrib->component_count < 1
+      || attrib->component_count > 4)
+    {
+      continue;
+    }
+
+    bool isFloat = 0 == strcmp(attrib->type, kOfxMeshAttribTypeFloat);
+    bool isColor = 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticColor);
+    bool isUByteColor = isColor && 0 == strcmp(attrib->type, kOfxMeshAttribTypeUByte) && attrib->component_count >= 3;
+    if (!isFloat && !isUByteColor) continue; // integer attributes cannot be glTF vertex attributes
+
+    ExportedAttribute entry;
+    entry.attrib = attrib;
+    entry.componentType = isFloat ? GLTF_FLOAT : GLTF_UNSIGNED_BYTE;
+    entry.elementSize = attrib->component_count * attributeComponentSize(attrib->type);
+    entry.vertexSize = (entry.elementSize + 3) & ~static_cast<size_t>(3);
+    entry.offset = 0;
+
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribPoint) && 0 == strcmp(attrib->name, kOfxMeshAttribPointPosition)) {
+      if (attrib->component_count != 3 || !isFloat) continue;
+      entry.gltfName = "POSITION";
+    } else if (!hasNormal && isFloat && attrib->component_count == 3 && 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticNormal)) {
+      entry.gltfName = "NORMAL";
+      hasNormal = true;
+    } else if (isFloat && attrib->component_count == 2 && 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticTextureCoordinate)) {
+      entry.gltfName = "TEXCOORD_" + std::to_string(texCoordSet++);
+    } else if (isColor && attrib->component_count >= 3) {
+      entry.gltfName = "COLOR_" + std::to_string(colorSet++);
+    } else if (isFloat) {
+      // Custom attributes must start with an underscore
+      entry.gltfName = "_";
+      for (const char *c = attrib->name ; *c ; ++c) entry.gltfName += static_cast<char>(toupper(static_cast<unsigned char>(*c)));
+    } else {
+      continue;
+    }
+    exported.push_back(entry);
+  }
+  // Position first, it is the one with bounds in the accessors
+  std::stable_partition(exported.begin(), exported.end(), [](const ExportedAttribute& entry) {
+    return entry.gltfName == "POSITION";
+  });
+  return exported;
+}
+
+OfxStatus saveGlbMesh(const char *filename, const OfxMeshStruct *mesh) {
+  OfxMeshHandle meshHandle = const_cast<OfxMeshHandle>(mesh);
+  const OfxMeshPropertySet& props = mesh->properties;
+  OfxMeshAttributePropertySet *cornerPointAttrib;
+  MFX_ENSURE(meshGetAttribute(meshHandle, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint, (OfxPropertySetHandle*)&cornerPointAttrib));
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(mesh, cornerPointAttrib);
+  auto faceSizes = mfx::makeFaceSizeView(mesh);
+
+  std::vector<ExportedAttribute> attributes = listExportedAttributes(mesh);
+  if (attributes.empty() || attributes[0].gltfName != "POSITION") {
+    printf("Error: cannot save a mesh without float point positions to GLB\n");
+    return kOfxStatErrUnsupported;
+  }
+
+  // 1. Triangulate faces as fans
+  bool hasCornerDomain = false;
+  bool hasFaceDomain = false;
+  for (const ExportedAttribute& attribute : attributes) {
+    hasCornerDomain = hasCornerDomain || attributeDomain(attribute.attrib) != PointDomain;
+    hasFaceDomain = hasFaceDomain || attributeDomain(attribute.attrib) == FaceDomain;
+  }
+  std::vector<uint32_t> corners; // corners of the triangles
+  std::vector<int> cornerFaces(hasFaceDomain ? props.corner_count : 0);
+  int cornerOffset = 0;
+  for (int face = 0 ; face < props.face_count ; ++face) {
+    int faceSize = faceSizes.get(face);
+    for (int k = 2 ; k < faceSize ; ++k) {
+      corners.push_back(cornerOffset);
+      corners.push_back(cornerOffset + k - 1);
+      corners.push_back(cornerOffset + k);
+    }
+    if (hasFaceDomain) {
+      std::fill(cornerFaces.begin() + cornerOffset, cornerFaces.begin() + cornerOffset + faceSize, face);
+    }
+    cornerOffset += faceSize;
+  }
+
+  // Without corner nor face attributes, points are shared by triangles,
+  // otherwise each corner gets its own vertex.
+  bool isPointCloud = corners.empty();
+  bool perCorner = hasCornerDomain && !isPointCloud;
+  if (!perCorner) {
+    for (uint32_t& corner : corners) corner = static_cast<uint32_t>(cornerPoints.get(corner));
+    auto end = std::remove_if(attributes.begin(), attributes.end(), [](const ExportedAttribute& attribute) {
+      return attributeDomain(attribute.attrib) != PointDomain;
+    });
+    attributes.erase(end, attributes.end());
+  }
+  int vertexCount = perCorner ? props.corner_count : props.point_count;
+  if (vertexCount == 0) {
+    printf("Error: cannot save an empty mesh to GLB\n");
+    return kOfxStatErrUnsupported;
+  }
+
+  // Index of the element of an attribute that a vertex uses
+  auto sourceIndex = [&](const ExportedAttribute& attribute, int vertex) {
+    if (attribute.attrib->byte_stride == 0) return 0;
+    if (!perCorner) return vertex;
+    switch (attributeDomain(attribute.attrib)) {
+    case PointDomain: return cornerPoints.get(vertex);
+    case FaceDomain: return cornerFaces[vertex];
+    default: return vertex;
+    }
+  };
+
+  // 2. Layout of the binary chunk: indices, then attributes
+  size_t binSize = corners.size() * sizeof(uint32_t);
+  for (ExportedAttribute& attribute : attributes) {
+    attribute.offset = binSize;
+    binSize += attribute.vertexSize * vertexCount;
+  }
+
+  float minPosition[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float maxPosition[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (int v = 0 ; v < vertexCount ; ++v) {
+    float position[3];
+    memcpy(position, attributes[0].attrib->data + sourceIndex(attributes[0], v) * attributes[0].attrib->byte_stride, sizeof(position));
+    for (int k = 0 ; k < 3 ; ++k) {
+      minPosition[k] = std::min(minPosition[k], position[k]);
+      maxPosition[k] = std::max(maxPosition[k], position[k]);
+    }
+  }
+
+  // 3. JSON chunk
+  std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"WebMfx\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0";
+  bool isIdentity = true;
+  for (int i = 0 ; i < 16 ; ++i) isIdentity = isIdentity && props.transform_matrix[i] == (i % 5 == 0 ? 1.0 : 0.0);
+  if (!isIdentity) {
+    json += ",\"matrix\":[";
+    for (int i = 0 ; i < 16 ; ++i) {
+      appendf(json, i > 0 ? ",%.17g" : "%.17g", props.transform_matrix[(i % 4) * 4 + i / 4]);
+    }
+    json += "]";
+  }
+  json += "}],\"meshes\":[{\"primitives\":[{\"attributes\":{";
+  int accessorIndex = isPointCloud ? 0 : 1;
+  for (size_t i = 0 ; i < attributes.size() ; ++i) {
+    if (i > 0) json += ",";
+    appendJsonString(json, attributes[i].gltfName);
+    appendf(json, ":%d", accessorIndex++);
+  }
+  json += "}";
+  if (isPointCloud) {
+    appendf(json, ",\"mode\":%d", GLTF_POINTS);
+  } else {
+    json += ",\"indices\":0";
+  }
+  json += "}]}],\"accessors\":[";
+  int bufferViewIndex = 0;
+  if (!isPointCloud) {
+    appendf(json, "{\"bufferView\":%d,\"componentType\":%d,\"count\":%d,\"type\":\"SCALAR\"}",
+            bufferViewIndex++, GLTF_UNSIGNED_INT, static_cast<int>(corners.size()));
+  }
+  for (size_t i = 0 ; i < attributes.size() ; ++i) {
+    const ExportedAttribute& attribute = attributes[i];
+    static const char *types[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+    if (!isPointCloud || i > 0) json += ",";
+    appendf(json, "{\"bufferView\":%d,\"componentType\":%d,\"count\":%d,\"type\":\"%s\"",
+            bufferViewIndex++, attribute.componentType, vertexCount, types[attribute.attrib->component_count - 1]);
+    if (attribute.componentType == GLTF_UNSIGNED_BYTE) json += ",\"normalized\":true";
+    if (i == 0) {
+      appendf(json, ",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]",
+              minPosition[0], minPosition[1], minPosition[2],
+              maxPosition[0], maxPosition[1], maxPosition[2]);
+    }
+    json += "}";
+  }
+  json += "],\"bufferViews\":[";
+  if (!isPointCloud) {
+    appendf(json, "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu,\"target\":34963}", corners.size() * sizeof(uint32_t));
+  }
+  for (size_t i = 0 ; i < attributes.size() ; ++i) {
+    const ExportedAttribute& attribute = attributes[i];
+    if (!isPointCloud || i > 0) json += ",";
+    appendf(json, "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu,\"byteStride\":%zu,\"target\":34962}",
+            attribute.offset, attribute.vertexSize * vertexCount, attribute.vertexSize);
+  }
+  appendf(json, "],\"buffers\":[{\"byteLength\":%zu}]}", binSize);
+  while (json.size() % 4 != 0) json += ' ';
+
+  // 4. File
+  BufferedWriter writer;
+  if (!writer.open(filename)) {
+    printf("Error: could not open file for writing: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+
+  uint32_t header[5] = {
+    GLB_MAGIC,
+    2,
+    static_cast<uint32_t>(sizeof(header) + json.size() + 8 + binSize),
+    static_cast<uint32_t>(json.size()),
+    GLB_CHUNK_JSON,
+  };
+  uint32_t binHeader[2] = { static_cast<uint32_t>(binSize), GLB_CHUNK_BIN };
+  writer.write(header, sizeof(header));
+  writer.write(json.data(), json.size());
+  writer.write(binHeader, sizeof(binHeader));
+  writer.write(corners.data(), corners.size() * sizeof(uint32_t));
+
+  for (const ExportedAttribute& attribute : attributes) {
+    auto view = mfx::makeByteView(mesh, attribute.attrib);
+    if (!perCorner && view.byteStride() == attribute.elementSize && attribute.vertexSize == attribute.elementSize) {
+      // Already laid out as glTF expects
+      writer.write(view.bytes(0), attribute.elementSize * vertexCount);
+      continue;
+    }
+    for (int v = 0 ; v < vertexCount ; ++v) {
+      writer.write(view.bytes(sourceIndex(attribute, v)), attribute.elementSize);
+      writer.pad(attribute.vertexSize - attribute.elementSize);
+    }
+  }
+
+  if (!writer.close()) {
+    printf("Error: could not write GLB file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  return kOfxStatOK;
+}
@@ -0,0 +1,47 @@
+#ifndef _GltfFormat_h_
+#define _GltfFormat_h_
+
+/**
+ * Binary glTF 2.0 (GLB) import and export.
+ *
+ * glTF vertices become mesh points and triangles become faces of constant
+ * size 3. Vertex attributes are mapped as follows, other ones keep their
+ * name in lower case, without the leading underscore of custom attributes:
+ *
+ *   POSITION     <-> point position
+ *   NORMAL       <-> point "normal"
+ *   TEXCOORD_n   <-> point "uv", "uv1", ...
+ *   COLOR_n      <-> point "color", "color1", ...
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+class Blob;
+
+/**
+ * Define the attributes of a mesh initialized with meshInit() from the
+ * triangles and points of the first mesh of a GLB file. Whenever the layout
+ * of an accessor matches the attribute type, the attribute points directly
+ * into the binary chunk of the blob (with is_owner = 0 and the byteStride of
+ * the buffer view), so the blob must outlive the mesh. Other accessors, and
+ * all of them when the glTF mesh has several primitives, are converted into
+ * buffers owned by the attributes.
+ * The world transform of the first node that instantiates the mesh, if any,
+ * is stored in the transform matrix of the mesh.
+ */
+OfxStatus loadGlbMesh(Blob& blob, OfxMeshStruct *mesh);
+
+/**
+ * Write a mesh to a GLB file as a single indexed triangle primitive, faces
+ * being triangulated as fans. Float attributes with 1 to 4 components and
+ * unsigned byte colors are exported. When the mesh has corner or face
+ * attributes, there is one glTF vertex per corner, otherwise one per point.
+ * A mesh without any face is exported as a point cloud.
+ */
+OfxStatus saveGlbMesh(const char *filename, const OfxMeshStruct *mesh);
+
+#endif // _GltfFormat_h_
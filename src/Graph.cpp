@@ -0,0 +1,428 @@
+#include "Graph.h"
+#include "Hash.h"
+#include "Parallel.h"
+
+#include <ofxMeshEffect.h>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Make dst point to the buffers of src without taking ownership of them,
+ * so that cooking the consumer neither copies nor frees them.
+ */
+static void borrowMesh(OfxMeshStruct *dst, const OfxMeshStruct *src) {
+  meshShallowCopy(dst, src);
+  for (int i = 0 ; i < 32 ; ++i) {
+    dst->attributes[i].is_owner = 0;
+  }
+}
+
+bool Graph::Output::contains(const char *data) const {
+  for (int i = 0 ; i < 32 && mesh.attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh.attributes[i];
+    if (nullptr == attrib->data) continue;
+    int elementCount = attributeElementCount(attrib, &mesh.properties);
+    size_t size = attrib->component_count * attributeComponentSize(attrib->type);
+    if (elementCount > 1) size += attrib->byte_stride * (elementCount - 1);
+    if (data >= attrib->data && data < attrib->data + size) return true;
+  }
+  return false;
+}
+
+int Graph::addNode(const OfxPlugin *plugin, OfxMeshEffectStruct *instance) {
+  for (const Node& node : m_nodes) {
+    if (node.instance == instance) {
+      printf("Error: this effect instance is already part of the graph\n");
+      return -1;
+    }
+  }
+  Node node;
+  node.plugin = plugin;
+  node.instance = instance;
+  m_nodes.push_back(std::move(node));
+  return nodeCount() - 1;
+}
+
+OfxStatus Graph::connect(int source, int target, const char *inputName) {
+  if (!isValidNode(source) || !isValidNode(target)) return kOfxStatErrBadIndex;
+  if (nullptr == findInput(target, inputName)) return kOfxStatErrBadIndex;
+  if (source == target || dependsOn(source, target)) {
+    printf("Error: connecting node #%d to node #%d would create a cycle\n", source, target);
+    return kOfxStatErrValue;
+  }
+  Link& l = link(target, inputName);
+  l.source = source;
+  l.mesh = nullptr;
+  return kOfxStatOK;
+}
+
+OfxStatus Graph::disconnect(int target, const char *inputName) {
+  if (!isValidNode(target)) return kOfxStatErrBadIndex;
+  std::vector<Link>& links = m_nodes[target].links;
+  auto it = std::find_if(links.begin(), links.end(), [inputName](const Link& l) {
+    return l.inputName == inputName;
+  });
+  if (it == links.end()) return kOfxStatErrBadIndex;
+  links.erase(it);
+  return kOfxStatOK;
+}
+
+OfxStatus Graph::setInputMesh(int node, const char *inputName, const OfxMeshStruct *mesh) {
+  if (!isValidNode(node) || nullptr == findInput(node, inputName)) return kOfxStatErrBadIndex;
+  if (nullptr == mesh) return kOfxStatErrBadHandle;
+  Link& l = link(node, inputName);
+  l.source = -1;
+  l.mesh = mesh;
+  return kOfxStatOK;
+}
+
+OfxStatus Graph::setKeepOutput(int node, bool keep) {
+  if (!isValidNode(node)) return kOfxStatErrBadIndex;
+  m_nodes[node].keepOutput = keep;
+  return kOfxStatOK;
+}
+
+void Graph::setCaching(bool enabled) {
+  // Outputs cooked without caching have no stamp
+  if (enabled != m_caching) releaseOutputs();
+  m_caching = enabled;
+}
+
+OfxStatus Graph::cook() {
+  Clock::time_point start = Clock::now();
+  m_stats = CookStats();
+  if (!m_caching) releaseOutputs();
+
+  std::vector<int> order;
+  if (!sortNodes(order)) {
+    printf("Error: the graph has a cycle\n");
+    return kOfxStatErrValue;
+  }
+
+  int count = nodeCount();
+  std::vector<std::vector<int>> consumers(count);
+  std::vector<int> missingInputs(count, 0);
+  // Number of consumers of each node that are not cooked yet
+  std::vector<int> pendingConsumers(count, 0);
+  for (int n = 0 ; n < count ; ++n) {
+    for (const Link& l : m_nodes[n].links) {
+      if (l.source < 0) continue;
+      consumers[l.source].push_back(n);
+      ++missingInputs[n];
+      ++pendingConsumers[l.source];
+    }
+  }
+  std::vector<bool> keep(count);
+  for (int n = 0 ; n < count ; ++n) {
+    keep[n] = m_caching || m_nodes[n].keepOutput || 0 == pendingConsumers[n];
+  }
+
+  // Among ready nodes, cook first the one with the longest path to a sink,
+  // estimated from the durations of the previous cook.
+  std::vector<double> priority(count, 0);
+  for (auto it = order.rbegin() ; it != order.rend() ; ++it) {
+    double downstream = 0;
+    for (int consumer : consumers[*it]) downstream = std::max(downstream, priority[consumer]);
+    priority[*it] = std::max(m_nodes[*it].cookTime, 1e-6) + downstream;
+  }
+
+  std::mutex mutex;
+  std::condition_variable readyCondition;
+  std::vector<int> ready;
+  for (int n = 0 ; n < count ; ++n) {
+    if (0 == missingInputs[n]) ready.push_back(n);
+  }
+  int remaining = count;
+  OfxStatus status = kOfxStatOK;
+
+  // Each worker cooks ready nodes until all nodes are done, so that a
+  // single one is enough to cook the whole graph.
+  auto worker = [&](int) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      readyCondition.wait(lock, [&] { return !ready.empty() || 0 == remaining || kOfxStatOK != status; });
+      if (0 == remaining || kOfxStatOK != status) return;
+
+      auto next = std::max_element(ready.begin(), ready.end(), [&](int a, int b) {
+        return priority[a] < priority[b] || (priority[a] == priority[b] && a > b);
+      });
+      int n = *next;
+      ready.erase(next);
+
+      lock.unlock();
+      Evaluation evaluation = evaluateNode(n);
+      lock.lock();
+
+      --remaining;
+      if (kOfxStatOK != evaluation.status) {
+        printf("Error: node #%d of the graph failed to cook (status %d)\n", n, evaluation.status);
+        status = evaluation.status;
+        readyCondition.notify_all();
+        return;
+      }
+      if (evaluation.reused) ++m_stats.reused;
+      else ++m_stats.cooked;
+      if (evaluation.unchanged) ++m_stats.unchanged;
+
+      for (int consumer : consumers[n]) {
+        if (0 == --missingInputs[consumer]) ready.push_back(consumer);
+      }
+      for (const Link& l : m_nodes[n].links) {
+        if (l.source < 0) continue;
+        if (0 == --pendingConsumers[l.source] && !keep[l.source]) {
+          m_nodes[l.source].output.reset();
+        }
+      }
+      readyCondition.notify_all();
+    }
+  };
+
+  // When each node consumes the previous one in the topological order,
+  // there is nothing to cook concurrently, so nodes are cooked on the
+  // calling thread and remain free to use all threads themselves.
+  bool isChain = true;
+  for (int i = 1 ; i < count && isChain ; ++i) {
+    const std::vector<int>& next = consumers[order[i - 1]];
+    isChain = std::find(next.begin(), next.end(), order[i]) != next.end();
+  }
+  int workerCount = isChain ? 1 : std::min(threadCount(), count);
+  if (workerCount > 1) {
+    parallelFor(workerCount, worker);
+  } else {
+    worker(0);
+  }
+
+  if (kOfxStatOK != status) {
+    if (!m_caching) releaseOutputs();
+    return status;
+  }
+
+  // Critical path, i.e. the longest chain of dependent cooks, which bounds
+  // the duration of the cook whatever the number of threads.
+  std::vector<double> finish(count, 0);
+  for (int n : order) {
+    double inputsReady = 0;
+    for (const Link& l : m_nodes[n].links) {
+      if (l.source >= 0) inputsReady = std::max(inputsReady, finish[l.source]);
+    }
+    finish[n] = inputsReady + m_nodes[n].cookTime;
+    m_stats.workTime += m_nodes[n].cookTime;
+    m_stats.criticalPathTime = std::max(m_stats.criticalPathTime, finish[n]);
+  }
+  m_stats.time = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("[host] Graph cooked in %.3fs on %d thread(s): %d node(s) cooked, %d reused, work %.3fs, critical path %.3fs\n",
+    m_stats.time, workerCount, m_stats.cooked, m_stats.reused, m_stats.workTime, m_stats.criticalPathTime);
+  return kOfxStatOK;
+}
+
+double Graph::nodeCookTime(int node) const {
+  return isValidNode(node) ? m_nodes[node].cookTime : 0;
+}
+
+const OfxMeshStruct* Graph::outputMesh(int node) const {
+  if (!isValidNode(node) || !m_nodes[node].output) return nullptr;
+  return &m_nodes[node].output->mesh;
+}
+
+void Graph::clear() {
+  m_nodes.clear();
+}
+
+OfxMeshInputStruct* Graph::findInput(int node, const char *inputName) const {
+  OfxMeshEffectStruct *instance = m_nodes[node].instance;
+  if (0 == strcmp(inputName, kOfxMeshMainOutput)) return nullptr;
+  for (int i = 0 ; i < 16 && instance->inputs[i].is_valid ; ++i) {
+    if (0 == strcmp(instance->inputs[i].name, inputName)) return &instance->inputs[i];
+  }
+  return nullptr;
+}
+
+Graph::Link& Graph::link(int node, const char *inputName) {
+  std::vector<Link>& links = m_nodes[node].links;
+  for (Link& l : links) {
+    if (l.inputName == inputName) return l;
+  }
+  links.emplace_back();
+  links.back().inputName = inputName;
+  return links.back();
+}
+
+bool Graph::dependsOn(int node, int other) const {
+  std::vector<bool> visited(m_nodes.size(), false);
+  std::vector<int> stack = { node };
+  while (!stack.empty()) {
+    int n = stack.back();
+    stack.pop_back();
+    if (n == other) return true;
+    if (visited[n]) continue;
+    visited[n] = true;
+    for (const Link& l : m_nodes[n].links) {
+      if (l.source >= 0) stack.push_back(l.source);
+    }
+  }
+  return false;
+}
+
+bool Graph::sortNodes(std::vector<int>& order) const {
+  // Kahn's algorithm, taking ready nodes by increasing index so that the
+  // order only depends on the graph
+  std::vector<int> missingInputs(m_nodes.size(), 0);
+  std::vector<std::vector<int>> consumers(m_nodes.size());
+  for (int n = 0 ; n < nodeCount() ; ++n) {
+    for (const Link& l : m_nodes[n].links) {
+      if (l.source < 0) continue;
+      ++missingInputs[n];
+      consumers[l.source].push_back(n);
+    }
+  }
+
+  order.clear();
+  std::vector<int> ready;
+  for (int n = nodeCount() - 1 ; n >= 0 ; --n) {
+    if (0 == missingInputs[n]) ready.push_back(n);
+  }
+  while (!ready.empty()) {
+    int n = ready.back();
+    ready.pop_back();
+    order.push_back(n);
+    for (int consumer : consumers[n]) {
+      if (0 == --missingInputs[consumer]) {
+        ready.insert(std::upper_bound(ready.begin(), ready.end(), consumer, std::greater<int>()), consumer);
+      }
+    }
+  }
+  return order.size() == m_nodes.size();
+}
+
+uint64_t Graph::computeStamp(int n) const {
+  const Node& node = m_nodes[n];
+  uint64_t h = hashBytes(nullptr, 0);
+
+  const OfxParamSetStruct& parameters = node.instance->parameters;
+  for (int i = 0 ; i < parameters.count ; ++i) {
+    const OfxParamStruct *param = parameters.entries[i];
+    h = hashParamValues(param->kind, param->values, h);
+    // Plugins may evaluate animated parameters at any time
+    h = hashCombine(h, static_cast<uint64_t>(param->key_count));
+    for (int k = 0 ; k < param->key_count ; ++k) {
+      const OfxParamKeyStruct& key = param->keys[k];
+      h = hashBytes(&key.time, sizeof(double), h);
+      h = hashParamValues(param->kind, key.values, h);
+      h = hashCombine(h, static_cast<uint64_t>(key.interpolation));
+    }
+  }
+
+  const OfxMeshEffectStruct *instance = node.instance;
+  for (int i = 0 ; i < 16 && instance->inputs[i].is_valid ; ++i) {
+    const OfxMeshInputStruct *input = &instance->inputs[i];
+    if (0 == strcmp(input->name, kOfxMeshMainOutput)) continue;
+    uint64_t inputHash = 0; // not connected
+    for (const Link& l : node.links) {
+      if (l.inputName != input->name) continue;
+      inputHash = l.source >= 0 ? m_nodes[l.source].outputHash : hashMesh(l.mesh);
+    }
+    h = hashCombine(hashBytes(input->name, strlen(input->name), h), inputHash);
+  }
+  return h;
+}
+
+Graph::Evaluation Graph::evaluateNode(int n) {
+  Node& node = m_nodes[n];
+  Evaluation evaluation;
+  node.cookTime = 0;
+
+  uint64_t stamp = 0;
+  if (m_caching) {
+    stamp = computeStamp(n);
+    if (node.output && stamp == node.stamp) {
+      evaluation.reused = true;
+      return evaluation;
+    }
+  }
+
+  Clock::time_point start = Clock::now();
+  evaluation.status = cookNode(n);
+  if (kOfxStatOK != evaluation.status) return evaluation;
+
+  if (m_caching) {
+    // Consumers are reused if this hash is the same as before
+    uint64_t outputHash = hashMesh(&node.output->mesh);
+    evaluation.unchanged = outputHash == node.outputHash;
+    node.outputHash = outputHash;
+    node.stamp = stamp;
+  }
+  node.cookTime = std::chrono::duration<double>(Clock::now() - start).count();
+  return evaluation;
+}
+
+OfxStatus Graph::cookNode(int n) {
+  Node& node = m_nodes[n];
+  OfxMeshEffectStruct *instance = node.instance;
+
+  OfxMeshInputStruct *output = nullptr;
+  for (int i = 0 ; i < 16 && instance->inputs[i].is_valid ; ++i) {
+    OfxMeshInputStruct *input = &instance->inputs[i];
+    if (0 == strcmp(input->name, kOfxMeshMainOutput)) {
+      output = input;
+      continue;
+    }
+    // Inputs that are not connected are empty
+    meshInit(&input->mesh);
+    for (const Link& l : node.links) {
+      if (l.inputName != input->name) continue;
+      borrowMesh(&input->mesh, l.source >= 0 ? &m_nodes[l.source].output->mesh : l.mesh);
+    }
+  }
+  if (nullptr == output) return kOfxStatErrBadHandle;
+
+  meshDestroy(&output->mesh);
+  meshInit(&output->mesh);
+  node.output.reset();
+
+  OfxStatus status = node.plugin->mainEntry(kOfxMeshEffectActionCook, instance, NULL, NULL);
+  // Some plugins reply with the "default" status once done, like for
+  // actions they do not handle
+  if (kOfxStatReplyDefault == status) status = kOfxStatOK;
+
+  if (kOfxStatOK == status) {
+    // Take ownership of the output buffers, leaving the instance's output
+    // empty, and retain the outputs it forwards buffers from.
+    std::shared_ptr<Output> taken = std::make_shared<Output>();
+    taken->mesh = output->mesh;
+    meshInit(&output->mesh);
+    for (int i = 0 ; i < 32 && taken->mesh.attributes[i].is_valid ; ++i) {
+      const OfxMeshAttributePropertySet *attrib = &taken->mesh.attributes[i];
+      if (attrib->is_owner || nullptr == attrib->data) continue;
+      for (const Link& l : node.links) {
+        if (l.source < 0) continue;
+        const std::shared_ptr<const Output>& upstream = m_nodes[l.source].output;
+        if (upstream->contains(attrib->data)
+          && std::find(taken->upstream.begin(), taken->upstream.end(), upstream) == taken->upstream.end())
+        {
+          taken->upstream.push_back(upstream);
+        }
+      }
+    }
+    node.output = taken;
+  } else {
+    meshDestroy(&output->mesh);
+    meshInit(&output->mesh);
+  }
+
+  // Inputs must not keep pointing to buffers that may be freed
+  for (int i = 0 ; i < 16 && instance->inputs[i].is_valid ; ++i) {
+    if (&instance->inputs[i] != output) meshInit(&instance->inputs[i].mesh);
+  }
+  return status;
+}
+
+void Graph::releaseOutputs() {
+  for (Node& node : m_nodes) {
+    node.output.reset();
+  }
+}
@@ -0,0 +1,212 @@
+#ifndef _Graph_h_
+#define _Graph_h_
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Mesh;
+class EffectInstance;
+
+/**
+ * Pipeline of effect instances, e.g. Box -> ComputeNormals -> ...
+ *
+ * Nodes are effect instances, which the graph does not own. Edges connect
+ * the main output of a node to a named input of another one, and inputs
+ * that are not connected may be fed with meshes owned by the caller.
+ *
+ * cook() runs the nodes in topological order. The output of a node is
+ * taken from its instance once it is cooked and handed to its consumers
+ * by reference, without copying any buffer.
+ *
+ * Outputs are cached from one cook to the next, so that changing a
+ * parameter only cooks the node and its dependents. Each node has a stamp,
+ * which is a hash of its parameter values and of the content of its
+ * inputs, and it is only cooked if its stamp differs from the one of its
+ * cached output. The content of each new output is hashed too, so when a
+ * node cooks to an identical output its consumers are not cooked either.
+ *
+ * Nodes that do not depend on each other, e.g. the upstream chains of the
+ * inputs of a boolean or merge effect, are cooked concurrently on the
+ * thread pool of Parallel.h. Ready nodes are picked by decreasing length
+ * of their path to a sink, estimated from the durations of the previous
+ * cook, so that the critical path starts first.
+ *
+ * When caching is disabled, an output is freed as soon as all of its
+ * consumers are cooked, unless it is kept (see setKeepOutput()) or an
+ * output further down still points into its buffers, which is the case of
+ * attributes forwarded by plugins. Outputs of nodes that have no consumer
+ * are always kept.
+ */
+class Graph {
+public:
+  Graph() {}
+  Graph(const Graph&) = delete;
+  Graph& operator=(const Graph&) = delete;
+
+  /**
+   * Add a node and return its index, or -1 if the instance is already part
+   * of the graph. The instance must outlive the graph, or its next call to
+   * clear(). Its output is only available through outputMesh() after
+   * cooking the graph.
+   */
+  int addNode(const OfxPlugin *plugin, OfxMeshEffectStruct *instance);
+  // Defined along with the JavaScript bindings
+  int addNode(EffectInstance *instance);
+
+  int nodeCount() const { return static_cast<int>(m_nodes.size()); }
+
+  /**
+   * Feed the main output of source to the input of target called
+   * inputName, replacing what was previously connected to it. Fails with
+   * kOfxStatErrValue if this would create a cycle.
+   */
+  OfxStatus connect(int source, int target, const char *inputName);
+  OfxStatus disconnect(int target, const char *inputName);
+
+  /**
+   * Feed a mesh to an input, replacing what was previously connected to
+   * it. The mesh must remain valid until the graph is cooked, and so do
+   * outputs that forward its attributes.
+   */
+  OfxStatus setInputMesh(int node, const char *inputName, const OfxMeshStruct *mesh);
+  // Defined along with the JavaScript bindings
+  OfxStatus setInputMesh(int node, const char *inputName, const Mesh *mesh);
+
+  /**
+   * Tell whether the output of a node that has consumers must remain
+   * available after cook(), e.g. to display an intermediate result.
+   */
+  OfxStatus setKeepOutput(int node, bool keep);
+
+  /**
+   * Keep outputs between cooks to reuse them, which is the default.
+   * Switching caching on or off releases all outputs.
+   */
+  void setCaching(bool enabled);
+  bool caching() const { return m_caching; }
+
+  /**
+   * Cook the nodes whose parameters or inputs changed since the previous
+   * cook, or all nodes if caching is disabled.
+   */
+  OfxStatus cook();
+
+  /**
+   * Statistics of the last cook: number of nodes that were cooked, that
+   * were reused from the cache without cooking, and that were cooked but
+   * gave the very same output as before, so that their consumers were
+   * reused.
+   */
+  int cookedNodeCount() const { return m_stats.cooked; }
+  int reusedNodeCount() const { return m_stats.reused; }
+  int unchangedNodeCount() const { return m_stats.unchanged; }
+
+  /**
+   * Timings of the last cook, in seconds: its duration, the sum of the
+   * durations of the cooked nodes, and the critical path, i.e. the longest
+   * chain of dependent cooks, which bounds the duration of the cook
+   * whatever the number of threads. Reused nodes count for 0.
+   */
+  double cookTime() const { return m_stats.time; }
+  double workTime() const { return m_stats.workTime; }
+  double criticalPathTime() const { return m_stats.criticalPathTime; }
+  double nodeCookTime(int node) const;
+
+  /**
+   * Output of a node after cook(), or null if it was not kept. It is valid
+   * until the next call to cook(), setCaching() or clear().
+   */
+  const OfxMeshStruct* outputMesh(int node) const;
+  // Defined along with the JavaScript bindings
+  Mesh getOutputMesh(int node) const;
+
+  /**
+   * Remove all nodes, releasing their outputs.
+   */
+  void clear();
+
+private:
+  /**
+   * Output mesh of a node, which owns its buffers.
+   */
+  struct Output {
+    OfxMeshStruct mesh;
+    // Outputs that attributes of this one forward buffers from
+    std::vector<std::shared_ptr<const Output>> upstream;
+
+    Output() { meshInit(&mesh); }
+    ~Output() { meshDestroy(&mesh); }
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    // Whether data points into a buffer of this mesh
+    bool contains(const char *data) const;
+  };
+
+  struct Link {
+    std::string inputName;
+    int source = -1; // node index, or -1 if fed with mesh
+    const OfxMeshStruct *mesh = nullptr;
+  };
+
+  struct Node {
+    const OfxPlugin *plugin;
+    OfxMeshEffectStruct *instance;
+    std::vector<Link> links;
+    bool keepOutput = false;
+    std::shared_ptr<const Output> output;
+    uint64_t stamp = 0; // stamp of the parameters and inputs output was cooked from
+    uint64_t outputHash = 0; // hash of the content of output
+    double cookTime = 0; // in the last cook, 0 if the node was reused
+  };
+
+  struct CookStats {
+    int cooked = 0;
+    int reused = 0;
+    int unchanged = 0;
+    double time = 0;
+    double workTime = 0;
+    double criticalPathTime = 0;
+  };
+
+  struct Evaluation {
+    OfxStatus status = kOfxStatOK;
+    bool reused = false;
+    bool unchanged = false;
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  bool isValidNode(int node) const { return node >= 0 && node < nodeCount(); }
+  // Input of the node's instance called inputName, if it is not the main output
+  OfxMeshInputStruct* findInput(int node, const char *inputName) const;
+  Link& link(int node, const char *inputName);
+  // Whether the output of other is needed to cook node
+  bool dependsOn(int node, int other) const;
+  // Node indices in topological order, or false if there is a cycle
+  bool sortNodes(std::vector<int>& order) const;
+  // Hash of the parameter values of the node and of its inputs' content
+  uint64_t computeStamp(int node) const;
+  // Cook the node unless its cached output can be reused. Nodes that do
+  // not depend on each other may be evaluated concurrently.
+  Evaluation evaluateNode(int node);
+  OfxStatus cookNode(int node);
+  void releaseOutputs();
+
+private:
+  std::vector<Node> m_nodes;
+  bool m_caching = true;
+  CookStats m_stats;
+};
+
+#endif // _Graph_h_
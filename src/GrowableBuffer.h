@@ -0,0 +1,103 @@
+#ifndef _GrowableBuffer_h_
+#define _GrowableBuffer_h_
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Minimal growable array of trivially copyable values, allocated with
+ * malloc/realloc so that its buffer can be handed over to an attribute
+ * (attributeDestroy() releases owned buffers with free()).
+ *
+ * When growing fails, the buffer keeps its previous allocation and values,
+ * the call returns false and failed() tells it until the next clear(), so
+ * that loops pushing many values may check it only once at the end.
+ */
+template <typename T>
+class GrowableBuffer {
+public:
+  GrowableBuffer() {}
+  ~GrowableBuffer() { std::free(m_data); }
+  GrowableBuffer(const GrowableBuffer&) = delete;
+  GrowableBuffer& operator=(const GrowableBuffer&) = delete;
+  GrowableBuffer(GrowableBuffer&& other) { *this = static_cast<GrowableBuffer&&>(other); }
+  GrowableBuffer& operator=(GrowableBuffer&& other) {
+    if (this != &other) {
+      std::free(m_data);
+      m_data = other.m_data;
+      m_size = other.m_size;
+      m_capacity = other.m_capacity;
+      m_failed = other.m_failed;
+      other.m_data = nullptr;
+      other.m_size = other.m_capacity = 0;
+      other.m_failed = false;
+    }
+    return *this;
+  }
+
+  bool push_back(T value) {
+    if (m_size == m_capacity && !reserve(m_capacity > 0 ? 2 * m_capacity : 1024)) return false;
+    m_data[m_size++] = value;
+    return true;
+  }
+
+  // Grow or shrink without initializing new values
+  bool resize(size_t size) {
+    if (size > m_capacity && !reserve(size > 2 * m_capacity ? size : 2 * m_capacity)) return false;
+    m_size = size;
+    return true;
+  }
+
+  // Drop all values but keep the allocation for reuse
+  void clear() {
+    m_size = 0;
+    m_failed = false;
+  }
+
+  bool reserve(size_t capacity) {
+    if (capacity <= m_capacity) return true;
+    T *data = capacity <= SIZE_MAX / sizeof(T) ? static_cast<T*>(std::realloc(m_data, capacity * sizeof(T))) : nullptr;
+    if (nullptr == data) {
+      m_failed = true;
+      return false;
+    }
+    m_data = data;
+    m_capacity = capacity;
+    return true;
+  }
+
+  bool failed() const { return m_failed; }
+
+  /**
+   * Give up ownership of the buffer, shrunk to its actual size if possible.
+   * The caller must free() it.
+   */
+  T* release() {
+    T *data = nullptr;
+    if (m_size > 0) {
+      data = static_cast<T*>(std::realloc(m_data, m_size * sizeof(T)));
+      if (nullptr == data) data = m_data; // keep the larger allocation
+    } else {
+      std::free(m_data);
+    }
+    m_data = nullptr;
+    m_size = m_capacity = 0;
+    m_failed = false;
+    return data;
+  }
+
+  T* data() { return m_data; }
+  const T* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  T& operator[](size_t i) { return m_data[i]; }
+  const T& operator[](size_t i) const { return m_data[i]; }
+
+private:
+  T *m_data = nullptr;
+  size_t m_size = 0;
+  size_t m_capacity = 0;
+  bool m_failed = false;
+};
+
+#endif // _GrowableBuffer_h_
@@ -0,0 +1,99 @@
+#include "Hash.h"
+#include "Parallel.h"
+
+#include <cpp/host/attribute.h>
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+static const int hashBlockSize = 1 << 16; // in elements
+
+static const uint64_t goldenRatio = 0x9e3779b97f4a7c15ull;
+
+// Finalizer of MurmurHash3, which spreads each input bit on all output bits
+static uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed) {
+  const char *bytes = static_cast<const char*>(data);
+  uint64_t h = seed ^ (size * goldenRatio);
+  size_t i = 0;
+  for (; i + 8 <= size ; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, 8);
+    h = (h ^ mix(word)) * goldenRatio;
+  }
+  if (i < size) {
+    uint64_t word = 0;
+    memcpy(&word, bytes + i, size - i);
+    h = (h ^ mix(word)) * goldenRatio;
+  }
+  return mix(h);
+}
+
+uint64_t hashCombine(uint64_t a, uint64_t b) {
+  return mix(a * goldenRatio + b);
+}
+
+uint64_t hashParamValues(OfxParamKind kind, const OfxParamValueStruct *values, uint64_t seed) {
+  uint64_t h = seed;
+  bool isIntegral = paramKindIsIntegral(kind);
+  for (int k = 0 ; k < paramKindComponentCount(kind) ; ++k) {
+    if (isIntegral) {
+      h = hashCombine(h, static_cast<uint64_t>(values[k].as_int));
+    } else {
+      h = hashBytes(&values[k].as_double, sizeof(double), h);
+    }
+  }
+  return h;
+}
+
+uint64_t hashElements(const mfx::StridedAttributeView<const char, 1>& view, size_t elementSize) {
+  int count = static_cast<int>(view.size());
+  if (!view.isValid() || count <= 0) return hashBytes(nullptr, 0);
+  int blockCount = (count + hashBlockSize - 1) / hashBlockSize;
+  std::vector<uint64_t> blockHashes(blockCount);
+  bool isPacked = view.byteStride() == elementSize;
+  parallelFor(blockCount, [&](int block) {
+    int begin = block * hashBlockSize;
+    int end = std::min(count, begin + hashBlockSize);
+    if (isPacked) {
+      blockHashes[block] = hashBytes(view.bytes(begin), (end - begin) * elementSize);
+    } else {
+      // Gather elements so that the result does not depend on the stride
+      std::vector<char> packed((end - begin) * elementSize);
+      for (int i = begin ; i < end ; ++i) {
+        memcpy(packed.data() + (i - begin) * elementSize, view.bytes(i), elementSize);
+      }
+      blockHashes[block] = hashBytes(packed.data(), packed.size());
+    }
+  });
+  uint64_t h = hashBytes(nullptr, 0, static_cast<uint64_t>(count));
+  for (uint64_t blockHash : blockHashes) h = hashCombine(h, blockHash);
+  return h;
+}
+
+uint64_t hashMesh(const OfxMeshStruct *mesh) {
+  const OfxMeshPropertySet& props = mesh->properties;
+  int counts[] = { props.point_count, props.corner_count, props.face_count, props.constant_face_size };
+  uint64_t h = hashBytes(counts, sizeof(counts));
+  h = hashBytes(props.transform_matrix, sizeof(props.transform_matrix), h);
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    h = hashBytes(attrib->attachment, strlen(attrib->attachment), h);
+    h = hashBytes(attrib->name, strlen(attrib->name), h);
+    h = hashBytes(attrib->type, strlen(attrib->type), h);
+    h = hashBytes(attrib->semantic, strlen(attrib->semantic), h);
+    h = hashCombine(h, static_cast<uint64_t>(attrib->component_count));
+    size_t elementSize = attrib->component_count * attributeComponentSize(attrib->type);
+    h = hashCombine(h, hashElements(mfx::makeByteView(mesh, attrib), elementSize));
+  }
+  return h;
+}
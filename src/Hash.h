@@ -0,0 +1,47 @@
+#ifndef _Hash_h_
+#define _Hash_h_
+
+/**
+ * Fast non-cryptographic 64-bit hashing, used to tell whether buffers
+ * changed from one cook to the next without keeping a copy of them.
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <cpp/common/AttributeView.h>
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Hash size bytes starting at data. The seed allows chaining calls.
+ */
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0);
+
+/**
+ * Order dependent combination of two hashes.
+ */
+uint64_t hashCombine(uint64_t a, uint64_t b);
+
+/**
+ * Chain the components of a parameter value of the given kind to seed.
+ */
+uint64_t hashParamValues(OfxParamKind kind, const OfxParamValueStruct *values, uint64_t seed);
+
+/**
+ * Hash the elements of an attribute view, where each element is elementSize
+ * bytes long (see mfx::makeByteView()). Packed views are hashed by blocks on
+ * all threads, and strided ones element by element, but both give the same
+ * result for the same content.
+ */
+uint64_t hashElements(const mfx::StridedAttributeView<const char, 1>& view, size_t elementSize);
+
+/**
+ * Hash the element counts, transform and attributes of a mesh, including
+ * the content of their buffers, whatever their layout.
+ */
+uint64_t hashMesh(const OfxMeshStruct *mesh);
+
+#endif // _Hash_h_
@@ -0,0 +1,142 @@
+#include "MeshRows.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+static bool isAttachment(const char *attachment) {
+  return 0 == strcmp(attachment, kOfxMeshAttribPoint)
+    || 0 == strcmp(attachment, kOfxMeshAttribCorner)
+    || 0 == strcmp(attachment, kOfxMeshAttribFace)
+    || 0 == strcmp(attachment, kOfxMeshAttribMesh);
+}
+
+/**
+ * Reads one attribute component as a double, whatever the attribute type.
+ */
+class ComponentReader {
+public:
+  ComponentReader(const OfxMeshStruct *mesh, const OfxMeshAttributePropertySet *attrib, int component) {
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribFace)
+      && 0 == strcmp(attrib->name, kOfxMeshAttribFaceSize)
+      && mesh->properties.constant_face_size > -1)
+    {
+      m_ints = mfx::makeFaceSizeView(mesh);
+      m_type = Int;
+    } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeFloat)) {
+      m_floats = mfx::makeAttributeView<float, 1>(mesh, attrib, component);
+      m_type = Float;
+    } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeInt)) {
+      m_ints = mfx::makeAttributeView<int, 1>(mesh, attrib, component);
+      m_type = Int;
+    } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeUByte)) {
+      m_bytes = mfx::makeAttributeView<unsigned char, 1>(mesh, attrib, component);
+      m_type = UByte;
+    }
+  }
+
+  double read(int index) const {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    switch (m_type) {
+    case Float: return m_floats.isValid() ? m_floats.get(index) : nan;
+    case Int: return m_ints.isValid() ? m_ints.get(index) : nan;
+    case UByte: return m_bytes.isValid() ? m_bytes.get(index) : nan;
+    default: return nan;
+    }
+  }
+
+private:
+  enum Type { Unknown, Float, Int, UByte };
+  mfx::StridedAttributeView<const float, 1> m_floats;
+  mfx::StridedAttributeView<const int, 1> m_ints;
+  mfx::StridedAttributeView<const unsigned char, 1> m_bytes;
+  Type m_type = Unknown;
+};
+
+int meshRowSize(const OfxMeshStruct *mesh, const char *attachment) {
+  if (!isAttachment(attachment)) return -1;
+  int size = 1;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, attachment)) size += attrib->component_count;
+  }
+  return size;
+}
+
+int meshRowCount(const OfxMeshStruct *mesh, const char *attachment) {
+  const OfxMeshPropertySet& props = mesh->properties;
+  if (0 == strcmp(attachment, kOfxMeshAttribPoint)) return props.point_count;
+  if (0 == strcmp(attachment, kOfxMeshAttribCorner)) return props.corner_count;
+  if (0 == strcmp(attachment, kOfxMeshAttribFace)) return props.face_count;
+  if (0 == strcmp(attachment, kOfxMeshAttribMesh)) return 1;
+  return 0;
+}
+
+OfxStatus readMeshRows(const OfxMeshStruct *mesh, const char *attachment, int first, int count, const int *order, double *out) {
+  int rowSize = meshRowSize(mesh, attachment);
+  if (rowSize < 0) return kOfxStatErrBadIndex;
+  int rowCount = meshRowCount(mesh, attachment);
+  if (first < 0) return kOfxStatErrBadIndex;
+  count = std::max(0, std::min(count, rowCount - first));
+
+  for (int r = 0 ; r < count ; ++r) {
+    int index = nullptr != order ? order[first + r] : first + r;
+    if (index < 0 || index >= rowCount) return kOfxStatErrBadIndex;
+    out[rowSize * r] = index;
+  }
+
+  int offset = 1;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 != strcmp(attrib->attachment, attachment)) continue;
+    for (int k = 0 ; k < attrib->component_count ; ++k) {
+      ComponentReader reader(mesh, attrib, k);
+      for (int r = 0 ; r < count ; ++r) {
+        int index = static_cast<int>(out[rowSize * r]);
+        out[rowSize * r + offset + k] = reader.read(index);
+      }
+    }
+    offset += attrib->component_count;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus sortMeshRows(const OfxMeshStruct *mesh, const char *attachment, const char *name, int component, bool descending, int *order) {
+  const OfxMeshAttributePropertySet *attrib = nullptr;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid && nullptr == attrib ; ++i) {
+    if (0 == strcmp(mesh->attributes[i].attachment, attachment) && 0 == strcmp(mesh->attributes[i].name, name)) {
+      attrib = &mesh->attributes[i];
+    }
+  }
+  if (nullptr == attrib) return kOfxStatErrUnknown;
+  if (component < 0 || component >= attrib->component_count) return kOfxStatErrBadIndex;
+
+  int rowCount = meshRowCount(mesh, attachment);
+  ComponentReader reader(mesh, attrib, component);
+
+  // Sorting (key, index) pairs keeps keys next to indices in memory, and
+  // comparing indices on ties makes std::sort stable.
+  std::vector<std::pair<double, int>> keys(rowCount);
+  for (int i = 0 ; i < rowCount ; ++i) {
+    keys[i] = { reader.read(i), i };
+  }
+  std::sort(keys.begin(), keys.end(), [descending](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+    bool aIsNan = std::isnan(a.first), bIsNan = std::isnan(b.first);
+    if (aIsNan || bIsNan) {
+      if (aIsNan != bIsNan) return bIsNan;
+      return a.second < b.second;
+    }
+    if (a.first != b.first) return descending ? a.first > b.first : a.first < b.first;
+    return a.second < b.second;
+  });
+  for (int i = 0 ; i < rowCount ; ++i) {
+    order[i] = keys[i].second;
+  }
+  return kOfxStatOK;
+}
@@ -0,0 +1,47 @@
+#ifndef _MeshRows_h_
+#define _MeshRows_h_
+
+/**
+ * Row oriented access to the attributes of a mesh, for spreadsheets that
+ * only display a window of rows at a time.
+ *
+ * A row describes one element (point, corner, face or the mesh itself)
+ * and contains its index followed by all the components of all the
+ * attributes attached to it, in the order of mesh->attributes. Values are
+ * written as doubles, which represent all attribute types exactly.
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+/**
+ * Number of values in each row of the given attachment, or -1 if it is not
+ * a valid attachment.
+ */
+int meshRowSize(const OfxMeshStruct *mesh, const char *attachment);
+
+/**
+ * Number of rows of the given attachment, i.e. its element count.
+ */
+int meshRowCount(const OfxMeshStruct *mesh, const char *attachment);
+
+/**
+ * Write rows [first, first + count) of the attachment to out, which must
+ * hold count * meshRowSize() doubles. If order is not null, row r is the
+ * element order[r] rather than the element r. Rows past the end are not
+ * written. Components of attributes without data are NaN, except face
+ * sizes of meshes with a constant face size.
+ */
+OfxStatus readMeshRows(const OfxMeshStruct *mesh, const char *attachment, int first, int count, const int *order, double *out);
+
+/**
+ * Sort the elements of an attachment by the given component of one of its
+ * attributes, writing meshRowCount() element indices to order. The sort is
+ * stable and NaN values come last in both directions.
+ */
+OfxStatus sortMeshRows(const OfxMeshStruct *mesh, const char *attachment, const char *name, int component, bool descending, int *order);
+
+#endif // _MeshRows_h_
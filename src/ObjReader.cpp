@@ -0,0 +1,563 @@
+#include "ObjReader.h"
+#include "Parallel.h"
+
+extern "C" {
+#include <host/meshEffectSuite.h>
+#include <common/common.h> // for MFX_ENSURE
+}
+
+#include <ofxMeshEffect.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <algorithm>
+
+//--------------------------------------------------------
+// Low level parsing helpers, working on [p, end) ranges that are not null
+// terminated.
+
+static inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipSpaces(const char *p, const char *end) {
+  while (p < end && isSpace(*p)) ++p;
+  return p;
+}
+
+static inline const char* skipToken(const char *p, const char *end) {
+  while (p < end && !isSpace(*p)) ++p;
+  return p;
+}
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/**
+ * Parse a (possibly negative) integer, return nullptr if there is none.
+ */
+static const char* parseInt(const char *p, const char *end, int *value) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  if (p == end || !isDigit(*p)) return nullptr;
+  int result = 0;
+  for (; p < end && isDigit(*p) ; ++p) {
+    result = 10 * result + (*p - '0');
+  }
+  *value = negative ? -result : result;
+  return p;
+}
+
+/**
+ * Parse a decimal floating point number. This is much faster than strtof,
+ * which has to honor the locale, and precise enough for single precision
+ * output. Special values (nan, inf) fall back to strtof.
+ */
+static const char* parseFloat(const char *p, const char *end, float *value) {
+  static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int exponent = 0;
+  int digitCount = 0;
+  for (; p < end && isDigit(*p) ; ++p, ++digitCount) {
+    if (mantissa < 1000000000000000000ull) {
+      mantissa = 10 * mantissa + (*p - '0');
+    } else {
+      ++exponent;
+    }
+  }
+  if (p < end && *p == '.') {
+    ++p;
+    for (; p < end && isDigit(*p) ; ++p, ++digitCount) {
+      if (mantissa < 1000000000000000000ull) {
+        mantissa = 10 * mantissa + (*p - '0');
+        --exponent;
+      }
+    }
+  }
+
+  if (digitCount == 0) {
+    // nan, inf or garbage
+    char buffer[64];
+    size_t length = skipToken(start, end) - start;
+    if (length == 0 || length >= sizeof(buffer)) return nullptr;
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    char *parsed_end;
+    *value = strtof(buffer, &parsed_end);
+    if (parsed_end == buffer) return nullptr;
+    return start + (parsed_end - buffer);
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    int exponentValue;
+    const char *exponentEnd = parseInt(p + 1, end, &exponentValue);
+    if (nullptr != exponentEnd) {
+      exponent += exponentValue;
+      p = exponentEnd;
+    }
+  }
+
+  double result = static_cast<double>(mantissa);
+  if (exponent < 0 && exponent >= -22) {
+    result /= powersOfTen[-exponent];
+  } else if (exponent > 0 && exponent <= 22) {
+    result *= powersOfTen[exponent];
+  } else if (exponent != 0) {
+    result *= std::pow(10.0, exponent);
+  }
+  *value = static_cast<float>(negative ? -result : result);
+  return p;
+}
+
+//--------------------------------------------------------
+
+static const int elementComponentCount[] = { 3, 2, 3 };
+static const char *elementName[] = { "point", "texture coordinate", "normal" };
+
+// Corners are validated and de-indexed by blocks of this size
+static const int cornerBlockSize = 1 << 16;
+
+// Corner index of a texture coordinate or normal that a face does not give
+static const int missingIndex = -1;
+// Corner index of a relative OBJ index that points before the first element,
+// which must not be mistaken for a missing one
+static const int invalidIndex = INT_MIN;
+
+ObjReader::ObjReader(const ObjLoadOptions& options)
+  : m_options(options)
+{}
+
+bool ObjReader::isEnabled(ElementType type) const {
+  return type == Position || (type == TexCoord && m_options.texCoords) || (type == Normal && m_options.normals);
+}
+
+int ObjReader::elementCount(ElementType type) const {
+  return static_cast<int>(m_elements[type].size() / elementComponentCount[type]);
+}
+
+void ObjReader::feed(const char *data, size_t size) {
+  if (m_outOfMemory) return;
+  const char *p = data;
+  const char *end = data + size;
+
+  if (!m_pending.empty()) {
+    const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (nullptr == eol) {
+      m_pending.append(p, end);
+      return;
+    }
+    m_pending.append(p, eol);
+    parseLines(m_pending.data(), m_pending.data() + m_pending.size());
+    m_pending.clear();
+    p = eol + 1;
+  }
+
+  // Parse all complete lines at once and keep the remainder for later
+  const char *lastLineEnd = end;
+  while (lastLineEnd > p && lastLineEnd[-1] != '\n') --lastLineEnd;
+  parseLines(p, lastLineEnd);
+  m_pending.assign(lastLineEnd, end);
+}
+
+void ObjReader::parseLines(const char *begin, const char *end) {
+  if (begin == end || m_outOfMemory) return;
+
+  // Chunks must be large enough for the stitching overhead to be negligible
+  // but not too large so that the temporary per-chunk buffers remain small
+  // compared to the output.
+  const size_t minChunkSize = 1 << 16;
+  const size_t maxChunkSize = 1 << 22;
+  int threads = threadCount();
+  size_t chunkSize = static_cast<size_t>(end - begin) / threads + 1;
+  if (chunkSize < minChunkSize) chunkSize = minChunkSize;
+  if (chunkSize > maxChunkSize) chunkSize = maxChunkSize;
+
+  if (static_cast<int>(m_chunks.size()) < threads) {
+    m_chunks.resize(threads);
+  }
+  std::vector<const char*> cuts(threads + 1);
+
+  while (begin < end) {
+    // Split the next wave of at most one chunk per thread at line boundaries
+    int chunkCount = 0;
+    cuts[0] = begin;
+    while (chunkCount < threads && begin < end) {
+      const char *cut = end;
+      if (static_cast<size_t>(end - begin) > chunkSize) {
+        cut = static_cast<const char*>(memchr(begin + chunkSize, '\n', end - begin - chunkSize));
+        cut = nullptr != cut ? cut + 1 : end;
+      }
+      cuts[++chunkCount] = begin = cut;
+    }
+
+    parallelFor(chunkCount, [&](int i) {
+      m_chunks[i].clear();
+      m_chunks[i].options = m_options;
+      m_chunks[i].parse(cuts[i], cuts[i + 1]);
+    });
+
+    for (int i = 0 ; i < chunkCount ; ++i) {
+      m_outOfMemory = m_outOfMemory || m_chunks[i].failed();
+    }
+    if (m_outOfMemory || !stitch(chunkCount)) {
+      m_outOfMemory = true;
+      return;
+    }
+  }
+}
+
+bool ObjReader::stitch(int chunkCount) {
+  // Prefix sums giving the location of each chunk in the output
+  std::vector<size_t> elementOffsets[ElementTypeCount];
+  std::vector<size_t> cornerOffsets(chunkCount + 1);
+  std::vector<size_t> faceOffsets(chunkCount + 1);
+  for (int t = 0 ; t < ElementTypeCount ; ++t) {
+    elementOffsets[t].resize(chunkCount + 1);
+    elementOffsets[t][0] = elementCount(static_cast<ElementType>(t));
+  }
+  cornerOffsets[0] = m_cornerIndices[Position].size();
+  faceOffsets[0] = m_faceSizes.size();
+  for (int i = 0 ; i < chunkCount ; ++i) {
+    const Chunk& chunk = m_chunks[i];
+    for (int t = 0 ; t < ElementTypeCount ; ++t) {
+      elementOffsets[t][i + 1] = elementOffsets[t][i] + chunk.elementCount(static_cast<ElementType>(t));
+    }
+    cornerOffsets[i + 1] = cornerOffsets[i] + chunk.cornerIndices[Position].size();
+    faceOffsets[i + 1] = faceOffsets[i] + chunk.faceSizes.size();
+    if (0 == m_errorLine && 0 != chunk.errorLine) {
+      m_errorLine = m_lineCount + chunk.errorLine;
+    }
+    m_lineCount += chunk.lineCount;
+  }
+
+  for (int t = 0 ; t < ElementTypeCount ; ++t) {
+    if (!isEnabled(static_cast<ElementType>(t))) continue;
+    if (!m_elements[t].resize(elementComponentCount[t] * elementOffsets[t][chunkCount])) return false;
+    if (!m_cornerIndices[t].resize(cornerOffsets[chunkCount])) return false;
+  }
+  if (!m_faceSizes.resize(faceOffsets[chunkCount])) return false;
+
+  parallelFor(chunkCount, [&](int i) {
+    const Chunk& chunk = m_chunks[i];
+    memcpy(m_faceSizes.data() + faceOffsets[i], chunk.faceSizes.data(), chunk.faceSizes.size() * sizeof(int));
+    for (int t = 0 ; t < ElementTypeCount ; ++t) {
+      if (!isEnabled(static_cast<ElementType>(t))) continue;
+      const GrowableBuffer<float>& elements = chunk.elements[t];
+      memcpy(m_elements[t].data() + elementComponentCount[t] * elementOffsets[t][i], elements.data(), elements.size() * sizeof(float));
+      int *cornerIndices = m_cornerIndices[t].data() + cornerOffsets[i];
+      memcpy(cornerIndices, chunk.cornerIndices[t].data(), chunk.cornerIndices[t].size() * sizeof(int));
+      int elementOffset = static_cast<int>(elementOffsets[t][i]);
+      const GrowableBuffer<int>& relativeCorners = chunk.relativeCorners[t];
+      for (size_t k = 0 ; k < relativeCorners.size() ; ++k) {
+        int& index = cornerIndices[relativeCorners[k]];
+        index += elementOffset;
+        if (index < 0) index = invalidIndex;
+      }
+    }
+  });
+  return true;
+}
+
+void ObjReader::Chunk::clear() {
+  for (int t = 0 ; t < ElementTypeCount ; ++t) {
+    elements[t].clear();
+    cornerIndices[t].clear();
+    relativeCorners[t].clear();
+  }
+  faceSizes.clear();
+  lineCount = 0;
+  errorLine = 0;
+}
+
+bool ObjReader::Chunk::failed() const {
+  bool failed = faceSizes.failed();
+  for (int t = 0 ; t < ElementTypeCount ; ++t) {
+    failed = failed || elements[t].failed() || cornerIndices[t].failed() || relativeCorners[t].failed();
+  }
+  return failed;
+}
+
+int ObjReader::Chunk::elementCount(ElementType type) const {
+  return static_cast<int>(elements[type].size() / elementComponentCount[type]);
+}
+
+void ObjReader::Chunk::parse(const char *p, const char *end) {
+  while (p < end) {
+    const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (nullptr == eol) eol = end;
+    parseLine(p, eol);
+    p = eol + 1;
+  }
+}
+
+void ObjReader::Chunk::pushIndex(ElementType type, int index) {
+  // OBJ indices are 1-based, negative indices are relative to the last
+  // element and resolved when stitching since previous chunks are not known
+  // yet, and 0 stands for a missing index.
+  if (index > 0) {
+    cornerIndices[type].push_back(index - 1);
+  } else if (index < 0) {
+    relativeCorners[type].push_back(static_cast<int>(cornerIndices[type].size()));
+    cornerIndices[type].push_back(elementCount(type) + index);
+  } else {
+    cornerIndices[type].push_back(missingIndex);
+  }
+}
+
+void ObjReader::Chunk::parseLine(const char *p, const char *end) {
+  ++lineCount;
+  p = skipSpaces(p, end);
+  if (end - p < 2) return;
+
+  if (p[0] == 'v') {
+    ElementType type;
+    if (isSpace(p[1])) {
+      type = Position;
+      p += 2;
+    } else if (p[1] == 't' && options.texCoords && end - p > 2 && isSpace(p[2])) {
+      type = TexCoord;
+      p += 3;
+    } else if (p[1] == 'n' && options.normals && end - p > 2 && isSpace(p[2])) {
+      type = Normal;
+      p += 3;
+    } else {
+      return; // not requested
+    }
+
+    int componentCount = elementComponentCount[type];
+    float values[3];
+    for (int k = 0 ; k < componentCount ; ++k) {
+      p = nullptr != p ? parseFloat(skipSpaces(p, end), end, &values[k]) : nullptr;
+    }
+    if (nullptr == p) {
+      if (0 == errorLine) errorLine = lineCount;
+      values[0] = values[1] = values[2] = 0.0f;
+    }
+    for (int k = 0 ; k < componentCount ; ++k) {
+      elements[type].push_back(values[k]);
+    }
+  }
+  else if (p[0] == 'f' && isSpace(p[1])) {
+    int faceSize = 0;
+    p = skipSpaces(p + 2, end);
+    while (p < end) {
+      int index;
+      const char *next = parseInt(p, end, &index);
+      if (nullptr == next || 0 == index) {
+        if (0 == errorLine) errorLine = lineCount;
+        break;
+      }
+      pushIndex(Position, index);
+
+      if (options.texCoords || options.normals) {
+        // v/vt/vn, v//vn or v/vt
+        int texCoordIndex = 0, normalIndex = 0;
+        if (next < end && *next == '/') {
+          ++next;
+          if (next < end && *next != '/') {
+            next = parseInt(next, end, &texCoordIndex);
+          }
+          if (nullptr != next && next < end && *next == '/') {
+            next = parseInt(next + 1, end, &normalIndex);
+          }
+          if (nullptr == next && 0 == errorLine) errorLine = lineCount;
+        }
+        if (options.texCoords) pushIndex(TexCoord, texCoordIndex);
+        if (options.normals) pushIndex(Normal, normalIndex);
+      }
+
+      ++faceSize;
+      p = skipSpaces(skipToken(p, end), end);
+    }
+    if (faceSize > 0) {
+      faceSizes.push_back(faceSize);
+    }
+  }
+}
+
+OfxStatus ObjReader::readFile(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (nullptr == file) {
+    printf("Error: could not open OBJ file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+
+  std::vector<char> block(static_cast<size_t>(threadCount()) << 22);
+  size_t size;
+  while (!m_outOfMemory && (size = fread(block.data(), 1, block.size(), file)) > 0) {
+    feed(block.data(), size);
+  }
+  fclose(file);
+  return kOfxStatOK;
+}
+
+bool ObjReader::validateIndices(ElementType type) const {
+  const GrowableBuffer<int>& cornerIndices = m_cornerIndices[type];
+  int cornerCount = static_cast<int>(cornerIndices.size());
+  // Faces always give a point, only other elements may be missing
+  bool allowMissing = type != Position;
+  int maxIndex = elementCount(type) - 1;
+  int blockCount = (cornerCount + cornerBlockSize - 1) / cornerBlockSize;
+  std::vector<char> blockIsValid(blockCount);
+  parallelFor(blockCount, [&](int block) {
+    int end = std::min(cornerCount, (block + 1) * cornerBlockSize);
+    bool isValid = true;
+    for (int i = block * cornerBlockSize ; i < end ; ++i) {
+      int index = cornerIndices[i];
+      isValid = isValid && ((index >= 0 && index <= maxIndex) || (allowMissing && index == missingIndex));
+    }
+    blockIsValid[block] = isValid;
+  });
+  for (int block = 0 ; block < blockCount ; ++block) {
+    if (!blockIsValid[block]) return false;
+  }
+  return true;
+}
+
+OfxStatus ObjReader::defineCornerAttribute(OfxMeshStruct *mesh, ElementType type, const char *name, const char *semantic) {
+  int componentCount = elementComponentCount[type];
+  OfxMeshAttributePropertySet *attrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribCorner,
+                             name,
+                             componentCount,
+                             kOfxMeshAttribTypeFloat,
+                             semantic,
+                             (OfxPropertySetHandle*)&attrib));
+
+  const GrowableBuffer<int>& cornerIndices = m_cornerIndices[type];
+  const float *elements = m_elements[type].data();
+  int cornerCount = static_cast<int>(cornerIndices.size());
+  float *data = static_cast<float*>(malloc(std::max(cornerCount, 1) * componentCount * sizeof(float)));
+  if (nullptr == data) {
+    return kOfxStatErrMemory;
+  }
+  int blockCount = (cornerCount + cornerBlockSize - 1) / cornerBlockSize;
+  parallelFor(blockCount, [&](int block) {
+    int end = std::min(cornerCount, (block + 1) * cornerBlockSize);
+    for (int i = block * cornerBlockSize ; i < end ; ++i) {
+      int index = cornerIndices[i];
+      for (int k = 0 ; k < componentCount ; ++k) {
+        data[componentCount * i + k] = index != missingIndex ? elements[componentCount * index + k] : 0.0f;
+      }
+    }
+  });
+
+  attrib->data = reinterpret_cast<char*>(data);
+  attrib->byte_stride = componentCount * sizeof(float);
+  attrib->is_owner = 1;
+  return kOfxStatOK;
+}
+
+OfxStatus ObjReader::finish(OfxMeshStruct *mesh) {
+  if (!m_pending.empty()) {
+    parseLines(m_pending.data(), m_pending.data() + m_pending.size());
+    m_pending.clear();
+  }
+
+  if (m_outOfMemory) {
+    printf("Error: could not allocate memory for the OBJ mesh\n");
+    reset();
+    return kOfxStatErrMemory;
+  }
+
+  if (0 != m_errorLine) {
+    printf("Warning: malformed OBJ line #%d\n", m_errorLine);
+  }
+
+  for (int t = 0 ; t < ElementTypeCount ; ++t) {
+    ElementType type = static_cast<ElementType>(t);
+    if (isEnabled(type) && !validateIndices(type)) {
+      printf("Error: OBJ faces reference a %s index out of range\n", elementName[t]);
+      reset();
+      return kOfxStatErrFormat;
+    }
+  }
+
+  mesh->properties.point_count = elementCount(Position);
+  mesh->properties.corner_count = static_cast<int>(m_cornerIndices[Position].size());
+  mesh->properties.face_count = static_cast<int>(m_faceSizes.size());
+  mesh->properties.constant_face_size = -1;
+
+  // 1. Point Position
+  OfxMeshAttributePropertySet *pointPositionAttrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribPoint,
+                             kOfxMeshAttribPointPosition,
+                             3,
+                             kOfxMeshAttribTypeFloat,
+                             nullptr,
+                             (OfxPropertySetHandle*)&pointPositionAttrib));
+  pointPositionAttrib->data = reinterpret_cast<char*>(m_elements[Position].release());
+  pointPositionAttrib->byte_stride = 3 * sizeof(float);
+  pointPositionAttrib->is_owner = 1;
+
+  // 2. Corner Point
+  OfxMeshAttributePropertySet *cornerPointAttrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribCorner,
+                             kOfxMeshAttribCornerPoint,
+                             1,
+                             kOfxMeshAttribTypeInt,
+                             nullptr,
+                             (OfxPropertySetHandle*)&cornerPointAttrib));
+  cornerPointAttrib->data = reinterpret_cast<char*>(m_cornerIndices[Position].release());
+  cornerPointAttrib->byte_stride = sizeof(int);
+  cornerPointAttrib->is_owner = 1;
+
+  // 3. Face Size
+  OfxMeshAttributePropertySet *faceSizeAttrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribFace,
+                             kOfxMeshAttribFaceSize,
+                             1,
+                             kOfxMeshAttribTypeInt,
+                             nullptr,
+                             (OfxPropertySetHandle*)&faceSizeAttrib));
+  faceSizeAttrib->data = reinterpret_cast<char*>(m_faceSizes.release());
+  faceSizeAttrib->byte_stride = sizeof(int);
+  faceSizeAttrib->is_owner = 1;
+
+  // 4. Optional corner layers, only if the file actually contains some
+  if (m_options.texCoords && elementCount(TexCoord) > 0) {
+    MFX_ENSURE(defineCornerAttribute(mesh, TexCoord, "uv", kOfxMeshAttribSemanticTextureCoordinate));
+  }
+  if (m_options.normals && elementCount(Normal) > 0) {
+    MFX_ENSURE(defineCornerAttribute(mesh, Normal, "normal", kOfxMeshAttribSemanticNormal));
+  }
+
+  reset();
+  return kOfxStatOK;
+}
+
+void ObjReader::reset() {
+  for (int t = 0 ; t < ElementTypeCount ; ++t) {
+    m_elements[t] = GrowableBuffer<float>();
+    m_cornerIndices[t] = GrowableBuffer<int>();
+  }
+  m_faceSizes = GrowableBuffer<int>();
+  m_lineCount = 0;
+  m_errorLine = 0;
+  m_outOfMemory = false;
+  m_pending.clear();
+  m_chunks.clear();
+}
@@ -0,0 +1,121 @@
+#ifndef _ObjReader_h_
+#define _ObjReader_h_
+
+/**
+ * Streaming Wavefront OBJ reader that writes point positions, corner points
+ * and face sizes directly into the buffers that end up owned by the mesh
+ * attributes, without any intermediate representation.
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include "GrowableBuffer.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Optional layers to import, in addition to the mesh connectivity. Layers
+ * that are not requested are not even parsed.
+ */
+struct ObjLoadOptions {
+  bool texCoords = false; // import "vt" as a corner attribute "uv"
+  bool normals = false; // import "vn" as a corner attribute "normal"
+};
+
+/**
+ * Large inputs are split at line boundaries into chunks that are parsed
+ * concurrently (see Parallel.h), then stitched together using prefix sums
+ * over the number of elements, corners and faces of each chunk.
+ */
+class ObjReader {
+public:
+  ObjReader(const ObjLoadOptions& options = ObjLoadOptions());
+  ObjReader(const ObjReader&) = delete;
+  ObjReader& operator=(const ObjReader&) = delete;
+
+  /**
+   * Parse the next chunk of the file. Chunks may be of any size, lines that
+   * span several chunks are carried over to the next call.
+   */
+  void feed(const char *data, size_t size);
+
+  /**
+   * Feed the whole content of a file, read by blocks.
+   */
+  OfxStatus readFile(const char *filename);
+
+  /**
+   * Parse any pending line and move the buffers into the attributes of the
+   * mesh, which must have been initialized with meshInit(). Texture
+   * coordinates and normals are de-indexed into compact corner attributes.
+   * The reader is empty afterwards.
+   */
+  OfxStatus finish(OfxMeshStruct *mesh);
+
+private:
+  // Kinds of OBJ elements that faces index into ("v", "vt" and "vn" lines)
+  enum ElementType {
+    Position,
+    TexCoord,
+    Normal,
+    ElementTypeCount,
+  };
+
+  /**
+   * Result of parsing a range of complete lines independently from the rest
+   * of the file. Corner indices are absolute, except for the ones listed in
+   * relativeCorners which come from negative OBJ indices and are relative to
+   * the first element of the chunk (and may thus be negative). Missing
+   * texture coordinate or normal indices are -1.
+   */
+  struct Chunk {
+    ObjLoadOptions options;
+    GrowableBuffer<float> elements[ElementTypeCount];
+    GrowableBuffer<int> cornerIndices[ElementTypeCount];
+    GrowableBuffer<int> relativeCorners[ElementTypeCount];
+    GrowableBuffer<int> faceSizes;
+    int lineCount = 0;
+    int errorLine = 0; // first malformed line in the chunk, 1-based, if any
+
+    void clear();
+    void parse(const char *begin, const char *end);
+    void parseLine(const char *begin, const char *end);
+    void pushIndex(ElementType type, int index);
+    int elementCount(ElementType type) const;
+    // Whether some values could not be stored for lack of memory
+    bool failed() const;
+  };
+
+  bool isEnabled(ElementType type) const;
+  int elementCount(ElementType type) const;
+  // Parse a range of complete lines (the last one may miss its end of line)
+  void parseLines(const char *begin, const char *end);
+  // Append the first chunkCount chunks to the output buffers, return false
+  // if they cannot grow
+  bool stitch(int chunkCount);
+  // Check that all corner indices are in range, or missing for texture
+  // coordinates and normals
+  bool validateIndices(ElementType type) const;
+  // Define a corner attribute holding the element of each corner
+  OfxStatus defineCornerAttribute(OfxMeshStruct *mesh, ElementType type, const char *name, const char *semantic);
+  void reset();
+
+private:
+  ObjLoadOptions m_options;
+  GrowableBuffer<float> m_elements[ElementTypeCount];
+  GrowableBuffer<int> m_cornerIndices[ElementTypeCount];
+  GrowableBuffer<int> m_faceSizes;
+  int m_lineCount = 0;
+  int m_errorLine = 0; // first malformed line, if any
+  bool m_outOfMemory = false; // parsing stops at the first allocation failure, reported by finish()
+  std::string m_pending; // incomplete last line of the previous chunk
+  std::vector<Chunk> m_chunks; // kept across calls to reuse allocations
+};
+
+#endif // _ObjReader_h_
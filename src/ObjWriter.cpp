@@ -0,0 +1,162 @@
+#include "ObjWriter.h"
+#include "BufferedWriter.h"
+#include "Parallel.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+static const int lineBlockSize = 1 << 14;
+
+/**
+ * Format count lines by blocks on all threads and write them in order.
+ * formatLine(i, text) appends the i-th line to text. Return false if a block
+ * could not be formatted for lack of memory.
+ */
+template <typename Func>
+static bool writeLines(BufferedWriter& writer, int count, const Func& formatLine) {
+  int threads = threadCount();
+  std::vector<TextBuffer> texts(threads);
+  int blockCount = (count + lineBlockSize - 1) / lineBlockSize;
+  for (int wave = 0 ; wave < blockCount ; wave += threads) {
+    int waveSize = std::min(threads, blockCount - wave);
+    parallelFor(waveSize, [&](int t) {
+      TextBuffer& text = texts[t];
+      text.clear();
+      int begin = (wave + t) * lineBlockSize;
+      int end = std::min(count, begin + lineBlockSize);
+      for (int i = begin ; i < end ; ++i) formatLine(i, text);
+    });
+    for (int t = 0 ; t < waveSize ; ++t) {
+      if (texts[t].failed()) return false;
+      writer.write(texts[t].data(), texts[t].size());
+    }
+  }
+  return true;
+}
+
+/**
+ * Find a float attribute of the given semantic attached to points or
+ * corners, return nullptr if there is none.
+ */
+static const OfxMeshAttributePropertySet* findLayer(const OfxMeshStruct *mesh, const char *semantic, int componentCount) {
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->semantic, semantic)
+      && attrib->component_count == componentCount
+      && 0 == strcmp(attrib->type, kOfxMeshAttribTypeFloat)
+      && nullptr != attrib->data
+      && (0 == strcmp(attrib->attachment, kOfxMeshAttribPoint) || 0 == strcmp(attrib->attachment, kOfxMeshAttribCorner)))
+    {
+      return attrib;
+    }
+  }
+  return nullptr;
+}
+
+template <int N>
+static bool writeFloats(BufferedWriter& writer, const char *prefix, const mfx::StridedAttributeView<const float, N>& view, int count) {
+  return writeLines(writer, count, [&](int i, TextBuffer& text) {
+    text.append(prefix);
+    for (int k = 0 ; k < N ; ++k) {
+      text.append(' ');
+      text.appendFloat(view.get(i, k));
+    }
+    text.append('\n');
+  });
+}
+
+OfxStatus saveObjMesh(const char *filename, const OfxMeshStruct *mesh) {
+  const OfxMeshPropertySet& props = mesh->properties;
+  const OfxMeshAttributePropertySet *positionAttrib = nullptr;
+  const OfxMeshAttributePropertySet *cornerPointAttrib = nullptr;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribPoint) && 0 == strcmp(attrib->name, kOfxMeshAttribPointPosition)) positionAttrib = attrib;
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribCorner) && 0 == strcmp(attrib->name, kOfxMeshAttribCornerPoint)) cornerPointAttrib = attrib;
+  }
+  if (nullptr == positionAttrib || positionAttrib->component_count != 3 || 0 != strcmp(positionAttrib->type, kOfxMeshAttribTypeFloat)) {
+    printf("Error: cannot save a mesh without float point positions to OBJ\n");
+    return kOfxStatErrUnsupported;
+  }
+  auto positions = mfx::makeAttributeView<float, 3>(mesh, positionAttrib);
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(mesh, cornerPointAttrib);
+  auto faceSizes = mfx::makeFaceSizeView(mesh);
+  if (props.face_count > 0 && (!cornerPoints.isValid() || !faceSizes.isValid())) {
+    printf("Error: cannot save a mesh without face connectivity to OBJ\n");
+    return kOfxStatErrBadHandle;
+  }
+
+  const OfxMeshAttributePropertySet *texCoordAttrib = findLayer(mesh, kOfxMeshAttribSemanticTextureCoordinate, 2);
+  const OfxMeshAttributePropertySet *normalAttrib = findLayer(mesh, kOfxMeshAttribSemanticNormal, 3);
+  auto texCoords = mfx::makeAttributeView<float, 2>(mesh, texCoordAttrib);
+  auto normals = mfx::makeAttributeView<float, 3>(mesh, normalAttrib);
+  bool texCoordsPerPoint = nullptr != texCoordAttrib && 0 == strcmp(texCoordAttrib->attachment, kOfxMeshAttribPoint);
+  bool normalsPerPoint = nullptr != normalAttrib && 0 == strcmp(normalAttrib->attachment, kOfxMeshAttribPoint);
+
+  BufferedWriter writer;
+  if (!writer.open(filename)) {
+    printf("Error: could not open file for writing: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  writer.writeString("# WebMfx\n");
+
+  // 1. Elements, shared values (stride 0) are written once
+  bool formatted = writeFloats(writer, "v", positions, props.point_count);
+  if (formatted && texCoords.isValid()) {
+    int count = texCoords.byteStride() == 0 ? 1 : (texCoordsPerPoint ? props.point_count : props.corner_count);
+    formatted = writeFloats(writer, "vt", texCoords, count);
+  }
+  if (formatted && normals.isValid()) {
+    int count = normals.byteStride() == 0 ? 1 : (normalsPerPoint ? props.point_count : props.corner_count);
+    formatted = writeFloats(writer, "vn", normals, count);
+  }
+
+  // 2. Faces, which need the offset of their first corner to be formatted
+  // independently
+  std::vector<int> faceOffsets;
+  if (props.constant_face_size == -1) {
+    faceOffsets.resize(props.face_count);
+    int offset = 0;
+    for (int face = 0 ; face < props.face_count ; ++face) {
+      faceOffsets[face] = offset;
+      offset += faceSizes.get(face);
+    }
+  }
+
+  formatted = formatted && writeLines(writer, props.face_count, [&](int face, TextBuffer& text) {
+    int faceSize = faceSizes.get(face);
+    int offset = faceOffsets.empty() ? face * faceSize : faceOffsets[face];
+    text.append('f');
+    for (int k = 0 ; k < faceSize ; ++k) {
+      int corner = offset + k;
+      int point = cornerPoints.get(corner);
+      text.append(' ');
+      text.appendInt(point + 1);
+      if (texCoords.isValid()) {
+        text.append('/');
+        text.appendInt(texCoords.byteStride() == 0 ? 1 : (texCoordsPerPoint ? point : corner) + 1);
+      }
+      if (normals.isValid()) {
+        text.append(texCoords.isValid() ? "/" : "//");
+        text.appendInt(normals.byteStride() == 0 ? 1 : (normalsPerPoint ? point : corner) + 1);
+      }
+    }
+    text.append('\n');
+  });
+
+  if (!formatted) {
+    writer.close();
+    printf("Error: could not allocate memory to format OBJ file: %s\n", filename);
+    return kOfxStatErrMemory;
+  }
+  if (!writer.close()) {
+    printf("Error: could not write OBJ file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  return kOfxStatOK;
+}
@@ -0,0 +1,19 @@
+#ifndef _ObjWriter_h_
+#define _ObjWriter_h_
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+/**
+ * Write a mesh to a Wavefront OBJ file. Besides point positions and faces,
+ * the first float2 texture coordinate attribute and the first float3 normal
+ * attribute attached to points or corners are written as "vt" and "vn"
+ * lines. Other attributes cannot be represented.
+ * Lines are formatted by blocks on all threads and written in order.
+ */
+OfxStatus saveObjMesh(const char *filename, const OfxMeshStruct *mesh);
+
+#endif // _ObjWriter_h_
@@ -0,0 +1,118 @@
+#ifndef _OutputSlots_h_
+#define _OutputSlots_h_
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * Output meshes that successive cooks of an effect instance alternate
+ * between, so that a result remains valid (e.g. displayed or inspected)
+ * while the next one is cooked.
+ *
+ * A slot holding an output that is in use is pinned, and cooks only write
+ * to slots that are not pinned, preferably not the one of the last output.
+ * With a single slot, the output must thus be released before cooking
+ * again. Slot is any structure with an OfxMeshStruct mesh and an int
+ * pinCount, e.g. with a handle for the JavaScript bindings.
+ */
+template <typename Slot>
+class OutputSlots {
+public:
+  OutputSlots() {
+    m_slots.emplace_back(new Slot());
+    m_last = m_slots[0].get();
+  }
+  OutputSlots(const OutputSlots&) = delete;
+  OutputSlots& operator=(const OutputSlots&) = delete;
+  OutputSlots(OutputSlots&&) = default;
+  OutputSlots& operator=(OutputSlots&&) = default;
+
+  int count() const { return static_cast<int>(m_slots.size()); }
+
+  /**
+   * Add or remove slots. Slots that are pinned or hold the last output are
+   * never removed, in which case this returns kOfxStatErrValue.
+   */
+  OfxStatus setCount(int count) {
+    if (count < 1) return kOfxStatErrValue;
+    while (this->count() < count) {
+      m_slots.emplace_back(new Slot());
+    }
+    for (auto it = m_slots.begin() ; it != m_slots.end() && this->count() > count ;) {
+      if ((*it)->pinCount == 0 && it->get() != m_last) {
+        it = m_slots.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return this->count() > count ? kOfxStatErrValue : kOfxStatOK;
+  }
+
+  // Slot of the last successful cook, which is empty until then
+  Slot* last() const { return m_last; }
+
+  /**
+   * Slot that the next cook may write to, or nullptr if they are all
+   * pinned.
+   */
+  Slot* next() const {
+    Slot *slot = nullptr;
+    for (const auto& candidate : m_slots) {
+      if (candidate->pinCount > 0) continue;
+      if (nullptr == slot || slot == m_last) slot = candidate.get();
+    }
+    return slot;
+  }
+
+  /**
+   * Move a cooked mesh to a slot returned by next(), which then holds the
+   * last output. The mesh is left empty.
+   */
+  void store(Slot *slot, OfxMeshStruct *mesh) {
+    meshDestroy(&slot->mesh);
+    slot->mesh = *mesh;
+    meshInit(mesh);
+    m_last = slot;
+  }
+
+  // Pin the slot of the last output and return it
+  Slot* pinLast() {
+    ++m_last->pinCount;
+    return m_last;
+  }
+
+  /**
+   * Unpin a slot, return kOfxStatErrBadHandle if it is not one of these
+   * slots or is not pinned.
+   */
+  OfxStatus release(const Slot *slot) {
+    for (const auto& candidate : m_slots) {
+      if (candidate.get() != slot) continue;
+      if (candidate->pinCount == 0) return kOfxStatErrBadHandle;
+      --candidate->pinCount;
+      return kOfxStatOK;
+    }
+    return kOfxStatErrBadHandle;
+  }
+
+  // First slot for which pred(slot) is true, or nullptr
+  template <typename Predicate>
+  Slot* find(Predicate pred) const {
+    for (const auto& slot : m_slots) {
+      if (pred(*slot)) return slot.get();
+    }
+    return nullptr;
+  }
+
+private:
+  std::vector<std::unique_ptr<Slot>> m_slots;
+  Slot *m_last; // slot of the last successful cook
+};
+
+#endif // _OutputSlots_h_
@@ -0,0 +1,153 @@
+#include "Parallel.h"
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define WEBMFX_NO_THREADS
+#endif
+
+#ifndef WEBMFX_NO_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+#ifdef WEBMFX_NO_THREADS
+
+int threadCount() {
+  return 1;
+}
+
+void parallelFor(int count, const std::function<void(int)>& func) {
+  for (int i = 0 ; i < count ; ++i) {
+    func(i);
+  }
+}
+
+#else // WEBMFX_NO_THREADS
+
+/**
+ * Workers sleep until a job is posted, then all threads (including the one
+ * that posted the job) grab iterations from a shared atomic counter until
+ * there are none left. There is at most one job at a time.
+ */
+class ThreadPool {
+public:
+  static ThreadPool& instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  int size() const { return static_cast<int>(m_workers.size()) + 1; }
+
+  void run(int count, const std::function<void(int)>& func) {
+    std::unique_lock<std::mutex> jobLock(m_jobMutex, std::try_to_lock);
+    if (!jobLock.owns_lock() || s_isWorker || m_workers.empty() || count <= 1) {
+      for (int i = 0 ; i < count ; ++i) func(i);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_func = &func;
+      m_count = count;
+      m_next = 0;
+      m_pending = count;
+      ++m_generation;
+    }
+    m_wakeCondition.notify_all();
+
+    work(func, count);
+
+    // Also wait for workers that joined late, so that none of them still
+    // holds a reference to func when the next job resets the counter.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_pending == 0 && m_activeWorkers == 0; });
+    m_func = nullptr;
+  }
+
+private:
+  ThreadPool() {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    int workerCount = hardwareThreads > 1 ? static_cast<int>(hardwareThreads) - 1 : 0;
+    for (int i = 0 ; i < workerCount ; ++i) {
+      m_workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wakeCondition.notify_all();
+    for (auto& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  void workerLoop() {
+    s_isWorker = true;
+    unsigned int seenGeneration = 0;
+    for (;;) {
+      const std::function<void(int)> *func;
+      int count;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeCondition.wait(lock, [&] { return m_stop || (m_func != nullptr && m_generation != seenGeneration); });
+        if (m_stop) return;
+        seenGeneration = m_generation;
+        func = m_func;
+        count = m_count;
+        ++m_activeWorkers;
+      }
+      work(*func, count);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_activeWorkers;
+        if (m_pending == 0 && m_activeWorkers == 0) m_doneCondition.notify_all();
+      }
+    }
+  }
+
+  void work(const std::function<void(int)>& func, int count) {
+    int done = 0;
+    for (int i = m_next++ ; i < count ; i = m_next++) {
+      func(i);
+      ++done;
+    }
+    if (done > 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pending -= done;
+      if (m_pending == 0 && m_activeWorkers == 0) m_doneCondition.notify_all();
+    }
+  }
+
+private:
+  std::vector<std::thread> m_workers;
+  std::mutex m_jobMutex; // held while a job is running
+  std::mutex m_mutex; // protects the job description below
+  std::condition_variable m_wakeCondition;
+  std::condition_variable m_doneCondition;
+  const std::function<void(int)> *m_func = nullptr;
+  int m_count = 0;
+  std::atomic<int> m_next{0};
+  int m_pending = 0;
+  int m_activeWorkers = 0;
+  unsigned int m_generation = 0;
+  bool m_stop = false;
+
+  static thread_local bool s_isWorker;
+};
+
+thread_local bool ThreadPool::s_isWorker = false;
+
+int threadCount() {
+  return ThreadPool::instance().size();
+}
+
+void parallelFor(int count, const std::function<void(int)>& func) {
+  ThreadPool::instance().run(count, func);
+}
+
+#endif // WEBMFX_NO_THREADS
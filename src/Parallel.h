@@ -0,0 +1,26 @@
+#ifndef _Parallel_h_
+#define _Parallel_h_
+
+/**
+ * Minimal data parallelism on top of a process-wide thread pool. When the
+ * host is built for WebAssembly without pthreads support (see the
+ * WEBMFX_PTHREADS CMake option), everything runs on the calling thread.
+ */
+
+#include <functional>
+
+/**
+ * Number of threads that parallelFor() distributes work on, including the
+ * calling thread. This is 1 when threads are not available.
+ */
+int threadCount();
+
+/**
+ * Call func(i) for all i in [0, count) and wait for all calls to return.
+ * Iterations are distributed dynamically, so they may be unevenly sized.
+ * Calls issued from within a running parallelFor() (or concurrently with
+ * one) are executed serially on the calling thread.
+ */
+void parallelFor(int count, const std::function<void(int)>& func);
+
+#endif // _Parallel_h_
@@ -0,0 +1,730 @@
+#include "PlyFormat.h"
+#include "Blob.h"
+#include "GrowableBuffer.h"
+#include "Parallel.h"
+#include "BufferedWriter.h"
+
+extern "C" {
+#include <host/meshEffectSuite.h>
+#include <common/common.h> // for MFX_ENSURE
+}
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+static const int pointBlockSize = 1 << 16;
+
+enum PlyType {
+  PLY_INVALID,
+  PLY_CHAR,
+  PLY_UCHAR,
+  PLY_SHORT,
+  PLY_USHORT,
+  PLY_INT,
+  PLY_UINT,
+  PLY_FLOAT,
+  PLY_DOUBLE,
+};
+
+namespace {
+
+struct PlyProperty {
+  std::string name;
+  PlyType type = PLY_INVALID;
+  PlyType countType = PLY_INVALID; // only for lists
+  bool isList = false;
+  size_t offset = 0; // in the record, only for elements without lists
+};
+
+struct PlyElement {
+  std::string name;
+  long long count = 0;
+  std::vector<PlyProperty> properties;
+  bool hasList = false;
+  size_t recordSize = 0; // only for elements without lists
+
+  const PlyProperty* property(const char *name) const {
+    for (const PlyProperty& prop : properties) {
+      if (prop.name == name) return &prop;
+    }
+    return nullptr;
+  }
+};
+
+/**
+ * Consecutive vertex properties that end up in the same point attribute.
+ */
+struct PropertyGroup {
+  std::string name;
+  const char *semantic = nullptr;
+  std::vector<const PlyProperty*> properties;
+};
+
+} // anonymous namespace
+
+static PlyType parseType(const std::string& name) {
+  if (name == "char" || name == "int8") return PLY_CHAR;
+  if (name == "uchar" || name == "uint8") return PLY_UCHAR;
+  if (name == "short" || name == "int16") return PLY_SHORT;
+  if (name == "ushort" || name == "uint16") return PLY_USHORT;
+  if (name == "int" || name == "int32") return PLY_INT;
+  if (name == "uint" || name == "uint32") return PLY_UINT;
+  if (name == "float" || name == "float32") return PLY_FLOAT;
+  if (name == "double" || name == "float64") return PLY_DOUBLE;
+  return PLY_INVALID;
+}
+
+static size_t typeSize(PlyType type) {
+  switch (type) {
+  case PLY_CHAR:
+  case PLY_UCHAR:
+    return 1;
+  case PLY_SHORT:
+  case PLY_USHORT:
+    return 2;
+  case PLY_INT:
+  case PLY_UINT:
+  case PLY_FLOAT:
+    return 4;
+  case PLY_DOUBLE:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+static double readValue(const char *p, PlyType type) {
+  switch (type) {
+  case PLY_CHAR: { int8_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_UCHAR: { uint8_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_SHORT: { int16_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_USHORT: { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_INT: { int32_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_UINT: { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_FLOAT: { float v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_DOUBLE: { double v; memcpy(&v, p, sizeof(v)); return v; }
+  default: return 0.0;
+  }
+}
+
+/**
+ * Read an unsigned integer, used for list counts and indices. Return -1 for
+ * negative and non integer values.
+ */
+static long long readIndex(const char *p, PlyType type) {
+  switch (type) {
+  case PLY_UCHAR: return static_cast<uint8_t>(*p);
+  case PLY_USHORT: { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_UINT: { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+  case PLY_CHAR: { int8_t v; memcpy(&v, p, sizeof(v)); return v < 0 ? -1 : v; }
+  case PLY_SHORT: { int16_t v; memcpy(&v, p, sizeof(v)); return v < 0 ? -1 : v; }
+  case PLY_INT: { int32_t v; memcpy(&v, p, sizeof(v)); return v < 0 ? -1 : v; }
+  default: return -1;
+  }
+}
+
+/**
+ * Parse the text header, return the offset of the binary data or 0 if the
+ * header is invalid.
+ */
+static size_t parseHeader(const char *data, size_t size, std::vector<PlyElement>& elements) {
+  const char *p = data;
+  const char *end = data + size;
+  bool isFirstLine = true;
+  bool hasFormat = false;
+  while (p < end) {
+    const char *lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (nullptr == lineEnd) return 0;
+    std::string line(p, lineEnd);
+    p = lineEnd + 1;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    std::vector<std::string> tokens;
+    size_t start = 0;
+    while (start < line.size()) {
+      size_t tokenEnd = line.find_first_of(" \t", start);
+      if (tokenEnd == std::string::npos) tokenEnd = line.size();
+      if (tokenEnd > start) tokens.push_back(line.substr(start, tokenEnd - start));
+      start = tokenEnd + 1;
+    }
+    if (tokens.empty()) continue;
+
+    if (isFirstLine) {
+      if (tokens[0] != "ply") return 0;
+      isFirstLine = false;
+    } else if (tokens[0] == "format") {
+      if (tokens.size() < 2 || tokens[1] != "binary_little_endian") {
+        printf("Error: only binary little endian PLY files are supported\n");
+        return 0;
+      }
+      hasFormat = true;
+    } else if (tokens[0] == "element") {
+      if (tokens.size() < 3) return 0;
+      elements.emplace_back();
+      elements.back().name = tokens[1];
+      elements.back().count = strtoll(tokens[2].c_str(), nullptr, 10);
+      if (elements.back().count < 0) return 0;
+    } else if (tokens[0] == "property") {
+      if (elements.empty()) return 0;
+      PlyElement& element = elements.back();
+      PlyProperty prop;
+      if (tokens.size() >= 5 && tokens[1] == "list") {
+        prop.isList = true;
+        prop.countType = parseType(tokens[2]);
+        prop.type = parseType(tokens[3]);
+        prop.name = tokens[4];
+        if (prop.countType == PLY_INVALID || prop.countType == PLY_FLOAT || prop.countType == PLY_DOUBLE) return 0;
+        element.hasList = true;
+      } else if (tokens.size() >= 3) {
+        prop.type = parseType(tokens[1]);
+        prop.name = tokens[2];
+        prop.offset = element.recordSize;
+        element.recordSize += typeSize(prop.type);
+      } else {
+        return 0;
+      }
+      if (prop.type == PLY_INVALID) return 0;
+      element.properties.push_back(prop);
+    } else if (tokens[0] == "end_header") {
+      return hasFormat ? static_cast<size_t>(p - data) : 0;
+    }
+    // "comment" and "obj_info" lines are ignored
+  }
+  return 0;
+}
+
+/**
+ * Walk through the records of an element that contains lists, optionally
+ * collecting the content of one of its lists as faces. Return the size of
+ * the element's data, or 0 if it overflows the file or has invalid indices,
+ * or if the face buffers cannot grow (see GrowableBuffer::failed()).
+ */
+static size_t scanListElement(const PlyElement& element,
+                              const char *data,
+                              size_t size,
+                              const PlyProperty *indexList,
+                              long long pointCount,
+                              GrowableBuffer<int>& faceSizes,
+                              GrowableBuffer<int>& cornerPoints)
+{
+  const char *p = data;
+  const char *end = data + size;
+
+  // Fast path for the usual "property list uchar int vertex_indices" faces
+  if (element.properties.size() == 1 && &element.properties[0] == indexList
+    && indexList->countType == PLY_UCHAR && (indexList->type == PLY_INT || indexList->type == PLY_UINT))
+  {
+    for (long long i = 0 ; i < element.count ; ++i) {
+      if (p == end) return 0;
+      int count = static_cast<uint8_t>(*p++);
+      if (static_cast<size_t>(end - p) < count * sizeof(uint32_t)) return 0;
+      size_t cornerOffset = cornerPoints.size();
+      if (!faceSizes.push_back(count) || !cornerPoints.resize(cornerOffset + count)) return 0;
+      memcpy(cornerPoints.data() + cornerOffset, p, count * sizeof(uint32_t));
+      p += count * sizeof(uint32_t);
+      for (int k = 0 ; k < count ; ++k) {
+        if (static_cast<uint32_t>(cornerPoints[cornerOffset + k]) >= static_cast<uint64_t>(pointCount)) return 0;
+      }
+    }
+    return static_cast<size_t>(p - data);
+  }
+
+  for (long long i = 0 ; i < element.count ; ++i) {
+    for (const PlyProperty& prop : element.properties) {
+      if (!prop.isList) {
+        if (static_cast<size_t>(end - p) < typeSize(prop.type)) return 0;
+        p += typeSize(prop.type);
+        continue;
+      }
+      size_t countSize = typeSize(prop.countType);
+      if (p + countSize > end) return 0;
+      long long count = readIndex(p, prop.countType);
+      p += countSize;
+      size_t valueSize = typeSize(prop.type);
+      if (count < 0 || static_cast<size_t>(end - p) < count * valueSize) return 0;
+      if (&prop == indexList) {
+        if (!faceSizes.push_back(static_cast<int>(count))) return 0;
+        for (long long k = 0 ; k < count ; ++k) {
+          long long index = readIndex(p + k * valueSize, prop.type);
+          if (index < 0 || index >= pointCount) return 0;
+          if (!cornerPoints.push_back(static_cast<int>(index))) return 0;
+        }
+      }
+      p += count * valueSize;
+    }
+  }
+  return static_cast<size_t>(p - data);
+}
+
+/**
+ * Size of the data of an element without lists, or 0 if it does not fit in
+ * the available size.
+ */
+static size_t fixedElementSize(const PlyElement& element, size_t available) {
+  if (element.recordSize == 0 || static_cast<unsigned long long>(element.count) > available / element.recordSize) return 0;
+  return static_cast<size_t>(element.count) * element.recordSize;
+}
+
+/**
+ * Group the vertex properties into attributes, see PlyFormat.h
+ */
+static std::vector<PropertyGroup> groupVertexProperties(const PlyElement& vertex) {
+  struct KnownGroup { const char *name; const char *semantic; const char *components[4]; int minCount; };
+  static const KnownGroup knownGroups[] = {
+    { kOfxMeshAttribPointPosition, nullptr, { "x", "y", "z", nullptr }, 3 },
+    { "normal", kOfxMeshAttribSemanticNormal, { "nx", "ny", "nz", nullptr }, 3 },
+    { "color", kOfxMeshAttribSemanticColor, { "red", "green", "blue", "alpha" }, 3 },
+    { "uv", kOfxMeshAttribSemanticTextureCoordinate, { "u", "v", nullptr, nullptr }, 2 },
+    { "uv", kOfxMeshAttribSemanticTextureCoordinate, { "s", "t", nullptr, nullptr }, 2 },
+  };
+
+  std::vector<PropertyGroup> groups;
+  std::vector<bool> isGrouped(vertex.properties.size(), false);
+  for (const KnownGroup& known : knownGroups) {
+    PropertyGroup group;
+    group.name = known.name;
+    group.semantic = known.semantic;
+    for (int k = 0 ; k < 4 && nullptr != known.components[k] ; ++k) {
+      const PlyProperty *prop = vertex.property(known.components[k]);
+      if (nullptr == prop) break;
+      group.properties.push_back(prop);
+    }
+    if (static_cast<int>(group.properties.size()) < known.minCount) continue;
+    for (const PlyProperty *prop : group.properties) isGrouped[prop - vertex.properties.data()] = true;
+    bool isDuplicate = false;
+    for (const PropertyGroup& other : groups) isDuplicate = isDuplicate || other.name == group.name;
+    if (!isDuplicate) groups.push_back(group);
+  }
+
+  for (size_t i = 0 ; i < vertex.properties.size() ; ++i) {
+    if (isGrouped[i]) continue;
+    PropertyGroup group;
+    group.name = vertex.properties[i].name;
+    group.properties.push_back(&vertex.properties[i]);
+    groups.push_back(group);
+  }
+  return groups;
+}
+
+/**
+ * Type in which a group of vertex properties is stored in the mesh (one of
+ * PLY_FLOAT, PLY_INT or PLY_UCHAR), and whether the records can be viewed in
+ * place, i.e. the components are contiguous, of that very type and suitably
+ * aligned in records that start at a multiple of alignof(float).
+ */
+static PlyType groupStorageType(const PropertyGroup& group, bool *isViewable) {
+  PlyType type = group.properties[0]->type;
+  bool isUniform = true;
+  bool isContiguous = true;
+  for (size_t k = 1 ; k < group.properties.size() ; ++k) {
+    isUniform = isUniform && group.properties[k]->type == type;
+    isContiguous = isContiguous && group.properties[k]->offset == group.properties[0]->offset + k * typeSize(type);
+  }
+
+  PlyType storageType;
+  if (group.name == kOfxMeshAttribPointPosition || !isUniform || type == PLY_FLOAT || type == PLY_DOUBLE) {
+    storageType = PLY_FLOAT;
+  } else if (type == PLY_UCHAR) {
+    storageType = PLY_UCHAR;
+  } else {
+    storageType = PLY_INT;
+  }
+  *isViewable = isUniform && isContiguous && type == storageType
+    && group.properties[0]->offset % typeSize(storageType) == 0;
+  return storageType;
+}
+
+/**
+ * Define a point attribute from a group of vertex properties, either as a
+ * view into the vertex records or as a converted copy. Records start every
+ * recordStride bytes from vertexData.
+ */
+static OfxStatus definePointAttribute(OfxMeshStruct *mesh, const char *vertexData, size_t recordStride, const PropertyGroup& group) {
+  bool isViewable;
+  PlyType storageType = groupStorageType(group, &isViewable);
+  const char *attribType =
+    storageType == PLY_FLOAT ? kOfxMeshAttribTypeFloat :
+    storageType == PLY_INT ? kOfxMeshAttribTypeInt :
+    kOfxMeshAttribTypeUByte;
+  size_t componentSize = attributeComponentSize(attribType);
+  int componentCount = static_cast<int>(group.properties.size());
+
+  OfxMeshAttributePropertySet *attrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribPoint,
+                             group.name.c_str(),
+                             componentCount,
+                             attribType,
+                             group.semantic,
+                             (OfxPropertySetHandle*)&attrib));
+
+  const char *first = vertexData + group.properties[0]->offset;
+  bool isAligned = reinterpret_cast<uintptr_t>(first) % componentSize == 0 && recordStride % componentSize == 0;
+  if (isViewable && isAligned) {
+    attrib->data = const_cast<char*>(first);
+    attrib->byte_stride = recordStride;
+    attrib->is_owner = 0;
+    return kOfxStatOK;
+  }
+
+  int pointCount = mesh->properties.point_count;
+  size_t elementSize = componentCount * componentSize;
+  char *data = static_cast<char*>(malloc(std::max(pointCount * elementSize, static_cast<size_t>(1))));
+  if (nullptr == data) return kOfxStatErrMemory;
+  attrib->data = data;
+  attrib->byte_stride = elementSize;
+  attrib->is_owner = 1;
+
+  int blockCount = (pointCount + pointBlockSize - 1) / pointBlockSize;
+  parallelFor(blockCount, [&](int block) {
+    int end = std::min(pointCount, (block + 1) * pointBlockSize);
+    for (int i = block * pointBlockSize ; i < end ; ++i) {
+      const char *record = vertexData + i * recordStride;
+      char *dst = data + i * elementSize;
+      for (int k = 0 ; k < componentCount ; ++k) {
+        const PlyProperty *prop = group.properties[k];
+        if (prop->type == storageType) {
+          memcpy(dst + k * componentSize, record + prop->offset, componentSize);
+          continue;
+        }
+        double value = readValue(record + prop->offset, prop->type);
+        if (storageType == PLY_FLOAT) {
+          float f = static_cast<float>(value);
+          memcpy(dst + k * sizeof(float), &f, sizeof(f));
+        } else if (storageType == PLY_INT) {
+          int n = static_cast<int>(value);
+          memcpy(dst + k * sizeof(int), &n, sizeof(n));
+        } else {
+          dst[k] = static_cast<char>(static_cast<unsigned char>(value));
+        }
+      }
+    }
+  });
+  return kOfxStatOK;
+}
+
+OfxStatus loadPlyMesh(Blob& blob, OfxMeshStruct *mesh) {
+  std::vector<PlyElement> elements;
+  size_t dataOffset = parseHeader(blob.data(), blob.size(), elements);
+  if (0 == dataOffset) {
+    printf("Error: invalid PLY header\n");
+    return kOfxStatErrFormat;
+  }
+
+  // 1. Locate the vertex and face elements, parsing faces on the way
+  const PlyElement *vertex = nullptr;
+  const char *vertexData = nullptr;
+  GrowableBuffer<int> faceSizes;
+  GrowableBuffer<int> cornerPoints;
+  const char *p = blob.data() + dataOffset;
+  const char *end = blob.data() + blob.size();
+  bool hasFaces = false;
+  for (const PlyElement& element : elements) {
+    size_t elementSize;
+    if (element.name == "vertex" && nullptr == vertex) {
+      if (element.hasList || nullptr == element.property("x") || nullptr == element.property("y") || nullptr == element.property("z")) {
+        printf("Error: PLY vertices must have x, y and z properties and no list\n");
+        return kOfxStatErrUnsupported;
+      }
+      if (element.count > INT_MAX) {
+        printf("Error: PLY file has too many vertices\n");
+        return kOfxStatErrUnsupported;
+      }
+      vertex = &element;
+      vertexData = p;
+      elementSize = fixedElementSize(element, end - p);
+    } else if (element.name == "face" && nullptr != vertex && !hasFaces) {
+      const PlyProperty *indexList = element.property("vertex_indices");
+      if (nullptr == indexList) indexList = element.property("vertex_index");
+      if (nullptr == indexList || !indexList->isList) {
+        printf("Error: PLY faces have no vertex_indices list\n");
+        return kOfxStatErrFormat;
+      }
+      elementSize = scanListElement(element, p, end - p, indexList, vertex->count, faceSizes, cornerPoints);
+      hasFaces = true;
+    } else if (!element.hasList) {
+      elementSize = fixedElementSize(element, end - p);
+    } else {
+      GrowableBuffer<int> ignoredSizes, ignoredCorners;
+      elementSize = scanListElement(element, p, end - p, nullptr, 0, ignoredSizes, ignoredCorners);
+    }
+    if (faceSizes.failed() || cornerPoints.failed()) {
+      printf("Error: could not allocate memory for PLY faces\n");
+      return kOfxStatErrMemory;
+    }
+    if (elementSize == 0 && element.count > 0) {
+      printf("Error: PLY element %s is truncated or invalid\n", element.name.c_str());
+      return kOfxStatErrFormat;
+    }
+    p += elementSize;
+  }
+  if (nullptr == vertex) {
+    printf("Error: PLY file has no vertex element\n");
+    return kOfxStatErrFormat;
+  }
+  if (cornerPoints.size() > INT_MAX) {
+    printf("Error: PLY file has too many face corners\n");
+    return kOfxStatErrUnsupported;
+  }
+
+  OfxMeshPropertySet& props = mesh->properties;
+  props.point_count = static_cast<int>(vertex->count);
+  props.corner_count = static_cast<int>(cornerPoints.size());
+  props.face_count = static_cast<int>(faceSizes.size());
+  props.constant_face_size = -1;
+
+  // Drop face sizes when all faces have the same size, e.g. scanned triangles
+  if (faceSizes.size() > 0) {
+    int size = faceSizes[0];
+    bool isConstant = true;
+    for (size_t i = 1 ; isConstant && i < faceSizes.size() ; ++i) isConstant = faceSizes[i] == size;
+    if (isConstant) {
+      props.constant_face_size = size;
+      faceSizes = GrowableBuffer<int>();
+    }
+  }
+
+  // 2. Point attributes, starting with the position. The header has any
+  // length and records are packed, so records are seldom aligned. Rather
+  // than converting each attribute that could be a view, the vertex block is
+  // copied once with records padded to an aligned stride.
+  std::vector<PropertyGroup> groups = groupVertexProperties(*vertex);
+  size_t recordStride = vertex->recordSize;
+  const size_t alignment = alignof(float);
+  bool hasViewableGroup = false;
+  for (const PropertyGroup& group : groups) {
+    bool isViewable;
+    groupStorageType(group, &isViewable);
+    hasViewableGroup = hasViewableGroup || isViewable;
+  }
+  if (hasViewableGroup && (reinterpret_cast<uintptr_t>(vertexData) % alignment != 0 || recordStride % alignment != 0)) {
+    size_t alignedStride = (recordStride + alignment - 1) / alignment * alignment;
+    char *aligned = static_cast<unsigned long long>(vertex->count) <= SIZE_MAX / alignedStride
+      ? blob.allocate(vertex->count * alignedStride)
+      : nullptr;
+    if (nullptr == aligned) {
+      printf("Error: could not allocate memory for PLY vertices\n");
+      return kOfxStatErrMemory;
+    }
+    if (alignedStride == recordStride) {
+      memcpy(aligned, vertexData, vertex->count * recordStride);
+    } else {
+      int pointCount = static_cast<int>(vertex->count);
+      int blockCount = (pointCount + pointBlockSize - 1) / pointBlockSize;
+      parallelFor(blockCount, [&](int block) {
+        int blockEnd = std::min(pointCount, (block + 1) * pointBlockSize);
+        for (int i = block * pointBlockSize ; i < blockEnd ; ++i) {
+          memcpy(aligned + i * alignedStride, vertexData + i * recordStride, recordStride);
+        }
+      });
+    }
+    vertexData = aligned;
+    recordStride = alignedStride;
+  }
+  MFX_ENSURE(definePointAttribute(mesh, vertexData, recordStride, groups[0]));
+
+  // 3. Corner points and face sizes
+  OfxMeshAttributePropertySet *cornerPointAttrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribCorner,
+                             kOfxMeshAttribCornerPoint,
+                             1,
+                             kOfxMeshAttribTypeInt,
+                             nullptr,
+                             (OfxPropertySetHandle*)&cornerPointAttrib));
+  cornerPointAttrib->data = reinterpret_cast<char*>(cornerPoints.release());
+  cornerPointAttrib->byte_stride = sizeof(int);
+  cornerPointAttrib->is_owner = 1;
+
+  OfxMeshAttributePropertySet *faceSizeAttrib;
+  MFX_ENSURE(attributeDefine(mesh,
+                             kOfxMeshAttribFace,
+                             kOfxMeshAttribFaceSize,
+                             1,
+                             kOfxMeshAttribTypeInt,
+                             nullptr,
+                             (OfxPropertySetHandle*)&faceSizeAttrib));
+  faceSizeAttrib->data = reinterpret_cast<char*>(faceSizes.release());
+  faceSizeAttrib->byte_stride = sizeof(int);
+  faceSizeAttrib->is_owner = 1;
+
+  // 4. Other point attributes, as long as there is room for them
+  const size_t maxAttributes = sizeof(mesh->attributes) / sizeof(*mesh->attributes);
+  for (size_t i = 1 ; i < groups.size() ; ++i) {
+    if (mesh->attributes[maxAttributes - 1].is_valid) {
+      printf("Warning: too many PLY vertex properties, ignoring %s and the following ones\n", groups[i].name.c_str());
+      break;
+    }
+    MFX_ENSURE(definePointAttribute(mesh, vertexData, recordStride, groups[i]));
+  }
+
+  return kOfxStatOK;
+}
+
+//--------------------------------------------------------
+// Export
+
+namespace {
+
+struct PlyExportedAttribute {
+  mfx::StridedAttributeView<const char, 1> view;
+  size_t elementSize;
+  std::string properties; // lines of the header
+  bool isPosition;
+};
+
+} // anonymous namespace
+
+static const char* plyTypeName(const char *type) {
+  if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) return "float";
+  if (0 == strcmp(type, kOfxMeshAttribTypeInt)) return "int";
+  if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) return "uchar";
+  return nullptr;
+}
+
+/**
+ * Add the property lines of all the attributes of an attachment to the
+ * header, and list the attributes to write in each record.
+ */
+static void declareProperties(const OfxMeshStruct *mesh, const char *attachment, std::string& header, std::vector<PlyExportedAttribute>& exported) {
+  bool hasNormal = false, hasColor = false, hasTexCoord = false;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    const char *typeName = plyTypeName(attrib->type);
+    if (0 != strcmp(attrib->attachment, attachment)
+      || 0 == strcmp(attrib->name, kOfxMeshAttribFaceSize)
+      || nullptr == attrib->data
+      || nullptr == typeName
+      || attrib->component_count < 1
+      || attrib->component_count > 4)
+    {
+      continue;
+    }
+
+    static const char *positionNames[] = { "x", "y", "z" };
+    static const char *normalNames[] = { "nx", "ny", "nz" };
+    static const char *colorNames[] = { "red", "green", "blue", "alpha" };
+    static const char *texCoordNames[] = { "u", "v" };
+    const char **names = nullptr;
+    if (0 == strcmp(attrib->name, kOfxMeshAttribPointPosition) && attrib->component_count == 3) {
+      names = positionNames;
+    } else if (!hasNormal && attrib->component_count == 3 && 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticNormal)) {
+      names = normalNames;
+      hasNormal = true;
+    } else if (!hasColor && attrib->component_count >= 3 && 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticColor)) {
+      names = colorNames;
+      hasColor = true;
+    } else if (!hasTexCoord && attrib->component_count == 2 && 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticTextureCoordinate)) {
+      names = texCoordNames;
+      hasTexCoord = true;
+    }
+
+    PlyExportedAttribute entry;
+    entry.view = mfx::makeByteView(mesh, attrib);
+    entry.elementSize = attrib->component_count * attributeComponentSize(attrib->type);
+    entry.isPosition = names == positionNames;
+    for (int k = 0 ; k < attrib->component_count ; ++k) {
+      entry.properties += "property ";
+      entry.properties += typeName;
+      entry.properties += " ";
+      if (nullptr != names) {
+        entry.properties += names[k];
+      } else {
+        entry.properties += attrib->name;
+        if (attrib->component_count > 1) entry.properties += "_" + std::to_string(k);
+      }
+      entry.properties += "\n";
+    }
+    exported.push_back(entry);
+  }
+
+  // Position first, as most readers expect
+  std::stable_partition(exported.begin(), exported.end(), [](const PlyExportedAttribute& entry) {
+    return entry.isPosition;
+  });
+  for (const PlyExportedAttribute& entry : exported) header += entry.properties;
+}
+
+static void writeRecordFields(BufferedWriter& writer, const std::vector<PlyExportedAttribute>& exported, int index) {
+  for (const PlyExportedAttribute& entry : exported) {
+    writer.write(entry.view.bytes(index), entry.elementSize);
+  }
+}
+
+OfxStatus savePlyMesh(const char *filename, const OfxMeshStruct *mesh) {
+  const OfxMeshPropertySet& props = mesh->properties;
+  const OfxMeshAttributePropertySet *cornerPointAttrib = nullptr;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribCorner) && 0 == strcmp(attrib->name, kOfxMeshAttribCornerPoint)) cornerPointAttrib = attrib;
+  }
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(mesh, cornerPointAttrib);
+  auto faceSizes = mfx::makeFaceSizeView(mesh);
+  if (props.face_count > 0 && (!cornerPoints.isValid() || !faceSizes.isValid())) {
+    printf("Error: cannot save a mesh without face connectivity to PLY\n");
+    return kOfxStatErrBadHandle;
+  }
+
+  // Face sizes above 255 need a larger list count type
+  int maxFaceSize = 0;
+  for (int face = 0 ; face < props.face_count ; ++face) {
+    maxFaceSize = std::max(maxFaceSize, faceSizes.get(face));
+    if (faceSizes.byteStride() == 0) break;
+  }
+  bool hasLargeFaces = maxFaceSize > 255;
+
+  std::string header = "ply\nformat binary_little_endian 1.0\ncomment WebMfx\n";
+  std::vector<PlyExportedAttribute> vertexAttributes, faceAttributes;
+  header += "element vertex " + std::to_string(props.point_count) + "\n";
+  declareProperties(mesh, kOfxMeshAttribPoint, header, vertexAttributes);
+  if (props.face_count > 0) {
+    header += "element face " + std::to_string(props.face_count) + "\n";
+    header += hasLargeFaces ? "property list int int vertex_indices\n" : "property list uchar int vertex_indices\n";
+    declareProperties(mesh, kOfxMeshAttribFace, header, faceAttributes);
+  }
+  header += "end_header\n";
+
+  BufferedWriter writer;
+  if (!writer.open(filename)) {
+    printf("Error: could not open file for writing: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  writer.write(header.data(), header.size());
+
+  for (int i = 0 ; i < props.point_count ; ++i) {
+    writeRecordFields(writer, vertexAttributes, i);
+  }
+
+  int offset = 0;
+  for (int face = 0 ; face < props.face_count ; ++face) {
+    int faceSize = faceSizes.get(face);
+    if (hasLargeFaces) {
+      writer.write(&faceSize, sizeof(int));
+    } else {
+      uint8_t count = static_cast<uint8_t>(faceSize);
+      writer.write(&count, sizeof(count));
+    }
+    if (cornerPoints.byteStride() == sizeof(int) && faceSize > 0) {
+      writer.write(cornerPoints.bytes(offset), faceSize * sizeof(int));
+    } else {
+      for (int k = 0 ; k < faceSize ; ++k) writer.write(cornerPoints.bytes(offset + k), sizeof(int));
+    }
+    writeRecordFields(writer, faceAttributes, face);
+    offset += faceSize;
+  }
+
+  if (!writer.close()) {
+    printf("Error: could not write PLY file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  return kOfxStatOK;
+}
@@ -0,0 +1,48 @@
+#ifndef _PlyFormat_h_
+#define _PlyFormat_h_
+
+/**
+ * Binary little endian PLY import, for scanned point clouds and meshes.
+ *
+ * Vertex properties are grouped into point attributes:
+ *
+ *   x, y, z                     -> point position
+ *   nx, ny, nz                  -> point "normal"
+ *   red, green, blue[, alpha]   -> point "color"
+ *   u, v (or s, t)              -> point "uv"
+ *   any other scalar property   -> point attribute of the same name
+ *
+ * Faces are read from the "vertex_indices" (or "vertex_index") list of the
+ * face element, if any. Without faces, the mesh is a point cloud with no
+ * corner and no face.
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+class Blob;
+
+/**
+ * Define the attributes of a mesh initialized with meshInit() from the
+ * content of a PLY file. Vertex records have a fixed layout, so point
+ * attributes are strided views (with is_owner = 0) whenever their components
+ * are contiguous and of a type that the mesh supports. Views point into the
+ * blob, or into a copy of the vertex records with an aligned stride that the
+ * blob owns when the records in the file are not aligned. Other attributes
+ * are converted into owned buffers, which is a plain strided copy rather than
+ * actual parsing.
+ */
+OfxStatus loadPlyMesh(Blob& blob, OfxMeshStruct *mesh);
+
+/**
+ * Write a mesh to a binary little endian PLY file, with the same property
+ * names as above. Point attributes become vertex properties and face
+ * attributes become face properties. Corner attributes have no equivalent
+ * in PLY and are not written.
+ */
+OfxStatus savePlyMesh(const char *filename, const OfxMeshStruct *mesh);
+
+#endif // _PlyFormat_h_
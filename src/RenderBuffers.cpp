@@ -0,0 +1,414 @@
+#include "RenderBuffers.h"
+#include "Parallel.h"
+#include "Hash.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+static const int faceBlockSize = 1 << 14;
+
+struct Vec3 {
+  float x, y, z;
+};
+
+static Vec3 sub(const Vec3& a, const Vec3& b) {
+  return Vec3{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static Vec3 cross(const Vec3& a, const Vec3& b) {
+  return Vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static float dot(const Vec3& a, const Vec3& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vec3 normalize(const Vec3& v) {
+  float length = std::sqrt(dot(v, v));
+  return length > 0 ? Vec3{ v.x / length, v.y / length, v.z / length } : v;
+}
+
+/**
+ * Normal of a polygon by Newell's method, which is robust to concave and
+ * slightly non planar polygons. It is not normalized.
+ */
+static Vec3 newellNormal(const Vec3 *points, int n) {
+  Vec3 normal{ 0, 0, 0 };
+  for (int i = 0 ; i < n ; ++i) {
+    const Vec3& a = points[i];
+    const Vec3& b = points[(i + 1) % n];
+    normal.x += (a.y - b.y) * (a.z + b.z);
+    normal.y += (a.z - b.z) * (a.x + b.x);
+    normal.z += (a.x - b.x) * (a.y + b.y);
+  }
+  return normal;
+}
+
+/**
+ * Triangulation of polygons, writing 3 * (n - 2) indices of the polygon's
+ * corners in [0, n) while preserving its winding. Buffers are reused from
+ * one polygon to the next.
+ */
+class Triangulator {
+public:
+  void triangulate(const Vec3 *points, int n, const Vec3& normal, int *triangles);
+
+private:
+  void triangulateQuad(const Vec3 *points, const Vec3& normal, int *triangles);
+  void earClip(const Vec3 *points, int n, const Vec3& normal, int *triangles);
+
+private:
+  std::vector<float> m_u;
+  std::vector<float> m_v;
+  std::vector<int> m_remaining;
+};
+
+void Triangulator::triangulate(const Vec3 *points, int n, const Vec3& normal, int *triangles) {
+  if (n == 3) {
+    triangles[0] = 0; triangles[1] = 1; triangles[2] = 2;
+  } else if (n == 4) {
+    triangulateQuad(points, normal, triangles);
+  } else if (n > 4) {
+    earClip(points, n, normal, triangles);
+  }
+}
+
+void Triangulator::triangulateQuad(const Vec3 *points, const Vec3& normal, int *triangles) {
+  // A quad has at most one reflex corner, and must be split along the
+  // diagonal that starts from it.
+  auto isReflex = [&](int i) {
+    Vec3 edgeIn = sub(points[i], points[(i + 3) % 4]);
+    Vec3 edgeOut = sub(points[(i + 1) % 4], points[i]);
+    return dot(cross(edgeIn, edgeOut), normal) < 0;
+  };
+  if (isReflex(1) || isReflex(3)) {
+    const int split[6] = { 0, 1, 3, 1, 2, 3 };
+    memcpy(triangles, split, sizeof(split));
+  } else {
+    const int split[6] = { 0, 1, 2, 0, 2, 3 };
+    memcpy(triangles, split, sizeof(split));
+  }
+}
+
+void Triangulator::earClip(const Vec3 *points, int n, const Vec3& normal, int *triangles) {
+  // 1. Project onto the axis-aligned plane closest to the polygon's plane
+  float ax = std::abs(normal.x), ay = std::abs(normal.y), az = std::abs(normal.z);
+  m_u.resize(n);
+  m_v.resize(n);
+  for (int i = 0 ; i < n ; ++i) {
+    const Vec3& p = points[i];
+    if (az >= ax && az >= ay) {
+      m_u[i] = p.x; m_v[i] = p.y;
+    } else if (ax >= ay) {
+      m_u[i] = p.y; m_v[i] = p.z;
+    } else {
+      m_u[i] = p.z; m_v[i] = p.x;
+    }
+  }
+
+  // The projection may mirror the polygon, so corners are convex when they
+  // turn in the same direction as the polygon as a whole.
+  float area = 0;
+  for (int i = 0 ; i < n ; ++i) {
+    int j = (i + 1) % n;
+    area += m_u[i] * m_v[j] - m_u[j] * m_v[i];
+  }
+  float orientation = area >= 0 ? 1.0f : -1.0f;
+  auto turn = [&](int a, int b, int c) {
+    return orientation * ((m_u[b] - m_u[a]) * (m_v[c] - m_v[a]) - (m_v[b] - m_v[a]) * (m_u[c] - m_u[a]));
+  };
+
+  m_remaining.resize(n);
+  for (int i = 0 ; i < n ; ++i) m_remaining[i] = i;
+
+  // 2. Clip ears until a triangle remains. If a full turn finds no ear, the
+  // polygon is degenerate (self intersecting or collinear) and the rest is
+  // triangulated as a fan.
+  int count = n;
+  int i = 0;
+  int attempts = count;
+  int *out = triangles;
+  while (count > 3 && attempts > 0) {
+    int prev = m_remaining[(i + count - 1) % count];
+    int cur = m_remaining[i];
+    int next = m_remaining[(i + 1) % count];
+    bool isEar = turn(prev, cur, next) > 0;
+    for (int k = 0 ; isEar && k < count ; ++k) {
+      int other = m_remaining[k];
+      if (other == prev || other == cur || other == next) continue;
+      isEar = !(turn(prev, cur, other) >= 0 && turn(cur, next, other) >= 0 && turn(next, prev, other) >= 0);
+    }
+    if (isEar) {
+      out[0] = prev; out[1] = cur; out[2] = next;
+      out += 3;
+      m_remaining.erase(m_remaining.begin() + i);
+      --count;
+      if (i >= count) i = 0;
+      attempts = count;
+    } else {
+      i = (i + 1) % count;
+      --attempts;
+    }
+  }
+  for (int k = 1 ; k + 1 < count ; ++k) {
+    out[0] = m_remaining[0]; out[1] = m_remaining[k]; out[2] = m_remaining[k + 1];
+    out += 3;
+  }
+}
+
+static const OfxMeshAttributePropertySet* findAttribute(const OfxMeshStruct *mesh, const char *attachment, const char *name) {
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, attachment) && 0 == strcmp(attrib->name, name)) return attrib;
+  }
+  return nullptr;
+}
+
+/**
+ * Find the float3 normal attribute to display, if any. It is the attribute
+ * named "normal" that effects such as ComputeNormals produce, or else the
+ * first attribute with the normal semantic.
+ */
+static const OfxMeshAttributePropertySet* findNormals(const OfxMeshStruct *mesh) {
+  const OfxMeshAttributePropertySet *found = nullptr;
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (attrib->component_count != 3 || 0 != strcmp(attrib->type, kOfxMeshAttribTypeFloat) || nullptr == attrib->data) continue;
+    if (0 == strcmp(attrib->name, "normal")) return attrib;
+    if (nullptr == found && 0 == strcmp(attrib->semantic, kOfxMeshAttribSemanticNormal)) found = attrib;
+  }
+  return found;
+}
+
+enum NormalLayout {
+  ComputedNormals,
+  PointNormals,
+  CornerNormals,
+  FaceNormals,
+  MeshNormals,
+};
+
+static NormalLayout normalLayout(const OfxMeshAttributePropertySet *normalAttrib) {
+  if (nullptr == normalAttrib) return ComputedNormals;
+  if (0 == strcmp(normalAttrib->attachment, kOfxMeshAttribPoint)) return PointNormals;
+  if (0 == strcmp(normalAttrib->attachment, kOfxMeshAttribCorner)) return CornerNormals;
+  if (0 == strcmp(normalAttrib->attachment, kOfxMeshAttribFace)) return FaceNormals;
+  return MeshNormals;
+}
+
+/**
+ * Write a vector to 3 floats of a vertex buffer, raising changed if this
+ * modifies them.
+ */
+static void store(float *dst, const Vec3& value, bool& changed) {
+  if (!changed && 0 != memcmp(dst, &value, sizeof(Vec3))) changed = true;
+  memcpy(dst, &value, sizeof(Vec3));
+}
+
+bool RenderBuffers::Topology::operator==(const Topology& other) const {
+  return pointCount == other.pointCount
+    && cornerCount == other.cornerCount
+    && faceCount == other.faceCount
+    && constantFaceSize == other.constantFaceSize
+    && normalLayout == other.normalLayout
+    && hash == other.hash;
+}
+
+void RenderBuffers::clear() {
+  m_topology = Topology();
+  m_vertexCount = 0;
+  m_triangleCount = 0;
+  m_positions.clear();
+  m_normals.clear();
+  m_indices.clear();
+  m_triangleFaces.clear();
+  m_blockCornerOffsets.clear();
+  m_blockTriangleOffsets.clear();
+}
+
+OfxStatus RenderBuffers::update(const OfxMeshStruct *mesh) {
+  // Errors leave empty buffers, which is a change unless they already were
+  m_changes = PositionsChanged | NormalsChanged | IndicesChanged;
+  const OfxMeshPropertySet& props = mesh->properties;
+
+  const OfxMeshAttributePropertySet *positionAttrib = findAttribute(mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition);
+  if (nullptr == positionAttrib || nullptr == positionAttrib->data || positionAttrib->component_count != 3 || 0 != strcmp(positionAttrib->type, kOfxMeshAttribTypeFloat)) {
+    printf("Error: cannot display a mesh without float point positions\n");
+    clear();
+    return kOfxStatErrUnsupported;
+  }
+  const OfxMeshAttributePropertySet *cornerPointAttrib = findAttribute(mesh, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint);
+  auto positions = mfx::makeAttributeView<float, 3>(mesh, positionAttrib);
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(mesh, cornerPointAttrib);
+  auto faceSizes = mfx::makeFaceSizeView(mesh);
+  if (props.face_count > 0 && (!cornerPoints.isValid() || !faceSizes.isValid())) {
+    printf("Error: cannot display a mesh without face connectivity\n");
+    clear();
+    return kOfxStatErrBadHandle;
+  }
+
+  const OfxMeshAttributePropertySet *normalAttrib = findNormals(mesh);
+  auto normals = mfx::makeAttributeView<float, 3>(mesh, normalAttrib);
+  NormalLayout layout = normalLayout(normalAttrib);
+  bool isPerPoint = layout == PointNormals;
+
+  // 1. Compare the topology with the one of the previous update
+  Topology topology;
+  topology.pointCount = props.point_count;
+  topology.cornerCount = props.corner_count;
+  topology.faceCount = props.face_count;
+  topology.constantFaceSize = props.constant_face_size;
+  topology.normalLayout = layout;
+  topology.hash = hashElements(mfx::makeByteView(mesh, cornerPointAttrib), sizeof(int));
+  if (props.constant_face_size == -1) {
+    const OfxMeshAttributePropertySet *faceSizeAttrib = findAttribute(mesh, kOfxMeshAttribFace, kOfxMeshAttribFaceSize);
+    topology.hash = hashCombine(topology.hash, hashElements(mfx::makeByteView(mesh, faceSizeAttrib), sizeof(int)));
+  }
+  bool triangulate = !(topology == m_topology);
+
+  // 2. Offsets of each block of faces in the corner and triangle lists,
+  // which are part of the topology
+  int blockCount = (props.face_count + faceBlockSize - 1) / faceBlockSize;
+  if (triangulate) {
+    clear();
+    m_blockCornerOffsets.assign(blockCount + 1, 0);
+    m_blockTriangleOffsets.assign(blockCount + 1, 0);
+    int cornerCount = 0;
+    int triangleCount = 0;
+    for (int face = 0 ; face < props.face_count ; ++face) {
+      if (face % faceBlockSize == 0) {
+        m_blockCornerOffsets[face / faceBlockSize] = cornerCount;
+        m_blockTriangleOffsets[face / faceBlockSize] = triangleCount;
+      }
+      int faceSize = faceSizes.get(face);
+      if (faceSize < 0) {
+        printf("Error: invalid size for face #%d: %d\n", face, faceSize);
+        clear();
+        return kOfxStatErrBadIndex;
+      }
+      cornerCount += faceSize;
+      triangleCount += std::max(0, faceSize - 2);
+    }
+    m_blockCornerOffsets[blockCount] = cornerCount;
+    m_blockTriangleOffsets[blockCount] = triangleCount;
+    if (cornerCount != props.corner_count) {
+      printf("Error: face sizes add up to %d corners but the mesh has %d\n", cornerCount, props.corner_count);
+      clear();
+      return kOfxStatErrBadIndex;
+    }
+
+    m_vertexCount = isPerPoint ? props.point_count : props.corner_count;
+    m_triangleCount = triangleCount;
+    m_positions.resize(3 * static_cast<size_t>(m_vertexCount));
+    m_normals.resize(3 * static_cast<size_t>(m_vertexCount));
+    m_indices.resize(3 * static_cast<size_t>(m_triangleCount));
+    m_triangleFaces.resize(m_triangleCount);
+  }
+
+  // Per block change flags, only tracked when the triangulation is reused
+  // since everything changes otherwise
+  int pointBlockCount = (props.point_count + faceBlockSize - 1) / faceBlockSize;
+  std::vector<char> blockPositionsChanged(std::max(blockCount, pointBlockCount), 0);
+  std::vector<char> blockNormalsChanged(std::max(blockCount, pointBlockCount), 0);
+
+  // 3. Vertices that are points are copied as is
+  if (isPerPoint) {
+    parallelFor(pointBlockCount, [&](int block) {
+      bool positionsChanged = false, normalsChanged = false;
+      int end = std::min(props.point_count, (block + 1) * faceBlockSize);
+      for (int point = block * faceBlockSize ; point < end ; ++point) {
+        Vec3 position{ positions.get(point, 0), positions.get(point, 1), positions.get(point, 2) };
+        Vec3 normal{ normals.get(point, 0), normals.get(point, 1), normals.get(point, 2) };
+        store(&m_positions[3 * static_cast<size_t>(point)], position, positionsChanged);
+        store(&m_normals[3 * static_cast<size_t>(point)], normal, normalsChanged);
+      }
+      blockPositionsChanged[block] = positionsChanged;
+      blockNormalsChanged[block] = normalsChanged;
+    });
+  }
+
+  // 4. Faces, by blocks on all threads. Nothing to do if the triangulation
+  // is kept and vertices are points.
+  std::vector<char> blockIsValid(blockCount, 1);
+  if (triangulate || !isPerPoint) {
+    parallelFor(blockCount, [&](int block) {
+      Triangulator triangulator;
+      std::vector<Vec3> points;
+      std::vector<int> localTriangles;
+      bool positionsChanged = false, normalsChanged = false;
+      int corner = m_blockCornerOffsets[block];
+      int triangle = m_blockTriangleOffsets[block];
+      int end = std::min(props.face_count, (block + 1) * faceBlockSize);
+      bool isValid = true;
+      for (int face = block * faceBlockSize ; face < end && isValid ; ++face) {
+        int faceSize = faceSizes.get(face);
+        points.resize(faceSize);
+        for (int k = 0 ; k < faceSize ; ++k) {
+          int point = cornerPoints.get(corner + k);
+          isValid = isValid && point >= 0 && point < props.point_count;
+          if (!isValid) break;
+          points[k] = Vec3{ positions.get(point, 0), positions.get(point, 1), positions.get(point, 2) };
+        }
+        if (!isValid) break;
+
+        Vec3 faceNormal{ 0, 0, 0 };
+        if ((triangulate && faceSize > 3) || layout == ComputedNormals) {
+          faceNormal = newellNormal(points.data(), faceSize);
+        }
+
+        if (!isPerPoint) {
+          for (int k = 0 ; k < faceSize ; ++k) {
+            size_t vertex = 3 * static_cast<size_t>(corner + k);
+            Vec3 normal;
+            if (layout == ComputedNormals) {
+              normal = normalize(faceNormal);
+            } else {
+              int index = layout == CornerNormals ? corner + k : (layout == FaceNormals ? face : 0);
+              normal = Vec3{ normals.get(index, 0), normals.get(index, 1), normals.get(index, 2) };
+            }
+            store(&m_positions[vertex], points[k], positionsChanged);
+            store(&m_normals[vertex], normal, normalsChanged);
+          }
+        }
+
+        if (triangulate && faceSize >= 3) {
+          int localCount = 3 * (faceSize - 2);
+          localTriangles.resize(localCount);
+          triangulator.triangulate(points.data(), faceSize, faceNormal, localTriangles.data());
+          uint32_t *indices = &m_indices[3 * static_cast<size_t>(triangle)];
+          for (int k = 0 ; k < localCount ; ++k) {
+            int c = corner + localTriangles[k];
+            indices[k] = static_cast<uint32_t>(isPerPoint ? cornerPoints.get(c) : c);
+          }
+          for (int t = 0 ; t < faceSize - 2 ; ++t) {
+            m_triangleFaces[triangle + t] = face;
+          }
+          triangle += faceSize - 2;
+        }
+        corner += faceSize;
+      }
+      blockIsValid[block] = isValid;
+      blockPositionsChanged[block] |= positionsChanged;
+      blockNormalsChanged[block] |= normalsChanged;
+    });
+  }
+
+  if (std::find(blockIsValid.begin(), blockIsValid.end(), 0) != blockIsValid.end()) {
+    printf("Error: corner points out of range, cannot display mesh\n");
+    clear();
+    return kOfxStatErrBadIndex;
+  }
+
+  if (triangulate) {
+    m_topology = topology;
+  } else {
+    auto any = [](const std::vector<char>& flags) { return std::find(flags.begin(), flags.end(), 1) != flags.end(); };
+    m_changes = (any(blockPositionsChanged) ? PositionsChanged : 0) | (any(blockNormalsChanged) ? NormalsChanged : 0);
+  }
+  return kOfxStatOK;
+}
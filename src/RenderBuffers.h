@@ -0,0 +1,98 @@
+#ifndef _RenderBuffers_h_
+#define _RenderBuffers_h_
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+
+/**
+ * Indexed triangle list built from any mesh, for display.
+ *
+ * Faces of any size are triangulated by ear clipping, in the plane that
+ * best fits them, so that concave polygons are displayed correctly.
+ *
+ * If the mesh has a float3 "normal" attribute attached to points, there is
+ * one vertex per point and triangles index points directly. Otherwise there
+ * is one vertex per corner, with normals taken from a "normal" attribute of
+ * the corners, faces or mesh if any, or flat face normals otherwise.
+ *
+ * Buffers are kept from one update to the next and only grow, so that
+ * displaying successive cooks does not reallocate them. Pointers returned
+ * by the accessors are valid until the next update.
+ *
+ * When the topology did not change since the previous update (same element
+ * counts, same normal layout and same hash of the corner points and face
+ * sizes), the triangulation is kept and only vertices are refreshed. This
+ * is the case of deformers, for which the triangulation of concave faces is
+ * then that of the first cook. changes() tells which buffers were actually
+ * modified, so that the viewer uploads only those.
+ */
+class RenderBuffers {
+public:
+  // Flags returned by changes()
+  enum Change {
+    PositionsChanged = 1 << 0,
+    NormalsChanged = 1 << 1,
+    IndicesChanged = 1 << 2, // also covers triangleFaces() and vertexCount()
+  };
+
+public:
+  OfxStatus update(const OfxMeshStruct *mesh);
+  // Defined along with the JavaScript bindings
+  OfxStatus update(const Mesh *mesh);
+
+  int vertexCount() const { return m_vertexCount; }
+  int triangleCount() const { return m_triangleCount; }
+
+  // Combination of Change flags describing the last update
+  int changes() const { return m_changes; }
+
+  // 3 floats per vertex
+  const float* positions() const { return m_positions.data(); }
+  // 3 floats per vertex
+  const float* normals() const { return m_normals.data(); }
+  // 3 vertex indices per triangle
+  const uint32_t* indices() const { return m_indices.data(); }
+  // Index of the original face of each triangle
+  const int* triangleFaces() const { return m_triangleFaces.data(); }
+
+private:
+  /**
+   * What the triangulation depends on. The triangulation is reused when
+   * this is equal to the topology of the previous update.
+   */
+  struct Topology {
+    int pointCount = -1;
+    int cornerCount = -1;
+    int faceCount = -1;
+    int constantFaceSize = -1;
+    int normalLayout = -1;
+    uint64_t hash = 0;
+
+    bool operator==(const Topology& other) const;
+  };
+
+  void clear();
+
+private:
+  Topology m_topology;
+  int m_changes = 0;
+  int m_vertexCount = 0;
+  int m_triangleCount = 0;
+  std::vector<float> m_positions;
+  std::vector<float> m_normals;
+  std::vector<uint32_t> m_indices;
+  std::vector<int> m_triangleFaces;
+  // Offsets of each block of faces in the corner and triangle lists
+  std::vector<int> m_blockCornerOffsets;
+  std::vector<int> m_blockTriangleOffsets;
+};
+
+#endif // _RenderBuffers_h_
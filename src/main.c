@@ -126,8 +126,8 @@ int test(test_return_t* ret) {
   MFX_CHECK(plugin->mainEntry(kOfxActionDescribe, &descriptor, NULL, NULL));
 
   printf("Parameters:\n");
-  for (int i = 0 ; descriptor.parameters.entries[i].is_valid ; ++i) {
-    const OfxParamHandle param = &descriptor.parameters.entries[i];
+  for (int i = 0 ; i < descriptor.parameters.count ; ++i) {
+    const OfxParamHandle param = descriptor.parameters.entries[i];
     printf(" - %s (%s)\n", param->name, param->type);
   }
   printf("Inputs:\n");
@@ -137,7 +137,8 @@ int test(test_return_t* ret) {
   }
 
   OfxMeshEffectStruct instance;
-  meshEffectCopy(&instance, &descriptor);
+  meshEffectInit(&instance);
+  MFX_CHECK(meshEffectCopy(&instance, &descriptor));
   printf("(CreateInstance)\n");
   MFX_CHECK(plugin->mainEntry(kOfxActionCreateInstance, &instance, NULL, NULL));
 
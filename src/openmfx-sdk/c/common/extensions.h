@@ -0,0 +1,95 @@
+#ifndef __MFX_SDK_COMMON_EXTENSIONS__
+#define __MFX_SDK_COMMON_EXTENSIONS__
+
+/**
+ * WebMfx specific extensions to the OpenMfx API. Plugins must not rely on
+ * them being available and fall back to the standard API otherwise, which
+ * the helpers of the plugin SDK do.
+ */
+
+#include <ofxCore.h>
+#include <ofxMeshEffect.h>
+
+#include <stddef.h>
+
+/**
+ * Mesh property gathering the point count, corner count, face count and
+ * constant face size (in this order), so that they can be read or written
+ * with a single call to propGetIntN/propSetIntN.
+ *  - Type - int X 4
+ *  - Property Set - a mesh instance (read/write)
+ */
+#define kMfxMeshPropCounts "WebMfxMeshPropCounts"
+
+/*****************************************************************************/
+/* Mesh View Suite */
+
+/**
+ * Name of the suite returning at once all the properties of a mesh that a
+ * cook typically needs, namely its element counts and the layout of its
+ * attributes.
+ */
+#define kMfxMeshViewSuite "WebMfxMeshViewSuite"
+
+/**
+ * Maximum number of attributes listed in a MfxMeshView
+ */
+#define kMfxMeshViewMaxAttributes 32
+
+typedef enum MfxAttachment {
+  MFX_ATTACHMENT_POINT,
+  MFX_ATTACHMENT_CORNER,
+  MFX_ATTACHMENT_FACE,
+  MFX_ATTACHMENT_MESH,
+} MfxAttachment;
+
+typedef enum MfxAttributeType {
+  MFX_ATTRIBUTE_TYPE_UNKNOWN,
+  MFX_ATTRIBUTE_TYPE_UBYTE,
+  MFX_ATTRIBUTE_TYPE_INT,
+  MFX_ATTRIBUTE_TYPE_FLOAT,
+} MfxAttributeType;
+
+/**
+ * Plain description of an attribute, with its attachment and type already
+ * resolved from their string identifiers. Strings point to host memory and
+ * remain valid as long as the mesh is.
+ */
+typedef struct MfxAttributeDescriptor {
+  MfxAttachment attachment;
+  const char *name;
+  MfxAttributeType type;
+  int component_count;
+  void *data;
+  size_t byte_stride;
+  const char *semantic;
+  int is_owner;
+} MfxAttributeDescriptor;
+
+typedef struct MfxMeshView {
+  int point_count;
+  int corner_count;
+  int face_count;
+  int constant_face_size;
+  int attribute_count;
+  /**
+   * When the face size is constant, the face size attribute points to the
+   * constant_face_size field of this structure with a stride of 0, so that it
+   * can be read like any other attribute.
+   */
+  MfxAttributeDescriptor attributes[kMfxMeshViewMaxAttributes];
+} MfxMeshView;
+
+typedef struct MfxMeshViewSuiteV1 {
+  /**
+   * Fill view with the counts and attributes of the mesh
+   * @param mesh mesh handle returned by inputGetMesh
+   * @param view plugin owned structure to fill
+   * @return kOfxStatOK, kOfxStatErrBadHandle if mesh is invalid,
+   * kOfxStatErrUnsupported if it has more than kMfxMeshViewMaxAttributes
+   * attributes
+   */
+  OfxStatus (*meshGetView)(OfxMeshHandle mesh, MfxMeshView *view);
+} MfxMeshViewSuiteV1;
+
+#endif // __MFX_SDK_COMMON_EXTENSIONS__
@@ -3,6 +3,7 @@
 #include "meshEffectSuite.h"
 #include "propertySuite.h"
 #include "parameterSuite.h"
+#include "meshViewSuite.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -27,5 +28,11 @@ const void* fetchSuite(OfxPropertySetHandle host, const char *suiteName, int sui
         return (void*)&parameterSuiteV1;
     }
   }
+  if (0 == strcmp(suiteName, kMfxMeshViewSuite)) {
+    switch (suiteVersion) {
+      case 1:
+        return (void*)&meshViewSuiteV1;
+    }
+  }
   return NULL;
 }
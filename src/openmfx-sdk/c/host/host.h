@@ -4,6 +4,16 @@
 /*****************************************************************************/
 /* Master Host */
 
+/*
+ * Suite functions keep no global state and only access the handles they are
+ * given, so distinct effect instances may be cooked concurrently. A mesh may
+ * be fed to several of them at once since inputs are only read. Instances
+ * share the read-only name index of their descriptor's parameters, with an
+ * atomic reference count, so they may also be copied and destroyed
+ * concurrently, but parameters must not be defined on an instance while it
+ * is being cooked.
+ */
+
 #include <ofxCore.h>
 
 const void* fetchSuite(OfxPropertySetHandle host, const char *suiteName, int suiteVersion);
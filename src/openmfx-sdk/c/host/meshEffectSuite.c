@@ -82,17 +82,22 @@ OfxStatus inputGetMesh(OfxMeshInputHandle input,
   if (input->is_valid != 1) {
     return kOfxStatErrBadHandle;
   }
-  if (time != 0.0) {
-    return kOfxStatErrMissingHostFeature;
-  }
 
   if (0 == strncmp(input->name, kOfxMeshMainOutput, 256)) {
     MFX_ENSURE(defaultAttributesDefine(&input->mesh));
   }
 
-  *meshHandle = &input->mesh;
+  // Inputs that have no time samples are static. The output is the one
+  // being cooked, whatever the time. Input meshes are read only, so handing
+  // out the borrowed samples is fine.
+  OfxMeshHandle mesh = (OfxMeshHandle)meshInputMeshAtTime(input, time);
+  if (NULL == mesh) {
+    return kOfxStatErrBadHandle;
+  }
+
+  *meshHandle = mesh;
   if (NULL != propertySet) {
-    *propertySet = (OfxPropertySetHandle)&input->mesh.properties;
+    *propertySet = (OfxPropertySetHandle)&mesh->properties;
   }
 
   return kOfxStatOK;
@@ -162,7 +167,11 @@ OfxStatus attributeDefine(OfxMeshHandle meshHandle,
   strncpy(attribute->name, name, 64);
   attribute->component_count = componentCount;
   strncpy(attribute->type, type, 64);
-  strncpy(attribute->semantic, semantic, 64);
+  if (NULL != semantic) {
+    strncpy(attribute->semantic, semantic, 64);
+  } else {
+    attribute->semantic[0] = '\0';
+  }
 
   *attributeHandle = (OfxPropertySetHandle)attribute;
   return kOfxStatOK;
@@ -0,0 +1,67 @@
+#include "meshViewSuite.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static MfxAttachment attachmentFromString(const char *attachment) {
+  if (0 == strcmp(attachment, kOfxMeshAttribPoint)) return MFX_ATTACHMENT_POINT;
+  if (0 == strcmp(attachment, kOfxMeshAttribCorner)) return MFX_ATTACHMENT_CORNER;
+  if (0 == strcmp(attachment, kOfxMeshAttribFace)) return MFX_ATTACHMENT_FACE;
+  return MFX_ATTACHMENT_MESH;
+}
+
+static MfxAttributeType attributeTypeFromString(const char *type) {
+  if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) return MFX_ATTRIBUTE_TYPE_FLOAT;
+  if (0 == strcmp(type, kOfxMeshAttribTypeInt)) return MFX_ATTRIBUTE_TYPE_INT;
+  if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) return MFX_ATTRIBUTE_TYPE_UBYTE;
+  return MFX_ATTRIBUTE_TYPE_UNKNOWN;
+}
+
+OfxStatus meshGetView(OfxMeshHandle mesh, MfxMeshView *view)
+{
+  if (NULL == mesh || NULL == view) {
+    return kOfxStatErrBadHandle;
+  }
+
+  const OfxMeshPropertySet *props = &mesh->properties;
+  view->point_count = props->point_count;
+  view->corner_count = props->corner_count;
+  view->face_count = props->face_count;
+  view->constant_face_size = props->constant_face_size;
+
+  // Valid attributes are packed at the beginning of the mesh's array
+  const int max_mesh_attributes = (int)(sizeof mesh->attributes / sizeof *mesh->attributes);
+  int count = 0;
+  for (; count < max_mesh_attributes && mesh->attributes[count].is_valid ; ++count) {
+    if (count == kMfxMeshViewMaxAttributes) {
+      printf("Error: mesh has more than the %d attributes a view can list\n", kMfxMeshViewMaxAttributes);
+      return kOfxStatErrUnsupported;
+    }
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[count];
+    MfxAttributeDescriptor *desc = &view->attributes[count];
+    desc->attachment = attachmentFromString(attrib->attachment);
+    desc->name = attrib->name;
+    desc->type = attributeTypeFromString(attrib->type);
+    desc->component_count = attrib->component_count;
+    desc->data = attrib->data;
+    desc->byte_stride = attrib->byte_stride;
+    desc->semantic = attrib->semantic;
+    desc->is_owner = attrib->is_owner;
+
+    if (props->constant_face_size > -1
+      && desc->attachment == MFX_ATTACHMENT_FACE
+      && 0 == strcmp(attrib->name, kOfxMeshAttribFaceSize))
+    {
+      desc->data = &view->constant_face_size;
+      desc->byte_stride = 0;
+    }
+  }
+  view->attribute_count = count;
+
+  return kOfxStatOK;
+}
+
+const MfxMeshViewSuiteV1 meshViewSuiteV1 = {
+  meshGetView, // OfxStatus (*meshGetView)(OfxMeshHandle mesh, MfxMeshView *view);
+};
@@ -0,0 +1,16 @@
+#ifndef _meshViewSuite_h_
+#define _meshViewSuite_h_
+
+/*****************************************************************************/
+/* Mesh View Suite (WebMfx extension) */
+
+#include "../common/extensions.h"
+
+#include <ofxCore.h>
+#include <ofxMeshEffect.h>
+
+OfxStatus meshGetView(OfxMeshHandle mesh, MfxMeshView *view);
+
+extern const MfxMeshViewSuiteV1 meshViewSuiteV1;
+
+#endif // _meshViewSuite_h_
@@ -11,14 +11,15 @@ OfxStatus paramDefine(OfxParamSetHandle paramSet,
                       OfxPropertySetHandle *propertySet)
 {
   printf("[host] paramDefine(paramSet %p, %s, %s)\n", paramSet, paramType, name);
-  int param_index = 0;
-  while (paramSet->entries[param_index].is_valid) ++param_index;
-  if (param_index == 16) return kOfxStatErrMemory;
-  OfxParamHandle param = &paramSet->entries[param_index];
+  OfxParamKind kind = paramKindFromType(paramType);
+  if (kind == PARAM_UNKNOWN) return kOfxStatErrUnknown;
+
+  OfxParamHandle param;
+  OfxStatus status = parameterSetAppend(paramSet, name, &param);
+  if (kOfxStatOK != status) return status;
 
-  paramInit(param);
   strncpy(param->type, paramType, 64);
-  strncpy(param->name, name, 64);
+  param->kind = kind;
 
   if (NULL != propertySet) {
     *propertySet = (OfxPropertySetHandle)&param->properties;
@@ -33,76 +34,181 @@ OfxStatus paramGetHandle(OfxParamSetHandle paramSet,
                          OfxPropertySetHandle *propertySet)
 {
   printf("[host] paramGetHandle(paramSet %p, %s)\n", paramSet, name);
-  for (int i = 0 ; i < 16 && paramSet->entries[i].is_valid ; ++i) {
-    OfxParamHandle param = &paramSet->entries[i];
-    if (0 == strncmp(name, param->name, 64)) {
-      *paramHandle = param;
-      if (NULL != propertySet) {
-        *propertySet = (OfxPropertySetHandle)&param->properties;
-      }
-      return kOfxStatOK;
-    }
+  int param_index = parameterSetFind(paramSet, name);
+  if (-1 == param_index) return kOfxStatErrBadHandle;
+  OfxParamHandle param = paramSet->entries[param_index];
+  *paramHandle = param;
+  if (NULL != propertySet) {
+    *propertySet = (OfxPropertySetHandle)&param->properties;
   }
-  return kOfxStatErrBadHandle;
+  return kOfxStatOK;
 }
 
-OfxStatus paramGetValue(OfxParamHandle paramHandle, ...) {
-  va_list argp;
-  va_start(argp, paramHandle);
-
-  if (0 == strncmp(paramHandle->type, kOfxParamTypeInteger, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeDouble, 64)) {
-    double *value = va_arg(argp, double*);
-    *value = paramHandle->values[0].as_double;
+/**
+ * Write the components of values to the pointers of the variadic
+ * arguments of paramGetValue() and paramGetValueAtTime().
+ */
+static OfxStatus paramReadValues(OfxParamHandle paramHandle, const OfxParamValueStruct *values, va_list argp) {
+  switch (paramHandle->kind) {
+  case PARAM_INTEGER:
+  case PARAM_BOOLEAN:
+  case PARAM_CHOICE:
+  case PARAM_INTEGER2D:
+  case PARAM_INTEGER3D:
+    for (int i = 0 ; i < paramKindComponentCount(paramHandle->kind) ; ++i) {
+      *va_arg(argp, int*) = values[i].as_int;
+    }
     return kOfxStatOK;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeBoolean, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeChoice, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeRGBA, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeRGB, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeDouble2D, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeInteger2D, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeDouble3D, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeInteger3D, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeString, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeCustom, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypeGroup, 64)) {
-    return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypePage, 64)) {
+  case PARAM_DOUBLE:
+  case PARAM_DOUBLE2D:
+  case PARAM_DOUBLE3D:
+  case PARAM_RGB:
+  case PARAM_RGBA:
+    for (int i = 0 ; i < paramKindComponentCount(paramHandle->kind) ; ++i) {
+      *va_arg(argp, double*) = values[i].as_double;
+    }
+    return kOfxStatOK;
+  case PARAM_STRING:
+  case PARAM_CUSTOM:
+  case PARAM_GROUP:
+  case PARAM_PAGE:
+  case PARAM_PUSHBUTTON:
     return kOfxStatErrUnsupported;
-  } else if (0 == strncmp(paramHandle->type, kOfxParamTypePushButton, 64)) {
+  default:
+    return kOfxStatErrBadHandle;
+  }
+}
+
+/**
+ * Read the components of values from the variadic arguments of
+ * paramSetValue() and paramSetValueAtTime().
+ */
+static OfxStatus paramWriteValues(OfxParamHandle paramHandle, OfxParamValueStruct *values, va_list argp) {
+  switch (paramHandle->kind) {
+  case PARAM_BOOLEAN:
+    values[0].as_bool = va_arg(argp, int) != 0;
+    return kOfxStatOK;
+  case PARAM_INTEGER:
+  case PARAM_CHOICE:
+  case PARAM_INTEGER2D:
+  case PARAM_INTEGER3D:
+    for (int i = 0 ; i < paramKindComponentCount(paramHandle->kind) ; ++i) {
+      values[i].as_int = va_arg(argp, int);
+    }
+    return kOfxStatOK;
+  case PARAM_DOUBLE:
+  case PARAM_DOUBLE2D:
+  case PARAM_DOUBLE3D:
+  case PARAM_RGB:
+  case PARAM_RGBA:
+    for (int i = 0 ; i < paramKindComponentCount(paramHandle->kind) ; ++i) {
+      values[i].as_double = va_arg(argp, double);
+    }
+    return kOfxStatOK;
+  case PARAM_STRING:
+  case PARAM_CUSTOM:
+  case PARAM_GROUP:
+  case PARAM_PAGE:
+  case PARAM_PUSHBUTTON:
     return kOfxStatErrUnsupported;
-  } else {
+  default:
     return kOfxStatErrBadHandle;
   }
 }
 
+OfxStatus paramGetValue(OfxParamHandle paramHandle, ...) {
+  va_list argp;
+  va_start(argp, paramHandle);
+  OfxStatus status = paramReadValues(paramHandle, paramHandle->values, argp);
+  va_end(argp);
+  return status;
+}
+
+OfxStatus paramGetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...) {
+  if (NULL == paramHandle || !paramHandle->is_valid) return kOfxStatErrBadHandle;
+  OfxParamValueStruct values[4];
+  paramEvaluateCached(paramHandle, time, values);
+
+  va_list argp;
+  va_start(argp, time);
+  OfxStatus status = paramReadValues(paramHandle, values, argp);
+  va_end(argp);
+  return status;
+}
+
+OfxStatus paramSetValue(OfxParamHandle paramHandle, ...) {
+  va_list argp;
+  va_start(argp, paramHandle);
+  OfxStatus status = paramWriteValues(paramHandle, paramHandle->values, argp);
+  va_end(argp);
+  return status;
+}
+
+OfxStatus paramSetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...) {
+  printf("[host] paramSetValueAtTime(param %p, %f)\n", paramHandle, time);
+  OfxParamValueStruct values[4];
+  memset(values, 0, sizeof(values));
+
+  va_list argp;
+  va_start(argp, time);
+  OfxStatus status = paramWriteValues(paramHandle, values, argp);
+  va_end(argp);
+
+  if (kOfxStatOK != status) return status;
+  return paramInsertKey(paramHandle, time, values, PARAM_INTERPOLATION_LINEAR);
+}
+
+OfxStatus paramGetNumKeys(OfxParamHandle paramHandle, unsigned int *numberOfKeys) {
+  if (NULL == paramHandle || !paramHandle->is_valid) return kOfxStatErrBadHandle;
+  *numberOfKeys = (unsigned int)paramHandle->key_count;
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetKeyTime(OfxParamHandle paramHandle, unsigned int nthKey, OfxTime *time) {
+  if (NULL == paramHandle || !paramHandle->is_valid) return kOfxStatErrBadHandle;
+  if (nthKey >= (unsigned int)paramHandle->key_count) return kOfxStatErrBadIndex;
+  *time = paramHandle->keys[nthKey].time;
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetKeyIndex(OfxParamHandle paramHandle, OfxTime time, int direction, int *index) {
+  if (NULL == paramHandle || !paramHandle->is_valid) return kOfxStatErrBadHandle;
+  *index = paramFindKey(paramHandle, time, direction);
+  return -1 != *index ? kOfxStatOK : kOfxStatFailed;
+}
+
+OfxStatus paramDeleteKey(OfxParamHandle paramHandle, OfxTime time) {
+  printf("[host] paramDeleteKey(param %p, %f)\n", paramHandle, time);
+  if (NULL == paramHandle || !paramHandle->is_valid) return kOfxStatErrBadHandle;
+  int index = paramFindKey(paramHandle, time, 0);
+  if (-1 == index) return kOfxStatErrBadIndex;
+  paramRemoveKey(paramHandle, index);
+  return kOfxStatOK;
+}
+
+OfxStatus paramDeleteAllKeys(OfxParamHandle paramHandle) {
+  printf("[host] paramDeleteAllKeys(param %p)\n", paramHandle);
+  if (NULL == paramHandle || !paramHandle->is_valid) return kOfxStatErrBadHandle;
+  paramClearKeys(paramHandle);
+  return kOfxStatOK;
+}
+
 const OfxParameterSuiteV1 parameterSuiteV1 = {
   paramDefine, // OfxStatus (*paramDefine)(OfxParamSetHandle paramSet, const char *paramType, const char *name, OfxPropertySetHandle *propertySet);
   paramGetHandle, // OfxStatus (*paramGetHandle)(OfxParamSetHandle paramSet, const char *name, OfxParamHandle *param, OfxPropertySetHandle *propertySet);
   NULL, // OfxStatus (*paramSetGetPropertySet)(OfxParamSetHandle paramSet, OfxPropertySetHandle *propHandle);
   NULL, // OfxStatus (*paramGetPropertySet)(OfxParamHandle param, OfxPropertySetHandle *propHandle);
   paramGetValue, // OfxStatus (*paramGetValue)(OfxParamHandle paramHandle, ...);
-  NULL, // OfxStatus (*paramGetValueAtTime)(OfxParamHandle paramHandle, OfxTime time, ...);
+  paramGetValueAtTime, // OfxStatus (*paramGetValueAtTime)(OfxParamHandle paramHandle, OfxTime time, ...);
   NULL, // OfxStatus (*paramGetDerivative)(OfxParamHandle paramHandle, OfxTime time, ...);
   NULL, // OfxStatus (*paramGetIntegral)(OfxParamHandle paramHandle, OfxTime time1, OfxTime time2, ...);
-  NULL, // OfxStatus (*paramSetValue)(OfxParamHandle paramHandle, ...);
-  NULL, // OfxStatus (*paramSetValueAtTime)(OfxParamHandle paramHandle, OfxTime time, ...);
-  NULL, // OfxStatus (*paramGetNumKeys)(OfxParamHandle paramHandle, unsigned int  *numberOfKeys);
-  NULL, // OfxStatus (*paramGetKeyTime)(OfxParamHandle paramHandle, unsigned int nthKey, OfxTime *time);
-  NULL, // OfxStatus (*paramGetKeyIndex)(OfxParamHandle paramHandle, OfxTime time, int direction, int *index);
-  NULL, // OfxStatus (*paramDeleteKey)(OfxParamHandle paramHandle, OfxTime time);
-  NULL, // OfxStatus (*paramDeleteAllKeys)(OfxParamHandle paramHandle);
+  paramSetValue, // OfxStatus (*paramSetValue)(OfxParamHandle paramHandle, ...);
+  paramSetValueAtTime, // OfxStatus (*paramSetValueAtTime)(OfxParamHandle paramHandle, OfxTime time, ...);
+  paramGetNumKeys, // OfxStatus (*paramGetNumKeys)(OfxParamHandle paramHandle, unsigned int  *numberOfKeys);
+  paramGetKeyTime, // OfxStatus (*paramGetKeyTime)(OfxParamHandle paramHandle, unsigned int nthKey, OfxTime *time);
+  paramGetKeyIndex, // OfxStatus (*paramGetKeyIndex)(OfxParamHandle paramHandle, OfxTime time, int direction, int *index);
+  paramDeleteKey, // OfxStatus (*paramDeleteKey)(OfxParamHandle paramHandle, OfxTime time);
+  paramDeleteAllKeys, // OfxStatus (*paramDeleteAllKeys)(OfxParamHandle paramHandle);
   NULL, // OfxStatus (*paramCopy)(OfxParamHandle paramTo, OfxParamHandle  paramFrom, OfxTime dstOffset, const OfxRangeD *frameRange);
   NULL, // OfxStatus (*paramEditBegin)(OfxParamSetHandle paramSet, const char *name); 
   NULL, // OfxStatus (*paramEditEnd)(OfxParamSetHandle paramSet);
@@ -19,6 +19,22 @@ OfxStatus paramGetHandle(OfxParamSetHandle paramSet,
 
 OfxStatus paramGetValue(OfxParamHandle paramHandle, ...);
 
+OfxStatus paramGetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...);
+
+OfxStatus paramSetValue(OfxParamHandle paramHandle, ...);
+
+OfxStatus paramSetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...);
+
+OfxStatus paramGetNumKeys(OfxParamHandle paramHandle, unsigned int *numberOfKeys);
+
+OfxStatus paramGetKeyTime(OfxParamHandle paramHandle, unsigned int nthKey, OfxTime *time);
+
+OfxStatus paramGetKeyIndex(OfxParamHandle paramHandle, OfxTime time, int direction, int *index);
+
+OfxStatus paramDeleteKey(OfxParamHandle paramHandle, OfxTime time);
+
+OfxStatus paramDeleteAllKeys(OfxParamHandle paramHandle);
+
 extern const OfxParameterSuiteV1 parameterSuiteV1;
 
 #endif // _parameterSuite_h_
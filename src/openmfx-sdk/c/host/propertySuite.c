@@ -1,10 +1,73 @@
 #include "propertySuite.h"
 #include "types.h"
 #include "../common/common.h"
+#include "../common/extensions.h"
 
 #include <stdio.h>
 #include <string.h>
 
+/**
+ * Number of values held by a property, or 0 if the property set does not
+ * have such a property.
+ */
+static int propertyDimension(OfxPropertySetHandle properties, const char *property) {
+  switch (properties->type) {
+    case PROPSET_INPUT:
+      if (0 == strcmp(property, kOfxPropLabel)) return 1;
+      return 0;
+    case PROPSET_MESH:
+      if (0 == strcmp(property, kOfxMeshPropPointCount)) return 1;
+      if (0 == strcmp(property, kOfxMeshPropCornerCount)) return 1;
+      if (0 == strcmp(property, kOfxMeshPropFaceCount)) return 1;
+      if (0 == strcmp(property, kOfxMeshPropConstantFaceSize)) return 1;
+      if (0 == strcmp(property, kOfxMeshPropTransformMatrix)) return 16;
+      if (0 == strcmp(property, kMfxMeshPropCounts)) return 4;
+      return 0;
+    case PROPSET_ATTRIBUTE:
+      if (0 == strcmp(property, kOfxMeshAttribPropData)) return 1;
+      if (0 == strcmp(property, kOfxMeshAttribPropIsOwner)) return 1;
+      if (0 == strcmp(property, kOfxMeshAttribPropStride)) return 1;
+      if (0 == strcmp(property, kOfxMeshAttribPropComponentCount)) return 1;
+      if (0 == strcmp(property, kOfxMeshAttribPropType)) return 1;
+      if (0 == strcmp(property, kOfxMeshAttribPropSemantic)) return 1;
+      return 0;
+    case PROPSET_COOK_ARGS:
+      if (0 == strcmp(property, kOfxPropTime)) return 1;
+      return 0;
+    case PROPSET_UNKNOWN:
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Check that count values can be read from/written to the property
+ */
+static OfxStatus checkPropertyCount(OfxPropertySetHandle properties, const char *property, int count) {
+  int dimension = propertyDimension(properties, property);
+  if (0 == dimension) {
+    return kOfxStatErrBadHandle;
+  }
+  if (count < 0 || count > dimension) {
+    return kOfxStatErrBadIndex;
+  }
+  return kOfxStatOK;
+}
+
+/**
+ * Field of the mesh properties matching the index-th entry of the
+ * kMfxMeshPropCounts property, or NULL if index is out of range.
+ */
+static int *meshPropCount(OfxMeshPropertySet *mesh_props, int index) {
+  switch (index) {
+    case 0: return &mesh_props->point_count;
+    case 1: return &mesh_props->corner_count;
+    case 2: return &mesh_props->face_count;
+    case 3: return &mesh_props->constant_face_size;
+    default: return NULL;
+  }
+}
+
 OfxStatus propSetPointer(OfxPropertySetHandle properties,
                          const char *property,
                          int index,
@@ -194,6 +257,14 @@ OfxStatus propSetInt(OfxPropertySetHandle properties,
         mesh_props->constant_face_size = value;
         return kOfxStatOK;
       }
+      else if (0 == strcmp(property, kMfxMeshPropCounts)) {
+        int *count = meshPropCount(mesh_props, index);
+        if (NULL == count) {
+          return kOfxStatErrBadIndex;
+        }
+        *count = value;
+        return kOfxStatOK;
+      }
       return kOfxStatErrBadHandle;
     }
     case PROPSET_ATTRIBUTE:
@@ -269,6 +340,14 @@ OfxStatus propGetInt(OfxPropertySetHandle properties,
         *value = mesh_props->constant_face_size;
         return kOfxStatOK;
       }
+      else if (0 == strcmp(property, kMfxMeshPropCounts)) {
+        int *count = meshPropCount(mesh_props, index);
+        if (NULL == count) {
+          return kOfxStatErrBadIndex;
+        }
+        *value = *count;
+        return kOfxStatOK;
+      }
       return kOfxStatErrBadHandle;
     }
     case PROPSET_ATTRIBUTE:
@@ -305,23 +384,248 @@ OfxStatus propGetInt(OfxPropertySetHandle properties,
   return kOfxStatOK;
 }
 
+OfxStatus propSetDouble(OfxPropertySetHandle properties,
+                        const char *property,
+                        int index,
+                        double value)
+{
+  printf("[host] propSetDouble(properties %p, %s, %d, %f)\n", properties, property, index, value);
+
+  switch (properties->type) {
+    case PROPSET_MESH:
+    {
+      OfxMeshPropertySet *mesh_props = (OfxMeshPropertySet*)properties;
+      if (0 == strcmp(property, kOfxMeshPropTransformMatrix)) {
+        if (index < 0 || index >= 16) {
+          return kOfxStatErrBadIndex;
+        }
+        mesh_props->transform_matrix[index] = value;
+        return kOfxStatOK;
+      }
+      return kOfxStatErrBadHandle;
+    }
+    case PROPSET_COOK_ARGS:
+    {
+      OfxCookArgsPropertySet *cook_args = (OfxCookArgsPropertySet*)properties;
+      if (0 == strcmp(property, kOfxPropTime)) {
+        if (index != 0) {
+          return kOfxStatErrBadIndex;
+        }
+        cook_args->time = value;
+        return kOfxStatOK;
+      }
+      return kOfxStatErrBadHandle;
+    }
+    case PROPSET_UNKNOWN:
+    default:
+      return kOfxStatErrBadHandle;
+  }
+
+  return kOfxStatOK;
+}
+
+OfxStatus propGetDouble(OfxPropertySetHandle properties,
+                        const char *property,
+                        int index,
+                        double *value)
+{
+  printf("[host] propGetDouble(properties %p, %s, %d)\n", properties, property, index);
+
+  switch (properties->type) {
+    case PROPSET_MESH:
+    {
+      OfxMeshPropertySet *mesh_props = (OfxMeshPropertySet*)properties;
+      if (0 == strcmp(property, kOfxMeshPropTransformMatrix)) {
+        if (index < 0 || index >= 16) {
+          return kOfxStatErrBadIndex;
+        }
+        *value = mesh_props->transform_matrix[index];
+        return kOfxStatOK;
+      }
+      return kOfxStatErrBadHandle;
+    }
+    case PROPSET_COOK_ARGS:
+    {
+      OfxCookArgsPropertySet *cook_args = (OfxCookArgsPropertySet*)properties;
+      if (0 == strcmp(property, kOfxPropTime)) {
+        if (index != 0) {
+          return kOfxStatErrBadIndex;
+        }
+        *value = cook_args->time;
+        return kOfxStatOK;
+      }
+      return kOfxStatErrBadHandle;
+    }
+    case PROPSET_UNKNOWN:
+    default:
+      return kOfxStatErrBadHandle;
+  }
+
+  return kOfxStatOK;
+}
+
+OfxStatus propSetPointerN(OfxPropertySetHandle properties,
+                          const char *property,
+                          int count,
+                          void *const*value)
+{
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propSetPointer(properties, property, i, value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propSetStringN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         const char *const*value)
+{
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propSetString(properties, property, i, value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propSetDoubleN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         const double *value)
+{
+  printf("[host] propSetDoubleN(properties %p, %s, %d)\n", properties, property, count);
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+
+  if (properties->type == PROPSET_MESH && 0 == strcmp(property, kOfxMeshPropTransformMatrix)) {
+    OfxMeshPropertySet *mesh_props = (OfxMeshPropertySet*)properties;
+    memcpy(mesh_props->transform_matrix, value, count * sizeof(double));
+    return kOfxStatOK;
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propSetDouble(properties, property, i, value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propSetIntN(OfxPropertySetHandle properties,
+                      const char *property,
+                      int count,
+                      const int *value)
+{
+  printf("[host] propSetIntN(properties %p, %s, %d)\n", properties, property, count);
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+
+  if (properties->type == PROPSET_MESH && 0 == strcmp(property, kMfxMeshPropCounts)) {
+    OfxMeshPropertySet *mesh_props = (OfxMeshPropertySet*)properties;
+    for (int i = 0 ; i < count ; ++i) {
+      *meshPropCount(mesh_props, i) = value[i];
+    }
+    return kOfxStatOK;
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propSetInt(properties, property, i, value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetPointerN(OfxPropertySetHandle properties,
+                          const char *property,
+                          int count,
+                          void **value)
+{
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propGetPointer(properties, property, i, &value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetStringN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         char **value)
+{
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propGetString(properties, property, i, &value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetDoubleN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         double *value)
+{
+  printf("[host] propGetDoubleN(properties %p, %s, %d)\n", properties, property, count);
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+
+  if (properties->type == PROPSET_MESH && 0 == strcmp(property, kOfxMeshPropTransformMatrix)) {
+    const OfxMeshPropertySet *mesh_props = (const OfxMeshPropertySet*)properties;
+    memcpy(value, mesh_props->transform_matrix, count * sizeof(double));
+    return kOfxStatOK;
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propGetDouble(properties, property, i, &value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetIntN(OfxPropertySetHandle properties,
+                      const char *property,
+                      int count,
+                      int *value)
+{
+  printf("[host] propGetIntN(properties %p, %s, %d)\n", properties, property, count);
+  MFX_ENSURE(checkPropertyCount(properties, property, count));
+
+  if (properties->type == PROPSET_MESH && 0 == strcmp(property, kMfxMeshPropCounts)) {
+    OfxMeshPropertySet *mesh_props = (OfxMeshPropertySet*)properties;
+    for (int i = 0 ; i < count ; ++i) {
+      value[i] = *meshPropCount(mesh_props, i);
+    }
+    return kOfxStatOK;
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    MFX_ENSURE(propGetInt(properties, property, i, &value[i]));
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetDimension(OfxPropertySetHandle properties,
+                           const char *property,
+                           int *count)
+{
+  printf("[host] propGetDimension(properties %p, %s)\n", properties, property);
+  int dimension = propertyDimension(properties, property);
+  if (0 == dimension) {
+    return kOfxStatErrBadHandle;
+  }
+  *count = dimension;
+  return kOfxStatOK;
+}
+
 const OfxPropertySuiteV1 propertySuiteV1 = {
   propSetPointer, // OfxStatus (*propSetPointer)(OfxPropertySetHandle properties, const char *property, int index, void *value);
   propSetString, // OfxStatus (*propSetString) (OfxPropertySetHandle properties, const char *property, int index, const char *value);
-  NULL, // OfxStatus (*propSetDouble) (OfxPropertySetHandle properties, const char *property, int index, double value);
+  propSetDouble, // OfxStatus (*propSetDouble) (OfxPropertySetHandle properties, const char *property, int index, double value);
   propSetInt, // OfxStatus (*propSetInt)    (OfxPropertySetHandle properties, const char *property, int index, int value);
-  NULL, // OfxStatus (*propSetPointerN)(OfxPropertySetHandle properties, const char *property, int count, void *const*value);
-  NULL, // OfxStatus (*propSetStringN) (OfxPropertySetHandle properties, const char *property, int count, const char *const*value);
-  NULL, // OfxStatus (*propSetDoubleN) (OfxPropertySetHandle properties, const char *property, int count, const double *value);
-  NULL, // OfxStatus (*propSetIntN)    (OfxPropertySetHandle properties, const char *property, int count, const int *value);
+  propSetPointerN, // OfxStatus (*propSetPointerN)(OfxPropertySetHandle properties, const char *property, int count, void *const*value);
+  propSetStringN, // OfxStatus (*propSetStringN) (OfxPropertySetHandle properties, const char *property, int count, const char *const*value);
+  propSetDoubleN, // OfxStatus (*propSetDoubleN) (OfxPropertySetHandle properties, const char *property, int count, const double *value);
+  propSetIntN, // OfxStatus (*propSetIntN)    (OfxPropertySetHandle properties, const char *property, int count, const int *value);
   propGetPointer, // OfxStatus (*propGetPointer)(OfxPropertySetHandle properties, const char *property, int index, void **value);
   propGetString, // OfxStatus (*propGetString) (OfxPropertySetHandle properties, const char *property, int index, char **value);
-  NULL, // OfxStatus (*propGetDouble) (OfxPropertySetHandle properties, const char *property, int index, double *value);
+  propGetDouble, // OfxStatus (*propGetDouble) (OfxPropertySetHandle properties, const char *property, int index, double *value);
   propGetInt, // OfxStatus (*propGetInt)    (OfxPropertySetHandle properties, const char *property, int index, int *value);
-  NULL, // OfxStatus (*propGetPointerN)(OfxPropertySetHandle properties, const char *property, int count, void **value);
-  NULL, // OfxStatus (*propGetStringN) (OfxPropertySetHandle properties, const char *property, int count, char **value);
-  NULL, // OfxStatus (*propGetDoubleN) (OfxPropertySetHandle properties, const char *property, int count, double *value);
-  NULL, // OfxStatus (*propGetIntN)    (OfxPropertySetHandle properties, const char *property, int count, int *value);
+  propGetPointerN, // OfxStatus (*propGetPointerN)(OfxPropertySetHandle properties, const char *property, int count, void **value);
+  propGetStringN, // OfxStatus (*propGetStringN) (OfxPropertySetHandle properties, const char *property, int count, char **value);
+  propGetDoubleN, // OfxStatus (*propGetDoubleN) (OfxPropertySetHandle properties, const char *property, int count, double *value);
+  propGetIntN, // OfxStatus (*propGetIntN)    (OfxPropertySetHandle properties, const char *property, int count, int *value);
   NULL, // OfxStatus (*propReset)    (OfxPropertySetHandle properties, const char *property);
-  NULL, // OfxStatus (*propGetDimension)  (OfxPropertySetHandle properties, const char *property, int *count);
+  propGetDimension, // OfxStatus (*propGetDimension)  (OfxPropertySetHandle properties, const char *property, int *count);
 };
@@ -37,6 +37,60 @@ OfxStatus propGetInt(OfxPropertySetHandle properties,
                      int index,
                      int *value);
 
+OfxStatus propSetDouble(OfxPropertySetHandle properties,
+                        const char *property,
+                        int index,
+                        double value);
+
+OfxStatus propGetDouble(OfxPropertySetHandle properties,
+                        const char *property,
+                        int index,
+                        double *value);
+
+OfxStatus propSetPointerN(OfxPropertySetHandle properties,
+                          const char *property,
+                          int count,
+                          void *const*value);
+
+OfxStatus propSetStringN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         const char *const*value);
+
+OfxStatus propSetDoubleN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         const double *value);
+
+OfxStatus propSetIntN(OfxPropertySetHandle properties,
+                      const char *property,
+                      int count,
+                      const int *value);
+
+OfxStatus propGetPointerN(OfxPropertySetHandle properties,
+                          const char *property,
+                          int count,
+                          void **value);
+
+OfxStatus propGetStringN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         char **value);
+
+OfxStatus propGetDoubleN(OfxPropertySetHandle properties,
+                         const char *property,
+                         int count,
+                         double *value);
+
+OfxStatus propGetIntN(OfxPropertySetHandle properties,
+                      const char *property,
+                      int count,
+                      int *value);
+
+OfxStatus propGetDimension(OfxPropertySetHandle properties,
+                           const char *property,
+                           int *count);
+
 extern const OfxPropertySuiteV1 propertySuiteV1;
 
 #endif // _propertySuite_h_
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
+#include <math.h>
+#include <stdatomic.h>
 
 void meshInputPropertySetCopy(OfxMeshInputPropertySet *dst, const OfxMeshInputPropertySet *src) {
   strncpy(dst->label, src->label, 256);
@@ -18,6 +20,7 @@ void meshPropertySetCopy(OfxMeshPropertySet *dst, const OfxMeshPropertySet *src)
   dst->corner_count = src->corner_count;
   dst->face_count = src->face_count;
   dst->constant_face_size = src->constant_face_size;
+  memcpy(dst->transform_matrix, src->transform_matrix, sizeof(src->transform_matrix));
 }
 
 void propertySetCopy(OfxPropertySetHandle dst, const OfxPropertySetStruct *src) {
@@ -43,6 +46,30 @@ void attributeInit(OfxMeshAttributePropertySet *attrib) {
   attrib->is_owner = 1;
 }
 
+int attributeElementCount(const OfxMeshAttributePropertySet *attrib, const OfxMeshPropertySet *props) {
+  if (0 == strcmp(attrib->attachment, kOfxMeshAttribPoint)) {
+    return props->point_count;
+  } else if (0 == strcmp(attrib->attachment, kOfxMeshAttribCorner)) {
+    return props->corner_count;
+  } else if (0 == strcmp(attrib->attachment, kOfxMeshAttribFace)) {
+    return props->face_count;
+  } else {
+    return 1;
+  }
+}
+
+size_t attributeComponentSize(const char *type) {
+  if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) {
+    return sizeof(float);
+  } else if (0 == strcmp(type, kOfxMeshAttribTypeInt)) {
+    return sizeof(int);
+  } else if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) {
+    return sizeof(unsigned char);
+  } else {
+    return 0;
+  }
+}
+
 OfxStatus attributeAlloc(OfxMeshAttributePropertySet *attrib, OfxMeshPropertySet *props)
 {
   printf("[host] attributeAlloc(%s)\n", attrib->name);
@@ -63,27 +90,9 @@ OfxStatus attributeAlloc(OfxMeshAttributePropertySet *attrib, OfxMeshPropertySet
     return kOfxStatErrExists;
   }
 
-  int element_count;
-  if (0 == strcmp(attrib->attachment, kOfxMeshAttribPoint)) {
-    element_count = props->point_count;
-  } else if (0 == strcmp(attrib->attachment, kOfxMeshAttribCorner)) {
-    element_count = props->corner_count;
-  } else if (0 == strcmp(attrib->attachment, kOfxMeshAttribFace)) {
-    element_count = props->face_count;
-  } else {
-    element_count = 1;
-  }
-
-  size_t component_size = 0;
-  if (0 == strcmp(attrib->type, kOfxMeshAttribTypeFloat)) {
-    component_size = sizeof(float);
-  } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeInt)) {
-    component_size = sizeof(int);
-  } else if (0 == strcmp(attrib->type, kOfxMeshAttribTypeUByte)) {
-    component_size = sizeof(unsigned char);
-  } else {
-    assert(0);
-  }
+  int element_count = attributeElementCount(attrib, props);
+  size_t component_size = attributeComponentSize(attrib->type);
+  assert(component_size > 0);
 
   attrib->byte_stride = attrib->component_count * component_size;
   attrib->data = malloc(element_count * attrib->byte_stride);
@@ -118,35 +127,441 @@ void attributeShallowCopy(OfxMeshAttributePropertySet *dst, const OfxMeshAttribu
   dst->is_owner = src->is_owner;
 }
 
-void parameterCopy(OfxParamHandle dst, const OfxParamStruct *src) {
+OfxStatus parameterCopy(OfxParamHandle dst, const OfxParamStruct *src) {
   dst->is_valid = src->is_valid;
-  if (!src->is_valid) return;
+  if (!src->is_valid) return kOfxStatOK;
   strncpy(dst->name, src->name, 64);
   strncpy(dst->type, src->type, 64);
+  dst->kind = src->kind;
   memcpy(&dst->values, &src->values, sizeof(src->values));
+  paramClearKeys(dst);
+  for (int i = 0 ; i < src->key_count ; ++i) {
+    OfxStatus status = paramInsertKey(dst, src->keys[i].time, src->keys[i].values, src->keys[i].interpolation);
+    if (kOfxStatOK != status) return status;
+  }
   parameterPropertySetCopy(&dst->properties, &src->properties);
+  return kOfxStatOK;
+}
+
+static unsigned int hashParamName(const char *name) {
+  // FNV-1a
+  unsigned int hash = 2166136261u;
+  for (int i = 0 ; i < 64 && name[i] != '\0' ; ++i) {
+    hash ^= (unsigned char)name[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+struct OfxParamNameIndex {
+  atomic_int ref_count; // number of parameter sets sharing the index
+  int capacity; // power of two, at least twice the number of keys
+  int *slots; // index in entries, or -1 for empty slots
+  unsigned int *hashes; // hash of the name stored in each slot
+};
+
+static void nameIndexFree(OfxParamNameIndex *index) {
+  free(index->slots);
+  free(index->hashes);
+  free(index);
+}
+
+static OfxParamNameIndex *nameIndexAlloc(int capacity) {
+  OfxParamNameIndex *index = malloc(sizeof(OfxParamNameIndex));
+  if (NULL == index) return NULL;
+  atomic_init(&index->ref_count, 1);
+  index->capacity = capacity;
+  index->slots = malloc(capacity * sizeof(int));
+  index->hashes = malloc(capacity * sizeof(unsigned int));
+  if (NULL == index->slots || NULL == index->hashes) {
+    nameIndexFree(index);
+    return NULL;
+  }
+  for (int i = 0 ; i < capacity ; ++i) {
+    index->slots[i] = -1;
+  }
+  return index;
+}
+
+static OfxParamNameIndex *nameIndexRetain(OfxParamNameIndex *index) {
+  if (NULL != index) atomic_fetch_add_explicit(&index->ref_count, 1, memory_order_relaxed);
+  return index;
+}
+
+static void nameIndexRelease(OfxParamNameIndex *index) {
+  if (NULL == index) return;
+  if (atomic_fetch_sub_explicit(&index->ref_count, 1, memory_order_acq_rel) > 1) return;
+  nameIndexFree(index);
+}
+
+static void nameIndexInsert(OfxParamNameIndex *index, unsigned int hash, int entry) {
+  int mask = index->capacity - 1;
+  int slot = hash & mask;
+  while (index->slots[slot] != -1) slot = (slot + 1) & mask;
+  index->slots[slot] = entry;
+  index->hashes[slot] = hash;
+}
+
+/**
+ * Make sure that the name index is not shared and can hold one more key.
+ */
+static OfxStatus nameIndexReserve(OfxParamSetHandle parameterSet) {
+  OfxParamNameIndex *index = parameterSet->name_index;
+  int needed = 2 * (parameterSet->count + 1);
+  if (NULL != index
+    && index->capacity >= needed
+    && 1 == atomic_load_explicit(&index->ref_count, memory_order_acquire))
+  {
+    return kOfxStatOK;
+  }
+
+  int capacity = NULL != index ? index->capacity : 16;
+  while (capacity < needed) capacity *= 2;
+  OfxParamNameIndex *new_index = nameIndexAlloc(capacity);
+  if (NULL == new_index) {
+    return kOfxStatErrMemory;
+  }
+  for (int i = 0 ; i < parameterSet->count ; ++i) {
+    nameIndexInsert(new_index, hashParamName(parameterSet->entries[i]->name), i);
+  }
+  nameIndexRelease(index);
+  parameterSet->name_index = new_index;
+  return kOfxStatOK;
 }
 
 void parameterSetInit(OfxParamSetHandle parameterSet) {
-  for (int i = 0 ; i < 16 ; ++i) {
-    parameterSet->entries[i].is_valid = 0;
+  parameterSet->entries = NULL;
+  parameterSet->count = 0;
+  parameterSet->capacity = 0;
+  parameterSet->name_index = NULL;
+}
+
+void parameterSetDestroy(OfxParamSetHandle parameterSet) {
+  for (int i = 0 ; i < parameterSet->count ; ++i) {
+    paramDestroy(parameterSet->entries[i]);
+    free(parameterSet->entries[i]);
+  }
+  free(parameterSet->entries);
+  nameIndexRelease(parameterSet->name_index);
+  parameterSetInit(parameterSet);
+}
+
+OfxStatus parameterSetCopy(OfxParamSetHandle dst, const OfxParamSetStruct *src) {
+  parameterSetDestroy(dst);
+  if (src->count == 0) return kOfxStatOK;
+  dst->entries = malloc(src->count * sizeof(OfxParamStruct*));
+  if (NULL == dst->entries) {
+    return kOfxStatErrMemory;
+  }
+  dst->capacity = src->count;
+  // dst->count grows along so that dst can be destroyed if a copy fails
+  for (int i = 0; i < src->count; ++i) {
+    OfxParamHandle param = malloc(sizeof(OfxParamStruct));
+    if (NULL == param) {
+      return kOfxStatErrMemory;
+    }
+    paramInit(param);
+    dst->entries[dst->count++] = param;
+    OfxStatus status = parameterCopy(param, src->entries[i]);
+    if (kOfxStatOK != status) {
+      return status;
+    }
   }
+  // Entries are at the same indices, so the index can be shared
+  dst->name_index = nameIndexRetain(src->name_index);
+  return kOfxStatOK;
 }
 
-void parameterSetCopy(OfxParamSetHandle dst, const OfxParamSetStruct *src) {
-  for (int i = 0; i < 16; ++i) {
-    parameterCopy(&dst->entries[i], &src->entries[i]);
+int parameterSetFind(const OfxParamSetStruct *parameterSet, const char *name) {
+  const OfxParamNameIndex *index = parameterSet->name_index;
+  if (NULL == index) return -1;
+  unsigned int hash = hashParamName(name);
+  int mask = index->capacity - 1;
+  for (int slot = hash & mask ; index->slots[slot] != -1 ; slot = (slot + 1) & mask) {
+    int entry = index->slots[slot];
+    if (index->hashes[slot] == hash && 0 == strncmp(name, parameterSet->entries[entry]->name, 64)) {
+      return entry;
+    }
   }
+  return -1;
+}
+
+OfxStatus parameterSetAppend(OfxParamSetHandle parameterSet, const char *name, OfxParamHandle *param) {
+  if (-1 != parameterSetFind(parameterSet, name)) return kOfxStatErrExists;
+
+  if (parameterSet->count == parameterSet->capacity) {
+    int capacity = parameterSet->capacity > 0 ? 2 * parameterSet->capacity : 16;
+    OfxParamStruct **entries = realloc(parameterSet->entries, capacity * sizeof(OfxParamStruct*));
+    if (NULL == entries) {
+      return kOfxStatErrMemory;
+    }
+    parameterSet->entries = entries;
+    parameterSet->capacity = capacity;
+  }
+  OfxStatus status = nameIndexReserve(parameterSet);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+
+  OfxParamHandle new_param = malloc(sizeof(OfxParamStruct));
+  if (NULL == new_param) {
+    return kOfxStatErrMemory;
+  }
+  paramInit(new_param);
+  strncpy(new_param->name, name, 64);
+  new_param->name[63] = '\0';
+
+  int entry = parameterSet->count++;
+  parameterSet->entries[entry] = new_param;
+  nameIndexInsert(parameterSet->name_index, hashParamName(new_param->name), entry);
+  *param = new_param;
+  return kOfxStatOK;
 }
 
 void paramInit(OfxParamHandle param) {
   param->is_valid = 1;
+  param->kind = PARAM_UNKNOWN;
+  memset(param->values, 0, sizeof(param->values));
+  param->keys = NULL;
+  param->key_count = 0;
+  param->key_capacity = 0;
+  param->has_cached_values = 0;
   propertySetInit((OfxPropertySetHandle)&param->properties, PROPSET_PARAM);
 }
 
+void paramDestroy(OfxParamHandle param) {
+  free(param->keys);
+  param->keys = NULL;
+  param->key_count = 0;
+  param->key_capacity = 0;
+  param->has_cached_values = 0;
+}
+
+OfxStatus paramInsertKey(OfxParamHandle param, double time, const OfxParamValueStruct *values, OfxParamInterpolation interpolation) {
+  int index = 0;
+  while (index < param->key_count && param->keys[index].time < time) ++index;
+
+  if (index == param->key_count || param->keys[index].time != time) {
+    if (param->key_count == param->key_capacity) {
+      int capacity = param->key_capacity > 0 ? 2 * param->key_capacity : 4;
+      OfxParamKeyStruct *keys = realloc(param->keys, capacity * sizeof(OfxParamKeyStruct));
+      if (NULL == keys) {
+        return kOfxStatErrMemory;
+      }
+      param->keys = keys;
+      param->key_capacity = capacity;
+    }
+    memmove(&param->keys[index + 1], &param->keys[index], (param->key_count - index) * sizeof(OfxParamKeyStruct));
+    ++param->key_count;
+    param->keys[index].time = time;
+  }
+  memcpy(param->keys[index].values, values, sizeof(param->keys[index].values));
+  param->keys[index].interpolation = interpolation;
+  param->has_cached_values = 0;
+  return kOfxStatOK;
+}
+
+void paramRemoveKey(OfxParamHandle param, int index) {
+  if (index < 0 || index >= param->key_count) return;
+  memmove(&param->keys[index], &param->keys[index + 1], (param->key_count - index - 1) * sizeof(OfxParamKeyStruct));
+  --param->key_count;
+  param->has_cached_values = 0;
+}
+
+void paramClearKeys(OfxParamHandle param) {
+  param->key_count = 0;
+  param->has_cached_values = 0;
+}
+
+/**
+ * Index of the last key at or before time, or -1 if time is before the
+ * first key.
+ */
+static int paramKeyBefore(const OfxParamStruct *param, double time) {
+  int lo = 0, hi = param->key_count; // first key after time is in [lo, hi]
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (param->keys[mid].time <= time) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - 1;
+}
+
+int paramFindKey(const OfxParamStruct *param, double time, int direction) {
+  const double epsilon = 1e-6;
+  if (direction > 0) {
+    int index = paramKeyBefore(param, time + epsilon) + 1;
+    return index < param->key_count ? index : -1;
+  }
+  if (direction < 0) {
+    return paramKeyBefore(param, time - epsilon);
+  }
+  int index = paramKeyBefore(param, time + epsilon);
+  if (index >= 0 && fabs(param->keys[index].time - time) <= epsilon) return index;
+  return -1;
+}
+
+/**
+ * Slope of the cubic curve at key index, per unit of time.
+ */
+static double paramKeyTangent(const OfxParamStruct *param, int index, int component) {
+  if (index <= 0 || index >= param->key_count - 1) return 0.0;
+  const OfxParamKeyStruct *prev = &param->keys[index - 1];
+  const OfxParamKeyStruct *next = &param->keys[index + 1];
+  double dv;
+  if (paramKindIsIntegral(param->kind)) {
+    dv = (double)next->values[component].as_int - prev->values[component].as_int;
+  } else {
+    dv = next->values[component].as_double - prev->values[component].as_double;
+  }
+  return dv / (next->time - prev->time);
+}
+
+/**
+ * Evaluate the parameter at time, given the index of the last key at or
+ * before time.
+ */
+static void paramEvaluateFrom(const OfxParamStruct *param, int index, double time, OfxParamValueStruct *values) {
+  if (param->key_count == 0) {
+    memcpy(values, param->values, sizeof(param->values));
+    return;
+  }
+  if (index < 0) {
+    memcpy(values, param->keys[0].values, sizeof(param->keys[0].values));
+    return;
+  }
+
+  const OfxParamKeyStruct *key = &param->keys[index];
+  OfxParamInterpolation interpolation = key->interpolation;
+  if (param->kind == PARAM_BOOLEAN || param->kind == PARAM_CHOICE) {
+    interpolation = PARAM_INTERPOLATION_CONSTANT;
+  }
+  if (index == param->key_count - 1 || interpolation == PARAM_INTERPOLATION_CONSTANT) {
+    memcpy(values, key->values, sizeof(key->values));
+    return;
+  }
+
+  const OfxParamKeyStruct *next = &param->keys[index + 1];
+  double duration = next->time - key->time;
+  double u = (time - key->time) / duration;
+  int is_integral = paramKindIsIntegral(param->kind);
+  memset(values, 0, 4 * sizeof(OfxParamValueStruct));
+  for (int k = 0 ; k < paramKindComponentCount(param->kind) ; ++k) {
+    double v0 = is_integral ? key->values[k].as_int : key->values[k].as_double;
+    double v1 = is_integral ? next->values[k].as_int : next->values[k].as_double;
+    double v;
+    if (interpolation == PARAM_INTERPOLATION_CUBIC) {
+      // Cubic Hermite basis
+      double u2 = u * u, u3 = u2 * u;
+      double m0 = paramKeyTangent(param, index, k) * duration;
+      double m1 = paramKeyTangent(param, index + 1, k) * duration;
+      v = (2 * u3 - 3 * u2 + 1) * v0 + (u3 - 2 * u2 + u) * m0 + (-2 * u3 + 3 * u2) * v1 + (u3 - u2) * m1;
+    } else {
+      v = v0 + u * (v1 - v0);
+    }
+    if (is_integral) {
+      values[k].as_int = (int)lround(v);
+    } else {
+      values[k].as_double = v;
+    }
+  }
+}
+
+void paramEvaluate(const OfxParamStruct *param, double time, OfxParamValueStruct *values) {
+  paramEvaluateFrom(param, paramKeyBefore(param, time), time, values);
+}
+
+void paramEvaluateCached(OfxParamHandle param, double time, OfxParamValueStruct *values) {
+  if (param->key_count == 0) {
+    memcpy(values, param->values, sizeof(param->values));
+    return;
+  }
+  if (!param->has_cached_values || param->cached_time != time) {
+    paramEvaluate(param, time, param->cached_values);
+    param->cached_time = time;
+    param->has_cached_values = 1;
+  }
+  memcpy(values, param->cached_values, sizeof(param->cached_values));
+}
+
+void paramEvaluateRange(const OfxParamStruct *param, double first, double step, int count, OfxParamValueStruct *values) {
+  int index = paramKeyBefore(param, first);
+  for (int i = 0 ; i < count ; ++i) {
+    double time = first + i * step;
+    while (index + 1 < param->key_count && param->keys[index + 1].time <= time) ++index;
+    paramEvaluateFrom(param, index, time, values + 4 * i);
+  }
+}
+
+void paramSetEvaluation(OfxParamHandle param, double time, const OfxParamValueStruct *values) {
+  memcpy(param->values, values, sizeof(param->values));
+  memcpy(param->cached_values, values, sizeof(param->cached_values));
+  param->cached_time = time;
+  param->has_cached_values = 1;
+}
+
+OfxParamKind paramKindFromType(const char *type) {
+  if (0 == strncmp(type, kOfxParamTypeInteger, 64)) return PARAM_INTEGER;
+  if (0 == strncmp(type, kOfxParamTypeDouble, 64)) return PARAM_DOUBLE;
+  if (0 == strncmp(type, kOfxParamTypeBoolean, 64)) return PARAM_BOOLEAN;
+  if (0 == strncmp(type, kOfxParamTypeChoice, 64)) return PARAM_CHOICE;
+  if (0 == strncmp(type, kOfxParamTypeRGBA, 64)) return PARAM_RGBA;
+  if (0 == strncmp(type, kOfxParamTypeRGB, 64)) return PARAM_RGB;
+  if (0 == strncmp(type, kOfxParamTypeDouble2D, 64)) return PARAM_DOUBLE2D;
+  if (0 == strncmp(type, kOfxParamTypeInteger2D, 64)) return PARAM_INTEGER2D;
+  if (0 == strncmp(type, kOfxParamTypeDouble3D, 64)) return PARAM_DOUBLE3D;
+  if (0 == strncmp(type, kOfxParamTypeInteger3D, 64)) return PARAM_INTEGER3D;
+  if (0 == strncmp(type, kOfxParamTypeString, 64)) return PARAM_STRING;
+  if (0 == strncmp(type, kOfxParamTypeCustom, 64)) return PARAM_CUSTOM;
+  if (0 == strncmp(type, kOfxParamTypeGroup, 64)) return PARAM_GROUP;
+  if (0 == strncmp(type, kOfxParamTypePage, 64)) return PARAM_PAGE;
+  if (0 == strncmp(type, kOfxParamTypePushButton, 64)) return PARAM_PUSHBUTTON;
+  return PARAM_UNKNOWN;
+}
+
+int paramKindComponentCount(OfxParamKind kind) {
+  switch (kind) {
+  case PARAM_INTEGER:
+  case PARAM_DOUBLE:
+  case PARAM_BOOLEAN:
+  case PARAM_CHOICE:
+    return 1;
+  case PARAM_DOUBLE2D:
+  case PARAM_INTEGER2D:
+    return 2;
+  case PARAM_RGB:
+  case PARAM_DOUBLE3D:
+  case PARAM_INTEGER3D:
+    return 3;
+  case PARAM_RGBA:
+    return 4;
+  default:
+    return 0;
+  }
+}
+
+int paramKindIsIntegral(OfxParamKind kind) {
+  switch (kind) {
+  case PARAM_INTEGER:
+  case PARAM_BOOLEAN:
+  case PARAM_CHOICE:
+  case PARAM_INTEGER2D:
+  case PARAM_INTEGER3D:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
 void meshInit(OfxMeshHandle mesh) {
   propertySetInit((OfxPropertySetHandle)&mesh->properties, PROPSET_MESH);
   mesh->properties.constant_face_size = -1;
+  for (int i = 0 ; i < 16 ; ++i) {
+    mesh->properties.transform_matrix[i] = i % 5 == 0 ? 1.0 : 0.0;
+  }
   for (int i = 0 ; i < 32 ; ++i) {
     attributeInit(&mesh->attributes[i]);
   }
@@ -165,10 +580,40 @@ void meshShallowCopy(OfxMeshHandle dst, const OfxMeshStruct *src) {
   meshPropertySetCopy(&dst->properties, &src->properties);
 }
 
+OfxStatus meshDeepCopy(OfxMeshHandle dst, const OfxMeshStruct *src) {
+  meshPropertySetCopy(&dst->properties, &src->properties);
+  for (int i = 0 ; i < 32 && src->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *src_attrib = &src->attributes[i];
+    OfxMeshAttributePropertySet *attrib = &dst->attributes[i];
+    attributeShallowCopy(attrib, src_attrib);
+    attrib->data = NULL;
+    attrib->is_owner = 1;
+    if (NULL == src_attrib->data) continue;
+
+    int element_count = attributeElementCount(src_attrib, &src->properties);
+    size_t element_size = src_attrib->component_count * attributeComponentSize(src_attrib->type);
+    attrib->byte_stride = element_size;
+    attrib->data = malloc(element_count * element_size);
+    if (NULL == attrib->data && element_count > 0) {
+      return kOfxStatErrMemory;
+    }
+    if (src_attrib->byte_stride == element_size) {
+      memcpy(attrib->data, src_attrib->data, element_count * element_size);
+    } else {
+      for (int j = 0 ; j < element_count ; ++j) {
+        memcpy(attrib->data + j * element_size, src_attrib->data + j * src_attrib->byte_stride, element_size);
+      }
+    }
+  }
+  return kOfxStatOK;
+}
+
 void meshInputInit(OfxMeshInputHandle input) {
   input->is_valid = 1;
   input->name[0] = '\0';
   meshInit(&input->mesh);
+  input->time_samples = NULL;
+  input->time_sample_count = 0;
   propertySetInit((OfxPropertySetHandle)&input->properties, PROPSET_INPUT);
 }
 
@@ -185,9 +630,24 @@ void meshInputDestroy(OfxMeshInputHandle input) {
   input->is_valid = 0;
 }
 
+const OfxMeshStruct *meshInputMeshAtTime(const OfxMeshInputStruct *input, double time) {
+  if (input->time_sample_count == 0) {
+    return &input->mesh;
+  }
+  int index = 0;
+  while (index + 1 < input->time_sample_count && input->time_samples[index + 1].time <= time) ++index;
+  return input->time_samples[index].mesh;
+}
+
+void cookArgsInit(OfxCookArgsPropertySet *args, double time) {
+  propertySetInit((OfxPropertySetHandle)args, PROPSET_COOK_ARGS);
+  args->time = time;
+}
+
 void meshEffectInit(OfxMeshEffectHandle meshEffect) {
   parameterSetInit(&meshEffect->parameters);
   for (int i = 0 ; i < 16 ; ++i) {
+    meshInputInit(&meshEffect->inputs[i]);
     meshEffect->inputs[i].is_valid = 0;
   }
   meshEffect->is_valid = 1;
@@ -195,12 +655,15 @@ void meshEffectInit(OfxMeshEffectHandle meshEffect) {
 
 void meshEffectDestroy(OfxMeshEffectHandle meshEffect) {
   for (int i = 0 ; i < 16 ; ++i) {
-    meshInputDestroy(&meshEffect->inputs[i]);
+    if (meshEffect->inputs[i].is_valid) {
+      meshInputDestroy(&meshEffect->inputs[i]);
+    }
   }
+  parameterSetDestroy(&meshEffect->parameters);
   meshEffect->is_valid = 0;
 }
 
-void meshEffectCopy(OfxMeshEffectHandle dst, const OfxMeshEffectStruct *src) {
+OfxStatus meshEffectCopy(OfxMeshEffectHandle dst, const OfxMeshEffectStruct *src) {
   if (dst->is_valid) {
     meshEffectDestroy(dst);
   }
@@ -208,5 +671,5 @@ void meshEffectCopy(OfxMeshEffectHandle dst, const OfxMeshEffectStruct *src) {
   for (int input_index = 0; input_index < 16; ++input_index) {
     meshInputCopy(&dst->inputs[input_index], &src->inputs[input_index]);
   }
-  parameterSetCopy(&dst->parameters, &src->parameters);
+  return parameterSetCopy(&dst->parameters, &src->parameters);
 }
@@ -13,8 +13,28 @@ typedef enum OfxPropertySetType {
   PROPSET_PARAM,
   PROPSET_MESH,
   PROPSET_ATTRIBUTE,
+  PROPSET_COOK_ARGS,
 } OfxPropertySetType;
 
+typedef enum OfxParamKind {
+  PARAM_UNKNOWN,
+  PARAM_INTEGER,
+  PARAM_DOUBLE,
+  PARAM_BOOLEAN,
+  PARAM_CHOICE,
+  PARAM_RGBA,
+  PARAM_RGB,
+  PARAM_DOUBLE2D,
+  PARAM_INTEGER2D,
+  PARAM_DOUBLE3D,
+  PARAM_INTEGER3D,
+  PARAM_STRING,
+  PARAM_CUSTOM,
+  PARAM_GROUP,
+  PARAM_PAGE,
+  PARAM_PUSHBUTTON,
+} OfxParamKind;
+
 typedef struct OfxPropertySetStruct {
   OfxPropertySetType type;
 } OfxPropertySetStruct;
@@ -33,16 +53,55 @@ typedef union OfxParamValueStruct {
     int as_bool;
 } OfxParamValueStruct;
 
+/**
+ * How the values of an animated parameter go from a key to the next one.
+ * Boolean and choice parameters are always constant, and interpolated
+ * integers are rounded to the nearest.
+ */
+typedef enum OfxParamInterpolation {
+  PARAM_INTERPOLATION_CONSTANT, // hold the values of the key
+  PARAM_INTERPOLATION_LINEAR,
+  PARAM_INTERPOLATION_CUBIC, // Catmull-Rom tangents, flat at the first and last keys
+} OfxParamInterpolation;
+
+typedef struct OfxParamKeyStruct {
+  double time;
+  OfxParamValueStruct values[4];
+  OfxParamInterpolation interpolation; // towards the next key
+} OfxParamKeyStruct;
+
 typedef struct OfxParamStruct {
   int is_valid;
   char name[64];
   char type[64];
-  OfxParamValueStruct values[4];
+  OfxParamKind kind; // resolved from type in paramDefine
+  OfxParamValueStruct values[4]; // one slot per component
+  OfxParamKeyStruct *keys; // sorted by time, NULL if the parameter is not animated
+  int key_count;
+  int key_capacity;
+  // Last evaluation of the keys, since plugins tend to query the same time
+  // repeatedly during a cook. Reset whenever keys change.
+  int has_cached_values;
+  double cached_time;
+  OfxParamValueStruct cached_values[4];
   OfxParamPropertySet properties;
 } OfxParamStruct;
 
+/**
+ * Open addressing hash table mapping parameter names to their index in the
+ * parameter set, defined in types.c. It is built while the descriptor is
+ * described and then shared read-only by the instances copied from it, so
+ * copying an instance does not rebuild it. Its reference count is atomic so
+ * that instances may be copied and destroyed on different threads. A set
+ * that defines a parameter while sharing its index first gets its own copy.
+ */
+typedef struct OfxParamNameIndex OfxParamNameIndex;
+
 typedef struct OfxParamSetStruct {
-  OfxParamStruct entries[16];
+  OfxParamStruct **entries; // individually allocated so that handles remain valid when growing
+  int count;
+  int capacity;
+  OfxParamNameIndex *name_index;
 } OfxParamSetStruct;
 
 typedef struct OfxMeshPropertySet {
@@ -51,6 +110,7 @@ typedef struct OfxMeshPropertySet {
   int corner_count;
   int face_count;
   int constant_face_size;
+  double transform_matrix[16]; // row major, identity by default
 } OfxMeshPropertySet;
 
 typedef struct OfxMeshAttributePropertySet {
@@ -76,13 +136,32 @@ typedef struct OfxMeshInputPropertySet {
   char label[256];
 } OfxMeshInputPropertySet;
 
+/**
+ * Mesh fed to an input from a given time on, until the next sample.
+ */
+typedef struct OfxMeshTimeSample {
+  double time;
+  const OfxMeshStruct *mesh;
+} OfxMeshTimeSample;
+
 typedef struct OfxMeshInputStruct {
   int is_valid;
   char name[256];
   OfxMeshStruct mesh;
+  // Borrowed, sorted by time. If there is none, mesh is used at all times.
+  const OfxMeshTimeSample *time_samples;
+  int time_sample_count;
   OfxMeshInputPropertySet properties;
 } OfxMeshInputStruct;
 
+/**
+ * inArgs of the cook action.
+ */
+typedef struct OfxCookArgsPropertySet {
+  OfxPropertySetStruct *header;
+  double time;
+} OfxCookArgsPropertySet;
+
 typedef struct OfxMeshEffectStruct {
   int is_valid;
   OfxMeshInputStruct inputs[16];
@@ -101,36 +180,96 @@ void propertySetInit(OfxPropertySetHandle propertySet, OfxPropertySetType type);
 
 void attributeInit(OfxMeshAttributePropertySet *attrib);
 
+// Number of elements of the attribute's attachment (1 for mesh attributes)
+int attributeElementCount(const OfxMeshAttributePropertySet *attrib, const OfxMeshPropertySet *props);
+
+// Size in bytes of one component of the given attribute type, 0 if unknown
+size_t attributeComponentSize(const char *type);
+
 OfxStatus attributeAlloc(OfxMeshAttributePropertySet *attrib, OfxMeshPropertySet *props);
 
 void attributeDestroy(OfxMeshAttributePropertySet *attrib);
 
 void attributeShallowCopy(OfxMeshAttributePropertySet *dst, const OfxMeshAttributePropertySet *src);
 
-void parameterCopy(OfxParamHandle dst, const OfxParamStruct *src);
+OfxStatus parameterCopy(OfxParamHandle dst, const OfxParamStruct *src);
 
 void parameterSetInit(OfxParamSetHandle parameterSet);
 
-void parameterSetCopy(OfxParamSetHandle dst, const OfxParamSetStruct *src);
+void parameterSetDestroy(OfxParamSetHandle parameterSet);
+
+OfxStatus parameterSetCopy(OfxParamSetHandle dst, const OfxParamSetStruct *src);
+
+// Return the index of the parameter called name, or -1 if there is none
+int parameterSetFind(const OfxParamSetStruct *parameterSet, const char *name);
+
+// Append a new initialized parameter called name, or return kOfxStatErrExists
+// if the name is taken
+OfxStatus parameterSetAppend(OfxParamSetHandle parameterSet, const char *name, OfxParamHandle *param);
 
 void paramInit(OfxParamHandle param);
 
+void paramDestroy(OfxParamHandle param);
+
+// Add a key, or replace the key at the very same time
+OfxStatus paramInsertKey(OfxParamHandle param, double time, const OfxParamValueStruct *values, OfxParamInterpolation interpolation);
+
+void paramRemoveKey(OfxParamHandle param, int index);
+
+void paramClearKeys(OfxParamHandle param);
+
+// Index of the key at time if direction is 0, or of the closest key after
+// (direction > 0) or before (direction < 0) it, or -1 if there is none
+int paramFindKey(const OfxParamStruct *param, double time, int direction);
+
+// Values of the parameter at time. Keys extend before the first one and
+// after the last one. If the parameter is not animated, this is its static
+// values.
+void paramEvaluate(const OfxParamStruct *param, double time, OfxParamValueStruct *values);
+
+// Same as paramEvaluate(), but reusing the last evaluation if it was at the
+// same time, so a parameter must not be evaluated by several threads at once
+void paramEvaluateCached(OfxParamHandle param, double time, OfxParamValueStruct *values);
+
+// Evaluate the parameter at times first, first + step, ... with step >= 0,
+// into 4 slots of values per time, walking the keys only once
+void paramEvaluateRange(const OfxParamStruct *param, double first, double step, int count, OfxParamValueStruct *values);
+
+// Make values, evaluated beforehand at time, the current values and the
+// cached evaluation of the parameter
+void paramSetEvaluation(OfxParamHandle param, double time, const OfxParamValueStruct *values);
+
+OfxParamKind paramKindFromType(const char *type);
+
+int paramKindComponentCount(OfxParamKind kind);
+
+int paramKindIsIntegral(OfxParamKind kind);
+
 void meshInit(OfxMeshHandle mesh);
 
 void meshDestroy(OfxMeshHandle mesh);
 
 void meshShallowCopy(OfxMeshHandle dst, const OfxMeshStruct *src);
 
+// Copy src into an empty dst that owns packed copies of all buffers
+OfxStatus meshDeepCopy(OfxMeshHandle dst, const OfxMeshStruct *src);
+
 void meshInputInit(OfxMeshInputHandle input);
 
 void meshInputCopy(OfxMeshInputHandle dst, const OfxMeshInputStruct *src);
 
 void meshInputDestroy(OfxMeshInputHandle input);
 
+// Mesh of the input at time, i.e. its last time sample at or before time,
+// or its first one
+const OfxMeshStruct *meshInputMeshAtTime(const OfxMeshInputStruct *input, double time);
+
+void cookArgsInit(OfxCookArgsPropertySet *args, double time);
+
 void meshEffectInit(OfxMeshEffectHandle meshEffect);
 
 void meshEffectDestroy(OfxMeshEffectHandle meshEffect);
 
-void meshEffectCopy(OfxMeshEffectHandle dst, const OfxMeshEffectStruct *src);
+OfxStatus meshEffectCopy(OfxMeshEffectHandle dst, const OfxMeshEffectStruct *src);
 
 #endif // _types_h_
@@ -1,5 +1,6 @@
 #include "mesh.h"
 #include "../common/common.h" // for MFX_ENSURE
+#include "../common/extensions.h" // for kMfxMeshPropCounts
 
 OfxStatus mfxPullMeshProperties(
     const OfxPropertySuiteV1 *propertySuite,
@@ -9,6 +10,18 @@ OfxStatus mfxPullMeshProperties(
 {
     OfxPropertySetHandle propHandle;
     meshEffectSuite->meshGetPropertySet(mesh, &propHandle);
+
+    // Single call on hosts supporting the WebMfx extension
+    int counts[4];
+    if (NULL != propertySuite->propGetIntN &&
+        kOfxStatOK == propertySuite->propGetIntN(propHandle, kMfxMeshPropCounts, 4, counts)) {
+        props->point_count = counts[0];
+        props->corner_count = counts[1];
+        props->face_count = counts[2];
+        props->constant_face_size = counts[3];
+        return kOfxStatOK;
+    }
+
     MFX_ENSURE(propertySuite->propGetInt(propHandle, kOfxMeshPropPointCount, 0, &props->point_count));
     MFX_ENSURE(propertySuite->propGetInt(propHandle, kOfxMeshPropCornerCount, 0, &props->corner_count));
     MFX_ENSURE(propertySuite->propGetInt(propHandle, kOfxMeshPropFaceCount, 0, &props->face_count));
@@ -24,6 +37,19 @@ OfxStatus mfxPushMeshProperties(
 {
     OfxPropertySetHandle propHandle;
     meshEffectSuite->meshGetPropertySet(mesh, &propHandle);
+
+    // Single call on hosts supporting the WebMfx extension
+    const int counts[4] = {
+        props->point_count,
+        props->corner_count,
+        props->face_count,
+        props->constant_face_size
+    };
+    if (NULL != propertySuite->propSetIntN &&
+        kOfxStatOK == propertySuite->propSetIntN(propHandle, kMfxMeshPropCounts, 4, counts)) {
+        return kOfxStatOK;
+    }
+
     MFX_ENSURE(propertySuite->propSetInt(propHandle, kOfxMeshPropPointCount, 0, props->point_count));
     MFX_ENSURE(propertySuite->propSetInt(propHandle, kOfxMeshPropCornerCount, 0, props->corner_count));
     MFX_ENSURE(propertySuite->propSetInt(propHandle, kOfxMeshPropFaceCount, 0, props->face_count));
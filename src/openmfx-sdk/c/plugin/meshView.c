@@ -0,0 +1,103 @@
+#include "meshView.h"
+#include "attribute.h"
+#include "mesh.h"
+#include "../common/common.h" // for MFX_ENSURE
+
+#include <string.h>
+
+static MfxAttributeType attributeTypeFromString(const char *type) {
+    if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) return MFX_ATTRIBUTE_TYPE_FLOAT;
+    if (0 == strcmp(type, kOfxMeshAttribTypeInt)) return MFX_ATTRIBUTE_TYPE_INT;
+    if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) return MFX_ATTRIBUTE_TYPE_UBYTE;
+    return MFX_ATTRIBUTE_TYPE_UNKNOWN;
+}
+
+static OfxStatus pullStandardAttribute(
+    const OfxPropertySuiteV1 *propertySuite,
+    const OfxMeshEffectSuiteV1 *meshEffectSuite,
+    OfxMeshHandle mesh,
+    const char *attachment,
+    MfxAttachment attachment_enum,
+    const char *name,
+    MfxMeshView *view)
+{
+    OfxPropertySetHandle attrib;
+    MFX_ENSURE(meshEffectSuite->meshGetAttribute(mesh, attachment, name, &attrib));
+
+    MfxAttributeProperties props;
+    MFX_ENSURE(mfxPullAttributeProperties(propertySuite, attrib, &props));
+
+    MfxAttributeDescriptor *desc = &view->attributes[view->attribute_count++];
+    desc->attachment = attachment_enum;
+    desc->name = name;
+    desc->type = attributeTypeFromString(props.type);
+    desc->component_count = props.component_count;
+    desc->data = props.data;
+    desc->byte_stride = props.byte_stride;
+    desc->semantic = props.semantic;
+    desc->is_owner = props.is_owner;
+    return kOfxStatOK;
+}
+
+OfxStatus mfxPullMeshView(
+    const MfxMeshViewSuiteV1 *meshViewSuite,
+    const OfxPropertySuiteV1 *propertySuite,
+    const OfxMeshEffectSuiteV1 *meshEffectSuite,
+    OfxMeshHandle mesh,
+    MfxMeshView *view)
+{
+    if (NULL != meshViewSuite) {
+        return meshViewSuite->meshGetView(mesh, view);
+    }
+
+    MfxMeshProperties props;
+    MFX_ENSURE(mfxPullMeshProperties(propertySuite, meshEffectSuite, mesh, &props));
+    view->point_count = props.point_count;
+    view->corner_count = props.corner_count;
+    view->face_count = props.face_count;
+    view->constant_face_size = props.constant_face_size;
+    view->attribute_count = 0;
+
+    MFX_ENSURE(pullStandardAttribute(propertySuite, meshEffectSuite, mesh,
+                                     kOfxMeshAttribPoint, MFX_ATTACHMENT_POINT,
+                                     kOfxMeshAttribPointPosition, view));
+    MFX_ENSURE(pullStandardAttribute(propertySuite, meshEffectSuite, mesh,
+                                     kOfxMeshAttribCorner, MFX_ATTACHMENT_CORNER,
+                                     kOfxMeshAttribCornerPoint, view));
+    MFX_ENSURE(pullStandardAttribute(propertySuite, meshEffectSuite, mesh,
+                                     kOfxMeshAttribFace, MFX_ATTACHMENT_FACE,
+                                     kOfxMeshAttribFaceSize, view));
+
+    if (view->constant_face_size > -1) {
+        MfxAttributeDescriptor *face_size = &view->attributes[view->attribute_count - 1];
+        face_size->data = &view->constant_face_size;
+        face_size->byte_stride = 0;
+    }
+
+    return kOfxStatOK;
+}
+
+const MfxAttributeDescriptor *mfxFindAttribute(
+    const MfxMeshView *view,
+    MfxAttachment attachment,
+    const char *name)
+{
+    for (int i = 0 ; i < view->attribute_count ; ++i) {
+        const MfxAttributeDescriptor *desc = &view->attributes[i];
+        if (desc->attachment == attachment && 0 == strcmp(desc->name, name)) {
+            return desc;
+        }
+    }
+    return NULL;
+}
+
+OfxStatus mfxForwardAttribute(
+    const OfxPropertySuiteV1 *propertySuite,
+    const MfxAttributeDescriptor *src,
+    OfxPropertySetHandle dst)
+{
+    MFX_ENSURE(propertySuite->propSetPointer(dst, kOfxMeshAttribPropData, 0, src->data));
+    MFX_ENSURE(propertySuite->propSetInt(dst, kOfxMeshAttribPropStride, 0, (int)src->byte_stride));
+    MFX_ENSURE(propertySuite->propSetInt(dst, kOfxMeshAttribPropIsOwner, 0, 0));
+    return kOfxStatOK;
+}
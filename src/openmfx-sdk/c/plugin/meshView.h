@@ -0,0 +1,41 @@
+#ifndef __MFX_SDK_PLUGIN_MESH_VIEW__
+#define __MFX_SDK_PLUGIN_MESH_VIEW__
+
+#include "../common/extensions.h"
+
+#include <ofxCore.h>
+#include <ofxMeshEffect.h>
+#include <ofxProperty.h>
+
+/**
+ * Fill view in a single call when meshViewSuite is available (it may be NULL,
+ * as returned by fetchSuite on hosts that do not provide it). Otherwise fall
+ * back to the standard suites, in which case only the position, corner point
+ * and face size attributes are listed because standard suites cannot
+ * enumerate attribute names.
+ */
+OfxStatus mfxPullMeshView(
+    const MfxMeshViewSuiteV1 *meshViewSuite,
+    const OfxPropertySuiteV1 *propertySuite,
+    const OfxMeshEffectSuiteV1 *meshEffectSuite,
+    OfxMeshHandle mesh,
+    MfxMeshView *view);
+
+/**
+ * @return the attribute of the view with the given attachment and name, or
+ * NULL if there is none.
+ */
+const MfxAttributeDescriptor *mfxFindAttribute(
+    const MfxMeshView *view,
+    MfxAttachment attachment,
+    const char *name);
+
+/**
+ * Make the attribute dst point to the data of src without owning it
+ */
+OfxStatus mfxForwardAttribute(
+    const OfxPropertySuiteV1 *propertySuite,
+    const MfxAttributeDescriptor *src,
+    OfxPropertySetHandle dst);
+
+#endif // __MFX_SDK_PLUGIN_MESH_VIEW__
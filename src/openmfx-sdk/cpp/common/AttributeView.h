@@ -0,0 +1,190 @@
+#ifndef __MFX_SDK_CPP_COMMON_ATTRIBUTE_VIEW__
+#define __MFX_SDK_CPP_COMMON_ATTRIBUTE_VIEW__
+
+/**
+ * Typed views over attribute buffers, which are otherwise exposed as a raw
+ * data pointer and a byte stride. The stride layout is a template argument so
+ * that element access compiles down to plain pointer arithmetic in the common
+ * contiguous case (letting the compiler vectorize loops) and to a single load
+ * in the constant case (stride 0, e.g. constant face size).
+ *
+ * Use visitAttributeView() to pick the right layout at runtime:
+ *
+ *   mfx::visitAttributeView<float, 3>(data, byteStride, pointCount, [&](auto positions) {
+ *     for (float *P : positions) { ... }
+ *   });
+ *
+ * Bounds are checked with assert(), i.e. in debug builds only.
+ *
+ * Read-only views use a const T, e.g. StridedAttributeView<const float, 3>.
+ * Buffers that may not be aligned for T, e.g. views into a loaded file, are
+ * read with get(), which copies the components out.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+namespace mfx {
+
+enum class AttributeLayout {
+  // byte_stride == N * sizeof(T)
+  Contiguous,
+  // byte_stride == 0, all elements share the same value
+  Constant,
+  // Any other stride, e.g. interleaved buffers
+  Strided,
+};
+
+/**
+ * View over the count elements of an attribute, each of which is made of N
+ * components of type T. Elements are accessed as T& when N == 1 and as a
+ * pointer to the first component otherwise.
+ */
+template <typename T, int N, AttributeLayout Layout = AttributeLayout::Strided>
+class AttributeView {
+  static_assert(N > 0, "Attributes have at least one component");
+
+public:
+  using Element = std::conditional_t<N == 1, T&, T*>;
+  using Value = std::remove_const_t<T>;
+  using Byte = std::conditional_t<std::is_const_v<T>, const char, char>;
+  using Pointer = std::conditional_t<std::is_const_v<T>, const void*, void*>;
+
+  class Iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::conditional_t<N == 1, T, T*>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Element;
+
+    Iterator(const AttributeView *view, size_t index) : m_view(view), m_index(index) {}
+
+    Element operator*() const { return (*m_view)[m_index]; }
+    Iterator& operator++() { ++m_index; return *this; }
+    Iterator operator++(int) { Iterator it = *this; ++m_index; return it; }
+    Iterator& operator+=(difference_type n) { m_index += n; return *this; }
+    Iterator operator+(difference_type n) const { return Iterator(m_view, m_index + n); }
+    difference_type operator-(const Iterator& other) const {
+      return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+    }
+    bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+    bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+  private:
+    const AttributeView *m_view;
+    size_t m_index;
+  };
+
+public:
+  AttributeView() = default;
+
+  AttributeView(Pointer data, size_t byteStride, size_t count)
+    : m_data(static_cast<Byte*>(data))
+    , m_byteStride(byteStride)
+    , m_count(count)
+  {
+    if constexpr (Layout == AttributeLayout::Contiguous) {
+      assert(byteStride == N * sizeof(T));
+    } else if constexpr (Layout == AttributeLayout::Constant) {
+      assert(byteStride == 0);
+    }
+  }
+
+  bool isValid() const { return nullptr != m_data; }
+  size_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+  size_t byteStride() const {
+    if constexpr (Layout == AttributeLayout::Contiguous) {
+      return N * sizeof(T);
+    } else if constexpr (Layout == AttributeLayout::Constant) {
+      return 0;
+    } else {
+      return m_byteStride;
+    }
+  }
+
+  /**
+   * Address of the first byte of the index-th element.
+   */
+  Byte* bytes(size_t index) const {
+    assert(index < m_count);
+    if constexpr (Layout == AttributeLayout::Contiguous) {
+      return m_data + N * sizeof(T) * index;
+    } else if constexpr (Layout == AttributeLayout::Constant) {
+      return m_data;
+    } else {
+      return m_data + m_byteStride * index;
+    }
+  }
+
+  /**
+   * Pointer to the first component of the index-th element.
+   */
+  T* component(size_t index) const {
+    return reinterpret_cast<T*>(bytes(index));
+  }
+
+  /**
+   * Copy of a component of the index-th element, which need not be aligned.
+   */
+  Value get(size_t index, int component = 0) const {
+    assert(component >= 0 && component < N);
+    Value value;
+    memcpy(&value, bytes(index) + component * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  Element operator[](size_t index) const {
+    if constexpr (N == 1) {
+      return *component(index);
+    } else {
+      return component(index);
+    }
+  }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, m_count); }
+
+  /**
+   * Raw contiguous storage, only available when the layout is contiguous
+   */
+  template <AttributeLayout L = Layout, typename = std::enable_if_t<L == AttributeLayout::Contiguous>>
+  T* data() const { return reinterpret_cast<T*>(m_data); }
+
+private:
+  Byte *m_data = nullptr;
+  size_t m_byteStride = 0;
+  size_t m_count = 0;
+};
+
+template <typename T, int N>
+using ContiguousAttributeView = AttributeView<T, N, AttributeLayout::Contiguous>;
+
+template <typename T, int N>
+using ConstantAttributeView = AttributeView<T, N, AttributeLayout::Constant>;
+
+template <typename T, int N>
+using StridedAttributeView = AttributeView<T, N, AttributeLayout::Strided>;
+
+/**
+ * Call func with the most specialized view matching the runtime byte stride.
+ * The callback is typically a generic lambda, instantiated once per layout.
+ */
+template <typename T, int N, typename Func>
+decltype(auto) visitAttributeView(typename AttributeView<T, N>::Pointer data, size_t byteStride, size_t count, Func&& func) {
+  if (byteStride == 0) {
+    return func(ConstantAttributeView<T, N>(data, byteStride, count));
+  } else if (byteStride == N * sizeof(T)) {
+    return func(ContiguousAttributeView<T, N>(data, byteStride, count));
+  } else {
+    return func(StridedAttributeView<T, N>(data, byteStride, count));
+  }
+}
+
+} // namespace mfx
+
+#endif // __MFX_SDK_CPP_COMMON_ATTRIBUTE_VIEW__
@@ -0,0 +1,64 @@
+#ifndef __MFX_SDK_CPP_HOST_ATTRIBUTE__
+#define __MFX_SDK_CPP_HOST_ATTRIBUTE__
+
+/**
+ * Bridge between the attributes of the C host SDK's OfxMeshStruct and the
+ * typed attribute views of the C++ SDK. Views are read-only and sized after
+ * the element count of the attachment of the attribute.
+ */
+
+#include "../common/AttributeView.h"
+
+extern "C" {
+#include "../../c/host/types.h"
+}
+
+#include <ofxMeshEffect.h>
+
+#include <cstring>
+
+namespace mfx {
+
+/**
+ * View on N components of type T of an attribute, starting at component
+ * first, which is invalid if attrib is null.
+ */
+template <typename T, int N>
+StridedAttributeView<const T, N> makeAttributeView(const OfxMeshStruct *mesh, const OfxMeshAttributePropertySet *attrib, int first = 0) {
+  if (nullptr == attrib || nullptr == attrib->data) return StridedAttributeView<const T, N>();
+  assert(first >= 0 && first + N <= attrib->component_count);
+  int count = attributeElementCount(attrib, &mesh->properties);
+  return StridedAttributeView<const T, N>(attrib->data + first * sizeof(T), attrib->byte_stride, count);
+}
+
+/**
+ * View on the raw elements of an attribute, for code that copies or hashes
+ * them whatever their type.
+ */
+inline StridedAttributeView<const char, 1> makeByteView(const OfxMeshStruct *mesh, const OfxMeshAttributePropertySet *attrib) {
+  if (nullptr == attrib || nullptr == attrib->data) return StridedAttributeView<const char, 1>();
+  int count = attributeElementCount(attrib, &mesh->properties);
+  return StridedAttributeView<const char, 1>(attrib->data, attrib->byte_stride, count);
+}
+
+/**
+ * View on the face sizes of a mesh, which points to the constant face size
+ * with a stride of 0 when the mesh has no face size buffer.
+ */
+inline StridedAttributeView<const int, 1> makeFaceSizeView(const OfxMeshStruct *mesh) {
+  const OfxMeshPropertySet& props = mesh->properties;
+  if (props.constant_face_size > -1) {
+    return StridedAttributeView<const int, 1>(&props.constant_face_size, 0, props.face_count);
+  }
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, kOfxMeshAttribFace) && 0 == strcmp(attrib->name, kOfxMeshAttribFaceSize)) {
+      return makeAttributeView<int, 1>(mesh, attrib);
+    }
+  }
+  return StridedAttributeView<const int, 1>();
+}
+
+} // namespace mfx
+
+#endif // __MFX_SDK_CPP_HOST_ATTRIBUTE__
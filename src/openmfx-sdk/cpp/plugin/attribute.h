@@ -0,0 +1,57 @@
+#ifndef __MFX_SDK_CPP_PLUGIN_ATTRIBUTE__
+#define __MFX_SDK_CPP_PLUGIN_ATTRIBUTE__
+
+/**
+ * Bridge between the C plugin SDK's MfxAttributeProperties and the typed
+ * attribute views of the C++ SDK.
+ */
+
+#include "../common/AttributeView.h"
+
+extern "C" {
+#include "../../c/plugin/attribute.h"
+}
+
+#include <cstring>
+#include <utility>
+
+namespace mfx {
+
+template <typename T>
+struct AttributeTypeName;
+
+template <> struct AttributeTypeName<float> { static constexpr const char *value = kOfxMeshAttribTypeFloat; };
+template <> struct AttributeTypeName<int> { static constexpr const char *value = kOfxMeshAttribTypeInt; };
+template <> struct AttributeTypeName<unsigned char> { static constexpr const char *value = kOfxMeshAttribTypeUByte; };
+
+/**
+ * Tell whether the attribute described by props can be viewed as N
+ * components of type T.
+ */
+template <typename T, int N>
+bool isAttributeCompatible(const MfxAttributeProperties& props) {
+  using Scalar = std::remove_const_t<T>;
+  return props.component_count >= N
+    && nullptr != props.type
+    && 0 == strcmp(props.type, AttributeTypeName<Scalar>::value);
+}
+
+/**
+ * Generic strided view, when the layout is not known in advance. Prefer
+ * visitAttributeView in hot loops.
+ */
+template <typename T, int N>
+StridedAttributeView<T, N> makeAttributeView(const MfxAttributeProperties& props, size_t count) {
+  assert((isAttributeCompatible<T, N>(props)));
+  return StridedAttributeView<T, N>(props.data, props.byte_stride, count);
+}
+
+template <typename T, int N, typename Func>
+decltype(auto) visitAttributeView(const MfxAttributeProperties& props, size_t count, Func&& func) {
+  assert((isAttributeCompatible<T, N>(props)));
+  return visitAttributeView<T, N>(props.data, props.byte_stride, count, std::forward<Func>(func));
+}
+
+} // namespace mfx
+
+#endif // __MFX_SDK_CPP_PLUGIN_ATTRIBUTE__
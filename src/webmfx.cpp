@@ -20,8 +20,18 @@ extern "C" {
 #include <ofxParam.h>
 
 // Other includes
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
+#include "ObjReader.h"
+#include "BinaryMeshFormat.h"
+#include "GltfFormat.h"
+#include "PlyFormat.h"
+#include "ObjWriter.h"
+#include "RenderBuffers.h"
+#include "MeshRows.h"
+#include "AttributeStats.h"
+#include "Graph.h"
+#include "FrameRange.h"
+#include "OutputSlots.h"
+#include "Blob.h"
 #include <cstdio>
 #include <SDL/SDL.h>
 #include <dlfcn.h>
@@ -29,6 +39,7 @@ extern "C" {
 #include <cstring>
 
 #include <vector>
+#include <memory>
 
 #define MOVE_ONLY(ClassName) \
   ClassName(const ClassName&) = delete; \
@@ -55,6 +66,8 @@ public:
   MOVE_ONLY(Parameter)
 
   const char* identifier() const;
+  const char* type() const;
+  int componentCount() const;
 
 private:
   const OfxParamStruct * m_parameter;
@@ -68,11 +81,19 @@ const char* Parameter::identifier() const {
   return m_parameter->name;
 }
 
+const char* Parameter::type() const {
+  return m_parameter->type;
+}
+
+int Parameter::componentCount() const {
+  return paramKindComponentCount(m_parameter->kind);
+}
+
 //--------------------------------------------------------
 
 class Attribute {
 public:
-  Attribute(OfxMeshAttributePropertySet *attribute = nullptr);
+  Attribute(OfxMeshAttributePropertySet *attribute = nullptr, const OfxMeshPropertySet *meshProperties = nullptr);
   MOVE_ONLY(Attribute)
 
   char* attachment() const;
@@ -82,12 +103,34 @@ public:
   char* type() const;
   void* data() const;
 
+  /**
+   * Number of elements of the attachment, i.e. of rows in data() unless the
+   * stride is 0, in which case a single value is shared by all of them.
+   */
+  int elementCount() const;
+
+  /**
+   * Size in bytes of a single component, 0 if the type is unknown.
+   */
+  int componentSize() const;
+
+  /**
+   * True if data() holds elementCount() * componentCount() tightly packed
+   * components, so that it can be viewed as a plain typed array.
+   */
+  bool isContiguous() const;
+
+  const OfxMeshAttributePropertySet* raw() const { return m_attribute; }
+  const OfxMeshPropertySet* meshProperties() const { return m_meshProperties; }
+
 private:
   OfxMeshAttributePropertySet *m_attribute;
+  const OfxMeshPropertySet *m_meshProperties;
 };
 
-Attribute::Attribute(OfxMeshAttributePropertySet *attribute)
+Attribute::Attribute(OfxMeshAttributePropertySet *attribute, const OfxMeshPropertySet *meshProperties)
   : m_attribute(attribute)
+  , m_meshProperties(meshProperties)
 {}
 
 char* Attribute::attachment() const {
@@ -115,6 +158,25 @@ void* Attribute::data() const {
   return m_attribute ? m_attribute->data : nullptr;
 }
 
+int Attribute::elementCount() const {
+  if (nullptr == m_attribute || nullptr == m_meshProperties) return 0;
+  return attributeElementCount(m_attribute, m_meshProperties);
+}
+
+int Attribute::componentSize() const {
+  return m_attribute ? static_cast<int>(attributeComponentSize(m_attribute->type)) : 0;
+}
+
+bool Attribute::isContiguous() const {
+  int size = componentSize();
+  return size > 0 && m_attribute->byte_stride == static_cast<size_t>(m_attribute->component_count * size);
+}
+
+OfxStatus AttributeStats::compute(const Attribute *attribute) {
+  if (nullptr == attribute || nullptr == attribute->raw() || nullptr == attribute->meshProperties()) return kOfxStatErrBadHandle;
+  return compute(attribute->raw(), attribute->meshProperties());
+}
+
 //--------------------------------------------------------
 
 class Input {
@@ -157,12 +219,64 @@ public:
   Attribute getAttribute(const char *attachment, const char *identifier) const;
   Attribute getAttributeByIndex(int attributeIndex) const;
 
+  /**
+   * Spreadsheet access (see MeshRows.h). Buffers are allocated by the caller
+   * in the wasm heap: out holds count * rowSize() doubles and order, if not
+   * null, holds the rowCount() element indices written by sortRows().
+   */
+  int rowSize(const char *attachment) const;
+  int rowCount(const char *attachment) const;
+  OfxStatus readRows(const char *attachment, int first, int count, void *out, const void *order = nullptr) const;
+  OfxStatus sortRows(const char *attachment, const char *identifier, int component, bool descending, void *order) const;
+
   /**
    * Load a mesh from a file, in which case this object points to a newly
    * allocated mesh that must be freed by calling unload().
    * If a file was already loaded, it is unloaded automatically.
+   * Options tell which optional layers to import, none by default.
+   */
+  OfxStatus loadObj(const char* filename, const ObjLoadOptions *options = nullptr);
+  /**
+   * Same as loadObj() but reading the file content from memory.
+   */
+  OfxStatus loadObjFromMemory(const void *data, int size, const ObjLoadOptions *options = nullptr);
+  /**
+   * Load a file progressively: call beginObj(), then feedObj() with the
+   * consecutive pieces of the file as they arrive, then endObj(). Each piece
+   * is parsed before feedObj() returns so that its buffer may be reused, and
+   * parsing overlaps with reading the next piece.
+   */
+  OfxStatus beginObj(const ObjLoadOptions *options = nullptr);
+  OfxStatus feedObj(const void *data, int size);
+  OfxStatus endObj();
+  /**
+   * Load a mesh saved with saveBinary(). Attributes point directly into the
+   * file content (memory mapped in native builds), which remains allocated
+   * until unload() is called.
+   */
+  OfxStatus loadBinary(const char* filename);
+  OfxStatus saveBinary(const char* filename) const;
+  /**
+   * Load the first mesh of a binary glTF file. Like for loadBinary(), most
+   * attributes point directly into the file content (copied once when
+   * loading from memory), which remains allocated until unload() is called.
+   */
+  OfxStatus loadGlb(const char* filename);
+  OfxStatus loadGlbFromMemory(const void *data, int size);
+  OfxStatus saveGlb(const char* filename) const;
+  /**
+   * Load a binary little endian PLY mesh or point cloud. Vertex properties
+   * are strided views into the file content whenever possible, which
+   * remains allocated until unload() is called.
    */
-  OfxStatus loadObj(const char* filename);
+  OfxStatus loadPly(const char* filename);
+  OfxStatus loadPlyFromMemory(const void *data, int size);
+  /**
+   * Exporters, which work whatever the layout of the attribute buffers
+   * (strided, shared, owned or not) and write through a large buffer.
+   */
+  OfxStatus saveObj(const char* filename) const;
+  OfxStatus savePly(const char* filename) const;
   /**
    * unload MUST be called when the mesh has been previously loaded from a mesh
    * and MUST NOT be called otherwise.
@@ -171,9 +285,15 @@ public:
 
   OfxMeshStruct* raw() const { return m_mesh; }
 
+private:
+  OfxStatus loadFromReader(ObjReader& reader);
+  OfxStatus loadFromBlob(std::unique_ptr<Blob> blob, OfxStatus (*load)(Blob&, OfxMeshStruct*));
+
 private:
   OfxMeshStruct *m_mesh;
   bool m_loaded; // tells whether the mesh has been allocated when loading it from a file
+  std::unique_ptr<ObjReader> m_objReader; // only set between beginObj() and endObj()
+  std::unique_ptr<Blob> m_blob; // backing storage of attributes that are not owned
 };
 
 Mesh::Mesh(OfxMeshStruct *mesh)
@@ -211,7 +331,7 @@ Attribute Mesh::getAttribute(const char *attachment, const char *identifier) con
   OfxMeshAttributePropertySet *attrib;
   OfxStatus status = meshGetAttribute(m_mesh, attachment, identifier, (OfxPropertySetHandle*)&attrib);
   if (kOfxStatOK == status) {
-    return Attribute(attrib);
+    return Attribute(attrib, &m_mesh->properties);
   } else {
     printf("Error: could not find the attribute %s for attachment %s!\n", identifier, attachment);
     return Attribute();
@@ -222,118 +342,171 @@ Attribute Mesh::getAttributeByIndex(int attributeIndex) const {
   OfxMeshAttributePropertySet *attrib;
   OfxStatus status = meshGetAttributeByIndex(m_mesh, attributeIndex, (OfxPropertySetHandle*)&attrib);
   if (kOfxStatOK == status) {
-    return Attribute(attrib);
+    return Attribute(attrib, &m_mesh->properties);
   } else {
     printf("Error: could not find the attribute #%d!\n", attributeIndex);
     return Attribute();
   }
 }
 
-OfxStatus Mesh::loadObj(const char* filename) {
+int Mesh::rowSize(const char *attachment) const {
+  if (nullptr == m_mesh) return -1;
+  return meshRowSize(m_mesh, attachment);
+}
+
+int Mesh::rowCount(const char *attachment) const {
+  if (nullptr == m_mesh) return 0;
+  return meshRowCount(m_mesh, attachment);
+}
+
+OfxStatus Mesh::readRows(const char *attachment, int first, int count, void *out, const void *order) const {
+  if (nullptr == m_mesh) return kOfxStatErrBadHandle;
+  return readMeshRows(m_mesh, attachment, first, count, static_cast<const int*>(order), static_cast<double*>(out));
+}
+
+OfxStatus Mesh::sortRows(const char *attachment, const char *identifier, int component, bool descending, void *order) const {
+  if (nullptr == m_mesh) return kOfxStatErrBadHandle;
+  return sortMeshRows(m_mesh, attachment, identifier, component, descending, static_cast<int*>(order));
+}
+
+OfxStatus Mesh::loadObj(const char* filename, const ObjLoadOptions *options) {
+  ObjReader reader(nullptr != options ? *options : ObjLoadOptions());
+  MFX_ENSURE(reader.readFile(filename));
+  return loadFromReader(reader);
+}
+
+OfxStatus Mesh::loadObjFromMemory(const void *data, int size, const ObjLoadOptions *options) {
+  ObjReader reader(nullptr != options ? *options : ObjLoadOptions());
+  reader.feed(static_cast<const char*>(data), static_cast<size_t>(size));
+  return loadFromReader(reader);
+}
+
+OfxStatus Mesh::beginObj(const ObjLoadOptions *options) {
+  m_objReader.reset(new ObjReader(nullptr != options ? *options : ObjLoadOptions()));
+  return kOfxStatOK;
+}
+
+OfxStatus Mesh::feedObj(const void *data, int size) {
+  if (!m_objReader) return kOfxStatErrBadHandle;
+  m_objReader->feed(static_cast<const char*>(data), static_cast<size_t>(size));
+  return kOfxStatOK;
+}
+
+OfxStatus Mesh::endObj() {
+  if (!m_objReader) return kOfxStatErrBadHandle;
+  std::unique_ptr<ObjReader> reader = std::move(m_objReader);
+  return loadFromReader(*reader);
+}
+
+OfxStatus Mesh::loadFromReader(ObjReader& reader) {
   if (m_loaded) unload();
 
-  tinyobj::attrib_t attrib;
-  std::vector<tinyobj::shape_t> shapes;
-  std::vector<tinyobj::material_t> materials;
-  std::string err;
-  bool triangulate = false;
-  const char *mtl_basedir = NULL;
-  bool status = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, mtl_basedir, triangulate);
-  if (!status) {
-    printf("Error: could not load OBJ file: %s\n", err.c_str());
+  m_mesh = new OfxMeshStruct();
+  meshInit(m_mesh);
+  m_loaded = true;
+
+  OfxStatus status = reader.finish(m_mesh);
+  if (kOfxStatOK != status) {
+    unload();
+    return status;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus Mesh::loadBinary(const char* filename) {
+  std::unique_ptr<Blob> blob = Blob::fromFile(filename);
+  if (!blob) {
+    printf("Error: could not read binary mesh file: %s\n", filename);
     return kOfxStatErrFatal;
   }
+  return loadFromBlob(std::move(blob), &loadBinaryMesh);
+}
 
-  m_mesh = new OfxMeshStruct();
-  meshInit(m_mesh);
+OfxStatus Mesh::loadGlb(const char* filename) {
+  std::unique_ptr<Blob> blob = Blob::fromFile(filename);
+  if (!blob) {
+    printf("Error: could not read GLB file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  return loadFromBlob(std::move(blob), &loadGlbMesh);
+}
 
-  int& pointCount = m_mesh->properties.point_count;
-  int& cornerCount = m_mesh->properties.corner_count;
-  int& faceCount = m_mesh->properties.face_count;
-  m_mesh->properties.constant_face_size = -1;
-
-  pointCount = (int)attrib.vertices.size();
-
-  cornerCount = 0;
-  faceCount = 0;
-  for (const auto& sh : shapes) {
-    cornerCount += (int)sh.mesh.indices.size();
-    faceCount += (int)sh.mesh.num_face_vertices.size();
-  }
-
-  // 1. Point Position
-  OfxMeshAttributePropertySet *pointPositionAttrib;
-  attributeDefine(m_mesh,
-                  kOfxMeshAttribPoint,
-                  kOfxMeshAttribPointPosition,
-                  3,
-                  kOfxMeshAttribTypeFloat,
-                  nullptr,
-                  (OfxPropertySetHandle*)&pointPositionAttrib);
-  
-  size_t buffsize = attrib.vertices.size() * sizeof(float);
-  pointPositionAttrib->data = new char[buffsize];
-  memcpy(pointPositionAttrib->data, attrib.vertices.data(), buffsize);
-  pointPositionAttrib->byte_stride = 3 * sizeof(float);
-  pointPositionAttrib->is_owner = true;
-
-  // 2. Corner Point
-  OfxMeshAttributePropertySet *cornerPointAttrib;
-  attributeDefine(m_mesh,
-                  kOfxMeshAttribCorner,
-                  kOfxMeshAttribCornerPoint,
-                  1,
-                  kOfxMeshAttribTypeInt,
-                  nullptr,
-                  (OfxPropertySetHandle*)&cornerPointAttrib);
-  
-  size_t indexSize = sizeof(tinyobj::index_t);
-  cornerPointAttrib->data = new char[cornerCount * indexSize];
-  cornerPointAttrib->byte_stride = indexSize;
-  cornerPointAttrib->is_owner = true;
-  size_t offset = 0;
-  for (const auto& sh : shapes) {
-    memcpy(cornerPointAttrib->data + offset * indexSize, sh.mesh.indices.data(), sh.mesh.indices.size() * indexSize);
-    offset += sh.mesh.indices.size();
-  }
-
-  // 3. Face Size
-  OfxMeshAttributePropertySet *faceSizeAttrib;
-  attributeDefine(m_mesh,
-                  kOfxMeshAttribFace,
-                  kOfxMeshAttribFaceSize,
-                  1,
-                  kOfxMeshAttribTypeInt,
-                  nullptr,
-                  (OfxPropertySetHandle*)&faceSizeAttrib);
-  
-  faceSizeAttrib->data = new char[faceCount * sizeof(int)];
-  faceSizeAttrib->byte_stride = sizeof(int);
-  faceSizeAttrib->is_owner = true;
-  offset = 0;
-  for (const auto& sh : shapes) {
-    for (unsigned char faceSize : sh.mesh.num_face_vertices) {
-      int *ptr = (int*)(faceSizeAttrib->data + offset * sizeof(int));
-      *ptr = (int)faceSize; // we convert because at the moment the backend does not support uint8 but in theory it should not be needed
-      ++offset;
-    }
+OfxStatus Mesh::loadGlbFromMemory(const void *data, int size) {
+  return loadFromBlob(Blob::fromMemory(data, static_cast<size_t>(size)), &loadGlbMesh);
+}
+
+OfxStatus Mesh::loadPly(const char* filename) {
+  std::unique_ptr<Blob> blob = Blob::fromFile(filename);
+  if (!blob) {
+    printf("Error: could not read PLY file: %s\n", filename);
+    return kOfxStatErrFatal;
+  }
+  return loadFromBlob(std::move(blob), &loadPlyMesh);
+}
+
+OfxStatus Mesh::loadPlyFromMemory(const void *data, int size) {
+  return loadFromBlob(Blob::fromMemory(data, static_cast<size_t>(size)), &loadPlyMesh);
+}
+
+OfxStatus Mesh::loadFromBlob(std::unique_ptr<Blob> blob, OfxStatus (*load)(Blob&, OfxMeshStruct*)) {
+  if (!blob) {
+    printf("Error: could not allocate memory for the mesh file\n");
+    return kOfxStatErrMemory;
   }
+  if (m_loaded) unload();
 
+  m_mesh = new OfxMeshStruct();
+  meshInit(m_mesh);
   m_loaded = true;
+  m_blob = std::move(blob);
+
+  OfxStatus status = load(*m_blob, m_mesh);
+  if (kOfxStatOK != status) {
+    unload();
+    return status;
+  }
   return kOfxStatOK;
 }
 
+OfxStatus Mesh::saveBinary(const char* filename) const {
+  if (nullptr == m_mesh) return kOfxStatErrBadHandle;
+  return saveBinaryMesh(filename, m_mesh);
+}
+
+OfxStatus Mesh::saveGlb(const char* filename) const {
+  if (nullptr == m_mesh) return kOfxStatErrBadHandle;
+  return saveGlbMesh(filename, m_mesh);
+}
+
+OfxStatus Mesh::saveObj(const char* filename) const {
+  if (nullptr == m_mesh) return kOfxStatErrBadHandle;
+  return saveObjMesh(filename, m_mesh);
+}
+
+OfxStatus Mesh::savePly(const char* filename) const {
+  if (nullptr == m_mesh) return kOfxStatErrBadHandle;
+  return savePlyMesh(filename, m_mesh);
+}
+
 OfxStatus Mesh::unload() {
   if (!m_loaded) return kOfxStatErrBadHandle;
   meshDestroy(m_mesh);
   delete m_mesh;
   m_mesh = nullptr;
+  m_blob.reset();
   m_loaded = false;
   return kOfxStatOK;
 }
 
 //--------------------------------------------------------
 
+OfxStatus RenderBuffers::update(const Mesh *mesh) {
+  if (nullptr == mesh || nullptr == mesh->raw()) return kOfxStatErrBadHandle;
+  return update(mesh->raw());
+}
+
+//--------------------------------------------------------
+
 class EffectDescriptor;
 
 class EffectInstance {
@@ -342,21 +515,77 @@ public:
   ~EffectInstance();
   MOVE_ONLY(EffectInstance)
 
+  // Typed setters, values are converted to the parameter's storage type
   OfxStatus setParameter(const char* identifier, double value);
+  OfxStatus setParameterInt(const char* identifier, int value);
+  OfxStatus setParameterBoolean(const char* identifier, bool value);
+  OfxStatus setParameter2d(const char* identifier, double x, double y);
+  OfxStatus setParameter3d(const char* identifier, double x, double y, double z);
+  OfxStatus setParameterRGB(const char* identifier, double r, double g, double b);
+  OfxStatus setParameterRGBA(const char* identifier, double r, double g, double b, double a);
+
+  /**
+   * Animate a parameter by setting a key, for cooking frame ranges (see
+   * FrameRangeCooker). Only the first components are used, depending on
+   * the parameter's type. Keys are interpolated linearly unless told
+   * otherwise with setParameterKeyInterpolation(), which takes an
+   * OfxParamInterpolation. cook() ignores keys.
+   */
+  OfxStatus setParameterKey(const char* identifier, double time, double x, double y, double z, double w);
+  OfxStatus setParameterKeyInterpolation(const char* identifier, double time, int interpolation);
+  OfxStatus clearParameterKeys(const char* identifier);
+
+  /**
+   * Status of the copy of the descriptor, if it is not kOfxStatOK the
+   * instance is unusable and cook() returns it.
+   */
+  OfxStatus status() const { return m_status; }
+
   OfxStatus cook();
 
-  // Warning: the mesh buffers must remain valid until cook() is called
+  // Warning: the mesh buffers must remain valid until cook() is called, and
+  // as long as outputs that forward its attributes are pinned
   OfxStatus setInputMesh(const char *identifier, const Mesh *mesh);
-  // Warning: the mesh is no longer valid after calling cook() again
-  Mesh getOutputMesh();
+
+  /**
+   * Number of output slots that successive cooks alternate between, 1 by
+   * default (see OutputSlots). getOutputMesh() pins the slot of the last
+   * output until releaseOutputMesh() is called, and cook() fails with
+   * kOfxStatFailed if all slots are pinned. The last output remains the
+   * same if cooking fails.
+   */
+  OfxStatus setOutputSlotCount(int count);
+  int outputSlotCount() const { return m_outputSlots.count(); }
+
+  Mesh* getOutputMesh();
+  OfxStatus releaseOutputMesh(const Mesh *mesh);
+
+  // For Graph and FrameRangeCooker only
+  const OfxPlugin* plugin() const { return m_plugin; }
+  OfxMeshEffectStruct* raw() { return &m_instance; }
+
+private:
+  struct OutputSlot {
+    OfxMeshStruct mesh;
+    Mesh handle; // returned by getOutputMesh(), so that JS keeps the same object
+    int pinCount = 0;
+
+    OutputSlot() : handle(&mesh) { meshInit(&mesh); }
+    ~OutputSlot() { meshDestroy(&mesh); }
+  };
 
 private:
   OfxParamStruct* findParameter(const char* identifier);
+  OfxStatus setParameterComponents(const char* identifier, const double *values, int count);
+  static void convertComponents(const OfxParamStruct *param, const double *values, int count, OfxParamValueStruct *converted);
+  OfxMeshInputStruct* findOutput();
 
 private:
   const OfxPlugin* m_plugin = nullptr;
   const OfxMeshEffectStruct* m_descriptor;
   OfxMeshEffectStruct m_instance;
+  OutputSlots<OutputSlot> m_outputSlots;
+  OfxStatus m_status;
 };
 
 //--------------------------------------------------------
@@ -397,7 +626,11 @@ EffectInstance::EffectInstance(const EffectDescriptor& descriptor)
   : m_descriptor(descriptor.raw())
   , m_plugin(descriptor.plugin())
 {
-  meshEffectCopy(&m_instance, m_descriptor);
+  meshEffectInit(&m_instance);
+  m_status = meshEffectCopy(&m_instance, m_descriptor);
+  if (kOfxStatOK != m_status) {
+    printf("Error: could not copy the parameters of the effect descriptor (%s)\n", ofxStatusName(m_status));
+  }
 }
 
 EffectInstance::~EffectInstance() {
@@ -405,23 +638,67 @@ EffectInstance::~EffectInstance() {
 }
 
 OfxStatus EffectInstance::setParameter(const char* identifier, double value) {
-  OfxParamStruct *param = findParameter(identifier);
-  if (nullptr == param) return kOfxStatErrBadHandle;
-  param->values[0].as_double = value;
-  return kOfxStatOK;
+  return setParameterComponents(identifier, &value, 1);
+}
+
+OfxStatus EffectInstance::setParameterInt(const char* identifier, int value) {
+  double values[] = { static_cast<double>(value) };
+  return setParameterComponents(identifier, values, 1);
+}
+
+OfxStatus EffectInstance::setParameterBoolean(const char* identifier, bool value) {
+  double values[] = { value ? 1.0 : 0.0 };
+  return setParameterComponents(identifier, values, 1);
+}
+
+OfxStatus EffectInstance::setParameter2d(const char* identifier, double x, double y) {
+  double values[] = { x, y };
+  return setParameterComponents(identifier, values, 2);
+}
+
+OfxStatus EffectInstance::setParameter3d(const char* identifier, double x, double y, double z) {
+  double values[] = { x, y, z };
+  return setParameterComponents(identifier, values, 3);
+}
+
+OfxStatus EffectInstance::setParameterRGB(const char* identifier, double r, double g, double b) {
+  double values[] = { r, g, b };
+  return setParameterComponents(identifier, values, 3);
+}
+
+OfxStatus EffectInstance::setParameterRGBA(const char* identifier, double r, double g, double b, double a) {
+  double values[] = { r, g, b, a };
+  return setParameterComponents(identifier, values, 4);
 }
 
 OfxStatus EffectInstance::cook() {
-  // Clear previous output
-  for (int i = 0 ; i < 16 && m_instance.inputs[i].is_valid ; ++i) {
-    OfxMeshInputStruct *input = &m_instance.inputs[i];
-    if (0 == strcmp(input->name, kOfxMeshMainOutput)) {
-      meshDestroy(&input->mesh);
-      meshInit(&input->mesh);
-    }
+  if (kOfxStatOK != m_status) return m_status;
+  OfxMeshInputStruct *output = findOutput();
+  if (nullptr == output) return kOfxStatErrBadHandle;
+
+  OutputSlot *slot = m_outputSlots.next();
+  if (nullptr == slot) {
+    printf("Error: all %d output slots are pinned, release some output meshes\n", outputSlotCount());
+    return kOfxStatFailed;
   }
 
-  MFX_ENSURE(m_plugin->mainEntry(kOfxMeshEffectActionCook, &m_instance, NULL, NULL));
+  // The plugin cooks into the output of the effect, and the slot is only
+  // recycled once the cook succeeded, so that the last output remains valid
+  // if it fails, even when it is in the very same slot.
+  meshDestroy(&output->mesh);
+  meshInit(&output->mesh);
+
+  OfxStatus status = m_plugin->mainEntry(kOfxMeshEffectActionCook, &m_instance, NULL, NULL);
+  // Some plugins reply with the "default" status once done (see Graph)
+  if (kOfxStatReplyDefault == status) status = kOfxStatOK;
+  if (kOfxStatOK != status) {
+    printf("Error: cook failed with status %d (%s)\n", status, ofxStatusName(status));
+    meshDestroy(&output->mesh);
+    meshInit(&output->mesh);
+    return status;
+  }
+
+  m_outputSlots.store(slot, &output->mesh);
   return kOfxStatOK;
 }
 
@@ -436,25 +713,113 @@ OfxStatus EffectInstance::setInputMesh(const char *identifier, const Mesh *mesh)
   return kOfxStatErrBadHandle;
 }
 
-Mesh EffectInstance::getOutputMesh() {
+OfxStatus EffectInstance::setOutputSlotCount(int count) {
+  OfxStatus status = m_outputSlots.setCount(count);
+  if (kOfxStatOK != status && count >= 1) {
+    printf("Warning: %d output slots are still in use\n", outputSlotCount());
+  }
+  return status;
+}
+
+Mesh* EffectInstance::getOutputMesh() {
+  return &m_outputSlots.pinLast()->handle;
+}
+
+OfxStatus EffectInstance::releaseOutputMesh(const Mesh *mesh) {
+  return m_outputSlots.release(m_outputSlots.find([mesh](const OutputSlot& slot) { return &slot.handle == mesh; }));
+}
+
+OfxMeshInputStruct* EffectInstance::findOutput() {
   for (int i = 0 ; i < 16 && m_instance.inputs[i].is_valid ; ++i) {
     OfxMeshInputStruct *input = &m_instance.inputs[i];
-    if (0 == strcmp(input->name, kOfxMeshMainOutput)) {
-      return Mesh(&input->mesh);
-    }
+    if (0 == strcmp(input->name, kOfxMeshMainOutput)) return input;
   }
-  return Mesh();
+  return nullptr;
 }
 
 OfxParamStruct* EffectInstance::findParameter(const char* identifier) {
-  auto& parameters = m_instance.parameters.entries;
-  for (int i = 0 ; i < 16 && parameters[i].is_valid ; ++i) {
-    OfxParamStruct* param = &parameters[i];
-    if (0 == strncmp(identifier, param->name, 64)) {
-      return param;
+  int index = parameterSetFind(&m_instance.parameters, identifier);
+  return index != -1 ? m_instance.parameters.entries[index] : nullptr;
+}
+
+OfxStatus EffectInstance::setParameterComponents(const char* identifier, const double *values, int count) {
+  OfxParamStruct *param = findParameter(identifier);
+  if (nullptr == param) return kOfxStatErrBadHandle;
+  if (count != paramKindComponentCount(param->kind)) return kOfxStatErrBadIndex;
+  convertComponents(param, values, count, param->values);
+  return kOfxStatOK;
+}
+
+void EffectInstance::convertComponents(const OfxParamStruct *param, const double *values, int count, OfxParamValueStruct *converted) {
+  bool isIntegral = paramKindIsIntegral(param->kind);
+  for (int i = 0 ; i < count ; ++i) {
+    if (isIntegral) {
+      converted[i].as_int = static_cast<int>(values[i]);
+    } else {
+      converted[i].as_double = values[i];
     }
   }
-  return nullptr;
+}
+
+OfxStatus EffectInstance::setParameterKey(const char* identifier, double time, double x, double y, double z, double w) {
+  OfxParamStruct *param = findParameter(identifier);
+  if (nullptr == param) return kOfxStatErrBadHandle;
+  int count = paramKindComponentCount(param->kind);
+  if (0 == count) return kOfxStatErrUnsupported;
+  double values[] = { x, y, z, w };
+  OfxParamValueStruct converted[4] = {};
+  convertComponents(param, values, count, converted);
+  int index = paramFindKey(param, time, 0);
+  OfxParamInterpolation interpolation = -1 != index ? param->keys[index].interpolation : PARAM_INTERPOLATION_LINEAR;
+  return paramInsertKey(param, time, converted, interpolation);
+}
+
+OfxStatus EffectInstance::setParameterKeyInterpolation(const char* identifier, double time, int interpolation) {
+  OfxParamStruct *param = findParameter(identifier);
+  if (nullptr == param) return kOfxStatErrBadHandle;
+  if (interpolation < PARAM_INTERPOLATION_CONSTANT || interpolation > PARAM_INTERPOLATION_CUBIC) return kOfxStatErrValue;
+  int index = paramFindKey(param, time, 0);
+  if (-1 == index) return kOfxStatErrBadIndex;
+  const OfxParamKeyStruct& key = param->keys[index];
+  return paramInsertKey(param, key.time, key.values, static_cast<OfxParamInterpolation>(interpolation));
+}
+
+OfxStatus EffectInstance::clearParameterKeys(const char* identifier) {
+  OfxParamStruct *param = findParameter(identifier);
+  if (nullptr == param) return kOfxStatErrBadHandle;
+  paramClearKeys(param);
+  return kOfxStatOK;
+}
+
+//--------------------------------------------------------
+
+int Graph::addNode(EffectInstance *instance) {
+  if (nullptr == instance) return -1;
+  return addNode(instance->plugin(), instance->raw());
+}
+
+OfxStatus Graph::setInputMesh(int node, const char *inputName, const Mesh *mesh) {
+  if (nullptr == mesh) return kOfxStatErrBadHandle;
+  return setInputMesh(node, inputName, mesh->raw());
+}
+
+Mesh Graph::getOutputMesh(int node) const {
+  return Mesh(const_cast<OfxMeshStruct*>(outputMesh(node)));
+}
+
+//--------------------------------------------------------
+
+FrameRangeCooker::FrameRangeCooker(EffectInstance *instance)
+  : FrameRangeCooker(instance->plugin(), instance->raw())
+{}
+
+OfxStatus FrameRangeCooker::setInputSample(const char *inputName, double time, const Mesh *mesh) {
+  if (nullptr == mesh) return kOfxStatErrBadHandle;
+  return setInputSample(inputName, time, mesh->raw());
+}
+
+Mesh MemoryFrameSink::getFrameMesh(int frame) const {
+  return Mesh(const_cast<OfxMeshStruct*>(frameMesh(frame)));
 }
 
 //--------------------------------------------------------
@@ -493,15 +858,11 @@ OfxStatus EffectDescriptor::unload() {
 
 int EffectDescriptor::getParameterCount() const {
   assert(m_loaded);
-  int count = 0;
-  for (int i = 0 ; i < 16 && m_descriptor.parameters.entries[i].is_valid ; ++i) {
-    ++count;
-  }
-  return count;
+  return m_descriptor.parameters.count;
 }
 
 Parameter EffectDescriptor::getParameter(int parameterIndex) const {
-  return Parameter(&m_descriptor.parameters.entries[parameterIndex]);
+  return Parameter(m_descriptor.parameters.entries[parameterIndex]);
 }
 
 int EffectDescriptor::getInputCount() const {
@@ -535,7 +896,7 @@ public:
   const EffectDescriptor* getEffectDescriptor(int effectIndex) const;
 
 private:
-  void* m_handle;
+  void* m_handle = nullptr;
   std::vector<EffectDescriptor> m_effectDescriptors;
 };
 
@@ -711,8 +1072,8 @@ extern "C" int test(test_return_t* ret) {
   MFX_CHECK(plugin->mainEntry(kOfxActionDescribe, &descriptor, NULL, NULL));
 
   printf("Parameters:\n");
-  for (int i = 0 ; descriptor.parameters.entries[i].is_valid ; ++i) {
-    const OfxParamHandle param = &descriptor.parameters.entries[i];
+  for (int i = 0 ; i < descriptor.parameters.count ; ++i) {
+    const OfxParamHandle param = descriptor.parameters.entries[i];
     printf(" - %s (%s)\n", param->name, param->type);
   }
   printf("Inputs:\n");
@@ -722,7 +1083,8 @@ extern "C" int test(test_return_t* ret) {
   }
 
   OfxMeshEffectStruct instance;
-  meshEffectCopy(&instance, &descriptor);
+  meshEffectInit(&instance);
+  MFX_CHECK(meshEffectCopy(&instance, &descriptor));
   printf("(CreateInstance)\n");
   MFX_CHECK(plugin->mainEntry(kOfxActionCreateInstance, &instance, NULL, NULL));
 
@@ -0,0 +1,102 @@
+#include "TestHarness.h"
+
+#include "AttributeStats.h"
+
+#include <ofxMeshEffect.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+/**
+ * Point attribute over data that the test owns.
+ */
+static OfxMeshAttributePropertySet pointAttribute(const char *type, int componentCount, void *data, size_t byteStride) {
+  OfxMeshAttributePropertySet attrib;
+  attributeInit(&attrib);
+  attrib.is_valid = 1;
+  strcpy(attrib.attachment, kOfxMeshAttribPoint);
+  strcpy(attrib.name, "values");
+  strcpy(attrib.type, type);
+  strcpy(attrib.semantic, "");
+  attrib.component_count = componentCount;
+  attrib.data = static_cast<char*>(data);
+  attrib.byte_stride = byteStride;
+  attrib.is_owner = 0;
+  return attrib;
+}
+
+TEST(attributeStats, floats) {
+  // Several blocks of float2 values interleaved with another float
+  const int count = 200001;
+  std::vector<float> data(3 * count);
+  for (int i = 0 ; i < count ; ++i) {
+    data[3 * i] = static_cast<float>(i % 1000) - 500.0f;
+    data[3 * i + 1] = 0.5f;
+    data[3 * i + 2] = 1234.0f; // not part of the attribute
+  }
+  data[3 * 7] = std::numeric_limits<float>::quiet_NaN();
+  data[3 * 150000] = std::numeric_limits<float>::infinity();
+  data[3 * 150001] = -std::numeric_limits<float>::infinity();
+  data[3 * (count - 1) + 1] = -2.0f;
+
+  double sum = 0;
+  int finiteCount = 0;
+  for (int i = 0 ; i < count ; ++i) {
+    if (std::isfinite(data[3 * i])) {
+      sum += data[3 * i];
+      ++finiteCount;
+    }
+  }
+
+  OfxMeshPropertySet props = {};
+  props.point_count = count;
+  OfxMeshAttributePropertySet attrib = pointAttribute(kOfxMeshAttribTypeFloat, 2, data.data(), 3 * sizeof(float));
+  AttributeStats stats;
+  CHECK_OK(stats.compute(&attrib, &props));
+  CHECK(stats.componentCount() == 2);
+  CHECK(stats.min(0) == -500.0 && stats.max(0) == 499.0);
+  CHECK(stats.finiteCount(0) == finiteCount);
+  CHECK(std::fabs(stats.mean(0) - sum / finiteCount) < 1e-3);
+  CHECK(stats.nanCount(0) == 1 && stats.infCount(0) == 2);
+  CHECK(stats.min(1) == -2.0 && stats.max(1) == 0.5);
+  CHECK(stats.nanCount(1) == 0 && stats.infCount(1) == 0);
+
+  // Without finite values, the range and mean are NaN
+  float nan = std::numeric_limits<float>::quiet_NaN();
+  props.point_count = 1;
+  OfxMeshAttributePropertySet nanAttrib = pointAttribute(kOfxMeshAttribTypeFloat, 1, &nan, sizeof(float));
+  CHECK_OK(stats.compute(&nanAttrib, &props));
+  CHECK(std::isnan(stats.min(0)) && std::isnan(stats.mean(0)) && stats.finiteCount(0) == 0);
+}
+
+TEST(attributeStats, integers) {
+  // Ints beyond the precision of floats are exact
+  int ints[3] = { 16777217, -3, 16777219 };
+  OfxMeshPropertySet props = {};
+  props.point_count = 3;
+  OfxMeshAttributePropertySet attrib = pointAttribute(kOfxMeshAttribTypeInt, 1, ints, sizeof(int));
+  AttributeStats stats;
+  CHECK_OK(stats.compute(&attrib, &props));
+  CHECK(stats.min(0) == -3 && stats.max(0) == 16777219);
+  CHECK(stats.mean(0) == (16777217.0 - 3.0 + 16777219.0) / 3);
+
+  // A value shared by all elements
+  unsigned char shared[2] = { 7, 200 };
+  props.point_count = 1000;
+  OfxMeshAttributePropertySet sharedAttrib = pointAttribute(kOfxMeshAttribTypeUByte, 2, shared, 0);
+  CHECK_OK(stats.compute(&sharedAttrib, &props));
+  CHECK(stats.min(1) == 200 && stats.max(1) == 200 && stats.finiteCount(1) == 1000);
+
+  // Constant face sizes have no data
+  OfxMeshAttributePropertySet faceSize = pointAttribute(kOfxMeshAttribTypeInt, 1, nullptr, sizeof(int));
+  strcpy(faceSize.attachment, kOfxMeshAttribFace);
+  strcpy(faceSize.name, kOfxMeshAttribFaceSize);
+  props.face_count = 10;
+  props.constant_face_size = 4;
+  CHECK_OK(stats.compute(&faceSize, &props));
+  CHECK(stats.min(0) == 4 && stats.max(0) == 4 && stats.mean(0) == 4);
+  props.constant_face_size = -1;
+  CHECK(kOfxStatErrBadHandle == stats.compute(&faceSize, &props));
+}
@@ -0,0 +1,341 @@
+#include "TestHarness.h"
+
+#include "ObjReader.h"
+#include "ObjWriter.h"
+#include "GltfFormat.h"
+#include "PlyFormat.h"
+#include "BinaryMeshFormat.h"
+#include "Blob.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Square pyramid, whose faces are a quad and 4 triangles
+static const char *pyramidObj =
+  "v 0 0 0\n"
+  "v 1 0 0\n"
+  "v 1 1 0\n"
+  "v 0 1 0\n"
+  "v 0.5 0.5 1\n"
+  "vt 0 0\n"
+  "vt 1 0\n"
+  "vt 1 1\n"
+  "vt 0 1\n"
+  "vt 0.5 0.5\n"
+  "f 1/1 4/4 3/3 2/2\n"
+  "f 1/1 2/2 5/5\n"
+  "f 2/2 3/3 5/5\n"
+  "f 3/3 4/4 5/5\n"
+  "f 4/4 1/1 5/5\n";
+
+static OfxStatus loadPyramid(OfxMeshStruct *mesh, bool texCoords) {
+  ObjLoadOptions options;
+  options.texCoords = texCoords;
+  ObjReader reader(options);
+  reader.feed(pyramidObj, strlen(pyramidObj));
+  return reader.finish(mesh);
+}
+
+static bool samePositions(const OfxMeshStruct *a, const OfxMeshStruct *b) {
+  if (a->properties.point_count != b->properties.point_count) return false;
+  auto positionsA = mfx::makeAttributeView<float, 3>(a, findAttribute(a, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+  auto positionsB = mfx::makeAttributeView<float, 3>(b, findAttribute(b, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+  if (!positionsA.isValid() || !positionsB.isValid()) return false;
+  for (int i = 0 ; i < a->properties.point_count ; ++i) {
+    for (int k = 0 ; k < 3 ; ++k) {
+      if (positionsA.get(i, k) != positionsB.get(i, k)) return false;
+    }
+  }
+  return true;
+}
+
+static bool sameTopology(const OfxMeshStruct *a, const OfxMeshStruct *b) {
+  if (a->properties.corner_count != b->properties.corner_count || a->properties.face_count != b->properties.face_count) return false;
+  auto cornerPointsA = mfx::makeAttributeView<int, 1>(a, findAttribute(a, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  auto cornerPointsB = mfx::makeAttributeView<int, 1>(b, findAttribute(b, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  auto faceSizesA = mfx::makeFaceSizeView(a);
+  auto faceSizesB = mfx::makeFaceSizeView(b);
+  if (!cornerPointsA.isValid() || !cornerPointsB.isValid() || !faceSizesA.isValid() || !faceSizesB.isValid()) return false;
+  for (int i = 0 ; i < a->properties.corner_count ; ++i) {
+    if (cornerPointsA.get(i) != cornerPointsB.get(i)) return false;
+  }
+  for (int i = 0 ; i < a->properties.face_count ; ++i) {
+    if (faceSizesA.get(i) != faceSizesB.get(i)) return false;
+  }
+  return true;
+}
+
+TEST(formats, binary) {
+  TestMesh mesh, loaded;
+  CHECK_OK(loadPyramid(&mesh.raw, true));
+  CHECK_OK(saveBinaryMesh("pyramid.wmfx", &mesh.raw));
+  std::unique_ptr<Blob> blob = Blob::fromFile("pyramid.wmfx");
+  CHECK(nullptr != blob);
+  CHECK_OK(loadBinaryMesh(*blob, &loaded.raw));
+  CHECK(samePositions(&mesh.raw, &loaded.raw));
+  CHECK(sameTopology(&mesh.raw, &loaded.raw));
+
+  // All attributes are kept as is, pointing into the blob
+  for (const OfxMeshAttributePropertySet& attrib : mesh.raw.attributes) {
+    if (!attrib.is_valid) break;
+    if (nullptr == attrib.data) continue;
+    const OfxMeshAttributePropertySet *loadedAttrib = findAttribute(&loaded.raw, attrib.attachment, attrib.name);
+    CHECK(nullptr != loadedAttrib);
+    CHECK(0 == strcmp(attrib.type, loadedAttrib->type));
+    CHECK(0 == strcmp(attrib.semantic, loadedAttrib->semantic));
+    CHECK(attrib.component_count == loadedAttrib->component_count);
+    CHECK(!loadedAttrib->is_owner);
+    CHECK(static_cast<char*>(loadedAttrib->data) >= blob->data() && static_cast<char*>(loadedAttrib->data) < blob->data() + blob->size());
+    size_t elementSize = attrib.component_count * attributeComponentSize(attrib.type);
+    auto elements = mfx::makeByteView(&mesh.raw, &attrib);
+    auto loadedElements = mfx::makeByteView(&loaded.raw, loadedAttrib);
+    for (size_t k = 0 ; k < elements.size() ; ++k) {
+      CHECK(0 == memcmp(elements.bytes(k), loadedElements.bytes(k), elementSize));
+    }
+  }
+}
+
+TEST(formats, binaryErrors) {
+  TestMesh mesh;
+  CHECK_OK(loadPyramid(&mesh.raw, false));
+  CHECK_OK(saveBinaryMesh("pyramid.wmfx", &mesh.raw));
+  std::unique_ptr<Blob> blob = Blob::fromFile("pyramid.wmfx");
+  CHECK(nullptr != blob);
+  std::string file(blob->data(), blob->size());
+
+  // Truncated payloads and headers are rejected rather than read past the
+  // end of the blob
+  for (size_t size : { file.size() - 1, sizeof(BinaryMeshHeader) + sizeof(BinaryMeshAttribute) / 2, size_t(8) }) {
+    TestMesh truncated;
+    std::unique_ptr<Blob> part = Blob::fromMemory(file.data(), size);
+    CHECK(nullptr != part);
+    CHECK(kOfxStatErrFormat == loadBinaryMesh(*part, &truncated.raw));
+  }
+
+  std::string wrongMagic = file;
+  wrongMagic[0] = 'X';
+  TestMesh other;
+  std::unique_ptr<Blob> part = Blob::fromMemory(wrongMagic.data(), wrongMagic.size());
+  CHECK(kOfxStatErrFormat == loadBinaryMesh(*part, &other.raw));
+}
+
+TEST(formats, obj) {
+  TestMesh mesh, loaded;
+  CHECK_OK(loadPyramid(&mesh.raw, true));
+  CHECK(mesh.raw.properties.point_count == 5);
+  CHECK(mesh.raw.properties.corner_count == 16);
+  CHECK(mesh.raw.properties.face_count == 5);
+
+  CHECK_OK(saveObjMesh("pyramid.obj", &mesh.raw));
+  ObjLoadOptions options;
+  options.texCoords = true;
+  ObjReader reader(options);
+  CHECK_OK(reader.readFile("pyramid.obj"));
+  CHECK_OK(reader.finish(&loaded.raw));
+  CHECK(samePositions(&mesh.raw, &loaded.raw));
+  CHECK(sameTopology(&mesh.raw, &loaded.raw));
+
+  auto texCoords = mfx::makeAttributeView<float, 2>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribCorner, "uv"));
+  auto loadedTexCoords = mfx::makeAttributeView<float, 2>(&loaded.raw, findAttribute(&loaded.raw, kOfxMeshAttribCorner, "uv"));
+  CHECK(texCoords.isValid() && loadedTexCoords.isValid());
+  for (int i = 0 ; i < mesh.raw.properties.corner_count ; ++i) {
+    CHECK(texCoords.get(i, 0) == loadedTexCoords.get(i, 0));
+    CHECK(texCoords.get(i, 1) == loadedTexCoords.get(i, 1));
+  }
+}
+
+template <typename T>
+static void appendValue(std::string& data, T value) {
+  data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Binary PLY file of a quad split into two triangles, whose vertex records
+ * of 19 bytes are never aligned.
+ */
+static std::string quadPly() {
+  std::string ply =
+    "ply\n"
+    "format binary_little_endian 1.0\n"
+    "comment any header length\n"
+    "element vertex 4\n"
+    "property float x\n"
+    "property float y\n"
+    "property float z\n"
+    "property uchar red\n"
+    "property uchar green\n"
+    "property uchar blue\n"
+    "property float intensity\n"
+    "element face 2\n"
+    "property list uchar int vertex_indices\n"
+    "end_header\n";
+  for (int i = 0 ; i < 4 ; ++i) {
+    appendValue<float>(ply, static_cast<float>(i % 2));
+    appendValue<float>(ply, static_cast<float>(i / 2));
+    appendValue<float>(ply, 0.5f);
+    appendValue<uint8_t>(ply, static_cast<uint8_t>(10 * i));
+    appendValue<uint8_t>(ply, 255);
+    appendValue<uint8_t>(ply, 0);
+    appendValue<float>(ply, 0.25f * i);
+  }
+  for (int face = 0 ; face < 2 ; ++face) {
+    appendValue<uint8_t>(ply, 3);
+    for (int index : { 0, face + 1, face + 2 }) appendValue<int32_t>(ply, index);
+  }
+  return ply;
+}
+
+TEST(formats, ply) {
+  std::string ply = quadPly();
+  std::unique_ptr<Blob> blob = Blob::fromMemory(ply.data(), ply.size());
+  CHECK(nullptr != blob);
+  TestMesh mesh;
+  CHECK_OK(loadPlyMesh(*blob, &mesh.raw));
+  CHECK(mesh.raw.properties.point_count == 4);
+  CHECK(mesh.raw.properties.face_count == 2);
+  CHECK(mesh.raw.properties.constant_face_size == 3);
+
+  // Vertex properties are grouped into point attributes viewing the records
+  const OfxMeshAttributePropertySet *position = findAttribute(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition);
+  CHECK(nullptr != position && !position->is_owner);
+  auto positions = mfx::makeAttributeView<float, 3>(&mesh.raw, position);
+  auto colors = mfx::makeAttributeView<unsigned char, 3>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribPoint, "color"));
+  auto intensities = mfx::makeAttributeView<float, 1>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribPoint, "intensity"));
+  CHECK(positions.isValid() && colors.isValid() && intensities.isValid());
+  for (int i = 0 ; i < 4 ; ++i) {
+    CHECK(positions.get(i, 0) == i % 2 && positions.get(i, 1) == i / 2 && positions.get(i, 2) == 0.5f);
+    CHECK(colors.get(i, 0) == 10 * i && colors.get(i, 1) == 255 && colors.get(i, 2) == 0);
+    CHECK(intensities.get(i) == 0.25f * i);
+  }
+  CHECK(0 == strcmp(findAttribute(&mesh.raw, kOfxMeshAttribPoint, "color")->semantic, kOfxMeshAttribSemanticColor));
+
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  const int expectedCornerPoints[6] = { 0, 1, 2, 0, 2, 3 };
+  for (int i = 0 ; i < 6 ; ++i) {
+    CHECK(cornerPoints.get(i) == expectedCornerPoints[i]);
+  }
+}
+
+TEST(formats, plyErrors) {
+  std::string ply = quadPly();
+  std::string ascii = ply;
+  ascii.replace(ascii.find("binary_little_endian"), strlen("binary_little_endian"), "ascii");
+  std::string badIndex = ply;
+  badIndex[badIndex.size() - 4] = 4; // last corner of the last face
+  for (const std::string& file : { ply.substr(0, ply.size() - 1), ascii, badIndex, std::string("ply\n") }) {
+    std::unique_ptr<Blob> blob = Blob::fromMemory(file.data(), file.size());
+    CHECK(nullptr != blob);
+    TestMesh mesh;
+    CHECK(kOfxStatErrFormat == loadPlyMesh(*blob, &mesh.raw));
+  }
+}
+
+TEST(formats, plyExport) {
+  TestMesh mesh, loaded;
+  CHECK_OK(loadPyramid(&mesh.raw, false));
+  CHECK_OK(savePlyMesh("pyramid.ply", &mesh.raw));
+  std::unique_ptr<Blob> blob = Blob::fromFile("pyramid.ply");
+  CHECK(nullptr != blob);
+  CHECK_OK(loadPlyMesh(*blob, &loaded.raw));
+  CHECK(samePositions(&mesh.raw, &loaded.raw));
+  CHECK(sameTopology(&mesh.raw, &loaded.raw));
+
+  // Other point attributes are written as vertex properties
+  std::string ply = quadPly();
+  std::unique_ptr<Blob> quadBlob = Blob::fromMemory(ply.data(), ply.size());
+  TestMesh quad, loadedQuad;
+  CHECK_OK(loadPlyMesh(*quadBlob, &quad.raw));
+  CHECK_OK(savePlyMesh("quad.ply", &quad.raw));
+  std::unique_ptr<Blob> loadedQuadBlob = Blob::fromFile("quad.ply");
+  CHECK(nullptr != loadedQuadBlob);
+  CHECK_OK(loadPlyMesh(*loadedQuadBlob, &loadedQuad.raw));
+  CHECK(samePositions(&quad.raw, &loadedQuad.raw));
+  CHECK(sameTopology(&quad.raw, &loadedQuad.raw));
+  auto colors = mfx::makeAttributeView<unsigned char, 3>(&loadedQuad.raw, findAttribute(&loadedQuad.raw, kOfxMeshAttribPoint, "color"));
+  auto intensities = mfx::makeAttributeView<float, 1>(&loadedQuad.raw, findAttribute(&loadedQuad.raw, kOfxMeshAttribPoint, "intensity"));
+  CHECK(colors.isValid() && intensities.isValid());
+  for (int i = 0 ; i < 4 ; ++i) {
+    CHECK(colors.get(i, 0) == 10 * i && colors.get(i, 1) == 255);
+    CHECK(intensities.get(i) == 0.25f * i);
+  }
+}
+
+TEST(formats, glb) {
+  TestMesh mesh, loaded;
+  CHECK_OK(loadPyramid(&mesh.raw, false));
+  CHECK_OK(saveGlbMesh("pyramid.glb", &mesh.raw));
+  std::unique_ptr<Blob> blob = Blob::fromFile("pyramid.glb");
+  CHECK(nullptr != blob);
+  CHECK_OK(loadGlbMesh(*blob, &loaded.raw));
+
+  // Without corner attributes, points are kept and faces become fans of
+  // triangles
+  CHECK(samePositions(&mesh.raw, &loaded.raw));
+  CHECK(loaded.raw.properties.face_count == 2 + 4);
+  CHECK(loaded.raw.properties.corner_count == 3 * loaded.raw.properties.face_count);
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  auto faceSizes = mfx::makeFaceSizeView(&mesh.raw);
+  auto loadedCornerPoints = mfx::makeAttributeView<int, 1>(&loaded.raw, findAttribute(&loaded.raw, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  CHECK(loadedCornerPoints.isValid());
+  int corner = 0, triangleCorner = 0;
+  for (int face = 0 ; face < mesh.raw.properties.face_count ; ++face) {
+    int faceSize = faceSizes.get(face);
+    for (int k = 2 ; k < faceSize ; ++k) {
+      CHECK(loadedCornerPoints.get(triangleCorner++) == cornerPoints.get(corner));
+      CHECK(loadedCornerPoints.get(triangleCorner++) == cornerPoints.get(corner + k - 1));
+      CHECK(loadedCornerPoints.get(triangleCorner++) == cornerPoints.get(corner + k));
+    }
+    corner += faceSize;
+  }
+}
+
+/**
+ * Replace the first occurrence of from by to in the JSON chunk of a GLB
+ * file, fixing up the chunk and file lengths.
+ */
+static std::string patchGlbJson(const std::string& glb, const std::string& from, const std::string& to) {
+  uint32_t jsonLength;
+  memcpy(&jsonLength, glb.data() + 12, sizeof(jsonLength));
+  std::string json = glb.substr(20, jsonLength);
+  std::string binChunk = glb.substr(20 + jsonLength);
+  size_t position = json.find(from);
+  if (position != std::string::npos) json.replace(position, from.size(), to);
+  while (json.size() % 4 != 0) json += ' ';
+
+  uint32_t lengths[2] = { static_cast<uint32_t>(20 + json.size() + binChunk.size()), static_cast<uint32_t>(json.size()) };
+  std::string patched = glb.substr(0, 8); // magic and version
+  patched.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+  patched.append(glb, 16, 4); // chunk type
+  return patched + json + binChunk;
+}
+
+TEST(formats, glbByteStride) {
+  TestMesh mesh;
+  CHECK_OK(loadPyramid(&mesh.raw, false));
+  CHECK_OK(saveGlbMesh("pyramid.glb", &mesh.raw));
+  std::unique_ptr<Blob> blob = Blob::fromFile("pyramid.glb");
+  CHECK(nullptr != blob);
+  std::string glb(blob->data(), blob->size());
+  CHECK(std::string::npos != glb.find("\"byteStride\":12,"));
+
+  // Changing the JSON chunk alone keeps the file valid
+  {
+    TestMesh loaded;
+    std::string patchedGlb = patchGlbJson(glb, "\"byteStride\":12,", "\"byteStride\": 12.0,");
+    std::unique_ptr<Blob> patched = Blob::fromMemory(patchedGlb.data(), patchedGlb.size());
+    CHECK_OK(loadGlbMesh(*patched, &loaded.raw));
+  }
+
+  // Strides must be integers multiple of 4 in [4, 252]
+  for (const char *stride : { "13", "-12", "12.5", "256", "\"12\"", "0" }) {
+    std::string patchedGlb = patchGlbJson(glb, "\"byteStride\":12,", std::string("\"byteStride\":") + stride + ",");
+    std::unique_ptr<Blob> patched = Blob::fromMemory(patchedGlb.data(), patchedGlb.size());
+    CHECK(nullptr != patched);
+    TestMesh loaded;
+    CHECK(kOfxStatErrFormat == loadGlbMesh(*patched, &loaded.raw));
+  }
+}
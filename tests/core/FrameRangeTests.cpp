@@ -0,0 +1,106 @@
+#include "TestHarness.h"
+
+#include "FrameRange.h"
+
+extern "C" {
+#include <host/parameterSuite.h>
+}
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cmath>
+
+/**
+ * Component of the position of a point of a frame, NaN if the frame was
+ * not written.
+ */
+static float framePosition(const MemoryFrameSink& sink, int frame, int point, int component) {
+  const OfxMeshStruct *mesh = sink.frameMesh(frame);
+  if (nullptr == mesh) return NAN;
+  auto positions = mfx::makeAttributeView<float, 3>(mesh, findAttribute(mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+  return positions.isValid() ? positions.get(point, component) : NAN;
+}
+
+TEST(frames, keyedParameters) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  CHECK(box.isValid());
+  std::unique_ptr<TestInstance> instance = box.instantiate();
+  CHECK(nullptr != instance);
+  CHECK_OK(instance->setDouble("width", 1));
+  CHECK_OK(instance->setDouble("height", 1));
+  CHECK_OK(instance->setDouble("depth", 1));
+  OfxParamHandle width = instance->param("width");
+  CHECK_OK(paramSetValueAtTime(width, 0.0, 2.0));
+  CHECK_OK(paramSetValueAtTime(width, 10.0, 4.0));
+
+  // The width goes linearly from 2 to 4, so that point 7 at (+w/2, +h/2,
+  // +d/2) has x = 1 + 0.1 t, and the height is not animated
+  FrameRangeCooker cooker(box.plugin(), &instance->raw);
+  MemoryFrameSink sink;
+  CHECK_OK(cooker.cookRange(0, 10, 1, &sink));
+  CHECK(sink.frameCount() == 11);
+  CHECK(cooker.cookedFrameCount() == 11);
+  for (int frame = 0 ; frame < sink.frameCount() ; ++frame) {
+    CHECK(sink.frameTime(frame) == frame);
+    CHECK(std::fabs(framePosition(sink, frame, 7, 0) - (1.0f + 0.1f * frame)) < 1e-5f);
+    CHECK(framePosition(sink, frame, 7, 1) == 0.5f);
+  }
+
+  // Nothing changed
+  CHECK_OK(cooker.cookRange(0, 10, 1, &sink));
+  CHECK(cooker.cookedFrameCount() == 0);
+  CHECK(cooker.reusedFrameCount() == 11);
+
+  // Moving the last key changes all frames but the first one
+  CHECK_OK(paramSetValueAtTime(width, 10.0, 6.0));
+  CHECK_OK(cooker.cookRange(0, 10, 1, &sink));
+  CHECK(cooker.cookedFrameCount() == 10);
+  CHECK(cooker.reusedFrameCount() == 1);
+  CHECK(std::fabs(framePosition(sink, 5, 7, 0) - 2.0f) < 1e-5f);
+
+  // Frames written to files
+  FileFrameSink files("frame%02d.wmfx");
+  CHECK_OK(cooker.cookRange(0, 1, 0.5, &files));
+  FileFrameSink badPattern("frame%s.wmfx");
+  CHECK(kOfxStatOK != cooker.cookRange(0, 1, 0.5, &badPattern));
+
+  cooker.setCaching(false);
+  CHECK_OK(cooker.cookRange(0, 10, 1, &sink));
+  CHECK(cooker.cookedFrameCount() == 11);
+}
+
+TEST(frames, inputSamples) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  std::unique_ptr<TestInstance> source = box.instantiate();
+  std::unique_ptr<TestInstance> shading = normals.instantiate();
+  CHECK(nullptr != source && nullptr != shading);
+  CHECK_OK(source->setDouble("width", 1));
+  CHECK_OK(source->setDouble("height", 1));
+  CHECK_OK(source->setDouble("depth", 1));
+  CHECK_OK(paramSetValueAtTime(source->param("width"), 0.0, 2.0));
+  CHECK_OK(paramSetValueAtTime(source->param("width"), 1.0, 4.0));
+
+  // Boxes of width 2 and 4
+  MemoryFrameSink boxes;
+  FrameRangeCooker boxCooker(box.plugin(), &source->raw);
+  CHECK_OK(boxCooker.cookRange(0, 1, 1, &boxes));
+  CHECK(boxes.frameCount() == 2);
+
+  // Inputs are held to the last sample at or before the cooked time
+  FrameRangeCooker cooker(normals.plugin(), &shading->raw);
+  CHECK_OK(cooker.setInputSample(kOfxMeshMainInput, 0, boxes.frameMesh(0)));
+  CHECK_OK(cooker.setInputSample(kOfxMeshMainInput, 3, boxes.frameMesh(1)));
+  CHECK(kOfxStatOK != cooker.setInputSample(kOfxMeshMainOutput, 3, boxes.frameMesh(1)));
+  MemoryFrameSink sink;
+  CHECK_OK(cooker.cookRange(0, 5, 1, &sink));
+  CHECK(sink.frameCount() == 6);
+  for (int frame = 0 ; frame < sink.frameCount() ; ++frame) {
+    float x = framePosition(sink, frame, 7, 0);
+    CHECK(x == (sink.frameTime(frame) < 3 ? 1.0f : 2.0f));
+  }
+  CHECK_OK(cooker.cookRange(0, 5, 1, &sink));
+  CHECK(cooker.reusedFrameCount() == 6);
+}
@@ -0,0 +1,244 @@
+#include "TestHarness.h"
+
+#include "Graph.h"
+
+extern "C" {
+#include <host/parameterSuite.h>
+}
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cstring>
+#include <vector>
+
+static const OfxMeshAttributePropertySet* positionAttribute(const OfxMeshStruct *mesh) {
+  return findAttribute(mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition);
+}
+
+TEST(graph, chain) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  std::unique_ptr<TestInstance> source = box.instantiate();
+  std::unique_ptr<TestInstance> shading = normals.instantiate();
+  CHECK(nullptr != source && nullptr != shading);
+  CHECK_OK(source->setDouble("width", 1));
+  CHECK_OK(source->setDouble("height", 1));
+  CHECK_OK(source->setDouble("depth", 1));
+
+  Graph graph;
+  int b = graph.addNode(box.plugin(), &source->raw);
+  int n = graph.addNode(normals.plugin(), &shading->raw);
+  CHECK(graph.addNode(box.plugin(), &source->raw) == -1);
+  CHECK(graph.nodeCount() == 2);
+  CHECK_OK(graph.connect(b, n, kOfxMeshMainInput));
+  CHECK(kOfxStatErrBadIndex == graph.connect(n, b, kOfxMeshMainInput)); // the box has no input
+  CHECK(kOfxStatErrValue == graph.connect(n, n, kOfxMeshMainInput));
+  CHECK_OK(graph.setKeepOutput(b, true));
+
+  // The output of the box is handed to ComputeNormals without any copy
+  CHECK_OK(graph.cook());
+  const OfxMeshStruct *boxOutput = graph.outputMesh(b);
+  const OfxMeshStruct *output = graph.outputMesh(n);
+  CHECK(nullptr != boxOutput && nullptr != output);
+  CHECK(nullptr != findAttribute(output, kOfxMeshAttribFace, "normal"));
+  CHECK(positionAttribute(output)->data == positionAttribute(boxOutput)->data);
+  CHECK(!positionAttribute(output)->is_owner);
+}
+
+TEST(graph, inputMeshes) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  std::unique_ptr<TestInstance> source = box.instantiate();
+  std::unique_ptr<TestInstance> shading = normals.instantiate();
+  CHECK(nullptr != source && nullptr != shading);
+
+  // Meshes that the caller owns can be fed to inputs instead of outputs
+  Graph boxGraph;
+  int b = boxGraph.addNode(box.plugin(), &source->raw);
+  CHECK_OK(boxGraph.cook());
+  const OfxMeshStruct *mesh = boxGraph.outputMesh(b);
+  CHECK(nullptr != mesh);
+
+  Graph graph;
+  int n = graph.addNode(normals.plugin(), &shading->raw);
+  CHECK(kOfxStatErrBadIndex == graph.setInputMesh(n, "NoSuchInput", mesh));
+  CHECK_OK(graph.setInputMesh(n, kOfxMeshMainInput, mesh));
+  CHECK_OK(graph.cook());
+  const OfxMeshStruct *output = graph.outputMesh(n);
+  CHECK(nullptr != output);
+  CHECK(output->properties.face_count == 6);
+  CHECK(positionAttribute(output)->data == positionAttribute(mesh)->data);
+
+  graph.clear();
+  CHECK(graph.nodeCount() == 0);
+  CHECK(nullptr == graph.outputMesh(n));
+}
+
+TEST(graph, recook) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  std::unique_ptr<TestInstance> source = box.instantiate();
+  std::unique_ptr<TestInstance> shading = normals.instantiate();
+  CHECK(nullptr != source && nullptr != shading);
+  CHECK_OK(source->setDouble("width", 1));
+  CHECK_OK(source->setDouble("height", 1));
+  CHECK_OK(source->setDouble("depth", 1));
+
+  Graph graph;
+  int b = graph.addNode(box.plugin(), &source->raw);
+  int n = graph.addNode(normals.plugin(), &shading->raw);
+  CHECK_OK(graph.connect(b, n, kOfxMeshMainInput));
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 2);
+
+  // Nothing changed
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 0);
+  CHECK(graph.reusedNodeCount() == 2);
+
+  // Only the consumer depends on its own parameters
+  CHECK_OK(shading->setInt("mode", 1));
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 1);
+  CHECK(graph.reusedNodeCount() == 1);
+  CHECK(nullptr != findAttribute(graph.outputMesh(n), kOfxMeshAttribPoint, "normal"));
+
+  // Keys are part of the stamp even though the box is cooked at time 0
+  // without evaluating them, so it gives the same output and its consumer
+  // is not cooked again
+  CHECK_OK(paramSetValueAtTime(source->param("width"), 5.0, 3.0));
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 1);
+  CHECK(graph.unchangedNodeCount() == 1);
+  CHECK(graph.reusedNodeCount() == 1);
+  CHECK_OK(paramDeleteAllKeys(source->param("width")));
+
+  CHECK_OK(source->setDouble("width", 2));
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 2);
+  const OfxMeshStruct *output = graph.outputMesh(n);
+  CHECK(nullptr != output);
+  auto positions = mfx::makeAttributeView<float, 3>(output, positionAttribute(output));
+  CHECK(positions.isValid());
+  CHECK(positions.get(7, 0) == 1.0f);
+
+  // Without caching, everything is cooked and intermediate outputs are only
+  // available when kept
+  graph.setCaching(false);
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 2);
+  CHECK(nullptr == graph.outputMesh(b));
+  CHECK(nullptr != graph.outputMesh(n));
+  CHECK_OK(graph.setKeepOutput(b, true));
+  CHECK_OK(graph.cook());
+  CHECK(nullptr != graph.outputMesh(b));
+}
+
+TEST(graph, unchangedOutputs) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  std::unique_ptr<TestInstance> source = box.instantiate();
+  std::unique_ptr<TestInstance> faceNormals = normals.instantiate();
+  std::unique_ptr<TestInstance> pointNormals = normals.instantiate();
+  CHECK(nullptr != source && nullptr != faceNormals && nullptr != pointNormals);
+  CHECK_OK(faceNormals->setInt("mode", 0));
+  CHECK_OK(pointNormals->setInt("mode", 1));
+
+  Graph graph;
+  int b = graph.addNode(box.plugin(), &source->raw);
+  int f = graph.addNode(normals.plugin(), &faceNormals->raw);
+  int p = graph.addNode(normals.plugin(), &pointNormals->raw);
+  CHECK_OK(graph.connect(b, f, kOfxMeshMainInput));
+  CHECK_OK(graph.connect(f, p, kOfxMeshMainInput));
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 3);
+
+  // Face normals do not depend on the weighting, so the node cooks to the
+  // same mesh and its consumer is not cooked again
+  CHECK_OK(faceNormals->setInt("weighting", 1));
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 1);
+  CHECK(graph.unchangedNodeCount() == 1);
+  CHECK(graph.reusedNodeCount() == 2);
+  CHECK(nullptr != graph.outputMesh(p));
+}
+
+/**
+ * Copy of the normals of the output of a node.
+ */
+static std::vector<float> outputNormals(const Graph& graph, int node, const char *attachment) {
+  std::vector<float> values;
+  const OfxMeshStruct *output = graph.outputMesh(node);
+  if (nullptr == output) return values;
+  auto normals = mfx::makeAttributeView<float, 3>(output, findAttribute(output, attachment, "normal"));
+  for (size_t i = 0 ; i < normals.size() ; ++i) {
+    for (int k = 0 ; k < 3 ; ++k) values.push_back(normals.get(i, k));
+  }
+  return values;
+}
+
+/**
+ * Add a box feeding chains of two ComputeNormals nodes to a graph, the mode
+ * of which depends on the index of the branch, starting at firstBranch.
+ * Return the last node of each branch, or an empty list if an instance
+ * could not be created.
+ */
+static std::vector<int> addBranches(Graph& graph, const TestEffect& box, const TestEffect& normals, int firstBranch, int branchCount, std::vector<std::unique_ptr<TestInstance>>& instances) {
+  std::vector<int> sinks;
+  instances.push_back(box.instantiate());
+  TestInstance *source = instances.back().get();
+  if (nullptr == source) return sinks;
+  source->setDouble("width", 1);
+  source->setDouble("height", 2);
+  source->setDouble("depth", 3);
+  int s = graph.addNode(box.plugin(), &source->raw);
+  for (int branch = firstBranch ; branch < firstBranch + branchCount ; ++branch) {
+    int previous = s;
+    for (int i = 0 ; i < 2 ; ++i) {
+      instances.push_back(normals.instantiate());
+      TestInstance *instance = instances.back().get();
+      if (nullptr == instance) return std::vector<int>();
+      instance->setInt("mode", branch % 3);
+      instance->setInt("weighting", branch / 3);
+      int node = graph.addNode(normals.plugin(), &instance->raw);
+      graph.connect(previous, node, kOfxMeshMainInput);
+      previous = node;
+    }
+    sinks.push_back(previous);
+  }
+  return sinks;
+}
+
+TEST(graph, parallelBranches) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  static const char *attachments[] = { kOfxMeshAttribFace, kOfxMeshAttribPoint, kOfxMeshAttribCorner };
+  const int branchCount = 4;
+
+  std::vector<std::unique_ptr<TestInstance>> instances;
+  Graph graph;
+  std::vector<int> sinks = addBranches(graph, box, normals, 0, branchCount, instances);
+  CHECK(static_cast<int>(sinks.size()) == branchCount);
+  CHECK_OK(graph.cook());
+  CHECK(graph.cookedNodeCount() == 1 + 2 * branchCount);
+  CHECK(graph.criticalPathTime() <= graph.workTime());
+
+  // Same results as cooking each branch on its own, as a single chain
+  for (int branch = 0 ; branch < branchCount ; ++branch) {
+    std::vector<std::unique_ptr<TestInstance>> chainInstances;
+    Graph chain;
+    std::vector<int> chainSinks = addBranches(chain, box, normals, branch, 1, chainInstances);
+    CHECK(chainSinks.size() == 1);
+    CHECK_OK(chain.cook());
+    const char *attachment = attachments[branch % 3];
+    std::vector<float> expected = outputNormals(chain, chainSinks[0], attachment);
+    CHECK(!expected.empty());
+    CHECK(outputNormals(graph, sinks[branch], attachment) == expected);
+  }
+}
@@ -0,0 +1,75 @@
+#include "TestHarness.h"
+
+#include "ObjReader.h"
+#include "MeshRows.h"
+
+#include <ofxMeshEffect.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+static OfxStatus loadObj(OfxMeshStruct *mesh, const char *obj) {
+  ObjReader reader;
+  reader.feed(obj, strlen(obj));
+  return reader.finish(mesh);
+}
+
+static const char *pointsObj =
+  "v 3 1 0\nv 1 2 0\nv 2 1 0\nv 0 0 0\n"
+  "f 1 2 3\nf 1 3 4\n";
+
+TEST(meshRows, read) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, pointsObj));
+  CHECK(meshRowSize(&mesh.raw, kOfxMeshAttribPoint) == 1 + 3);
+  CHECK(meshRowCount(&mesh.raw, kOfxMeshAttribPoint) == 4);
+  CHECK(meshRowSize(&mesh.raw, "NoSuchAttachment") == -1);
+
+  // Rows start with the element index, rows past the end are not written
+  std::vector<double> rows(3 * 4, -1.0);
+  CHECK_OK(readMeshRows(&mesh.raw, kOfxMeshAttribPoint, 2, 3, nullptr, rows.data()));
+  CHECK((rows == std::vector<double>{ 2, 2, 1, 0, 3, 0, 0, 0, -1, -1, -1, -1 }));
+
+  const int order[4] = { 3, 1, 0, 2 };
+  CHECK_OK(readMeshRows(&mesh.raw, kOfxMeshAttribPoint, 0, 2, order, rows.data()));
+  CHECK(rows[0] == 3 && rows[1] == 0 && rows[4] == 1 && rows[6] == 2);
+
+  // Face sizes are read even when they are constant
+  mesh.raw.properties.constant_face_size = 3;
+  CHECK(meshRowCount(&mesh.raw, kOfxMeshAttribFace) == 2);
+  int faceRowSize = meshRowSize(&mesh.raw, kOfxMeshAttribFace);
+  std::vector<double> faceRows(2 * faceRowSize);
+  CHECK_OK(readMeshRows(&mesh.raw, kOfxMeshAttribFace, 0, 2, nullptr, faceRows.data()));
+  CHECK(faceRows[1] == 3 && faceRows[faceRowSize + 1] == 3);
+
+  const int badOrder[4] = { 0, 4, 0, 0 };
+  CHECK(kOfxStatErrBadIndex == readMeshRows(&mesh.raw, kOfxMeshAttribPoint, 0, 2, badOrder, rows.data()));
+  CHECK(kOfxStatErrBadIndex == readMeshRows(&mesh.raw, kOfxMeshAttribPoint, -1, 2, nullptr, rows.data()));
+}
+
+TEST(meshRows, sort) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, pointsObj));
+  int order[4];
+
+  // Any component can be the key, ties keep the element order
+  CHECK_OK(sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, 0, false, order));
+  CHECK(order[0] == 3 && order[1] == 1 && order[2] == 2 && order[3] == 0);
+  CHECK_OK(sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, 1, false, order));
+  CHECK(order[0] == 3 && order[1] == 0 && order[2] == 2 && order[3] == 1);
+  CHECK_OK(sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, 1, true, order));
+  CHECK(order[0] == 1 && order[1] == 0 && order[2] == 2 && order[3] == 3);
+
+  // NaN values come last in both directions
+  float *positions = reinterpret_cast<float*>(findAttribute(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition)->data);
+  positions[3 * 3 + 1] = std::numeric_limits<float>::quiet_NaN();
+  CHECK_OK(sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, 1, false, order));
+  CHECK(order[0] == 0 && order[3] == 3);
+  CHECK_OK(sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, 1, true, order));
+  CHECK(order[0] == 1 && order[3] == 3);
+
+  CHECK(kOfxStatErrBadIndex == sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, 3, false, order));
+  CHECK(kOfxStatErrUnknown == sortMeshRows(&mesh.raw, kOfxMeshAttribPoint, "NoSuchAttribute", 0, false, order));
+}
@@ -0,0 +1,81 @@
+#include "TestHarness.h"
+
+#include "ObjReader.h"
+
+extern "C" {
+#include <host/meshViewSuite.h>
+}
+
+#include <ofxMeshEffect.h>
+
+#include <cstring>
+
+static OfxStatus loadObj(OfxMeshStruct *mesh, const char *obj) {
+  ObjLoadOptions options;
+  options.texCoords = true;
+  ObjReader reader(options);
+  reader.feed(obj, strlen(obj));
+  return reader.finish(mesh);
+}
+
+TEST(meshView, attributes) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw,
+    "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0.5 0.5 1\n"
+    "vt 0 0\nvt 1 0\n"
+    "f 1/1 4/2 3/1 2/2\nf 1/1 2/2 5/1\n"));
+
+  MfxMeshView view;
+  CHECK_OK(meshGetView(&mesh.raw, &view));
+  CHECK(view.point_count == 5);
+  CHECK(view.corner_count == 7);
+  CHECK(view.face_count == 2);
+  CHECK(view.constant_face_size == -1);
+
+  // The view lists the attributes of the mesh in order, pointing to the
+  // same buffers
+  int attributeCount = 0;
+  while (attributeCount < 32 && mesh.raw.attributes[attributeCount].is_valid) ++attributeCount;
+  CHECK(view.attribute_count == attributeCount);
+  for (int i = 0 ; i < attributeCount ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh.raw.attributes[i];
+    const MfxAttributeDescriptor *desc = &view.attributes[i];
+    CHECK(0 == strcmp(desc->name, attrib->name));
+    CHECK(0 == strcmp(desc->semantic, attrib->semantic));
+    CHECK(desc->component_count == attrib->component_count);
+    CHECK(desc->data == attrib->data);
+    CHECK(desc->byte_stride == attrib->byte_stride);
+    CHECK(desc->is_owner == attrib->is_owner);
+  }
+
+  const OfxMeshAttributePropertySet *texCoords = findAttribute(&mesh.raw, kOfxMeshAttribCorner, "uv");
+  CHECK(nullptr != texCoords);
+  const MfxAttributeDescriptor *desc = &view.attributes[texCoords - mesh.raw.attributes];
+  CHECK(desc->attachment == MFX_ATTACHMENT_CORNER);
+  CHECK(desc->type == MFX_ATTRIBUTE_TYPE_FLOAT);
+  CHECK(desc->component_count == 2);
+}
+
+TEST(meshView, constantFaceSize) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3\nf 1 3 4\n"));
+  mesh.raw.properties.constant_face_size = 3;
+
+  // The face size attribute reads the constant from the view itself
+  MfxMeshView view;
+  CHECK_OK(meshGetView(&mesh.raw, &view));
+  CHECK(view.constant_face_size == 3);
+  const MfxAttributeDescriptor *faceSize = nullptr;
+  for (int i = 0 ; i < view.attribute_count ; ++i) {
+    if (view.attributes[i].attachment == MFX_ATTACHMENT_FACE && 0 == strcmp(view.attributes[i].name, kOfxMeshAttribFaceSize)) {
+      faceSize = &view.attributes[i];
+    }
+  }
+  CHECK(nullptr != faceSize);
+  CHECK(faceSize->type == MFX_ATTRIBUTE_TYPE_INT);
+  CHECK(faceSize->data == &view.constant_face_size);
+  CHECK(faceSize->byte_stride == 0);
+
+  CHECK(kOfxStatErrBadHandle == meshGetView(nullptr, &view));
+  CHECK(kOfxStatErrBadHandle == meshGetView(&mesh.raw, nullptr));
+}
@@ -0,0 +1,214 @@
+#include "TestHarness.h"
+
+#include "FrameRange.h"
+#include "ObjReader.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cmath>
+#include <cstring>
+
+// Unit box scaled to 1x2x3, so that the faces orthogonal to x, y and z have
+// an area of 6, 3 and 2 respectively
+static void setBoxDimensions(TestInstance& box) {
+  box.setDouble("width", 1);
+  box.setDouble("height", 2);
+  box.setDouble("depth", 3);
+}
+
+/**
+ * Cook an instance of ComputeNormals at time 0 on the given input mesh.
+ */
+static OfxStatus cookNormals(const TestEffect& normals, TestInstance& instance, const OfxMeshStruct *input, MemoryFrameSink& sink) {
+  FrameRangeCooker cooker(normals.plugin(), &instance.raw);
+  OfxStatus status = cooker.setInputSample(kOfxMeshMainInput, 0, input);
+  if (kOfxStatOK != status) return status;
+  status = cooker.cookRange(0, 0, 1, &sink);
+  if (kOfxStatOK != status) return status;
+  return nullptr != sink.frameMesh(0) ? kOfxStatOK : kOfxStatFailed;
+}
+
+/**
+ * Cook a box with the dimensions of setBoxDimensions() into the sink.
+ */
+static OfxStatus cookBox(const TestEffect& box, MemoryFrameSink& sink) {
+  std::unique_ptr<TestInstance> instance = box.instantiate();
+  if (nullptr == instance) return kOfxStatFailed;
+  setBoxDimensions(*instance);
+  FrameRangeCooker cooker(box.plugin(), &instance->raw);
+  return cooker.cookRange(0, 0, 1, &sink);
+}
+
+static bool near(float a, float b) {
+  return std::fabs(a - b) < 1e-5f;
+}
+
+TEST(normals, faceMode) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  MemoryFrameSink boxes;
+  CHECK_OK(cookBox(box, boxes));
+  std::unique_ptr<TestInstance> instance = normals.instantiate();
+  CHECK(nullptr != instance);
+
+  MemoryFrameSink sink;
+  CHECK_OK(cookNormals(normals, *instance, boxes.frameMesh(0), sink));
+  const OfxMeshStruct *output = sink.frameMesh(0);
+  CHECK(nullptr == findAttribute(output, kOfxMeshAttribPoint, "normal"));
+  CHECK(nullptr == findAttribute(output, kOfxMeshAttribCorner, "normal"));
+  auto faceNormals = mfx::makeAttributeView<float, 3>(output, findAttribute(output, kOfxMeshAttribFace, "normal"));
+  auto positions = mfx::makeAttributeView<float, 3>(output, findAttribute(output, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+  auto cornerPoints = mfx::makeAttributeView<int, 1>(output, findAttribute(output, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  CHECK(faceNormals.isValid() && faceNormals.size() == 6);
+
+  // Normals of the box are unit axes pointing outwards
+  for (int face = 0 ; face < 6 ; ++face) {
+    float center[3] = { 0, 0, 0 }, length = 0, outwards = 0;
+    for (int i = 0 ; i < 4 ; ++i) {
+      int point = cornerPoints.get(4 * face + i);
+      for (int k = 0 ; k < 3 ; ++k) center[k] += positions.get(point, k);
+    }
+    for (int k = 0 ; k < 3 ; ++k) {
+      float n = faceNormals.get(face, k);
+      CHECK(near(n, 0) || near(std::fabs(n), 1));
+      length += n * n;
+      outwards += n * center[k];
+    }
+    CHECK(near(length, 1));
+    CHECK(outwards > 0);
+  }
+}
+
+TEST(normals, pointModeWeighting) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  MemoryFrameSink boxes;
+  CHECK_OK(cookBox(box, boxes));
+  const float third = 1.0f / std::sqrt(3.0f);
+
+  // Each point of a box has a corner in three orthogonal faces with right
+  // angles, so uniform and angle weighting agree, while area weighting
+  // favors the largest faces
+  const float expected[3][3] = {
+    { third, third, third },
+    { 6.0f / 7, 3.0f / 7, 2.0f / 7 },
+    { third, third, third },
+  };
+  for (int weighting = 0 ; weighting < 3 ; ++weighting) {
+    std::unique_ptr<TestInstance> instance = normals.instantiate();
+    CHECK(nullptr != instance);
+    CHECK_OK(instance->setInt("mode", 1));
+    CHECK_OK(instance->setInt("weighting", weighting));
+    MemoryFrameSink sink;
+    CHECK_OK(cookNormals(normals, *instance, boxes.frameMesh(0), sink));
+    const OfxMeshStruct *output = sink.frameMesh(0);
+    auto pointNormals = mfx::makeAttributeView<float, 3>(output, findAttribute(output, kOfxMeshAttribPoint, "normal"));
+    auto positions = mfx::makeAttributeView<float, 3>(output, findAttribute(output, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+    CHECK(pointNormals.isValid() && pointNormals.size() == 8);
+    for (int point = 0 ; point < 8 ; ++point) {
+      for (int k = 0 ; k < 3 ; ++k) {
+        float sign = positions.get(point, k) > 0 ? 1.0f : -1.0f;
+        CHECK(near(pointNormals.get(point, k), sign * expected[weighting][k]));
+      }
+    }
+  }
+}
+
+TEST(normals, cornerModeAngle) {
+  TestEffect box(BOX_PLUGIN_PATH);
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(box.isValid() && normals.isValid());
+  MemoryFrameSink boxes;
+  CHECK_OK(cookBox(box, boxes));
+
+  std::unique_ptr<TestInstance> faceInstance = normals.instantiate();
+  std::unique_ptr<TestInstance> pointInstance = normals.instantiate();
+  CHECK(nullptr != faceInstance && nullptr != pointInstance);
+  CHECK_OK(pointInstance->setInt("mode", 1));
+  CHECK_OK(pointInstance->setInt("weighting", 1));
+  MemoryFrameSink faceSink, pointSink;
+  CHECK_OK(cookNormals(normals, *faceInstance, boxes.frameMesh(0), faceSink));
+  CHECK_OK(cookNormals(normals, *pointInstance, boxes.frameMesh(0), pointSink));
+  auto faceNormals = mfx::makeAttributeView<float, 3>(faceSink.frameMesh(0), findAttribute(faceSink.frameMesh(0), kOfxMeshAttribFace, "normal"));
+  auto pointNormals = mfx::makeAttributeView<float, 3>(pointSink.frameMesh(0), findAttribute(pointSink.frameMesh(0), kOfxMeshAttribPoint, "normal"));
+  CHECK(faceNormals.isValid() && pointNormals.isValid());
+
+  // Faces of a box meet at right angles, so they are split below 90 degrees
+  // and smoothed above
+  for (double angle : { 30.0, 100.0 }) {
+    std::unique_ptr<TestInstance> instance = normals.instantiate();
+    CHECK(nullptr != instance);
+    CHECK_OK(instance->setInt("mode", 2));
+    CHECK_OK(instance->setInt("weighting", 1));
+    CHECK_OK(instance->setDouble("angle", angle));
+    MemoryFrameSink sink;
+    CHECK_OK(cookNormals(normals, *instance, boxes.frameMesh(0), sink));
+    const OfxMeshStruct *output = sink.frameMesh(0);
+    auto cornerNormals = mfx::makeAttributeView<float, 3>(output, findAttribute(output, kOfxMeshAttribCorner, "normal"));
+    auto cornerPoints = mfx::makeAttributeView<int, 1>(output, findAttribute(output, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+    CHECK(cornerNormals.isValid() && cornerNormals.size() == 24);
+    for (int corner = 0 ; corner < 24 ; ++corner) {
+      for (int k = 0 ; k < 3 ; ++k) {
+        float n = angle < 90 ? faceNormals.get(corner / 4, k) : pointNormals.get(cornerPoints.get(corner), k);
+        CHECK(near(cornerNormals.get(corner, k), n));
+      }
+    }
+  }
+}
+
+TEST(normals, angleWeighting) {
+  TestEffect normals(COMPUTE_NORMALS_PLUGIN_PATH);
+  CHECK(normals.isValid());
+
+  // Square pyramid, where the first point is the corner of the base quad and
+  // of two triangles
+  static const char *pyramidObj =
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\n"
+    "v 0.5 0.5 1\n"
+    "f 1 4 3 2\n"
+    "f 1 2 5\n"
+    "f 2 3 5\n"
+    "f 3 4 5\n"
+    "f 4 1 5\n";
+  TestMesh pyramid;
+  ObjReader reader;
+  reader.feed(pyramidObj, strlen(pyramidObj));
+  CHECK_OK(reader.finish(&pyramid.raw));
+
+  // The base has a right angle at the first point and each triangle an angle
+  // of acos(0.5 / sqrt(1.5)), with normals (0, 0, -1), (0, -2, 1) / sqrt(5)
+  // and (-2, 0, 1) / sqrt(5)
+  const float s = 1.0f / std::sqrt(5.0f);
+  const float faceNormals[3][3] = { { 0, 0, -1 }, { 0, -2 * s, s }, { -2 * s, 0, s } };
+  const float triangleAngle = std::acos(0.5f / std::sqrt(1.5f));
+  const float angles[3] = { 0.5f * static_cast<float>(M_PI), triangleAngle, triangleAngle };
+  for (int weighting : { 0, 2 }) {
+    float expected[3] = { 0, 0, 0 };
+    for (int face = 0 ; face < 3 ; ++face) {
+      float w = weighting == 2 ? angles[face] : 1.0f;
+      for (int k = 0 ; k < 3 ; ++k) expected[k] += w * faceNormals[face][k];
+    }
+    float length = std::sqrt(expected[0] * expected[0] + expected[1] * expected[1] + expected[2] * expected[2]);
+
+    std::unique_ptr<TestInstance> instance = normals.instantiate();
+    CHECK(nullptr != instance);
+    CHECK_OK(instance->setInt("mode", 1));
+    CHECK_OK(instance->setInt("weighting", weighting));
+    MemoryFrameSink sink;
+    CHECK_OK(cookNormals(normals, *instance, &pyramid.raw, sink));
+    const OfxMeshStruct *output = sink.frameMesh(0);
+    auto pointNormals = mfx::makeAttributeView<float, 3>(output, findAttribute(output, kOfxMeshAttribPoint, "normal"));
+    CHECK(pointNormals.isValid());
+    for (int k = 0 ; k < 3 ; ++k) {
+      CHECK(near(pointNormals.get(0, k), expected[k] / length));
+    }
+    // The apex is symmetric whatever the weighting
+    CHECK(near(pointNormals.get(4, 0), 0) && near(pointNormals.get(4, 1), 0) && near(pointNormals.get(4, 2), 1));
+  }
+}
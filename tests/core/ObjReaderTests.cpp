@@ -0,0 +1,244 @@
+#include "TestHarness.h"
+
+#include "ObjReader.h"
+
+#include <ofxMeshEffect.h>
+#include <cpp/host/attribute.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static OfxStatus loadObj(OfxMeshStruct *mesh, const std::string& obj, const ObjLoadOptions& options = ObjLoadOptions()) {
+  ObjReader reader(options);
+  reader.feed(obj.data(), obj.size());
+  return reader.finish(mesh);
+}
+
+static std::vector<int> cornerPoints(const OfxMeshStruct *mesh) {
+  std::vector<int> points;
+  auto view = mfx::makeAttributeView<int, 1>(mesh, findAttribute(mesh, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint));
+  for (size_t i = 0 ; i < view.size() ; ++i) points.push_back(view.get(i));
+  return points;
+}
+
+static std::vector<int> faceSizes(const OfxMeshStruct *mesh) {
+  std::vector<int> sizes;
+  auto view = mfx::makeFaceSizeView(mesh);
+  for (size_t i = 0 ; i < view.size() ; ++i) sizes.push_back(view.get(i));
+  return sizes;
+}
+
+TEST(objReader, connectivity) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw,
+    "# comment\n"
+    "o object\n"
+    "v 0 0 0\n"
+    "v 1.5 0 -2\n"
+    "  v 1 1e1 0\n"
+    "v 0 1 0\n"
+    "vt 0.5 0.5\n"
+    "s off\n"
+    "f 1 2 3 4\n"
+    "f 4 3 2\n"));
+  CHECK(mesh.raw.properties.point_count == 4);
+  CHECK(mesh.raw.properties.corner_count == 7);
+  CHECK(mesh.raw.properties.face_count == 2);
+  CHECK(mesh.raw.properties.constant_face_size == -1);
+  CHECK(nullptr == findAttribute(&mesh.raw, kOfxMeshAttribCorner, "uv"));
+
+  auto positions = mfx::makeAttributeView<float, 3>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+  CHECK(positions.isValid());
+  CHECK(positions.get(1, 0) == 1.5f && positions.get(1, 2) == -2.0f);
+  CHECK(positions.get(2, 1) == 10.0f);
+  CHECK((cornerPoints(&mesh.raw) == std::vector<int>{ 0, 1, 2, 3, 3, 2, 1 }));
+  CHECK((faceSizes(&mesh.raw) == std::vector<int>{ 4, 3 }));
+}
+
+TEST(objReader, negativeIndices) {
+  // Negative indices are relative to the last point defined so far
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw,
+    "v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+    "f -3 -2 -1\n"
+    "v 0 1 0\n"
+    "f 1 -2 -1\n"));
+  CHECK((cornerPoints(&mesh.raw) == std::vector<int>{ 0, 1, 2, 0, 2, 3 }));
+}
+
+TEST(objReader, errors) {
+  // Malformed lines are skipped with a warning
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, "v 0 0 0\nv 1 0\nv 0 1 0\nf 1 2 3\nf 1 x 3\n"));
+  CHECK(mesh.raw.properties.point_count == 3);
+  CHECK((faceSizes(&mesh.raw) == std::vector<int>{ 3, 1 }));
+
+  // Faces must reference existing points
+  TestMesh outOfRange, beforeFirst;
+  CHECK(kOfxStatErrFormat == loadObj(&outOfRange.raw, "v 0 0 0\nv 1 0 0\nf 1 2 3\n"));
+  CHECK(kOfxStatErrFormat == loadObj(&beforeFirst.raw, "v 0 0 0\nv 1 0 0\nf 1 2 -3\n"));
+
+  ObjReader reader;
+  CHECK(kOfxStatErrFatal == reader.readFile("no_such_file.obj"));
+}
+
+TEST(objReader, readFile) {
+  const char *filename = "triangle.obj";
+  FILE *file = fopen(filename, "wb");
+  CHECK(nullptr != file);
+  fputs("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3", file); // no final end of line
+  fclose(file);
+
+  // Readers are empty again after finish() and can be reused
+  ObjReader reader;
+  for (int i = 0 ; i < 2 ; ++i) {
+    TestMesh mesh;
+    CHECK_OK(reader.readFile(filename));
+    CHECK_OK(reader.finish(&mesh.raw));
+    CHECK(mesh.raw.properties.point_count == 3);
+    CHECK((cornerPoints(&mesh.raw) == std::vector<int>{ 0, 1, 2 }));
+  }
+}
+
+/**
+ * Grid of rows x columns points, each row of quads being written right after
+ * its points and indexing them with negative indices, so that faces at the
+ * start of a chunk reference points of the previous chunk. Expected corner
+ * points are written to cornerPoints.
+ */
+static std::string gridObj(int rows, int columns, std::vector<int>& cornerPoints) {
+  std::string obj;
+  char line[128];
+  for (int r = 0 ; r < rows ; ++r) {
+    for (int c = 0 ; c < columns ; ++c) {
+      snprintf(line, sizeof(line), "v %d.25 %d.5 0\n", c, r);
+      obj += line;
+    }
+    if (r == 0) continue;
+    for (int c = 0 ; c + 1 < columns ; ++c) {
+      int previousRow = -2 * columns + c, row = -columns + c;
+      snprintf(line, sizeof(line), "f %d %d %d %d\n", previousRow, previousRow + 1, row + 1, row);
+      obj += line;
+      int first = (r - 1) * columns + c;
+      cornerPoints.insert(cornerPoints.end(), { first, first + 1, first + columns + 1, first + columns });
+    }
+  }
+  return obj;
+}
+
+TEST(objReader, chunks) {
+  // Larger than the biggest chunk, so that it is split whatever the number
+  // of threads
+  const int rows = 2000, columns = 100;
+  std::vector<int> expectedCornerPoints;
+  std::string obj = gridObj(rows, columns, expectedCornerPoints);
+  CHECK(obj.size() > (size_t(1) << 22));
+
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, obj));
+  CHECK(mesh.raw.properties.point_count == rows * columns);
+  CHECK(mesh.raw.properties.face_count == (rows - 1) * (columns - 1));
+  CHECK(cornerPoints(&mesh.raw) == expectedCornerPoints);
+  std::vector<int> sizes = faceSizes(&mesh.raw);
+  CHECK(std::vector<int>(sizes.size(), 4) == sizes);
+
+  // Points stay in file order across chunks
+  auto positions = mfx::makeAttributeView<float, 3>(&mesh.raw, findAttribute(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition));
+  for (int r = 0 ; r < rows ; r += 97) {
+    for (int c = 0 ; c < columns ; c += 7) {
+      CHECK(positions.get(r * columns + c, 0) == c + 0.25f);
+      CHECK(positions.get(r * columns + c, 1) == r + 0.5f);
+    }
+  }
+}
+
+static std::vector<float> cornerValues(const OfxMeshStruct *mesh, const char *name, int componentCount) {
+  std::vector<float> values;
+  const OfxMeshAttributePropertySet *attrib = findAttribute(mesh, kOfxMeshAttribCorner, name);
+  if (nullptr == attrib || attrib->component_count != componentCount) return values;
+  auto view = mfx::makeAttributeView<float, 1>(mesh, attrib);
+  for (size_t i = 0 ; i < view.size() ; ++i) {
+    for (int k = 0 ; k < componentCount ; ++k) values.push_back(reinterpret_cast<const float*>(view.bytes(i))[k]);
+  }
+  return values;
+}
+
+TEST(objReader, cornerLayers) {
+  ObjLoadOptions options;
+  options.texCoords = true;
+  options.normals = true;
+  static const char *obj =
+    "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+    "vt 0 0\nvt 1 0\nvt 1 1\n"
+    "vn 0 0 1\nvn 0 0 -1\n"
+    "f 1/1/1 2/2/1 3/3/1\n" // v/vt/vn
+    "f 1//2 3//2 4//2\n" // v//vn
+    "f 1/-1 3/-2 4/-3\n"; // v/vt with relative indices
+
+  // Texture coordinates and normals are de-indexed into corner attributes,
+  // missing ones being zero
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, obj, options));
+  CHECK(mesh.raw.properties.corner_count == 9);
+  CHECK((cornerValues(&mesh.raw, "uv", 2) == std::vector<float>{ 0, 0, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0 }));
+  CHECK((cornerValues(&mesh.raw, "normal", 3) == std::vector<float>{
+    0, 0, 1, 0, 0, 1, 0, 0, 1,
+    0, 0, -1, 0, 0, -1, 0, 0, -1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0 }));
+  CHECK(0 == strcmp(findAttribute(&mesh.raw, kOfxMeshAttribCorner, "uv")->semantic, kOfxMeshAttribSemanticTextureCoordinate));
+
+  // Layers that are not requested are skipped
+  TestMesh connectivity;
+  CHECK_OK(loadObj(&connectivity.raw, obj));
+  CHECK(nullptr == findAttribute(&connectivity.raw, kOfxMeshAttribCorner, "uv"));
+  CHECK(nullptr == findAttribute(&connectivity.raw, kOfxMeshAttribCorner, "normal"));
+  CHECK((cornerPoints(&connectivity.raw) == cornerPoints(&mesh.raw)));
+}
+
+TEST(objReader, cornerLayerIndices) {
+  ObjLoadOptions options;
+  options.texCoords = true;
+  options.normals = true;
+  static const char *points = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvn 0 0 1\n";
+
+  // A relative index resolving just before the first element is invalid,
+  // not missing, and so are indices past the last element
+  for (const char *face : { "f 1/-3 2/1 3/1\n", "f 1/3 2/1 3/1\n", "f 1//-2 2//1 3//1\n", "f 1//2 2//1 3//1\n" }) {
+    TestMesh mesh;
+    CHECK(kOfxStatErrFormat == loadObj(&mesh.raw, std::string(points) + face, options));
+  }
+
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, std::string(points) + "f 1/-2/-1 2/-1 3\n", options));
+  CHECK((cornerValues(&mesh.raw, "uv", 2) == std::vector<float>{ 0, 0, 1, 0, 0, 0 }));
+}
+
+TEST(objReader, pieces) {
+  // Pieces of any size give the same mesh as feeding the file at once, as
+  // when streaming a file from JavaScript into a reused staging buffer
+  std::vector<int> expectedCornerPoints;
+  std::string obj = gridObj(300, 40, expectedCornerPoints);
+  std::string staging;
+  for (size_t pieceSize : { size_t(1), size_t(7), size_t(4096), size_t(100000) }) {
+    ObjReader reader;
+    for (size_t offset = 0 ; offset < obj.size() ; offset += pieceSize) {
+      staging.assign(obj, offset, pieceSize);
+      reader.feed(staging.data(), staging.size());
+      staging.assign(staging.size(), '#'); // the piece may be overwritten
+    }
+    TestMesh mesh;
+    CHECK_OK(reader.finish(&mesh.raw));
+    CHECK(mesh.raw.properties.point_count == 300 * 40);
+    CHECK(cornerPoints(&mesh.raw) == expectedCornerPoints);
+  }
+
+  // Windows line endings and a last line without end of line
+  TestMesh mesh;
+  ObjReader reader;
+  std::string crlf = "v 0 0 0\r\nv 1 0 0\r\nv 0 1 0\r\nf 1 2 3";
+  for (char c : crlf) reader.feed(&c, 1);
+  CHECK_OK(reader.finish(&mesh.raw));
+  CHECK((cornerPoints(&mesh.raw) == std::vector<int>{ 0, 1, 2 }));
+}
@@ -0,0 +1,102 @@
+#include "TestHarness.h"
+
+#include "OutputSlots.h"
+
+struct TestSlot {
+  OfxMeshStruct mesh;
+  int pinCount = 0;
+
+  TestSlot() { meshInit(&mesh); }
+  ~TestSlot() { meshDestroy(&mesh); }
+};
+
+// Store a mesh with pointCount points in the next slot, as a cook would
+static TestSlot* cookInto(OutputSlots<TestSlot>& slots, int pointCount) {
+  TestSlot *slot = slots.next();
+  if (nullptr == slot) return nullptr;
+  TestMesh output;
+  output.raw.properties.point_count = pointCount;
+  slots.store(slot, &output.raw);
+  return slot;
+}
+
+TEST(outputSlots, single) {
+  OutputSlots<TestSlot> slots;
+  CHECK(slots.count() == 1);
+  TestSlot *slot = cookInto(slots, 3);
+  CHECK(slot == slots.last());
+  CHECK(slot->mesh.properties.point_count == 3);
+
+  // A pinned output is not overwritten, even with a single slot
+  CHECK(slots.pinLast() == slot);
+  CHECK(nullptr == slots.next());
+  CHECK(nullptr == cookInto(slots, 4));
+  CHECK(slot->mesh.properties.point_count == 3);
+
+  CHECK_OK(slots.release(slot));
+  CHECK(cookInto(slots, 4) == slot);
+  CHECK(slot->mesh.properties.point_count == 4);
+}
+
+TEST(outputSlots, alternate) {
+  OutputSlots<TestSlot> slots;
+  CHECK_OK(slots.setCount(2));
+  TestSlot *first = cookInto(slots, 1);
+
+  // The next cook goes to the other slot, whether the last one is pinned
+  // or not
+  TestSlot *second = cookInto(slots, 2);
+  CHECK(nullptr != second && second != first);
+  CHECK(cookInto(slots, 3) == first);
+  slots.pinLast();
+  CHECK(cookInto(slots, 4) == second);
+  CHECK(first->mesh.properties.point_count == 3);
+
+  // Once both are pinned, cooks fail and the last output is kept
+  slots.pinLast();
+  CHECK(nullptr == slots.next());
+  CHECK(slots.last() == second);
+
+  CHECK_OK(slots.release(first));
+  CHECK(cookInto(slots, 5) == first);
+}
+
+TEST(outputSlots, release) {
+  OutputSlots<TestSlot> slots;
+  TestSlot other;
+  CHECK(kOfxStatErrBadHandle == slots.release(slots.last()));
+  CHECK(kOfxStatErrBadHandle == slots.release(&other));
+  CHECK(kOfxStatErrBadHandle == slots.release(nullptr));
+
+  // Pins are counted
+  slots.pinLast();
+  slots.pinLast();
+  CHECK_OK(slots.release(slots.last()));
+  CHECK(nullptr == slots.next());
+  CHECK_OK(slots.release(slots.last()));
+  CHECK(nullptr != slots.next());
+
+  TestSlot *last = slots.last();
+  CHECK(slots.find([last](const TestSlot& slot) { return &slot == last; }) == last);
+  CHECK(nullptr == slots.find([](const TestSlot&) { return false; }));
+}
+
+TEST(outputSlots, setCount) {
+  OutputSlots<TestSlot> slots;
+  CHECK(kOfxStatErrValue == slots.setCount(0));
+  CHECK_OK(slots.setCount(3));
+  CHECK(slots.count() == 3);
+
+  // The pinned slot and the last output are kept
+  TestSlot *pinned = cookInto(slots, 1);
+  slots.pinLast();
+  TestSlot *last = cookInto(slots, 2);
+  CHECK(kOfxStatErrValue == slots.setCount(1));
+  CHECK(slots.count() == 2);
+  CHECK(slots.last() == last && last->mesh.properties.point_count == 2);
+  CHECK(pinned->mesh.properties.point_count == 1);
+
+  CHECK_OK(slots.release(pinned));
+  CHECK_OK(slots.setCount(1));
+  CHECK(slots.last() == last);
+}
@@ -0,0 +1,321 @@
+#include "TestHarness.h"
+
+extern "C" {
+#include <host/parameterSuite.h>
+}
+
+#include <ofxParam.h>
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * Parameter set destroyed along with the test.
+ */
+struct TestParameterSet {
+  OfxParamSetStruct raw;
+
+  TestParameterSet() { parameterSetInit(&raw); }
+  ~TestParameterSet() { parameterSetDestroy(&raw); }
+  TestParameterSet(const TestParameterSet&) = delete;
+  TestParameterSet& operator=(const TestParameterSet&) = delete;
+
+  OfxParamHandle param(const char *name) {
+    OfxParamHandle handle = nullptr;
+    if (kOfxStatOK != paramGetHandle(&raw, name, &handle, nullptr)) return nullptr;
+    return handle;
+  }
+};
+
+TEST(parameters, typedValues) {
+  TestParameterSet parameters;
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeInteger, "count", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble, "size", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeBoolean, "enabled", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeInteger2D, "resolution", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble3D, "offset", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeRGBA, "color", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeString, "label", nullptr));
+  CHECK(kOfxStatErrExists == paramDefine(&parameters.raw, kOfxParamTypeDouble, "count", nullptr));
+  CHECK(kOfxStatErrUnknown == paramDefine(&parameters.raw, "NoSuchType", "other", nullptr));
+  CHECK(nullptr == parameters.param("other"));
+
+  // Types are resolved once at define time
+  CHECK(parameters.param("count")->kind == PARAM_INTEGER);
+  CHECK(parameters.param("enabled")->kind == PARAM_BOOLEAN);
+  CHECK(parameters.param("resolution")->kind == PARAM_INTEGER2D);
+  CHECK(parameters.param("offset")->kind == PARAM_DOUBLE3D);
+  CHECK(parameters.param("color")->kind == PARAM_RGBA);
+  CHECK(paramKindComponentCount(PARAM_RGBA) == 4);
+  CHECK(paramKindIsIntegral(PARAM_BOOLEAN) && !paramKindIsIntegral(PARAM_DOUBLE2D));
+
+  CHECK_OK(paramSetValue(parameters.param("count"), 7));
+  CHECK_OK(paramSetValue(parameters.param("size"), 0.25));
+  CHECK_OK(paramSetValue(parameters.param("enabled"), 5));
+  CHECK_OK(paramSetValue(parameters.param("resolution"), 640, 480));
+  CHECK_OK(paramSetValue(parameters.param("offset"), 1.0, -2.0, 3.5));
+  CHECK_OK(paramSetValue(parameters.param("color"), 0.1, 0.2, 0.3, 1.0));
+
+  int count = 0, enabled = 0, width = 0, height = 0;
+  double size = 0, x = 0, y = 0, z = 0, r = 0, g = 0, b = 0, a = 0;
+  CHECK_OK(paramGetValue(parameters.param("count"), &count));
+  CHECK(count == 7);
+  CHECK_OK(paramGetValue(parameters.param("size"), &size));
+  CHECK(size == 0.25);
+  CHECK_OK(paramGetValue(parameters.param("enabled"), &enabled));
+  CHECK(enabled == 1);
+  CHECK_OK(paramGetValue(parameters.param("resolution"), &width, &height));
+  CHECK(width == 640 && height == 480);
+  CHECK_OK(paramGetValue(parameters.param("offset"), &x, &y, &z));
+  CHECK(x == 1.0 && y == -2.0 && z == 3.5);
+  CHECK_OK(paramGetValue(parameters.param("color"), &r, &g, &b, &a));
+  CHECK(r == 0.1 && g == 0.2 && b == 0.3 && a == 1.0);
+
+  char *label = nullptr;
+  CHECK(kOfxStatErrUnsupported == paramGetValue(parameters.param("label"), &label));
+
+  // Copies keep the types and values
+  TestParameterSet copy;
+  CHECK_OK(parameterSetCopy(&copy.raw, &parameters.raw));
+  CHECK(copy.param("offset")->kind == PARAM_DOUBLE3D);
+  CHECK_OK(paramGetValue(copy.param("resolution"), &width, &height));
+  CHECK(width == 640 && height == 480);
+}
+
+static void parameterName(int i, char *name) {
+  snprintf(name, 64, "param%d", i);
+}
+
+static bool findsAll(const OfxParamSetStruct *parameters, int count) {
+  char name[64];
+  for (int i = 0 ; i < count ; ++i) {
+    parameterName(i, name);
+    if (parameterSetFind(parameters, name) != i) return false;
+  }
+  return true;
+}
+
+TEST(parameters, nameIndex) {
+  // Well beyond the 16 entries and slots allocated at first
+  const int count = 100;
+  std::unique_ptr<TestParameterSet> descriptor(new TestParameterSet());
+  char name[64];
+  for (int i = 0 ; i < count ; ++i) {
+    parameterName(i, name);
+    CHECK_OK(paramDefine(&descriptor->raw, kOfxParamTypeInteger, name, nullptr));
+  }
+  CHECK(descriptor->raw.count == count);
+  CHECK(findsAll(&descriptor->raw, count));
+  CHECK(-1 == parameterSetFind(&descriptor->raw, "param100"));
+
+  // Copies share the index of the descriptor until they define parameters
+  TestParameterSet instance, extended;
+  CHECK_OK(parameterSetCopy(&instance.raw, &descriptor->raw));
+  CHECK_OK(parameterSetCopy(&extended.raw, &descriptor->raw));
+  CHECK(instance.raw.name_index == descriptor->raw.name_index);
+  CHECK_OK(paramDefine(&extended.raw, kOfxParamTypeDouble, "param100", nullptr));
+  CHECK(extended.raw.name_index != descriptor->raw.name_index);
+  CHECK(findsAll(&extended.raw, count + 1));
+  CHECK(-1 == parameterSetFind(&descriptor->raw, "param100"));
+  CHECK(-1 == parameterSetFind(&instance.raw, "param100"));
+
+  // The index outlives the descriptor as long as an instance uses it
+  descriptor.reset();
+  CHECK(findsAll(&instance.raw, count));
+}
+
+TEST(parameters, concurrentCopies) {
+  const int count = 40;
+  TestParameterSet descriptor;
+  char name[64];
+  for (int i = 0 ; i < count ; ++i) {
+    parameterName(i, name);
+    CHECK_OK(paramDefine(&descriptor.raw, kOfxParamTypeDouble, name, nullptr));
+  }
+
+  // Instances are copied, looked up and destroyed on several threads at once
+  const int threadCount = 4;
+  std::vector<int> failures(threadCount, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0 ; t < threadCount ; ++t) {
+    threads.emplace_back([&descriptor, &failures, t]() {
+      for (int iteration = 0 ; iteration < 50 ; ++iteration) {
+        TestParameterSet instance;
+        if (kOfxStatOK != parameterSetCopy(&instance.raw, &descriptor.raw) || !findsAll(&instance.raw, count)) {
+          ++failures[t];
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int t = 0 ; t < threadCount ; ++t) {
+    CHECK(failures[t] == 0);
+  }
+  CHECK(findsAll(&descriptor.raw, count));
+}
+
+/**
+ * Values of a key of a double parameter, other components being zero.
+ */
+struct DoubleKey {
+  OfxParamValueStruct values[4] = {};
+  DoubleKey(double value) { values[0].as_double = value; }
+};
+
+static double evaluateDouble(const OfxParamStruct *param, double time) {
+  OfxParamValueStruct values[4];
+  paramEvaluate(param, time, values);
+  return values[0].as_double;
+}
+
+static int evaluateInt(const OfxParamStruct *param, double time) {
+  OfxParamValueStruct values[4];
+  paramEvaluate(param, time, values);
+  return values[0].as_int;
+}
+
+TEST(parameters, keys) {
+  TestParameterSet parameters;
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble, "size", nullptr));
+  OfxParamHandle size = parameters.param("size");
+  CHECK_OK(paramSetValue(size, 0.5));
+
+  // Keys are kept sorted, and a key at the same time replaces the previous
+  // one
+  CHECK_OK(paramSetValueAtTime(size, 10.0, 4.0));
+  CHECK_OK(paramSetValueAtTime(size, 0.0, 2.0));
+  CHECK_OK(paramSetValueAtTime(size, 5.0, 1.0));
+  CHECK_OK(paramSetValueAtTime(size, 5.0, 3.0));
+  unsigned int keyCount = 0;
+  CHECK_OK(paramGetNumKeys(size, &keyCount));
+  CHECK(keyCount == 3);
+  double time = -1;
+  CHECK_OK(paramGetKeyTime(size, 1, &time));
+  CHECK(time == 5.0);
+  CHECK(kOfxStatErrBadIndex == paramGetKeyTime(size, 3, &time));
+
+  CHECK(paramFindKey(size, 5.0, 0) == 1);
+  CHECK(paramFindKey(size, 4.0, 0) == -1);
+  CHECK(paramFindKey(size, 5.0, 1) == 2);
+  CHECK(paramFindKey(size, 5.0, -1) == 0);
+  CHECK(paramFindKey(size, 0.0, -1) == -1);
+  CHECK(paramFindKey(size, 10.0, 1) == -1);
+  int index = -1;
+  CHECK_OK(paramGetKeyIndex(size, 7.0, -1, &index));
+  CHECK(index == 1);
+  CHECK(kOfxStatFailed == paramGetKeyIndex(size, 12.0, 1, &index));
+
+  // Keys override the static value, which is used again once they are all
+  // deleted
+  double value = 0;
+  CHECK_OK(paramGetValueAtTime(size, 5.0, &value));
+  CHECK(value == 3.0);
+  CHECK(kOfxStatErrBadIndex == paramDeleteKey(size, 4.0));
+  CHECK_OK(paramDeleteKey(size, 5.0));
+  CHECK_OK(paramGetValueAtTime(size, 5.0, &value));
+  CHECK(value == 3.0); // interpolated between the remaining keys
+  CHECK_OK(paramGetNumKeys(size, &keyCount));
+  CHECK(keyCount == 2);
+
+  // Copies keep the keys
+  TestParameterSet copy;
+  CHECK_OK(parameterSetCopy(&copy.raw, &parameters.raw));
+  CHECK(copy.param("size")->key_count == 2);
+  CHECK(evaluateDouble(copy.param("size"), 2.5) == 2.5);
+  CHECK(copy.param("size")->keys != size->keys);
+
+  CHECK_OK(paramDeleteAllKeys(size));
+  CHECK_OK(paramGetValueAtTime(size, 5.0, &value));
+  CHECK(value == 0.5);
+  CHECK(copy.param("size")->key_count == 2);
+}
+
+TEST(parameters, interpolation) {
+  TestParameterSet parameters;
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble, "linear", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble, "constant", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble, "cubic", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeInteger, "count", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeBoolean, "enabled", nullptr));
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble3D, "offset", nullptr));
+
+  // Keys extend before the first one and after the last one
+  OfxParamHandle linear = parameters.param("linear");
+  CHECK_OK(paramSetValueAtTime(linear, 0.0, 2.0));
+  CHECK_OK(paramSetValueAtTime(linear, 10.0, 4.0));
+  CHECK(evaluateDouble(linear, -1.0) == 2.0);
+  CHECK(evaluateDouble(linear, 5.0) == 3.0);
+  CHECK(evaluateDouble(linear, 20.0) == 4.0);
+
+  OfxParamHandle constant = parameters.param("constant");
+  CHECK_OK(paramInsertKey(constant, 0.0, DoubleKey(2.0).values, PARAM_INTERPOLATION_CONSTANT));
+  CHECK_OK(paramInsertKey(constant, 10.0, DoubleKey(4.0).values, PARAM_INTERPOLATION_CONSTANT));
+  CHECK(evaluateDouble(constant, 9.0) == 2.0);
+  CHECK(evaluateDouble(constant, 10.0) == 4.0);
+
+  // Catmull-Rom tangents, flat at the first key: with keys 0, 1, 2 at times
+  // 0, 1, 2 the slope is 1 at the middle key, so that the curve is below
+  // the line on the first segment
+  OfxParamHandle cubic = parameters.param("cubic");
+  for (int i = 0 ; i < 3 ; ++i) {
+    CHECK_OK(paramInsertKey(cubic, i, DoubleKey(i).values, PARAM_INTERPOLATION_CUBIC));
+  }
+  CHECK(evaluateDouble(cubic, 0.5) == 0.375);
+  CHECK(evaluateDouble(cubic, 1.0) == 1.0);
+  CHECK(evaluateDouble(cubic, 1.5) == 1.625);
+
+  // Integers are rounded to the nearest, booleans are held
+  OfxParamHandle count = parameters.param("count");
+  CHECK_OK(paramSetValueAtTime(count, 0.0, 0));
+  CHECK_OK(paramSetValueAtTime(count, 3.0, 1));
+  CHECK(evaluateInt(count, 1.0) == 0);
+  CHECK(evaluateInt(count, 2.0) == 1);
+  OfxParamHandle enabled = parameters.param("enabled");
+  CHECK_OK(paramSetValueAtTime(enabled, 0.0, 1));
+  CHECK_OK(paramSetValueAtTime(enabled, 10.0, 0));
+  CHECK(evaluateInt(enabled, 9.0) == 1);
+
+  OfxParamHandle offset = parameters.param("offset");
+  CHECK_OK(paramSetValueAtTime(offset, 0.0, 0.0, 1.0, 2.0));
+  CHECK_OK(paramSetValueAtTime(offset, 2.0, 2.0, 1.0, -2.0));
+  double x = 0, y = 0, z = 0;
+  CHECK_OK(paramGetValueAtTime(offset, 1.0, &x, &y, &z));
+  CHECK(x == 1.0 && y == 1.0 && z == 0.0);
+}
+
+TEST(parameters, evaluationCache) {
+  TestParameterSet parameters;
+  CHECK_OK(paramDefine(&parameters.raw, kOfxParamTypeDouble2D, "scale", nullptr));
+  OfxParamHandle scale = parameters.param("scale");
+  CHECK_OK(paramSetValueAtTime(scale, 0.0, 0.0, 1.0));
+  CHECK_OK(paramSetValueAtTime(scale, 4.0, 8.0, 1.0));
+  CHECK_OK(paramInsertKey(scale, 6.0, DoubleKey(2.0).values, PARAM_INTERPOLATION_CUBIC));
+
+  OfxParamValueStruct values[4];
+  paramEvaluateCached(scale, 1.0, values);
+  CHECK(values[0].as_double == 2.0 && values[1].as_double == 1.0);
+  CHECK(scale->has_cached_values && scale->cached_time == 1.0);
+
+  // The cache is reset whenever keys change
+  CHECK_OK(paramSetValueAtTime(scale, 0.0, 4.0, 1.0));
+  CHECK(!scale->has_cached_values);
+  paramEvaluateCached(scale, 1.0, values);
+  CHECK(values[0].as_double == 5.0);
+  paramRemoveKey(scale, 0);
+  paramEvaluateCached(scale, 1.0, values);
+  CHECK(values[0].as_double == 8.0);
+
+  // Ranges, including times before, between and after keys, give the same
+  // values as evaluating each time on its own
+  CHECK_OK(paramSetValueAtTime(scale, 0.0, 0.0, 3.0));
+  const int count = 17;
+  std::vector<OfxParamValueStruct> range(4 * count);
+  paramEvaluateRange(scale, -1.0, 0.5, count, range.data());
+  for (int i = 0 ; i < count ; ++i) {
+    paramEvaluate(scale, -1.0 + 0.5 * i, values);
+    CHECK(range[4 * i].as_double == values[0].as_double);
+    CHECK(range[4 * i + 1].as_double == values[1].as_double);
+  }
+}
@@ -0,0 +1,111 @@
+#include "TestHarness.h"
+
+extern "C" {
+#include <host/propertySuite.h>
+#include <common/extensions.h>
+}
+
+#include <ofxMeshEffect.h>
+
+#include <cstring>
+
+TEST(properties, meshCounts) {
+  TestMesh mesh;
+  OfxPropertySetHandle properties = (OfxPropertySetHandle)&mesh.raw.properties;
+
+  // The extension property packs the four counts, that remain readable
+  // one by one
+  const int counts[4] = { 8, 24, 6, 4 };
+  CHECK_OK(propSetIntN(properties, kMfxMeshPropCounts, 4, counts));
+  int value = 0;
+  CHECK_OK(propGetInt(properties, kOfxMeshPropPointCount, 0, &value));
+  CHECK(value == 8);
+  CHECK_OK(propGetInt(properties, kOfxMeshPropCornerCount, 0, &value));
+  CHECK(value == 24);
+  CHECK_OK(propGetInt(properties, kOfxMeshPropFaceCount, 0, &value));
+  CHECK(value == 6);
+  CHECK_OK(propGetInt(properties, kOfxMeshPropConstantFaceSize, 0, &value));
+  CHECK(value == 4);
+
+  CHECK_OK(propSetInt(properties, kOfxMeshPropConstantFaceSize, 0, -1));
+  int readCounts[4] = { 0, 0, 0, 0 };
+  CHECK_OK(propGetIntN(properties, kMfxMeshPropCounts, 4, readCounts));
+  CHECK(readCounts[0] == 8 && readCounts[1] == 24 && readCounts[2] == 6 && readCounts[3] == -1);
+
+  // Reading fewer values than the dimension is allowed, more is not
+  int dimension = 0;
+  CHECK_OK(propGetDimension(properties, kMfxMeshPropCounts, &dimension));
+  CHECK(dimension == 4);
+  CHECK_OK(propGetIntN(properties, kMfxMeshPropCounts, 2, readCounts));
+  int tooMany[5] = { 0, 0, 0, 0, 0 };
+  CHECK(kOfxStatErrBadIndex == propGetIntN(properties, kMfxMeshPropCounts, 5, tooMany));
+  CHECK(kOfxStatErrBadIndex == propSetIntN(properties, kOfxMeshPropPointCount, 2, counts));
+  CHECK(kOfxStatErrBadHandle == propGetIntN(properties, "NoSuchProperty", 1, readCounts));
+  CHECK(kOfxStatErrBadHandle == propGetDimension(properties, "NoSuchProperty", &dimension));
+}
+
+TEST(properties, transformMatrix) {
+  TestMesh mesh;
+  OfxPropertySetHandle properties = (OfxPropertySetHandle)&mesh.raw.properties;
+
+  int dimension = 0;
+  CHECK_OK(propGetDimension(properties, kOfxMeshPropTransformMatrix, &dimension));
+  CHECK(dimension == 16);
+  double matrix[16];
+  CHECK_OK(propGetDoubleN(properties, kOfxMeshPropTransformMatrix, 16, matrix));
+  for (int i = 0 ; i < 16 ; ++i) {
+    CHECK(matrix[i] == (i % 5 == 0 ? 1.0 : 0.0));
+  }
+
+  for (int i = 0 ; i < 16 ; ++i) matrix[i] = 0.5 * i;
+  CHECK_OK(propSetDoubleN(properties, kOfxMeshPropTransformMatrix, 16, matrix));
+  double value = 0;
+  CHECK_OK(propGetDouble(properties, kOfxMeshPropTransformMatrix, 7, &value));
+  CHECK(value == 3.5);
+  CHECK_OK(propSetDouble(properties, kOfxMeshPropTransformMatrix, 15, -1.0));
+  CHECK_OK(propGetDoubleN(properties, kOfxMeshPropTransformMatrix, 16, matrix));
+  CHECK(matrix[14] == 7.0 && matrix[15] == -1.0);
+  CHECK(kOfxStatErrBadIndex == propGetDouble(properties, kOfxMeshPropTransformMatrix, 16, &value));
+}
+
+TEST(properties, attributes) {
+  TestMesh mesh;
+  OfxMeshAttributePropertySet *attrib = &mesh.raw.attributes[0];
+  attributeInit(attrib);
+  OfxPropertySetHandle properties = (OfxPropertySetHandle)attrib;
+
+  CHECK_OK(propSetInt(properties, kOfxMeshAttribPropComponentCount, 0, 3));
+  const char *type = kOfxMeshAttribTypeFloat;
+  CHECK_OK(propSetStringN(properties, kOfxMeshAttribPropType, 1, &type));
+  int componentCount = 0;
+  CHECK_OK(propGetIntN(properties, kOfxMeshAttribPropComponentCount, 1, &componentCount));
+  CHECK(componentCount == 3);
+  char *readType = nullptr;
+  CHECK_OK(propGetStringN(properties, kOfxMeshAttribPropType, 1, &readType));
+  CHECK(nullptr != readType && 0 == strcmp(readType, kOfxMeshAttribTypeFloat));
+
+  float data[6] = { 0, 1, 2, 3, 4, 5 };
+  void *pointer = data;
+  CHECK_OK(propSetPointerN(properties, kOfxMeshAttribPropData, 1, &pointer));
+  void *readPointer = nullptr;
+  CHECK_OK(propGetPointerN(properties, kOfxMeshAttribPropData, 1, &readPointer));
+  CHECK(readPointer == data);
+  attrib->data = nullptr; // not owned by the mesh
+
+  // Attributes have no double property
+  double value = 0;
+  CHECK(kOfxStatErrBadHandle == propGetDoubleN(properties, kOfxMeshAttribPropStride, 1, &value));
+}
+
+TEST(properties, cookArgs) {
+  OfxCookArgsPropertySet args;
+  cookArgsInit(&args, 2.5);
+  OfxPropertySetHandle properties = (OfxPropertySetHandle)&args;
+  double time = 0;
+  CHECK_OK(propGetDoubleN(properties, kOfxPropTime, 1, &time));
+  CHECK(time == 2.5);
+  CHECK_OK(propSetDouble(properties, kOfxPropTime, 0, 4.0));
+  CHECK_OK(propGetDouble(properties, kOfxPropTime, 0, &time));
+  CHECK(time == 4.0);
+  CHECK(kOfxStatErrBadIndex == propGetDouble(properties, kOfxPropTime, 1, &time));
+}
@@ -0,0 +1,143 @@
+#include "TestHarness.h"
+
+#include "ObjReader.h"
+#include "RenderBuffers.h"
+
+extern "C" {
+#include <host/meshEffectSuite.h>
+}
+
+#include <ofxMeshEffect.h>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static OfxStatus loadObj(OfxMeshStruct *mesh, const std::string& obj, bool normals = false) {
+  ObjLoadOptions options;
+  options.normals = normals;
+  ObjReader reader(options);
+  reader.feed(obj.data(), obj.size());
+  return reader.finish(mesh);
+}
+
+// L-shaped hexagon of area 3 in the z = 0 plane, starting at a vertex from
+// which a fan would cover the notch
+static const char *lShapeObj =
+  "v 0 0 0\nv 2 0 0\nv 2 1 0\nv 1 1 0\nv 1 2 0\nv 0 2 0\n"
+  "f 5 6 1 2 3 4\n";
+
+// Signed area of a triangle of the buffers, projected on the z = 0 plane
+static float triangleArea(const RenderBuffers& buffers, int triangle) {
+  const float *p[3];
+  for (int k = 0 ; k < 3 ; ++k) p[k] = buffers.positions() + 3 * buffers.indices()[3 * triangle + k];
+  return 0.5f * ((p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) - (p[1][1] - p[0][1]) * (p[2][0] - p[0][0]));
+}
+
+TEST(renderBuffers, concaveFaces) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, std::string(lShapeObj) + "v 3 0 0\nv 4 0 0\nv 3 1 0\nf 7 8 9\n"));
+  RenderBuffers buffers;
+  CHECK_OK(buffers.update(&mesh.raw));
+  CHECK(buffers.triangleCount() == 4 + 1);
+
+  // Triangles keep the orientation of their face and do not overlap
+  float area = 0;
+  for (int t = 0 ; t < 4 ; ++t) {
+    CHECK(triangleArea(buffers, t) > 0);
+    CHECK(buffers.triangleFaces()[t] == 0);
+    area += triangleArea(buffers, t);
+  }
+  CHECK(std::fabs(area - 3.0f) < 1e-5f);
+  CHECK(buffers.triangleFaces()[4] == 1);
+  CHECK(std::fabs(triangleArea(buffers, 4) - 0.5f) < 1e-6f);
+}
+
+TEST(renderBuffers, normalLayouts) {
+  // Without normals, there is a vertex per corner with flat face normals
+  TestMesh flat;
+  CHECK_OK(loadObj(&flat.raw, lShapeObj));
+  RenderBuffers buffers;
+  CHECK_OK(buffers.update(&flat.raw));
+  CHECK(buffers.vertexCount() == flat.raw.properties.corner_count);
+  for (int i = 0 ; i < buffers.vertexCount() ; ++i) {
+    const float *normal = buffers.normals() + 3 * i;
+    CHECK(normal[0] == 0 && normal[1] == 0 && std::fabs(normal[2] - 1.0f) < 1e-6f);
+  }
+
+  // Corner normals are displayed as is
+  TestMesh corners;
+  CHECK_OK(loadObj(&corners.raw, "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 1 0\nvn 1 0 0\nf 1//1 2//2 3//1\n", true));
+  CHECK_OK(buffers.update(&corners.raw));
+  CHECK(buffers.vertexCount() == 3);
+  CHECK(buffers.normals()[3] == 1 && buffers.normals()[4] == 0);
+  CHECK(buffers.normals()[7] == 1);
+
+  // Point normals share vertices between faces, indexed by point
+  TestMesh points;
+  CHECK_OK(loadObj(&points.raw, lShapeObj));
+  OfxMeshAttributePropertySet *normalAttrib;
+  CHECK_OK(attributeDefine(&points.raw, kOfxMeshAttribPoint, "normal", 3, kOfxMeshAttribTypeFloat, kOfxMeshAttribSemanticNormal, (OfxPropertySetHandle*)&normalAttrib));
+  CHECK_OK(attributeAlloc(normalAttrib, &points.raw.properties));
+  float *normals = reinterpret_cast<float*>(normalAttrib->data);
+  for (int i = 0 ; i < 6 ; ++i) {
+    normals[3 * i] = 0; normals[3 * i + 1] = static_cast<float>(i); normals[3 * i + 2] = 1;
+  }
+  CHECK_OK(buffers.update(&points.raw));
+  CHECK(buffers.vertexCount() == 6);
+  CHECK(buffers.triangleCount() == 4);
+  for (int i = 0 ; i < 6 ; ++i) {
+    CHECK(buffers.normals()[3 * i + 1] == static_cast<float>(i));
+  }
+  for (int c = 0 ; c < 3 * buffers.triangleCount() ; ++c) {
+    CHECK(buffers.indices()[c] < 6);
+  }
+}
+
+TEST(renderBuffers, errors) {
+  // Invalid meshes leave empty buffers
+  TestMesh mesh, empty;
+  CHECK_OK(loadObj(&mesh.raw, lShapeObj));
+  RenderBuffers buffers;
+  CHECK_OK(buffers.update(&mesh.raw));
+  CHECK(kOfxStatErrUnsupported == buffers.update(&empty.raw));
+  CHECK(buffers.vertexCount() == 0 && buffers.triangleCount() == 0);
+
+  mesh.raw.properties.corner_count -= 1;
+  CHECK(kOfxStatOK != buffers.update(&mesh.raw));
+  CHECK(buffers.vertexCount() == 0 && buffers.triangleCount() == 0);
+}
+
+TEST(renderBuffers, changes) {
+  TestMesh mesh;
+  CHECK_OK(loadObj(&mesh.raw, lShapeObj));
+  RenderBuffers buffers;
+  CHECK_OK(buffers.update(&mesh.raw));
+  CHECK(buffers.changes() == (RenderBuffers::PositionsChanged | RenderBuffers::NormalsChanged | RenderBuffers::IndicesChanged));
+  const uint32_t *indices = buffers.indices();
+  std::vector<uint32_t> triangles(indices, indices + 3 * buffers.triangleCount());
+
+  // Nothing changed
+  CHECK_OK(buffers.update(&mesh.raw));
+  CHECK(buffers.changes() == 0);
+
+  // Moving points within the plane of the face keeps its normal, and the
+  // triangulation is kept even though a fresh one could differ
+  float *positions = reinterpret_cast<float*>(findAttribute(&mesh.raw, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition)->data);
+  positions[3 * 3 + 0] = 1.5f;
+  CHECK_OK(buffers.update(&mesh.raw));
+  CHECK(buffers.changes() == RenderBuffers::PositionsChanged);
+  CHECK(std::vector<uint32_t>(buffers.indices(), buffers.indices() + 3 * buffers.triangleCount()) == triangles);
+
+  positions[3 * 0 + 2] = 1.0f;
+  CHECK_OK(buffers.update(&mesh.raw));
+  CHECK(buffers.changes() == (RenderBuffers::PositionsChanged | RenderBuffers::NormalsChanged));
+
+  // Same counts but different corners
+  TestMesh other;
+  CHECK_OK(loadObj(&other.raw, "v 0 0 0\nv 2 0 0\nv 2 1 0\nv 1 1 0\nv 1 2 0\nv 0 2 0\nf 1 2 3 4 5 6\n"));
+  CHECK_OK(buffers.update(&other.raw));
+  CHECK(buffers.changes() & RenderBuffers::IndicesChanged);
+  CHECK(buffers.triangleCount() == 4);
+}
@@ -0,0 +1,142 @@
+#include "TestHarness.h"
+
+extern "C" {
+#include <host/host.h>
+#include <host/parameterSuite.h>
+}
+
+#include <ofxMeshEffect.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct RegisteredTest {
+  const char *suite;
+  const char *name;
+  TestFunction function;
+};
+
+// Function local so that it exists before the static registrations
+std::vector<RegisteredTest>& registry() {
+  static std::vector<RegisteredTest> tests;
+  return tests;
+}
+
+int s_failureCount = 0;
+
+} // anonymous namespace
+
+TestRegistration::TestRegistration(const char *suite, const char *name, TestFunction function) {
+  registry().push_back(RegisteredTest{ suite, name, function });
+}
+
+void reportFailure(const char *file, int line, const char *expression) {
+  printf("%s:%d: check failed: %s\n", file, line, expression);
+  ++s_failureCount;
+}
+
+//--------------------------------------------------------
+
+OfxParamHandle TestInstance::param(const char *name) {
+  OfxParamHandle handle = nullptr;
+  if (kOfxStatOK != paramGetHandle(&raw.parameters, name, &handle, nullptr)) return nullptr;
+  return handle;
+}
+
+OfxStatus TestInstance::setDouble(const char *name, double value) {
+  OfxParamHandle handle = param(name);
+  if (nullptr == handle) return kOfxStatErrUnknown;
+  return paramSetValue(handle, value);
+}
+
+OfxStatus TestInstance::setInt(const char *name, int value) {
+  OfxParamHandle handle = param(name);
+  if (nullptr == handle) return kOfxStatErrUnknown;
+  return paramSetValue(handle, value);
+}
+
+//--------------------------------------------------------
+
+TestEffect::TestEffect(const char *path) {
+  meshEffectInit(&m_descriptor);
+
+  typedef OfxPlugin* (*GetPluginFunction)(int);
+  GetPluginFunction getPlugin = nullptr;
+#ifdef _WIN32
+  HMODULE library = LoadLibraryA(path);
+  if (nullptr != library) getPlugin = reinterpret_cast<GetPluginFunction>(GetProcAddress(library, "OfxGetPlugin"));
+#else
+  void *library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (nullptr != library) getPlugin = reinterpret_cast<GetPluginFunction>(dlsym(library, "OfxGetPlugin"));
+#endif
+  if (nullptr == getPlugin) {
+    printf("Error: could not load plugin library %s\n", path);
+    return;
+  }
+
+  static OfxHost host = { nullptr, &fetchSuite };
+  OfxPlugin *plugin = getPlugin(0);
+  plugin->setHost(&host);
+  if (kOfxStatOK != plugin->mainEntry(kOfxActionLoad, nullptr, nullptr, nullptr)
+    || kOfxStatOK != plugin->mainEntry(kOfxActionDescribe, &m_descriptor, nullptr, nullptr))
+  {
+    printf("Error: could not describe plugin %s\n", plugin->pluginIdentifier);
+    return;
+  }
+  m_plugin = plugin;
+}
+
+TestEffect::~TestEffect() {
+  if (nullptr != m_plugin) {
+    m_plugin->mainEntry(kOfxActionUnload, nullptr, nullptr, nullptr);
+  }
+  meshEffectDestroy(&m_descriptor);
+}
+
+std::unique_ptr<TestInstance> TestEffect::instantiate() const {
+  if (nullptr == m_plugin) return nullptr;
+  std::unique_ptr<TestInstance> instance(new TestInstance());
+  if (kOfxStatOK != meshEffectCopy(&instance->raw, &m_descriptor)) return nullptr;
+  OfxStatus status = m_plugin->mainEntry(kOfxActionCreateInstance, &instance->raw, nullptr, nullptr);
+  if (kOfxStatOK != status && kOfxStatReplyDefault != status) return nullptr;
+  return instance;
+}
+
+const OfxMeshAttributePropertySet* findAttribute(const OfxMeshStruct *mesh, const char *attachment, const char *name) {
+  for (int i = 0 ; i < 32 && mesh->attributes[i].is_valid ; ++i) {
+    const OfxMeshAttributePropertySet *attrib = &mesh->attributes[i];
+    if (0 == strcmp(attrib->attachment, attachment) && 0 == strcmp(attrib->name, name)) return attrib;
+  }
+  return nullptr;
+}
+
+//--------------------------------------------------------
+
+/**
+ * Run the tests of the suite given as argument, or all of them.
+ */
+int main(int argc, char **argv) {
+  const char *suite = argc > 1 ? argv[1] : nullptr;
+  int testCount = 0;
+  for (const RegisteredTest& test : registry()) {
+    if (nullptr != suite && 0 != strcmp(suite, test.suite)) continue;
+    int failureCount = s_failureCount;
+    test.function();
+    printf("[%s] %s.%s\n", failureCount == s_failureCount ? "PASS" : "FAIL", test.suite, test.name);
+    ++testCount;
+  }
+  if (testCount == 0) {
+    printf("Error: no test in suite '%s'\n", nullptr != suite ? suite : "");
+    return 1;
+  }
+  return s_failureCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#ifndef _TestHarness_h_
+#define _TestHarness_h_
+
+/**
+ * Minimal test harness of the native build. Tests are grouped into suites
+ * that ctest runs as separate processes, e.g. "WebMfxTests normals", and a
+ * failed CHECK() reports its location and leaves the current test.
+ */
+
+extern "C" {
+#include <host/types.h>
+}
+
+#include <ofxCore.h>
+
+#include <memory>
+
+typedef void (*TestFunction)();
+
+struct TestRegistration {
+  TestRegistration(const char *suite, const char *name, TestFunction function);
+};
+
+#define TEST(suite, name) \
+  static void test_##suite##_##name(); \
+  static TestRegistration registration_##suite##_##name(#suite, #name, &test_##suite##_##name); \
+  static void test_##suite##_##name()
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+      reportFailure(__FILE__, __LINE__, #condition); \
+      return; \
+    } \
+  } while (0)
+
+#define CHECK_OK(status) CHECK(kOfxStatOK == (status))
+
+void reportFailure(const char *file, int line, const char *expression);
+
+/**
+ * Mesh that is destroyed along with the test.
+ */
+struct TestMesh {
+  OfxMeshStruct raw;
+
+  TestMesh() { meshInit(&raw); }
+  ~TestMesh() { meshDestroy(&raw); }
+  TestMesh(const TestMesh&) = delete;
+  TestMesh& operator=(const TestMesh&) = delete;
+};
+
+/**
+ * Effect instance, copied from the descriptor of a TestEffect.
+ */
+struct TestInstance {
+  OfxMeshEffectStruct raw;
+
+  TestInstance() { meshEffectInit(&raw); }
+  ~TestInstance() { meshEffectDestroy(&raw); }
+  TestInstance(const TestInstance&) = delete;
+  TestInstance& operator=(const TestInstance&) = delete;
+
+  OfxParamHandle param(const char *name);
+  OfxStatus setDouble(const char *name, double value);
+  OfxStatus setInt(const char *name, int value);
+};
+
+/**
+ * First plugin of a shared library, loaded and described. The library
+ * remains loaded until the end of the tests.
+ */
+class TestEffect {
+public:
+  TestEffect(const char *path);
+  ~TestEffect();
+  TestEffect(const TestEffect&) = delete;
+  TestEffect& operator=(const TestEffect&) = delete;
+
+  bool isValid() const { return nullptr != m_plugin; }
+  const OfxPlugin* plugin() const { return m_plugin; }
+
+  /**
+   * New instance of the effect, or null if it could not be created.
+   */
+  std::unique_ptr<TestInstance> instantiate() const;
+
+private:
+  OfxPlugin *m_plugin = nullptr;
+  OfxMeshEffectStruct m_descriptor;
+};
+
+/**
+ * Attribute of a mesh, or null if there is none with this name.
+ */
+const OfxMeshAttributePropertySet* findAttribute(const OfxMeshStruct *mesh, const char *attachment, const char *name);
+
+#endif // _TestHarness_h_
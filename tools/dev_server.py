@@ -13,9 +13,20 @@ port = 8888
 url = f"http://{ip}:{port}/{build_dir}/WebMfxHost.html"
 
 
+class IsolatedRequestHandler(SimpleHTTPRequestHandler):
+    """
+    Serve pages as cross-origin isolated, which browsers require to enable
+    SharedArrayBuffer, hence threads (see WEBMFX_PTHREADS in CMakeLists.txt).
+    """
+    def end_headers(self):
+        self.send_header("Cross-Origin-Opener-Policy", "same-origin")
+        self.send_header("Cross-Origin-Embedder-Policy", "require-corp")
+        super().end_headers()
+
+
 def start_server():
     server_address = (ip, port)
-    httpd = HTTPServer(server_address, SimpleHTTPRequestHandler)
+    httpd = HTTPServer(server_address, IsolatedRequestHandler)
     httpd.serve_forever()
 
 